@@ -31,6 +31,7 @@ struct Mesh
 /**
  * Load mesh data from a file using assimp. Only the first mesh in the imported scene is read.
  * Vertices are packed as position (float3), normal (float3), uv (float2). Indices are 32-bit.
+ * Triangles and vertices are reordered with OptimizeMesh, unreferenced vertices are dropped.
  *
  * @param file_path Absolute or relative path to the mesh file.
  * @param out_mesh Output mesh with vertex and index data populated.
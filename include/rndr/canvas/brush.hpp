@@ -1,9 +1,11 @@
 #pragma once
 
+#include "opal/container/array-view.h"
 #include "opal/container/dynamic-array.h"
 #include "opal/container/string.h"
 
 #include "rndr/canvas/buffer.hpp"
+#include "rndr/canvas/shader.hpp"
 #include "rndr/types.hpp"
 
 #include <cstring>
@@ -13,7 +15,6 @@ namespace Rndr
 namespace Canvas
 {
 
-class Shader;
 class Texture;
 
 /** Simplified blend modes for the Canvas API. */
@@ -105,6 +106,15 @@ struct BrushDesc
     f32 depth_bias_units = 0.0f;
 };
 
+/**
+ * Small id of an interned BrushDesc. Brushes whose descriptors are equal share the id, so the
+ * DrawList can sort by it and the state cache can skip the whole pipeline state when it repeats.
+ */
+using PipelineStateId = u16;
+
+/** Largest valid pipeline state id. */
+constexpr PipelineStateId k_max_pipeline_state_id = 0xFFFF;
+
 /** A named uniform value stored as raw bytes. */
 struct UniformBinding
 {
@@ -127,19 +137,17 @@ struct BufferBinding
 };
 
 /**
- * A GPU uniform buffer owned by the Brush, paired with a CPU-side staging area.
+ * CPU-side staging area of one UBO binding point of a Brush.
  *
  * Created automatically by Brush::SetShader() based on shader reflection. One slot is created for
  * each unique UBO binding point that has uniform fields (size > 0). When SetUniform() is called,
  * the value is written into the CPU staging data at the correct offset and the slot is marked
- * dirty. Call UploadUniforms() to push all dirty slots to the GPU.
+ * dirty. UploadUniforms() copies the slots into the Context's uniform ring buffer, a single
+ * persistently mapped buffer shared by all brushes, and each slot is bound as a range of it.
  */
 struct UniformBufferSlot
 {
-    /** The GPU buffer that will be bound at this UBO slot during rendering. */
-    Buffer gpu_buffer;
-
-    /** CPU-side copy of the UBO data. SetUniform() writes here; UploadUniforms() pushes to GPU. */
+    /** CPU-side copy of the UBO data. SetUniform() writes here; UploadUniforms() copies it to the GPU. */
     Opal::DynamicArray<u8> cpu_data;
 
     /** The UBO binding point index, matching ShaderParameter::binding_index. */
@@ -148,8 +156,17 @@ struct UniformBufferSlot
     /** The binding space, matching ShaderParameter::binding_space (always 0 for OpenGL). */
     i32 binding_space = 0;
 
+    /** Offset of the latest GPU copy of cpu_data in the uniform ring buffer. */
+    u64 ring_offset = 0;
+
+    /** Ring buffer generation the GPU copy was made in. 0 if never uploaded. The copy is stale once the generation changes. */
+    u64 ring_generation = 0;
+
     /** True if cpu_data has been modified since the last UploadUniforms() call. */
     bool dirty = false;
+
+    /** True if the slot of a brush instance still reads the parent's data. cpu_data is empty until the first write. */
+    bool inherited = false;
 };
 
 /**
@@ -159,20 +176,34 @@ struct UniformBufferSlot
  * ## Uniform buffer management
  *
  * When a Shader is assigned via SetShader(), the Brush inspects the shader's reflection data and
- * automatically creates GPU uniform buffers (UniformBufferSlot) for each UBO binding point. This
+ * automatically creates staging areas (UniformBufferSlot) for each UBO binding point. This
  * covers both explicit `ConstantBuffer<T>` declarations and standalone global uniforms (which
  * Slang wraps into an implicit default UBO).
  *
  * The typical workflow is:
  *   1. `brush.SetShader(shader);`    — creates UBO slots from reflection.
  *   2. `brush.SetUniform("mvp", m);` — writes into the correct UBO's CPU staging data.
- *   3. `brush.UploadUniforms();`     — pushes all dirty UBOs to the GPU.
+ *   3. `brush.UploadUniforms();`     — copies the UBOs into the Context's uniform ring buffer.
  *
  * If SetUniform() is called with a name that does not match any shader parameter (or if no shader
  * is set), the value is stored in a fallback list (GetUniforms()) for later manual handling.
  *
  * Textures and storage buffers are bound by name and stored as non-owning pointers — the user is
  * responsible for keeping those resources alive.
+ *
+ * ## Brush instances
+ *
+ * CreateInstance() makes a lightweight brush that shares the shader, pipeline state and uniform
+ * data of its parent. An instance owns no uniform data until it writes a uniform: the first write
+ * to a block copies the parent's block (copy-on-write), later parent writes to that block are no
+ * longer seen by the instance. Blocks the instance never wrote keep following the parent.
+ *
+ * ## Shader reloads
+ *
+ * A shader can be rebuilt in place, for example by a ShaderRegistry. On its next use the brush
+ * compares Shader::GetUniformLayoutHash() to the layout its slots were created for and recreates
+ * the slots only if the layout changed. Recreated slots are zeroed, instances inherit all blocks
+ * again, and uniform handles resolved before the change must be resolved again.
  */
 class Brush
 {
@@ -187,17 +218,42 @@ public:
     Brush(Brush&& other) noexcept;
     Brush& operator=(Brush&& other) noexcept;
 
+    /** @return Deep copy of the brush. A clone of an instance is an instance of the same parent. */
     [[nodiscard]] Brush Clone() const;
 
     /**
-     * Set the shader program used for rendering. This also inspects the shader's reflection data
-     * and creates GPU uniform buffers (UniformBufferSlot) for each UBO binding point that has
-     * uniform fields. Any previously created UBO slots are destroyed and replaced.
+     * Create an instance of this brush. The instance shares the shader, pipeline state and uniform
+     * blocks of this brush and copies its texture and buffer bindings. Uniform blocks are copied
+     * only when the instance writes to them. Calling this on an instance creates a sibling.
      *
-     * Requires an active OpenGL context (since it creates GPU buffers).
+     * The parent must outlive its instances and must keep its address, so it must not be moved
+     * while instances exist. Calling SetShader() on an instance detaches it from its parent.
+     *
+     * @param debug_name Debug name of the instance.
+     * @return New brush instance.
+     * @throw Opal::InvalidArgumentException if this brush has no shader.
+     */
+    [[nodiscard]] Brush CreateInstance(Opal::StringUtf8 debug_name = "") const;
+
+    /** @return Parent brush of an instance, or nullptr if this brush is not an instance. */
+    [[nodiscard]] const Brush* GetParent() const;
+
+    /**
+     * Set the shader program used for rendering. This also inspects the shader's reflection data
+     * and creates staging areas (UniformBufferSlot) for each UBO binding point that has uniform
+     * fields. Any previously created UBO slots are destroyed and replaced.
      */
     void SetShader(const Shader& shader);
 
+    /**
+     * Switch to another variant of the current shader, see Shader::GetVariant(). Unlike
+     * SetShader(), this keeps the uniform data, the resource bindings and the parent of an instance.
+     * Does nothing if the variant is already set.
+     * @param variant Variant with the same uniform layout as the current shader.
+     * @throw Opal::InvalidArgumentException if the brush has no shader or the uniform layouts differ.
+     */
+    void SetShaderVariant(const Shader& variant);
+
     /** @return Currently bound shader, or nullptr if none. */
     [[nodiscard]] const Shader* GetShader() const;
 
@@ -232,6 +288,9 @@ public:
     /** @return Current pipeline state descriptor. */
     [[nodiscard]] const BrushDesc& GetDesc() const;
 
+    /** @return Id of the interned pipeline state. Equal for all brushes with an equal descriptor. 0 for the default descriptor. */
+    [[nodiscard]] PipelineStateId GetPipelineStateId() const;
+
     /**
      * Bind a texture by name. The name must match a texture parameter declared in the shader.
      * @param name Binding name as declared in the shader.
@@ -270,6 +329,37 @@ public:
     template<typename T>
     void SetUniform(const char* name, i32 index, const T& value);
 
+    /**
+     * Set a uniform value through a handle resolved with Shader::GetUniformHandle(). The value is
+     * copied straight into the staging data of the handle's slot, without any name lookup. Writing
+     * through an invalid handle does nothing. With RNDR_HARDENING the value size and the handle are
+     * validated.
+     * @param handle Handle resolved from the brush's shader.
+     * @param value Value to set. Must be a trivially copyable type matching the shader declaration.
+     */
+    template<typename T>
+    void SetUniform(const UniformHandle& handle, const T& value);
+
+    /**
+     * Set a uniform array element through a handle resolved with Shader::GetUniformHandle().
+     * @param handle Handle of the array uniform, resolved from the brush's shader.
+     * @param index Array element index.
+     * @param value Value to set.
+     */
+    template<typename T>
+    void SetUniform(const UniformHandle& handle, i32 index, const T& value);
+
+    /**
+     * Overwrite a whole uniform block with one copy. The block type is a struct generated from the
+     * shader by parameter-block-generator, or any trivially copyable struct with the same layout and
+     * the k_binding_index and k_binding_space constants of the block.
+     * @param block New contents of the block.
+     * @throw Opal::InvalidArgumentException if the brush has no shader, the shader has no uniform
+     *        block at the binding or the size of T differs from the size of the block.
+     */
+    template<typename T>
+    void SetParameterBlock(const T& block);
+
     /** @return Fallback uniform bindings for values that did not match any shader parameter. */
     [[nodiscard]] const Opal::DynamicArray<UniformBinding>& GetUniforms() const;
 
@@ -279,7 +369,13 @@ public:
     /** @return All buffer bindings. */
     [[nodiscard]] const Opal::DynamicArray<BufferBinding>& GetBuffers() const;
 
-    /** Upload all dirty uniform buffers to the GPU. */
+    /**
+     * Copy the uniform buffer slots into the Context's uniform ring buffer if any slot is dirty or
+     * its copy was made in an earlier ring generation, i.e. before the last Context::Present().
+     * All slots are copied together into one allocation.
+     *
+     * Requires a live Context.
+     */
     void UploadUniforms();
 
     /**
@@ -292,8 +388,9 @@ public:
      *   2. Configures depth state (test, write, compare func).
      *   3. Configures blend state from BlendMode.
      *   4. Configures rasterizer state (cull mode, fill mode, depth bias).
+     *      Steps 2 to 4 are skipped as a whole if the last applied brush had the same pipeline state id.
      *   5. Uploads dirty uniform buffers to the GPU (UploadUniforms).
-     *   6. Binds UBOs to their respective binding points (glBindBufferBase).
+     *   6. Binds the UBO ranges of the uniform ring buffer to their binding points (glBindBufferRange).
      *   7. Binds textures to their respective texture units (glBindTextureUnit).
      *   8. Binds storage buffers to their respective binding points (glBindBufferBase).
      *
@@ -304,6 +401,9 @@ public:
     /** @return All uniform buffer slots created from shader reflection. */
     [[nodiscard]] const Opal::DynamicArray<UniformBufferSlot>& GetUniformBufferSlots() const;
 
+    /** @return Current data of a uniform buffer slot. For inherited slots this is the parent's data. */
+    [[nodiscard]] Opal::ArrayView<const u8> GetUniformData(u64 slot_index) const;
+
     /** @return Debug name of this brush. */
     [[nodiscard]] const Opal::StringUtf8& GetDebugName() const;
 
@@ -311,24 +411,53 @@ public:
     [[nodiscard]] bool IsValid() const;
 
 private:
+    friend class FrameReplay;
+
     /** Non-template core of SetUniform. Routes data to the matching UBO slot or fallback list. */
     void SetUniformRaw(const char* name, const void* data, u64 size);
 
     /** Non-template core of SetUniform for array elements. */
     void SetUniformRaw(const char* name, i32 index, const void* data, u64 size);
 
+    /** Non-template core of the handle based SetUniform. Index is 0 for non-array uniforms. */
+    void SetUniformRaw(const UniformHandle& handle, i32 index, const void* data, u64 size);
+
+    /** Non-template core of SetParameterBlock. */
+    void SetParameterBlockRaw(i32 binding_index, i32 binding_space, const void* data, u64 size);
+
     /**
      * Scan the current shader's parameters and create one UniformBufferSlot for each unique UBO
      * binding point that has uniform fields (size > 0). Called automatically by SetShader().
      */
     void CreateUniformBufferSlots();
+
+    /** Recreate the UBO slots if the uniform layout of the shader changed since they were created. */
+    void SyncUniformLayout();
+
+    /** @return Slot ready for writing. Copies the parent's data into inherited slots and marks the slot dirty. */
+    UniformBufferSlot& GetWritableSlot(u64 slot_index);
+
+    /** Copy the texture and buffer bindings of this brush into another brush. */
+    void CopyResourceBindings(Brush& target) const;
+
     Opal::StringUtf8 m_debug_name;
     const Shader* m_shader = nullptr;
     BrushDesc m_desc;
+    PipelineStateId m_pipeline_state_id = 0;
     Opal::DynamicArray<UniformBinding> m_uniforms;
     Opal::DynamicArray<TextureBinding> m_textures;
     Opal::DynamicArray<BufferBinding> m_buffers;
     Opal::DynamicArray<UniformBufferSlot> m_uniform_buffer_slots;
+    const Brush* m_parent = nullptr;
+
+    /** Incremented on every write to the uniform blocks. Instances compare it to detect parent changes. */
+    u64 m_uniform_version = 0;
+
+    /** Parent's m_uniform_version at the last upload of an instance. */
+    u64 m_parent_uniform_version = 0;
+
+    /** Shader::GetUniformLayoutHash() of the shader at the time the UBO slots were created. */
+    u64 m_uniform_layout_hash = 0;
 };
 
 template<typename T>
@@ -345,5 +474,26 @@ void Brush::SetUniform(const char* name, i32 index, const T& value)
     SetUniformRaw(name, index, &value, sizeof(T));
 }
 
+template<typename T>
+void Brush::SetUniform(const UniformHandle& handle, const T& value)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Uniform value must be trivially copyable!");
+    SetUniformRaw(handle, 0, &value, sizeof(T));
+}
+
+template<typename T>
+void Brush::SetUniform(const UniformHandle& handle, i32 index, const T& value)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Uniform value must be trivially copyable!");
+    SetUniformRaw(handle, index, &value, sizeof(T));
+}
+
+template<typename T>
+void Brush::SetParameterBlock(const T& block)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Parameter block must be trivially copyable!");
+    SetParameterBlockRaw(T::k_binding_index, T::k_binding_space, &block, sizeof(T));
+}
+
 }  // namespace Canvas
 }  // namespace Rndr
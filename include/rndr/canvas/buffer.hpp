@@ -1,6 +1,7 @@
 #pragma once
 
 #include "opal/container/array-view.h"
+#include "opal/container/dynamic-array.h"
 #include "opal/container/string.h"
 
 #include "rndr/types.hpp"
@@ -55,6 +56,13 @@ public:
      */
     void Update(const Opal::ArrayView<const u8>& data) const;
 
+    /**
+     * Read back the whole buffer. Stalls until the GPU is done writing to it.
+     * @return Buffer contents.
+     * @throw Rndr::GraphicsAPIException if the buffer is invalid.
+     */
+    [[nodiscard]] Opal::DynamicArray<u8> ReadData() const;
+
     [[nodiscard]] BufferUsage GetUsage() const;
     [[nodiscard]] u64 GetSize() const;
     [[nodiscard]] u64 GetOffset() const;
@@ -2,6 +2,7 @@
 
 #include "rndr/canvas/context.hpp"
 #include "rndr/canvas/shader.hpp"
+#include "rndr/canvas/shader-registry.hpp"
 #include "rndr/canvas/render-target.hpp"
 #include "rndr/canvas/texture.hpp"
 #include "rndr/canvas/brush.hpp"
@@ -10,4 +11,5 @@
 #include "rndr/canvas/buffer.hpp"
 #include "rndr/canvas/draw-command-buffer.hpp"
 #include "rndr/canvas/draw-list.hpp"
+#include "rndr/canvas/frame-capture.hpp"
 #include "rndr/canvas/compute-list.hpp"
@@ -1,5 +1,9 @@
 #pragma once
 
+#include "opal/container/dynamic-array.h"
+#include "opal/container/scope-ptr.h"
+
+#include "rndr/canvas/draw-list.hpp"
 #include "rndr/types.hpp"
 
 namespace Rndr
@@ -7,15 +11,46 @@ namespace Rndr
 namespace Canvas
 {
 
-class Shader;
+class Brush;
+
+namespace Impl
+{
+class BarrierTracker;
+}
+
+/** Counters gathered during one ComputeList::Execute(). */
+struct ComputeListStats
+{
+    /** Number of compute dispatches. */
+    u32 dispatch_count = 0;
+
+    /** Number of glMemoryBarrier calls, including the one that ends the list. */
+    u32 barrier_count = 0;
+};
 
 /**
  * Records compute dispatches, then executes and resets. Same single-use semantics as DrawList.
+ *
+ * Unlike DrawList::Dispatch(), dispatches are not followed by a full memory barrier. The list tracks
+ * which storage buffers each dispatch reads and writes, using the shader's reflection, and only
+ * issues a GL_SHADER_STORAGE_BARRIER_BIT barrier before a dispatch that accesses a buffer written
+ * since the last barrier, or writes a buffer accessed since then. Consecutive independent dispatches
+ * run back to back. After the last dispatch, one barrier scoped to the usages of the written buffers
+ * makes the results visible to draws, indirect commands and CPU read backs.
+ *
+ * Typical usage:
+ * @code
+ *   ComputeList list;
+ *   list.Dispatch(cull_brush, group_count);     // Writes visible_instances.
+ *   list.Dispatch(histogram_brush, group_count); // Independent, no barrier.
+ *   list.Dispatch(compact_brush, group_count);  // Reads visible_instances, barrier.
+ *   list.Execute();
+ * @endcode
  */
 class ComputeList
 {
 public:
-    ComputeList() = default;
+    ComputeList();
     ~ComputeList();
 
     ComputeList(const ComputeList&) = delete;
@@ -24,18 +59,28 @@ public:
     ComputeList& operator=(ComputeList&& other) noexcept;
 
     /**
-     * Record a compute dispatch.
-     * @param shader Compute shader to dispatch.
+     * Record a compute dispatch. The brush must hold a compute shader and remain valid until
+     * Execute() is called. Storage buffers are tracked through the brush's buffer bindings.
+     * @param brush Brush with the compute shader, uniforms and buffers.
      * @param group_count_x Number of work groups in X.
      * @param group_count_y Number of work groups in Y.
      * @param group_count_z Number of work groups in Z.
      */
-    void Dispatch(const Shader& shader, u32 group_count_x, u32 group_count_y, u32 group_count_z);
+    void Dispatch(Brush& brush, u32 group_count_x, u32 group_count_y = 1, u32 group_count_z = 1);
+
+    /** @return Number of recorded dispatches not yet executed. */
+    [[nodiscard]] u64 GetCommandCount() const;
 
     /** Execute all recorded dispatches and clear internal state. */
     void Execute();
 
+    /** @return Stats of the last Execute(). */
+    [[nodiscard]] const ComputeListStats& GetStats() const;
+
 private:
+    Opal::DynamicArray<Impl::DispatchCommand> m_dispatches;
+    Opal::ScopePtr<Impl::BarrierTracker> m_barrier_tracker;
+    ComputeListStats m_stats;
 };
 
 }  // namespace Canvas
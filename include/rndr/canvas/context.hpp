@@ -1,6 +1,8 @@
 #pragma once
 
 #include "opal/container/ref.h"
+#include "opal/container/scope-ptr.h"
+#include "opal/container/string.h"
 
 #include "rndr/platform/windows-forward-def.hpp"
 #include "rndr/types.hpp"
@@ -13,6 +15,14 @@ class GenericWindow;
 namespace Rndr::Canvas
 {
 
+namespace Impl
+{
+class GLStateCache;
+class ShaderArchive;
+class ShaderCache;
+class UniformRingBuffer;
+}
+
 /**
  * Simplified data format enum covering both pixel formats and vertex attribute formats.
  * Canvas uses its own format vocabulary instead of exposing raw API-level formats.
@@ -61,6 +71,60 @@ struct ContextDesc
 
     /** Whether vertical sync should be enabled. */
     bool vsync_enabled = true;
+
+    /**
+     * Size in bytes of the persistently mapped buffer that holds the uniforms of all brushes. It
+     * should fit a few frames worth of uniform uploads, otherwise the CPU waits for the GPU.
+     */
+    u64 uniform_ring_buffer_size = 4 * 1024 * 1024;
+
+    /**
+     * Directory of the on-disk shader cache. Shaders store their compiled SPIR-V and reflection
+     * data there and later loads of the same source skip the Slang compiler. The directory is
+     * created if it does not exist. Empty disables the cache.
+     */
+    Opal::StringUtf8 shader_cache_directory;
+
+    /**
+     * Shader archive written by the shader-archiver tool, see the generate-shader-archive target.
+     * The archive is memory mapped and shaders found in it are loaded without invoking the Slang
+     * compiler, before the shader cache is consulted. If the archive can't be opened a warning is
+     * logged and shaders are compiled as usual. Empty disables the archive.
+     */
+    Opal::StringUtf8 shader_archive_path;
+};
+
+/**
+ * Counters of the GL state changes requested through the Context's state cache. A call is skipped
+ * when the requested state matches the state already set.
+ */
+struct StateCacheStats
+{
+    /** Number of GL calls that were issued. */
+    u64 issued_calls = 0;
+
+    /** Number of GL calls that were skipped because they would not change the state. */
+    u64 skipped_calls = 0;
+};
+
+/** Counters of the on-disk shader cache. */
+struct ShaderCacheStats
+{
+    /** Number of shaders loaded from the cache without invoking the compiler. */
+    u64 hits = 0;
+
+    /** Number of shaders that were compiled because the cache had no valid entry. */
+    u64 misses = 0;
+};
+
+/** Counters of the shader archive. */
+struct ShaderArchiveStats
+{
+    /** Number of shaders found in the archive. */
+    u64 hits = 0;
+
+    /** Number of lookups of shaders that are not in the archive. */
+    u64 misses = 0;
 };
 
 /**
@@ -106,7 +170,11 @@ public:
 
     void Destroy();
 
-    /** Swap front and back buffers, presenting the current frame to the screen. */
+    /**
+     * Swap front and back buffers, presenting the current frame to the screen. This also fences the
+     * uniform ring buffer allocations of the frame, so brushes upload their uniforms again in the
+     * next frame.
+     */
     void Present();
 
     /** Enable or disable vertical sync without teardown. */
@@ -133,6 +201,24 @@ public:
     /** @return The depth/stencil format configured for this context. */
     [[nodiscard]] Format GetDepthStencilFormat() const;
 
+    /** @return Issued and skipped GL call counters of the state cache used by Brush::Apply. */
+    [[nodiscard]] StateCacheStats GetStateCacheStats() const;
+
+    /** Reset the state cache counters to zero, e.g. at the start of a frame. */
+    void ResetStateCacheStats();
+
+    /**
+     * Forget all cached GL state so that the next Brush::Apply issues every call. Call this after
+     * changing GL state directly, outside of Canvas objects.
+     */
+    void InvalidateStateCache();
+
+    /** @return Hit and miss counters of the shader cache. All zeros if the cache is disabled. */
+    [[nodiscard]] ShaderCacheStats GetShaderCacheStats() const;
+
+    /** @return Hit and miss counters of the shader archive. All zeros if there is no archive. */
+    [[nodiscard]] ShaderArchiveStats GetShaderArchiveStats() const;
+
     [[nodiscard]] bool IsValid() const;
 
 private:
@@ -147,6 +233,10 @@ private:
     NativeGraphicsContextHandle m_graphics_context = k_invalid_graphics_context_handle;
     i32 m_width = 0;
     i32 m_height = 0;
+    Opal::ScopePtr<Impl::GLStateCache> m_state_cache;
+    Opal::ScopePtr<Impl::UniformRingBuffer> m_uniform_ring_buffer;
+    Opal::ScopePtr<Impl::ShaderCache> m_shader_cache;
+    Opal::ScopePtr<Impl::ShaderArchive> m_shader_archive;
 };
 
 }  // namespace Rndr::Canvas
\ No newline at end of file
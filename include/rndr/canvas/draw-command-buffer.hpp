@@ -1,5 +1,10 @@
 #pragma once
 
+#include "opal/container/array-view.h"
+#include "opal/container/dynamic-array.h"
+#include "opal/container/string.h"
+
+#include "rndr/canvas/buffer.hpp"
 #include "rndr/types.hpp"
 
 namespace Rndr
@@ -26,9 +31,20 @@ struct DrawIndexedCommand
     u32 first_instance = 0;
 };
 
+static_assert(sizeof(DrawCommand) == 16, "DrawCommand must match the GL indirect command layout!");
+static_assert(sizeof(DrawIndexedCommand) == 20, "DrawIndexedCommand must match the GL indirect command layout!");
+
 /**
  * Fixed-layout buffer for indirect draw commands. Templated on command type for compile-time
  * safety. Supports DrawCommand for non-indexed and DrawIndexedCommand for indexed geometry.
+ *
+ * Commands can be filled in two ways:
+ *   - On the CPU, with Add() or Append(). Commands are staged and uploaded by the DrawList right
+ *     before the draw that uses them, and the draw count is GetCount().
+ *   - On the GPU, by a compute shader that writes commands into GetBuffer() and atomically
+ *     increments the u32 in GetCountBuffer(). Bind both to the compute brush with
+ *     Brush::SetBuffer(), record DrawList::ResetDrawCount() before the dispatch, and draw with
+ *     DrawList::DrawIndirectCount() or DrawList::DrawIndexedIndirectCount().
  */
 template<typename T>
 class DrawCommandBuffer
@@ -39,8 +55,11 @@ public:
     /**
      * Create a draw command buffer.
      * @param max_count Maximum number of commands the buffer can hold.
+     * @param name Debug name for GPU debugging tools.
+     * @throw Opal::InvalidArgumentException if max_count is 0.
+     * @throw Rndr::GraphicsAPIException if the GPU buffers can't be created.
      */
-    explicit DrawCommandBuffer(u32 max_count);
+    explicit DrawCommandBuffer(u32 max_count, Opal::StringUtf8 name = {});
     ~DrawCommandBuffer();
 
     DrawCommandBuffer(const DrawCommandBuffer&) = delete;
@@ -51,12 +70,47 @@ public:
     [[nodiscard]] DrawCommandBuffer Clone() const;
     void Destroy();
 
+    /**
+     * Add a command to the end of the CPU staging data.
+     * @throw Opal::InvalidArgumentException if the buffer is full.
+     */
+    void Add(const T& command);
+
+    /**
+     * Grow the CPU staging data by @p count default initialized commands and return a view of them,
+     * so that they can be filled in place.
+     * @throw Opal::InvalidArgumentException if the buffer doesn't have room for @p count commands.
+     */
+    [[nodiscard]] Opal::ArrayView<T> Append(u32 count);
+
+    /** Remove all CPU staged commands. */
+    void Clear();
+
+    /** Upload CPU staged commands if they changed since the last upload. Called by the DrawList. */
+    void Upload();
+
+    /** @return Number of CPU staged commands. */
+    [[nodiscard]] u32 GetCount() const;
+
+    /** @return CPU staged commands. */
+    [[nodiscard]] Opal::ArrayView<const T> GetCommands() const;
+
     [[nodiscard]] u32 GetMaxCount() const;
+
+    /** @return GPU buffer holding the commands, bindable as a storage buffer. */
+    [[nodiscard]] const Buffer& GetBuffer() const;
+
+    /** @return GPU buffer holding a single u32 draw count, bindable as a storage buffer. */
+    [[nodiscard]] const Buffer& GetCountBuffer() const;
+
     [[nodiscard]] bool IsValid() const;
 
 private:
     u32 m_max_count = 0;
-    u32 m_handle = 0;
+    Buffer m_buffer;
+    Buffer m_count_buffer;
+    Opal::DynamicArray<T> m_staging;
+    bool m_dirty = false;
 };
 
 }  // namespace Canvas
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "opal/clonable-base.h"
+#include "opal/container/array-view.h"
 #include "opal/container/dynamic-array.h"
 #include "opal/container/string.h"
 #include "opal/variant.h"
@@ -12,7 +12,9 @@ namespace Rndr::Canvas
 {
 
 class Mesh;
+struct MeshRange;
 class Brush;
+class Buffer;
 class Context;
 class RenderTarget;
 struct DrawCommand;
@@ -20,60 +22,119 @@ struct DrawIndexedCommand;
 template <typename T>
 class DrawCommandBuffer;
 
+/** Type of a command recorded in a DrawList. */
+enum class DrawListCommandType : u8
+{
+    SetViewport,
+    SetRenderTarget,
+    SetContext,
+    DrawMesh,
+    DrawMeshInstanced,
+    DrawMeshRange,
+    DrawIndirect,
+    DrawIndexedIndirect,
+    ResetDrawCount,
+    Dispatch,
+    Clear,
+    BeginEvent,
+    EndEvent,
+    EnumCount
+};
+
+/** @return Name of a command type, e.g. "DrawMesh". */
+[[nodiscard]] const char* GetCommandTypeName(DrawListCommandType type);
+
 namespace Impl
 {
 
+/**
+ * Header of a recorded command. The command payload immediately follows the header, and @p size
+ * covers both, rounded up so that the next header stays aligned.
+ */
+struct CommandHeader
+{
+    DrawListCommandType type = DrawListCommandType::EnumCount;
+    u32 size = 0;
+};
+
+// Command payloads. They are trivially copyable and hold non-owning pointers, so that they can be
+// written into the command arena with memcpy and dropped without running destructors.
+
 struct SetViewportCommand
 {
+    static constexpr DrawListCommandType k_type = DrawListCommandType::SetViewport;
     i32 x;
     i32 y;
     i32 width;
     i32 height;
 };
 
-struct SetRenderTargetCommand : Opal::ClonableBase<SetRenderTargetCommand>
+struct SetRenderTargetCommand
 {
-    Opal::Ref<const RenderTarget> target;
-    OPAL_CLONE_FIELDS(target);
+    static constexpr DrawListCommandType k_type = DrawListCommandType::SetRenderTarget;
+    const RenderTarget* target = nullptr;
 };
 
-struct SetContextCommand : Opal::ClonableBase<SetContextCommand>
+struct SetContextCommand
 {
-    Opal::Ref<const Context> context;
-    OPAL_CLONE_FIELDS(context);
+    static constexpr DrawListCommandType k_type = DrawListCommandType::SetContext;
+    const Context* context = nullptr;
 };
 
-struct DrawMeshCommand : Opal::ClonableBase<DrawMeshCommand>
+struct DrawMeshCommand
 {
-    Opal::Ref<Mesh> mesh;
-    Opal::Ref<Brush> brush;
-    OPAL_CLONE_FIELDS(mesh, brush);
+    static constexpr DrawListCommandType k_type = DrawListCommandType::DrawMesh;
+    Mesh* mesh = nullptr;
+    Brush* brush = nullptr;
 };
 
-struct DrawMeshInstancedCommand : Opal::ClonableBase<DrawMeshInstancedCommand>
+struct DrawMeshInstancedCommand
 {
-    Opal::Ref<Mesh> mesh;
-    Opal::Ref<Brush> brush;
+    static constexpr DrawListCommandType k_type = DrawListCommandType::DrawMeshInstanced;
+    Mesh* mesh = nullptr;
+    Brush* brush = nullptr;
     u32 instance_count = 1;
-    OPAL_CLONE_FIELDS(mesh, brush, instance_count);
-};
-
-// struct DrawIndirectCommand
-// {
-//     Opal::Ref<const Mesh> mesh;
-//     Opal::Ref<Brush> brush;
-//     const DrawCommandBuffer<::Rndr::Canvas::DrawCommand>* commands = nullptr;
-// };
-//
-// struct DrawIndexedIndirectCommand
-// {
-//     const Mesh* mesh = nullptr;
-//     Brush* brush = nullptr;
-//     const DrawCommandBuffer<::Rndr::Canvas::DrawIndexedCommand>* commands = nullptr;
-// };
+};
+
+struct DrawMeshRangeCommand
+{
+    static constexpr DrawListCommandType k_type = DrawListCommandType::DrawMeshRange;
+    Mesh* mesh = nullptr;
+    Brush* brush = nullptr;
+    u32 first_index = 0;
+    u32 index_count = 0;
+    i32 base_vertex = 0;
+    u32 instance_count = 1;
+    u32 first_instance = 0;
+};
+
+struct DrawIndirectCommand
+{
+    static constexpr DrawListCommandType k_type = DrawListCommandType::DrawIndirect;
+    Mesh* mesh = nullptr;
+    Brush* brush = nullptr;
+    DrawCommandBuffer<::Rndr::Canvas::DrawCommand>* commands = nullptr;
+    bool gpu_count = false;
+};
+
+struct DrawIndexedIndirectCommand
+{
+    static constexpr DrawListCommandType k_type = DrawListCommandType::DrawIndexedIndirect;
+    Mesh* mesh = nullptr;
+    Brush* brush = nullptr;
+    DrawCommandBuffer<::Rndr::Canvas::DrawIndexedCommand>* commands = nullptr;
+    bool gpu_count = false;
+};
+
+struct ResetDrawCountCommand
+{
+    static constexpr DrawListCommandType k_type = DrawListCommandType::ResetDrawCount;
+    const Buffer* count_buffer = nullptr;
+};
 
 struct DispatchCommand
 {
+    static constexpr DrawListCommandType k_type = DrawListCommandType::Dispatch;
     Brush* brush = nullptr;
     u32 group_count_x = 1;
     u32 group_count_y = 1;
@@ -82,6 +143,7 @@ struct DispatchCommand
 
 struct ClearCommand
 {
+    static constexpr DrawListCommandType k_type = DrawListCommandType::Clear;
     Vector4f color = {0, 0, 0, 1};
     f32 depth = 1.0f;
     i32 stencil = 0;
@@ -92,24 +154,229 @@ struct ClearCommand
 
 struct BeginEventCommand
 {
+    static constexpr DrawListCommandType k_type = DrawListCommandType::BeginEvent;
     const char* event_name;
 };
 
 struct EndEventCommand
 {
+    static constexpr DrawListCommandType k_type = DrawListCommandType::EndEvent;
     const char* event_name;
 };
 
-using CommandVariant = Opal::Variant<SetViewportCommand, SetRenderTargetCommand, SetContextCommand, DrawMeshCommand,
-                                     DrawMeshInstancedCommand, DispatchCommand, ClearCommand, BeginEventCommand, EndEventCommand>;
+/** @return Payload of a recorded command. @p header must have been recorded with type T. */
+template <typename T>
+const T& GetCommandPayload(const CommandHeader& header)
+{
+    return *reinterpret_cast<const T*>(&header + 1);
+}
+
+/** Call the overload of @p fn that matches the payload type of a recorded command. */
+template <typename Fn>
+void VisitCommand(const CommandHeader& header, Fn&& fn);
+
+/**
+ * Linear allocator for recorded commands. Memory comes from fixed-size chunks that are kept when
+ * the arena is reset, so once a list has been recorded at its peak size, further recording does
+ * not allocate. Allocations never span two chunks and are 8 byte aligned.
+ */
+class CommandArena
+{
+public:
+    static constexpr u64 k_chunk_size = 64 * 1024;
+    static constexpr u64 k_alignment = 8;
+
+    CommandArena() = default;
+    ~CommandArena() = default;
+
+    CommandArena(const CommandArena&) = delete;
+    CommandArena& operator=(const CommandArena&) = delete;
+    CommandArena(CommandArena&& other) noexcept = default;
+    CommandArena& operator=(CommandArena&& other) noexcept = default;
+
+    /**
+     * Allocate memory for a record.
+     * @param size Size in bytes. Must be a multiple of k_alignment and at most k_chunk_size.
+     * @return Pointer to uninitialized memory.
+     */
+    [[nodiscard]] void* Allocate(u64 size);
+
+    /** Drop all records while keeping the chunks for reuse. */
+    void Reset();
+
+    /** Call @p fn with every recorded CommandHeader, in recording order. */
+    template <typename Fn>
+    void ForEach(Fn&& fn) const;
+
+private:
+    struct Chunk
+    {
+        Opal::DynamicArray<u64> data;
+        u64 used = 0;
+    };
+
+    Opal::DynamicArray<Chunk> m_chunks;
+    u64 m_current_chunk = 0;
+};
+
+/** Draw command paired with its sort key, used when executing in DrawSortMode::StateSorted. */
+struct DrawSortEntry
+{
+    u64 key = 0;
+    u32 command_index = 0;
+};
+
+/** Contiguous run of reorderable draw commands and the range of their sorted entries. */
+struct DrawSortRun
+{
+    u32 first_command = 0;
+    u32 first_entry = 0;
+    u32 count = 0;
+};
+
+enum class BakedBindingType : u8
+{
+    Texture,
+    StorageBuffer
+};
+
+/** Resource binding resolved from a brush at bake time. */
+struct BakedBinding
+{
+    BakedBindingType type = BakedBindingType::Texture;
+    u32 index = 0;
+    u32 handle = 0;
+};
+
+struct BakedSetRenderTargetCommand
+{
+    u32 framebuffer = 0;
+};
+
+/**
+ * Draw with all handles resolved at bake time. The brush is kept to read its pipeline state and to
+ * upload uniforms that were patched since the last execution.
+ */
+struct BakedDrawCommand
+{
+    Brush* brush = nullptr;
+    u32 program = 0;
+    u32 vertex_array = 0;
+    /** First index of an indexed draw. Non-indexed draws start at base_vertex, like MeshRange. */
+    u32 first_element = 0;
+    u32 element_count = 0;
+    i32 base_vertex = 0;
+    u32 instance_count = 1;
+    u32 first_instance = 0;
+    bool indexed = false;
+    u32 first_binding = 0;
+    u32 binding_count = 0;
+};
+
+struct BakedDispatchCommand
+{
+    Brush* brush = nullptr;
+    u32 program = 0;
+    u32 first_binding = 0;
+    u32 binding_count = 0;
+    u32 group_count_x = 1;
+    u32 group_count_y = 1;
+    u32 group_count_z = 1;
+
+    /** Memory barrier issued after the dispatch, resolved from the buffers the brush writes. */
+    u32 barrier_bits = 0;
+};
+
+using BakedCommandVariant =
+    Opal::Variant<SetViewportCommand, BakedSetRenderTargetCommand, SetContextCommand, BakedDrawCommand, DrawIndirectCommand,
+                  DrawIndexedIndirectCommand, ResetDrawCountCommand, BakedDispatchCommand, ClearCommand, BeginEventCommand,
+                  EndEventCommand>;
 
 }  // namespace Impl
 
+/** Order in which the DrawList issues recorded draw commands. */
+enum class DrawSortMode : u8
+{
+    /** Commands are executed exactly in recording order. */
+    RecordingOrder,
+
+    /**
+     * Draws between two barriers are sorted by a 64-bit state key (shader, brush state, textures,
+     * mesh) before execution to minimize GL state changes. Only opaque draws that test and write
+     * depth with a Less, LessEqual, Greater or GreaterEqual compare are sorted. Barriers always stay
+     * in place: render target, viewport and clear commands, dispatches, debug events and all other
+     * draws, i.e. blended ones, ones without depth test or depth write, and ones that compare with
+     * Equal, NotEqual, Always or Never.
+     */
+    StateSorted,
+
+    EnumCount
+};
+
+/**
+ * Counters and CPU timings gathered during one DrawList::Execute(). Only work submitted by the list
+ * is counted, so the numbers can be compared between frames and between lists.
+ */
+struct DrawListStats
+{
+    /** Number of non-instanced draw calls. */
+    u32 draw_count = 0;
+
+    /** Number of instanced draw calls. */
+    u32 instanced_draw_count = 0;
+
+    /** Number of multi-draw-indirect calls. */
+    u32 indirect_draw_count = 0;
+
+    /**
+     * Number of triangles submitted, over all instances. Indirect draws whose commands were written
+     * on the GPU are not included since their contents are not known on the CPU.
+     */
+    u64 triangle_count = 0;
+
+    /** Number of instances submitted. A non-instanced draw counts as one instance. */
+    u64 instance_count = 0;
+
+    /** Number of compute dispatches. */
+    u32 dispatch_count = 0;
+
+    /** Number of render target and context bindings. */
+    u32 render_target_switches = 0;
+
+    /** Number of Brush::Apply calls that bound a shader. */
+    u32 brush_applies = 0;
+
+    /** Bytes of dirty uniform buffer data uploaded to the GPU. */
+    u64 uniform_bytes_uploaded = 0;
+
+    /** Number of Mesh::Upload calls that uploaded dirty geometry. */
+    u32 mesh_uploads = 0;
+
+    /**
+     * CPU time in seconds spent executing commands, indexed by DrawListCommandType. Only gathered
+     * when DrawList::SetCommandTimingEnabled(true) was called, zero otherwise.
+     */
+    f64 command_cpu_time[static_cast<u64>(DrawListCommandType::EnumCount)] = {};
+
+    /** CPU time in seconds spent in Execute(), including sorting. */
+    f64 total_cpu_time = 0.0;
+};
+
+class BakedDrawList;
+
 /**
  * Records draw calls, then executes and resets. Single use: Execute() processes all commands then
  * clears internal state. The list object is reusable across frames, but commands are consumed on
  * execute.
  *
+ * Commands are encoded as tightly packed, variable-size records in a linear arena. The arena keeps
+ * its memory across executions, so recording a frame of similar size as the previous one does not
+ * allocate.
+ *
+ * Recording does not touch GL, so separate lists can be recorded on separate threads and then
+ * appended to a primary list, which is executed on the thread that owns the Context. Objects
+ * referenced by the recorded commands must not be mutated concurrently.
+ *
  * Typical usage:
  * @code
  *   DrawList list;
@@ -163,26 +430,276 @@ public:
      */
     void DrawInstanced(Mesh& mesh, Brush& brush, u32 instance_count);
 
-    // /** Record an indirect draw call for non-indexed geometry. */
-    // void DrawIndirect(const Mesh& mesh, Brush& brush, const DrawCommandBuffer<DrawCommand>& commands);
-    //
-    // /** Record an indirect draw call for indexed geometry. */
-    // void DrawIndexedIndirect(const Mesh& mesh, Brush& brush, const DrawCommandBuffer<DrawIndexedCommand>& commands);
+    /**
+     * Record a draw of a sub-range of a mesh, e.g. one returned by Mesh::AddRange(). Consecutive
+     * draws of ranges of the same mesh share its vertex array, so it is not rebound between them.
+     * The mesh and brush must remain valid until Execute() is called.
+     */
+    void Draw(Mesh& mesh, Brush& brush, const MeshRange& range);
+
+    /**
+     * Record an instanced draw of a sub-range of a mesh.
+     * @param mesh Mesh to draw from.
+     * @param brush Brush with pipeline state and uniforms.
+     * @param range Range of the mesh to draw.
+     * @param instance_count Number of instances to draw.
+     * @param first_instance Instance offset applied to instanced vertex attributes and to the
+     *                       shader's base instance.
+     */
+    void DrawInstanced(Mesh& mesh, Brush& brush, const MeshRange& range, u32 instance_count, u32 first_instance = 0);
+
+    /**
+     * Record a multi-draw-indirect call for non-indexed geometry. Issues GetCount() draws from the
+     * CPU staged commands, uploading them first if they changed. All referenced objects must remain
+     * valid until Execute() is called.
+     */
+    void DrawIndirect(Mesh& mesh, Brush& brush, DrawCommandBuffer<DrawCommand>& commands);
+
+    /** Indexed variant of DrawIndirect(). */
+    void DrawIndexedIndirect(Mesh& mesh, Brush& brush, DrawCommandBuffer<DrawIndexedCommand>& commands);
+
+    /**
+     * Record a multi-draw-indirect call for non-indexed geometry whose commands and draw count were
+     * written on the GPU, e.g. by a previous Dispatch(). The draw count is read from
+     * DrawCommandBuffer::GetCountBuffer() and clamped to GetMaxCount().
+     */
+    void DrawIndirectCount(Mesh& mesh, Brush& brush, DrawCommandBuffer<DrawCommand>& commands);
+
+    /** Indexed variant of DrawIndirectCount(). */
+    void DrawIndexedIndirectCount(Mesh& mesh, Brush& brush, DrawCommandBuffer<DrawIndexedCommand>& commands);
+
+    /**
+     * Record setting the GPU draw count of a command buffer to zero. Record it before the dispatch
+     * that generates the commands, so that each execution, including each execution of a baked list,
+     * counts from zero. The command buffer must remain valid until Execute() is called.
+     */
+    void ResetDrawCount(const DrawCommandBuffer<DrawCommand>& commands);
+
+    /** Indexed variant of ResetDrawCount(). */
+    void ResetDrawCount(const DrawCommandBuffer<DrawIndexedCommand>& commands);
+
+    /** Record setting the u32 at the start of a draw count buffer to zero. */
+    void ResetDrawCount(const Buffer& count_buffer);
 
     /**
      * Record a compute dispatch. The brush must hold a compute shader and remain valid until
-     * Execute() is called. Issues a glMemoryBarrier(GL_ALL_BARRIER_BITS) after the dispatch.
+     * Execute() is called. Issues a memory barrier after the dispatch, scoped to the usages of the
+     * storage buffers the shader writes. Use a ComputeList to also skip barriers between
+     * independent dispatches.
      */
     void Dispatch(Brush& brush, u32 group_count_x, u32 group_count_y = 1, u32 group_count_z = 1);
 
     void BeginEvent(const char* event_name);
     void EndEvent(const char* event_name);
 
+    /**
+     * Move all commands of a secondary list to the end of this list. The secondary list is left
+     * empty and can be reused for recording.
+     * @param secondary List whose commands are appended. Must not be this list.
+     */
+    void Append(DrawList& secondary);
+
+    /**
+     * Move all commands of the secondary lists to the end of this list, in the order the lists
+     * appear in the view. The resulting command order does not depend on when or on which thread
+     * each secondary list was recorded.
+     * @param secondaries Lists whose commands are appended. Must not contain this list.
+     */
+    void Append(Opal::ArrayView<DrawList> secondaries);
+
+    /** @return Number of recorded commands not yet executed. */
+    [[nodiscard]] u64 GetCommandCount() const;
+
+    /**
+     * Call @p fn with the header of each recorded command, in recording order. Use
+     * Impl::VisitCommand to read the command payload.
+     */
+    template <typename Fn>
+    void ForEachCommand(Fn&& fn) const;
+
+    /**
+     * Set the order in which draws are issued on Execute(). Defaults to DrawSortMode::RecordingOrder.
+     * The mode persists across executions.
+     */
+    void SetSortMode(DrawSortMode mode);
+
+    /** @return Order in which draws are issued on Execute(). */
+    [[nodiscard]] DrawSortMode GetSortMode() const;
+
+    /**
+     * Time each command on Execute() and accumulate the times in DrawListStats::command_cpu_time.
+     * Disabled by default since it reads the clock twice per command. The setting persists across
+     * executions.
+     */
+    void SetCommandTimingEnabled(bool enabled);
+
+    /** @return True if Execute() times each command. */
+    [[nodiscard]] bool IsCommandTimingEnabled() const;
+
     /** Execute all recorded commands and clear internal state. */
     void Execute();
 
+    /** @return Stats of the last Execute(). Zeroed until the list is executed for the first time. */
+    [[nodiscard]] const DrawListStats& GetStats() const;
+
+    /**
+     * Turn the recorded commands into a re-executable BakedDrawList and clear internal state. Draws
+     * are put in the order they would be executed in, given the current sort mode. Dirty meshes are
+     * uploaded, so this must be called on the thread that owns the Context.
+     * @return Baked command stream.
+     */
+    [[nodiscard]] BakedDrawList Bake();
+
 private:
-    Opal::DynamicArray<Impl::CommandVariant> m_commands;
+    friend class FrameCapture;
+
+    /** Build and sort the draw entries, one sorted range per run of reorderable draws. */
+    void SortDraws();
+
+    /** Sort the draws if needed, then call @p fn for each command in the order it is executed in. */
+    template <typename Fn>
+    void ForEachInExecutionOrder(Fn&& fn);
+
+    /** Write a command record into the arena. */
+    template <typename T>
+    void Record(const T& command);
+
+    /** Copy an already encoded record into the arena. */
+    void RecordRaw(const Impl::CommandHeader& header);
+
+    /** Drop all recorded commands, keeping the memory for the next recording. */
+    void Reset();
+
+    Impl::CommandArena m_arena;
+    u32 m_command_count = 0;
+    DrawSortMode m_sort_mode = DrawSortMode::RecordingOrder;
+    bool m_command_timing_enabled = false;
+    DrawListStats m_stats;
+
+    /**
+     * Sorted draw entries, their runs, the records of the entries in recording order and radix sort
+     * scratch space, reused across executions.
+     */
+    Opal::DynamicArray<Impl::DrawSortEntry> m_sort_entries;
+    Opal::DynamicArray<Impl::DrawSortRun> m_sort_runs;
+    Opal::DynamicArray<const Impl::CommandHeader*> m_sort_records;
+    Opal::DynamicArray<Impl::DrawSortEntry> m_sort_scratch;
 };
 
+/**
+ * Immutable command stream produced by DrawList::Bake(). Native handles of meshes, render targets,
+ * shaders, textures and buffers are resolved once at bake time, so executing it skips the
+ * per-command lookups a DrawList does and can be repeated any number of times, e.g. every frame
+ * for static content.
+ *
+ * Between executions, uniforms can be patched through Brush::SetUniform and pipeline state through
+ * the brush setters. Changing anything that alters a handle, such as the brush shader, its textures
+ * or buffers, or the size of a dynamic mesh, requires baking again. All referenced objects must
+ * outlive the baked list.
+ *
+ * Typical usage:
+ * @code
+ *   DrawList list;
+ *   list.Draw(grid_mesh, grid_brush);
+ *   BakedDrawList baked = list.Bake();
+ *   // every frame
+ *   grid_brush.SetUniform("view_projection", view_projection);
+ *   baked.Execute();
+ * @endcode
+ */
+class BakedDrawList
+{
+public:
+    BakedDrawList() = default;
+    ~BakedDrawList() = default;
+
+    BakedDrawList(const BakedDrawList&) = delete;
+    BakedDrawList& operator=(const BakedDrawList&) = delete;
+    BakedDrawList(BakedDrawList&& other) noexcept = default;
+    BakedDrawList& operator=(BakedDrawList&& other) noexcept = default;
+
+    /** Execute all baked commands. The commands are kept and can be executed again. */
+    void Execute();
+
+    /** @return Number of baked commands. */
+    [[nodiscard]] u64 GetCommandCount() const;
+
+private:
+    friend class DrawList;
+
+    Opal::DynamicArray<Impl::BakedCommandVariant> m_commands;
+    Opal::DynamicArray<Impl::BakedBinding> m_bindings;
+};
+
+template <typename Fn>
+void Impl::CommandArena::ForEach(Fn&& fn) const
+{
+    for (u64 chunk_index = 0; chunk_index < m_chunks.GetSize() && chunk_index <= m_current_chunk; ++chunk_index)
+    {
+        const Chunk& chunk = m_chunks[chunk_index];
+        const u8* data = reinterpret_cast<const u8*>(chunk.data.GetData());
+        for (u64 offset = 0; offset < chunk.used;)
+        {
+            const CommandHeader& header = *reinterpret_cast<const CommandHeader*>(data + offset);
+            fn(header);
+            offset += header.size;
+        }
+    }
+}
+
+template <typename Fn>
+void DrawList::ForEachCommand(Fn&& fn) const
+{
+    m_arena.ForEach(fn);
+}
+
+template <typename Fn>
+void Impl::VisitCommand(const CommandHeader& header, Fn&& fn)
+{
+    switch (header.type)
+    {
+        case DrawListCommandType::SetViewport:
+            fn(GetCommandPayload<SetViewportCommand>(header));
+            break;
+        case DrawListCommandType::SetRenderTarget:
+            fn(GetCommandPayload<SetRenderTargetCommand>(header));
+            break;
+        case DrawListCommandType::SetContext:
+            fn(GetCommandPayload<SetContextCommand>(header));
+            break;
+        case DrawListCommandType::DrawMesh:
+            fn(GetCommandPayload<DrawMeshCommand>(header));
+            break;
+        case DrawListCommandType::DrawMeshInstanced:
+            fn(GetCommandPayload<DrawMeshInstancedCommand>(header));
+            break;
+        case DrawListCommandType::DrawMeshRange:
+            fn(GetCommandPayload<DrawMeshRangeCommand>(header));
+            break;
+        case DrawListCommandType::DrawIndirect:
+            fn(GetCommandPayload<DrawIndirectCommand>(header));
+            break;
+        case DrawListCommandType::DrawIndexedIndirect:
+            fn(GetCommandPayload<DrawIndexedIndirectCommand>(header));
+            break;
+        case DrawListCommandType::ResetDrawCount:
+            fn(GetCommandPayload<ResetDrawCountCommand>(header));
+            break;
+        case DrawListCommandType::Dispatch:
+            fn(GetCommandPayload<DispatchCommand>(header));
+            break;
+        case DrawListCommandType::Clear:
+            fn(GetCommandPayload<ClearCommand>(header));
+            break;
+        case DrawListCommandType::BeginEvent:
+            fn(GetCommandPayload<BeginEventCommand>(header));
+            break;
+        case DrawListCommandType::EndEvent:
+            fn(GetCommandPayload<EndEventCommand>(header));
+            break;
+        default:
+            break;
+    }
+}
+
 }  // namespace Rndr::Canvas
@@ -0,0 +1,249 @@
+#pragma once
+
+#include "opal/container/dynamic-array.h"
+#include "opal/container/string.h"
+
+#include "rndr/canvas/brush.hpp"
+#include "rndr/canvas/buffer.hpp"
+#include "rndr/canvas/draw-command-buffer.hpp"
+#include "rndr/canvas/draw-list.hpp"
+#include "rndr/canvas/mesh.hpp"
+#include "rndr/canvas/render-target.hpp"
+#include "rndr/canvas/shader.hpp"
+#include "rndr/canvas/texture.hpp"
+#include "rndr/canvas/vertex-layout.hpp"
+#include "rndr/types.hpp"
+
+namespace Rndr::Canvas
+{
+
+class Context;
+
+namespace Impl
+{
+
+/** Resource index used when a captured object does not reference a resource. */
+constexpr u32 k_no_captured_resource = 0xFFFFFFFF;
+
+struct CapturedShader
+{
+    Opal::StringUtf8 name;
+    Opal::StringUtf8 vertex_source;
+    Opal::StringUtf8 fragment_source;
+    Opal::DynamicArray<PermutationKey> permutation_keys;
+
+    /** Captured shader this variant is requested from, with its key values. No sources are stored for variants. */
+    u32 variant_parent = k_no_captured_resource;
+    Opal::DynamicArray<u32> variant_values;
+};
+
+struct CapturedRenderTarget
+{
+    Opal::StringUtf8 name;
+    Opal::DynamicArray<TextureDesc> color_attachments;
+    bool use_depth_stencil = false;
+    TextureDesc depth_stencil_attachment;
+};
+
+/** Texture contents, or a reference to an attachment of a captured render target. */
+struct CapturedTexture
+{
+    Opal::StringUtf8 name;
+    TextureDesc desc;
+    u32 render_target = k_no_captured_resource;
+
+    /** Color attachment index, or -1 for the depth/stencil attachment. */
+    i32 attachment = 0;
+    Opal::DynamicArray<u8> data;
+};
+
+/** Buffer contents, or a reference to one of the buffers of a captured draw command buffer. */
+struct CapturedBuffer
+{
+    Opal::StringUtf8 name;
+    BufferUsage usage = BufferUsage::Storage;
+    u64 size = 0;
+    u64 offset = 0;
+    u32 command_buffer = k_no_captured_resource;
+
+    /** False for the command buffer's commands, true for its draw count. */
+    bool is_count_buffer = false;
+    Opal::DynamicArray<u8> data;
+};
+
+struct CapturedMesh
+{
+    Opal::StringUtf8 name;
+    Opal::DynamicArray<VertexLayout::Entry> layout;
+    Opal::DynamicArray<u8> vertex_data;
+    Opal::DynamicArray<u8> index_data;
+};
+
+/** CPU staged commands plus the GPU contents, which compute shaders may have written. */
+struct CapturedCommandBuffer
+{
+    bool indexed = false;
+    u32 max_count = 0;
+    Opal::DynamicArray<u8> staged_commands;
+    Opal::DynamicArray<u8> gpu_commands;
+    Opal::DynamicArray<u8> gpu_count;
+};
+
+struct CapturedUniformSlot
+{
+    i32 binding_index = -1;
+    i32 binding_space = 0;
+    Opal::DynamicArray<u8> data;
+};
+
+struct CapturedResourceBinding
+{
+    Opal::StringUtf8 name;
+    u32 resource = k_no_captured_resource;
+};
+
+struct CapturedBrush
+{
+    Opal::StringUtf8 name;
+    BrushDesc desc;
+    u32 shader = k_no_captured_resource;
+    Opal::DynamicArray<CapturedUniformSlot> uniform_slots;
+    Opal::DynamicArray<UniformBinding> uniforms;
+    Opal::DynamicArray<CapturedResourceBinding> textures;
+    Opal::DynamicArray<CapturedResourceBinding> buffers;
+};
+
+}  // namespace Impl
+
+/**
+ * Snapshot of one frame's DrawList: the recorded commands plus the contents of every mesh,
+ * texture, buffer, draw command buffer, shader source and brush uniform staging data they
+ * reference. A capture can be saved to a compact binary file and re-executed offline with
+ * FrameReplay, which makes a production frame a self-contained performance test case.
+ *
+ * Render target attachments are recorded as references to the captured render target, so passes
+ * that sample earlier passes keep doing so on replay. Their contents are not captured.
+ *
+ * Capture files are tied to the build that wrote them and are rejected on a version mismatch.
+ */
+class FrameCapture
+{
+public:
+    FrameCapture() = default;
+    ~FrameCapture() = default;
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+    FrameCapture(FrameCapture&& other) noexcept = default;
+    FrameCapture& operator=(FrameCapture&& other) noexcept = default;
+
+    /**
+     * Capture the commands recorded in a draw list. The list is not modified, so it can be
+     * executed afterward. Textures and buffers are read back from the GPU, so this must be called
+     * on the thread that owns the Context.
+     * @param list Draw list to capture.
+     * @return Capture of the list.
+     */
+    [[nodiscard]] static FrameCapture Capture(const DrawList& list);
+
+    /**
+     * Load a capture from a file written by Save().
+     * @param path Path to the capture file.
+     * @return Loaded capture.
+     * @throw Opal::Exception if the file can't be read or is not a valid capture.
+     */
+    [[nodiscard]] static FrameCapture Load(const Opal::StringUtf8& path);
+
+    /**
+     * Write the capture to a binary file.
+     * @param path Path to the capture file.
+     * @throw Opal::Exception if the file can't be written.
+     */
+    void Save(const Opal::StringUtf8& path) const;
+
+    /** @return Number of captured commands. */
+    [[nodiscard]] u32 GetCommandCount() const;
+
+    /** @return Number of captured shaders, render targets, textures, buffers, meshes and brushes. */
+    [[nodiscard]] u32 GetResourceCount() const;
+
+private:
+    friend class FrameReplay;
+
+    DrawSortMode m_sort_mode = DrawSortMode::RecordingOrder;
+    Opal::DynamicArray<Impl::CapturedShader> m_shaders;
+    Opal::DynamicArray<Impl::CapturedRenderTarget> m_render_targets;
+    Opal::DynamicArray<Impl::CapturedTexture> m_textures;
+    Opal::DynamicArray<Impl::CapturedCommandBuffer> m_command_buffers;
+    Opal::DynamicArray<Impl::CapturedBuffer> m_buffers;
+    Opal::DynamicArray<Impl::CapturedMesh> m_meshes;
+    Opal::DynamicArray<Impl::CapturedBrush> m_brushes;
+    Opal::DynamicArray<Opal::StringUtf8> m_event_names;
+
+    /** Commands encoded with resource indices in place of pointers. */
+    Opal::DynamicArray<u8> m_commands;
+    u32 m_command_count = 0;
+};
+
+/**
+ * Recreates the resources of a FrameCapture and re-executes its commands. Each Execute() records
+ * the captured commands into a DrawList and executes it, exactly as the captured frame did.
+ *
+ * @code
+ *   Canvas::FrameCapture capture = Canvas::FrameCapture::Load("frame.rndrcap");
+ *   Canvas::FrameReplay replay(context, capture);
+ *   replay.Execute();
+ * @endcode
+ */
+class FrameReplay
+{
+public:
+    /**
+     * Create all resources referenced by a capture.
+     * @param context Active Canvas context. Must outlive the replay.
+     * @param capture Capture to replay. Not referenced after construction.
+     * @throw Rndr::GraphicsAPIException if a resource can't be created.
+     * @throw Opal::Exception if a resource references an entry that is not in the capture.
+     */
+    FrameReplay(const Context& context, const FrameCapture& capture);
+    ~FrameReplay() = default;
+
+    FrameReplay(const FrameReplay&) = delete;
+    FrameReplay& operator=(const FrameReplay&) = delete;
+    FrameReplay(FrameReplay&&) = delete;
+    FrameReplay& operator=(FrameReplay&&) = delete;
+
+    /**
+     * Record the captured commands and execute them.
+     * @throw Opal::Exception if the commands are truncated or reference an entry that is not in the capture.
+     */
+    void Execute();
+
+    /** @return Number of commands executed by each Execute(). */
+    [[nodiscard]] u32 GetCommandCount() const;
+
+private:
+    const Context& m_context;
+    DrawSortMode m_sort_mode = DrawSortMode::RecordingOrder;
+    Opal::DynamicArray<Shader> m_shaders;
+    Opal::DynamicArray<RenderTarget> m_render_targets;
+    Opal::DynamicArray<Texture> m_textures;
+    Opal::DynamicArray<DrawCommandBuffer<DrawCommand>> m_draw_command_buffers;
+    Opal::DynamicArray<DrawCommandBuffer<DrawIndexedCommand>> m_indexed_command_buffers;
+    Opal::DynamicArray<Buffer> m_buffers;
+    Opal::DynamicArray<Mesh> m_meshes;
+    Opal::DynamicArray<Brush> m_brushes;
+
+    /** Replay objects by capture index. Shaders, textures and buffers may live inside other objects. */
+    Opal::DynamicArray<const Shader*> m_shader_refs;
+    Opal::DynamicArray<const Texture*> m_texture_refs;
+    Opal::DynamicArray<const Buffer*> m_buffer_refs;
+    Opal::DynamicArray<u32> m_command_buffer_slots;
+
+    Opal::DynamicArray<Opal::StringUtf8> m_event_names;
+    Opal::DynamicArray<u8> m_commands;
+    u32 m_command_count = 0;
+    DrawList m_draw_list;
+};
+
+}  // namespace Rndr::Canvas
@@ -9,6 +9,22 @@
 namespace Rndr::Canvas
 {
 
+/**
+ * Sub-range of a mesh's geometry. Lets many small meshes live in one Mesh, used as a geometry pool,
+ * and be drawn without switching vertex arrays. See Mesh::AddRange().
+ */
+struct MeshRange
+{
+    /** First index to draw. Ignored by non-indexed meshes, which start at base_vertex. */
+    u32 first_index = 0;
+
+    /** Number of indices to draw. For non-indexed meshes, the number of vertices. */
+    u32 index_count = 0;
+
+    /** Value added to every index before fetching a vertex. For non-indexed meshes, the first vertex. */
+    i32 base_vertex = 0;
+};
+
 /**
  * Geometry data paired with its vertex layout. Owns GPU resources (VAO, VBO, IBO).
  * Vertex data stride is validated against the layout at construction.
@@ -52,6 +68,20 @@ public:
      */
     void Append(Opal::ArrayView<const u8> vertex_data, Opal::ArrayView<const u8> index_data);
 
+    /**
+     * Append a sub-mesh to the CPU side buffers, using this mesh as a geometry pool. Unlike Append(),
+     * indices are relative to the sub-mesh's first vertex, so sub-meshes can be added as they are.
+     * The mesh must have been created with enough capacity.
+     * @param vertex_data Vertex data of the sub-mesh. Size must be a multiple of the layout stride.
+     * @param index_data Index data (u32 indices) of the sub-mesh.
+     * @return Range that draws the sub-mesh.
+     * @throw Opal::InvalidArgumentException if the data is empty, malformed or does not fit.
+     */
+    [[nodiscard]] MeshRange AddRange(Opal::ArrayView<const u8> vertex_data, Opal::ArrayView<const u8> index_data);
+
+    /** @return Range covering the whole mesh. */
+    [[nodiscard]] MeshRange GetFullRange() const;
+
     /**
      * Clear CPU side buffer contents.
      */
@@ -64,6 +94,14 @@ public:
     [[nodiscard]] bool HasIndices() const;
     [[nodiscard]] const VertexLayout& GetVertexLayout() const;
 
+    /** @return CPU side copy of the vertex data. */
+    [[nodiscard]] Opal::ArrayView<const u8> GetVertexData() const;
+
+    /** @return CPU side copy of the index data. Empty for non-indexed geometry. */
+    [[nodiscard]] Opal::ArrayView<const u8> GetIndexData() const;
+
+    [[nodiscard]] const Opal::StringUtf8& GetDebugName() const;
+
 private:
     void SetupVAO();
 
@@ -4,6 +4,7 @@
 #include "opal/container/hash-map.h"
 #include "opal/container/in-place-array.h"
 #include "opal/container/ref.h"
+#include "opal/container/scope-ptr.h"
 #include "opal/container/string.h"
 
 #include "rndr/canvas/brush.hpp"
@@ -14,6 +15,7 @@
 #include "rndr/canvas/texture.hpp"
 #include "rndr/colors.hpp"
 #include "rndr/math.hpp"
+#include "rndr/mesh-simplifier.hpp"
 #include "rndr/types.hpp"
 
 namespace Rndr
@@ -26,8 +28,8 @@ class Context;
 
 /**
  * Material description for PBR rendering. Texture pointers are optional; when null the
- * corresponding scalar value is used instead. The renderer computes the material_flags
- * bitmask automatically from which textures are set.
+ * corresponding scalar value is used instead. The renderer picks the shader variant that samples
+ * exactly the textures that are set.
  */
 struct PbrMaterialDesc
 {
@@ -66,6 +68,7 @@ struct PointLight
  */
 struct PbrModel
 {
+    /** Full detail geometry, i.e. LOD 0. PbrRenderer::DrawModel generates the LOD chain the first time a key is drawn. */
     Mesh mesh;
 
     Opal::StringUtf8 material_name;
@@ -85,12 +88,18 @@ struct PbrModel
 };
 
 /**
- * Renders 3D meshes with PBR (physically-based rendering) materials. Uses a single shader
- * with a material_flags uniform to dynamically select which textures to sample, avoiding
- * shader permutations.
+ * Renders 3D meshes with PBR (physically-based rendering) materials. The shader declares which
+ * textures it samples and the draw mode as specialization constants, and every batch draws with
+ * the variant that matches its texture set and the current draw mode, see Shader::GetVariant().
+ * Variants are linked the first time a combination is drawn.
  *
  * Instances sharing the same geometry and texture set are batched into a single instanced
- * draw call via an SSBO.
+ * draw call via an SSBO. Every batch draws with an instance of one base brush that holds the
+ * per-frame uniforms, so batches only own their texture and buffer bindings.
+ *
+ * Generated primitives and models drawn with DrawModel() get a LOD chain, see GenerateMeshLods(). Each instance
+ * draws the coarsest LOD whose error stays within SetLodErrorThreshold() pixels at its projected
+ * bounding sphere size, and a batch issues one instanced draw per LOD in use.
  *
  * Usage:
  * @code
@@ -122,12 +131,18 @@ public:
     /** Reset per-frame state (draw entries, lights). Call at the start of each frame. */
     void BeginFrame();
 
-    /** Set the combined view-projection matrix for this frame. */
+    /** Set the combined view-projection matrix for this frame. Set it before drawing, LOD selection uses it. */
     void SetViewProjection(const Matrix4x4f& view_projection);
 
     /** Set the camera position in world space (needed for specular lighting). */
     void SetCameraPosition(const Point3f& camera_position);
 
+    /**
+     * Set the largest error, in pixels, that LOD selection may introduce. 0 only allows LODs
+     * without error. Defaults to 1 pixel.
+     */
+    void SetLodErrorThreshold(f32 max_pixel_error);
+
     void AddDirectionalLight(const Vector3f& direction, const Vector4f& color);
     void AddPointLight(const Point3f& position, const Vector4f& color);
 
@@ -161,7 +176,8 @@ public:
     void DrawMesh(const Opal::StringUtf8& key, const Mesh& mesh, const Matrix4x4f& transform, const PbrMaterialDesc& material);
 
     /**
-     * Load a 3D model from a file using assimp and load its textures.
+     * Load a 3D model from a file using assimp and load its textures. The mesh is optimized with
+     * OptimizeMesh() and holds the full detail geometry only.
      * @param file_path Path to the model file (e.g., .gltf, .obj).
      * @param texture_desc Texture sampling parameters for loaded textures.
      * @param flip_vertically If true, flip textures vertically when loading.
@@ -171,7 +187,8 @@ public:
     PbrModel LoadModel(const Opal::StringUtf8& file_path, const TextureDesc& texture_desc = {}, bool flip_vertically = false);
 
     /**
-     * Draw a previously loaded model.
+     * Draw a previously loaded model. The first draw of a key generates the model's LOD chain and
+     * keeps the geometry with every LOD under that key.
      * @param key Unique string identifying this geometry (for caching).
      * @param model The loaded model.
      * @param transform Model transform.
@@ -192,6 +209,16 @@ private:
     static constexpr u32 k_flag_ambient_occlusion_texture = 1 << 4;
     static constexpr u32 k_flag_opacity_texture = 1 << 5;
 
+    /** Texture flag i is the specialization constant with id i, the draw mode follows them. */
+    static constexpr u32 k_texture_slot_count = 6;
+    static constexpr u32 k_draw_mode_constant_id = k_texture_slot_count;
+    static constexpr u32 k_permutation_key_count = k_texture_slot_count + 1;
+
+    static constexpr u32 k_draw_mode_lit = 0;
+    static constexpr u32 k_draw_mode_unlit = 1;
+    static constexpr u32 k_draw_mode_normals = 2;
+    static constexpr u32 k_draw_mode_count = 3;
+
     struct InstanceData
     {
         Matrix4x4f model_transform;
@@ -219,18 +246,41 @@ private:
 
     friend struct Opal::Hasher<BatchKey>;
 
+    /** Per-frame uniforms resolved once from the shader reflection. */
+    struct UniformHandles
+    {
+        UniformHandle view_projection;
+        UniformHandle camera_position;
+        UniformHandle directional_light_count;
+        UniformHandle directional_light_directions;
+        UniformHandle directional_light_colors;
+        UniformHandle point_light_count;
+        UniformHandle point_light_positions;
+        UniformHandle point_light_colors;
+    };
+
     struct BatchData
     {
+        /** Instances of each LOD of lod_chain, or a single list if the geometry has no LODs. */
+        Opal::DynamicArray<Opal::DynamicArray<InstanceData>> lod_instances;
+        /** Instances of all LODs packed one LOD after another, as uploaded to instance_buffer. */
         Opal::DynamicArray<InstanceData> instances;
+        MeshLodChain lod_chain;
+        /** Instance of m_base_brush. */
         Brush brush;
+        /** Selects the shader variant, the same for every instance since it only depends on the textures. */
+        u32 material_flags = 0;
         Buffer instance_buffer;
     };
 
     static u32 ComputeMaterialFlags(const PbrMaterialDesc& material);
+    [[nodiscard]] u32 GetDrawMode() const;
+    [[nodiscard]] const Shader& GetShaderVariant(u32 material_flags, u32 draw_mode) const;
     InstanceData MakeInstanceData(const Matrix4x4f& transform, const PbrMaterialDesc& material);
     void EnsureGeometry(const Opal::StringUtf8& key, const Opal::ArrayView<const u8>& vertex_data,
                         const Opal::ArrayView<const u8>& index_data);
     void AddDrawEntry(const Opal::StringUtf8& geometry_key, const Matrix4x4f& transform, const PbrMaterialDesc& material);
+    [[nodiscard]] u32 SelectLod(const MeshLodChain& lod_chain, const Matrix4x4f& transform) const;
     void BindTextures(Brush& brush, const BatchKey& key);
 
     static void GenerateCube(Opal::DynamicArray<u8>& out_vertex_data, Opal::DynamicArray<u8>& out_index_data, f32 u_tiling, f32 v_tiling);
@@ -239,18 +289,25 @@ private:
 
     Opal::Ref<Context> m_context;
     Shader m_shader;
+    UniformHandles m_uniforms;
+
+    /** Parent of all batch brushes. Heap allocated so its address survives moves of the renderer. */
+    Opal::ScopePtr<Brush> m_base_brush;
     Texture m_dummy_texture;
     u32 m_draw_flags = 0;
+    f32 m_lod_error_threshold = 1.0f;
 
     Matrix4x4f m_view_projection;
     Point3f m_camera_position;
     Opal::DynamicArray<DirectionalLight> m_directional_lights;
     Opal::DynamicArray<PointLight> m_point_lights;
 
-    /** Owned procedural geometry (cubes, spheres) generated on demand. */
+    /** Owned geometry generated on demand: cubes, spheres and the LOD chains of drawn models. */
     Opal::HashMap<Opal::StringUtf8, Mesh> m_geometry_cache;
     /** Non-owning references to externally-supplied meshes registered via DrawMesh. */
     Opal::HashMap<Opal::StringUtf8, Opal::Ref<const Mesh>> m_external_geometry;
+    /** LOD chains by geometry key. Geometry without one, like meshes passed to DrawMesh, is drawn whole. */
+    Opal::HashMap<Opal::StringUtf8, MeshLodChain> m_geometry_lods;
     Opal::HashMap<BatchKey, BatchData> m_batches;
 };
 
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "opal/container/dynamic-array.h"
+#include "opal/container/scope-ptr.h"
+#include "opal/container/string.h"
+
+#include "rndr/canvas/shader.hpp"
+#include "rndr/file.hpp"
+#include "rndr/types.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace Rndr
+{
+namespace Canvas
+{
+
+/** Shader source files loaded through a ShaderRegistry. */
+struct ShaderFileDesc
+{
+    /** Directory that the source paths are relative to. */
+    Opal::StringUtf8 ref_path;
+
+    /** Slang file of a single-source shader, or the vertex file of a two-source shader. */
+    Opal::StringUtf8 vertex_path;
+
+    /** Fragment file of a two-source shader. Leave empty for single-source shaders. */
+    Opal::StringUtf8 fragment_path;
+
+    Opal::StringUtf8 debug_name;
+};
+
+struct ShaderRegistryDesc
+{
+    /** How often the background thread checks the watched files for changes, in milliseconds. */
+    u32 poll_interval_ms = 250;
+};
+
+/**
+ * Owns shaders loaded from files and rebuilds them when their files change. Sources are read with
+ * File::ReadShader, which expands includes and records every file a shader depends on. Files are
+ * read through a ShaderFileCache shared by all shaders of the registry, so a recompile only reads
+ * the files that changed. A background thread polls the modification times of those files, and
+ * only the shaders that depend on a changed file are recompiled, also on the background thread.
+ *
+ * GL objects can only be touched on the Context thread, so a recompiled shader is swapped in by
+ * Update(). The swap replaces the program of the existing Shader object and relinks its variants
+ * in place, so brushes keep pointing to them and pick the new programs up on their next draw.
+ * Brushes recreate their uniform slots only if the uniform layout changed, see Brush. A shader
+ * that fails to recompile keeps its last good program and the error is logged.
+ *
+ * The registry must be created and used on the Context thread and destroyed before the Context.
+ */
+class ShaderRegistry
+{
+public:
+    explicit ShaderRegistry(const ShaderRegistryDesc& desc = {});
+    ~ShaderRegistry();
+
+    ShaderRegistry(const ShaderRegistry&) = delete;
+    ShaderRegistry& operator=(const ShaderRegistry&) = delete;
+    ShaderRegistry(ShaderRegistry&&) = delete;
+    ShaderRegistry& operator=(ShaderRegistry&&) = delete;
+
+    /**
+     * Load a shader and start watching its files.
+     * @param desc Source files of the shader.
+     * @return Shader owned by the registry. The reference stays valid for the lifetime of the registry.
+     * @throw Opal::InvalidArgumentException if a source file can't be read.
+     * @throw GraphicsAPIException if the shader fails to compile.
+     */
+    const Shader& Load(const ShaderFileDesc& desc);
+
+    /**
+     * Swap in the shaders that were recompiled since the last call. Call once per frame on the
+     * Context thread, outside of any draw list recording that uses the shaders.
+     * @return Number of shaders that were swapped.
+     */
+    u32 Update();
+
+    /**
+     * @param shader Shader returned by Load().
+     * @return Paths of all files the shader was built from, including the files it includes. Empty
+     *         if the shader is not owned by this registry.
+     */
+    [[nodiscard]] Opal::DynamicArray<Opal::StringUtf8> GetDependencies(const Shader& shader) const;
+
+    /** @return Number of shaders owned by the registry. */
+    [[nodiscard]] u64 GetShaderCount() const;
+
+    /** @return Counters of the cache that the registry reads shader files through. */
+    [[nodiscard]] ShaderFileCacheStats GetFileCacheStats() const;
+
+private:
+    struct Entry;
+    struct PendingReload;
+
+    struct WatchedFile
+    {
+        Opal::StringUtf8 path;
+
+        /** Modification time as seen by the last poll. Zero if the file does not exist. */
+        i64 last_write_time = 0;
+    };
+
+    void WatchLoop();
+
+    /** Add the files of an entry to m_files. Call with m_mutex locked. */
+    void WatchDependencies(const Opal::DynamicArray<Opal::StringUtf8>& dependencies);
+
+    ShaderRegistryDesc m_desc;
+    ShaderFileCache m_file_cache;
+    Opal::DynamicArray<Opal::ScopePtr<Entry>> m_entries;
+    Opal::DynamicArray<WatchedFile> m_files;
+    Opal::DynamicArray<Opal::ScopePtr<PendingReload>> m_pending_reloads;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_stop_condition;
+    bool m_stop = false;
+    std::thread m_watch_thread;
+};
+
+}  // namespace Canvas
+}  // namespace Rndr
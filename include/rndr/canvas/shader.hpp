@@ -1,5 +1,6 @@
 #pragma once
 
+#include "opal/container/array-view.h"
 #include "opal/container/dynamic-array.h"
 #include "opal/container/string.h"
 
@@ -17,6 +18,75 @@ using NumThreads = Rndr::NumThreads;
 using ParameterCategory = Rndr::ParameterCategory;
 using ShaderParameter = Rndr::ShaderParameter;
 
+/**
+ * A uniform buffer binding point of a shader. One block exists for each unique binding point that
+ * has uniform fields, in the order the fields first appear in the reflection data.
+ */
+struct UniformBlock
+{
+    i32 binding_index = -1;
+    i32 binding_space = 0;
+
+    /** Size in bytes covered by the uniform fields of the block. */
+    i32 size = 0;
+};
+
+/**
+ * Location of a uniform inside the uniform blocks of a shader, resolved once from reflection with
+ * Shader::GetUniformHandle(). Writing through a handle with Brush::SetUniform() skips the name
+ * lookup. A handle can be used with any brush that uses the shader it was resolved from.
+ */
+struct UniformHandle
+{
+    /** Index into Shader::GetUniformBlocks() and Brush::GetUniformBufferSlots(). -1 if not resolved. */
+    i32 block_index = -1;
+
+    /** Byte offset of the uniform inside its block. */
+    i32 offset = 0;
+
+    /** Size of the uniform in bytes. */
+    i32 size = 0;
+
+    /** Number of array elements. 0 if the uniform is not an array. */
+    i32 array_element_count = 0;
+
+    /** Byte distance between array elements. 0 if the uniform is not an array. */
+    i32 array_stride = 0;
+
+    [[nodiscard]] bool IsValid() const { return block_index >= 0; }
+};
+
+namespace Impl
+{
+struct CompiledShader;
+}
+
+/** Sources of one shader created with Shader::FromSourcesBatch. */
+struct ShaderSourceDesc
+{
+    /** Slang source of a single-source shader, or the vertex source of a two-source shader. */
+    Opal::StringUtf8 vertex_source;
+
+    /** Fragment source of a two-source shader. Leave empty for single-source shaders. */
+    Opal::StringUtf8 fragment_source;
+
+    Opal::StringUtf8 debug_name;
+};
+
+/**
+ * A key that selects between variants of a shader. Each key is a specialization constant declared
+ * in Slang with `[vk::constant_id(N)]`. Boolean keys have two values, enum keys have one value per
+ * enumerator. See Shader::GetVariant().
+ */
+struct PermutationKey
+{
+    /** The N of [vk::constant_id(N)] in the shader source. */
+    u32 constant_id = 0;
+
+    /** Number of values the key can take. Valid values are 0 to value_count - 1. */
+    u32 value_count = 2;
+};
+
 /**
  * A compiled GPU shader program. Slang source is compiled to SPIR-V and linked into an OpenGL
  * program.
@@ -28,6 +98,13 @@ using ShaderParameter = Rndr::ShaderParameter;
  * [shader("compute")] annotations. Single-source factory methods auto-detect whether the source
  * is a graphics shader (exactly one vertex + one fragment entry point) or a compute shader
  * (exactly one compute entry point). Two-source factory methods are graphics-only.
+ *
+ * ## Variants
+ *
+ * A shader that declares specialization constants can produce specialized variants. Declare the
+ * constants that act as keys with SetPermutationKeys() and request a variant with GetVariant().
+ * Each variant is its own GL program linked from the same SPIR-V, specialized with the key values,
+ * so the driver removes the branches that depend on them. Slang runs once for all variants.
  */
 class Shader
 {
@@ -68,6 +145,28 @@ public:
      */
     [[nodiscard]] static Shader FromSourcesInMemory(const Opal::StringUtf8& vertex_source, const Opal::StringUtf8& fragment_source, Opal::StringUtf8 debug_name = "");
 
+    /**
+     * Create a shader program from the precompiled shader archive of the Context, see
+     * ContextDesc::shader_archive_path. The Slang compiler is not invoked.
+     * @param name Name of the shader in the archive, its path relative to the archived directory.
+     * @param debug_name Name used for debug. Defaults to the archive name.
+     * @return A valid Shader object.
+     * @throw Opal::InvalidArgumentException if the Context has no archive or the archive has no such shader.
+     */
+    [[nodiscard]] static Shader FromArchive(const Opal::StringUtf8& name, Opal::StringUtf8 debug_name = "");
+
+    /**
+     * Create many shader programs at once. Slang compilation, including shader cache lookups, runs
+     * concurrently on worker threads. Linking of the GL programs happens on the calling thread,
+     * which must be the Context thread. If any shader fails to compile, no program is created and
+     * the error of the first failing shader is rethrown.
+     * @param descs Sources of the shaders. Single-source entries can be graphics or compute shaders.
+     * @param max_threads Maximum number of compile threads. Zero uses one thread per hardware thread.
+     * @return One shader per desc, in the order of the descs.
+     */
+    [[nodiscard]] static Opal::DynamicArray<Shader> FromSourcesBatch(const Opal::DynamicArray<ShaderSourceDesc>& descs,
+                                                                     u32 max_threads = 0);
+
     Shader() = default;
     ~Shader();
 
@@ -102,13 +201,105 @@ public:
      */
     [[nodiscard]] const ShaderParameter* FindParameter(const Opal::StringUtf8& name) const;
 
+    /** @return Uniform buffer binding points that hold uniform fields. Brush creates one UniformBufferSlot per block. */
+    [[nodiscard]] const Opal::DynamicArray<UniformBlock>& GetUniformBlocks() const;
+
+    /**
+     * Resolve a uniform to a handle. Do this once, for example after creating the shader, and use
+     * the handle for per-frame writes.
+     * @param name Uniform name as declared in the shader.
+     * @return Resolved handle, or an invalid handle if the shader has no uniform with that name.
+     */
+    [[nodiscard]] UniformHandle GetUniformHandle(const Opal::StringUtf8& name) const;
+
+    /**
+     * @return Hash of the uniform fields of all uniform blocks: their names, bindings, offsets and
+     *         sizes. Stays the same when a shader is rebuilt without changing its uniform layout.
+     */
+    [[nodiscard]] u64 GetUniformLayoutHash() const;
+
+    /** @return Specialization constants declared by the shader stages. */
+    [[nodiscard]] const Opal::DynamicArray<SpecializationConstant>& GetSpecializationConstants() const;
+
+    /**
+     * Declare the specialization constants that select the variants of this shader. Destroys all
+     * existing variants.
+     * @param keys Keys in the order their values are passed to GetVariant().
+     * @throw Opal::InvalidArgumentException if a key does not name a specialization constant of the
+     *        shader, has fewer than two values, or the keys have more than 2^64 combinations.
+     */
+    void SetPermutationKeys(const Opal::DynamicArray<PermutationKey>& keys);
+
+    /** @return Keys declared with SetPermutationKeys(). */
+    [[nodiscard]] Opal::ArrayView<const PermutationKey> GetPermutationKeys() const;
+
+    /**
+     * Get the variant of this shader specialized with the given key values. The first request for
+     * a combination links a new GL program, later requests return the cached variant. Must be
+     * called on the Context thread.
+     *
+     * A variant has the same reflection data and uniform layout as this shader, so a brush can
+     * switch to it with Brush::SetShaderVariant(). Variants are owned by this shader and are
+     * destroyed with it or when the keys change. Clone() of a variant returns an unspecialized shader.
+     *
+     * @param values One value per permutation key, in the order of the keys.
+     * @return Specialized variant, or this shader if it has no permutation keys.
+     * @throw Opal::InvalidArgumentException if the number of values does not match the keys or a
+     *        value is out of range.
+     * @throw GraphicsAPIException if the variant fails to link.
+     */
+    [[nodiscard]] const Shader& GetVariant(Opal::ArrayView<const u32> values) const;
+
+    /** @return Number of variants linked so far. */
+    [[nodiscard]] u64 GetVariantCount() const;
+
+    /** @return Shader this variant was requested from with GetVariant(), or nullptr if this shader is not a variant. */
+    [[nodiscard]] const Shader* GetVariantParent() const;
+
+    /** @return Key values this variant was specialized with. Empty if this shader is not a variant. */
+    [[nodiscard]] Opal::ArrayView<const u32> GetVariantValues() const;
+
     /** @return Vertex layout inferred from shader reflection. Empty for compute shaders. */
     [[nodiscard]] const VertexLayout& GetVertexLayout() const;
 
     /** @return Compute shader thread group size. All zeros for non-compute shaders. */
     [[nodiscard]] const NumThreads& GetNumThreads() const;
 
+    /** @return Slang source the shader was built from. For two-source shaders this is the vertex source. */
+    [[nodiscard]] const Opal::StringUtf8& GetVertexSource() const;
+
+    /** @return Fragment source of a two-source shader. Empty for single-source shaders. */
+    [[nodiscard]] const Opal::StringUtf8& GetFragmentSource() const;
+
+    [[nodiscard]] const Opal::StringUtf8& GetDebugName() const;
+
 private:
+    friend class ShaderRegistry;
+
+    struct VariantData;
+
+    /** Link the GL program of compiled shader stages and take over its reflection data. */
+    [[nodiscard]] static Shader FromCompiled(Impl::CompiledShader& compiled, const Opal::StringUtf8& vertex_source,
+                                             const Opal::StringUtf8& fragment_source, Opal::StringUtf8 debug_name);
+
+    /** Collect m_uniform_blocks and m_uniform_layout_hash from m_parameters. */
+    void BuildUniformBlocks();
+
+    /** @return Key values packed into one number, used to look up variants. */
+    [[nodiscard]] u64 PackVariantKey(Opal::ArrayView<const u32> values) const;
+
+    /** Link a new variant with the given key values. */
+    [[nodiscard]] Shader LinkVariant(Opal::ArrayView<const u32> values) const;
+
+    /** Point the parent of every variant at this shader, after it moved. */
+    void UpdateVariantParents();
+
+    /**
+     * Take over the program of a rebuilt shader. Permutation keys carry over and existing variants
+     * are relinked in place, so pointers to them stay valid. If relinking fails nothing changes.
+     */
+    void Reload(Shader&& rebuilt);
+
     /** OpenGL program handle. 0 means invalid. */
     u32 m_program = 0;
 
@@ -126,11 +317,26 @@ private:
     /** Merged reflection data from all stages. See ShaderParameter for layout conventions. */
     Opal::DynamicArray<ShaderParameter> m_parameters;
 
+    /** Uniform buffer binding points derived from m_parameters. */
+    Opal::DynamicArray<UniformBlock> m_uniform_blocks;
+
+    /** Hash of the uniform fields in m_parameters. See GetUniformLayoutHash(). */
+    u64 m_uniform_layout_hash = 0;
+
     /** Vertex input layout inferred from reflection. Empty for compute shaders. */
     VertexLayout m_vertex_layout;
 
     /** Compute thread group size. All zeros for non-compute shaders. */
     NumThreads m_num_threads;
+
+    Opal::DynamicArray<SpecializationConstant> m_specialization_constants;
+
+    /** SPIR-V, keys and linked variants. Only allocated for shaders with specialization constants. */
+    VariantData* m_variant_data = nullptr;
+
+    /** Shader that owns this variant, kept up to date when the parent moves. Null for non-variants. */
+    const Shader* m_variant_parent = nullptr;
+    Opal::DynamicArray<u32> m_variant_values;
 };
 
 }  // namespace Canvas
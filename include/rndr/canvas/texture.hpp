@@ -1,6 +1,7 @@
 #pragma once
 
 #include "opal/container/array-view.h"
+#include "opal/container/dynamic-array.h"
 #include "opal/container/string.h"
 
 #include "rndr/canvas/context.hpp"
@@ -172,6 +173,14 @@ public:
      */
     void Update(const Opal::ArrayView<const u8>& data) const;
 
+    /**
+     * Read back the pixels of the first mip level. Layers and cube faces are stored one after
+     * another, in the same layout the constructor accepts as initial data.
+     * @return Pixel data, or an empty array for multi-sample textures.
+     * @throw Rndr::GraphicsAPIException if the texture is invalid.
+     */
+    [[nodiscard]] Opal::DynamicArray<u8> ReadData() const;
+
     [[nodiscard]] bool IsValid() const;
     [[nodiscard]] const TextureDesc& GetDesc() const;
     [[nodiscard]] const Opal::StringUtf8& GetName() const;
@@ -54,6 +54,15 @@ enum class ParameterCategory : u8
     EnumCount,
 };
 
+/** Scalar type of vertex input attributes and uniform fields. */
+enum class ScalarType : u8
+{
+    Unknown,
+    Float32,
+    Int32,
+    UInt32,
+};
+
 /**
  * A single shader parameter extracted from Slang reflection. Parameters are organized as follows:
  *
@@ -101,14 +110,22 @@ struct ShaderParameter
 
     /** What kind of resource this parameter represents. */
     ParameterCategory category = ParameterCategory::EnumCount;
-};
 
-/** Scalar type for vertex input attributes. */
-enum class ScalarType : u8
-{
-    Unknown,
-    Float32,
-    Int32,
+    /**
+     * True if the shader can write to the resource (e.g. RWStructuredBuffer), false if it is read
+     * only (e.g. StructuredBuffer). Only meaningful for StorageBuffer params.
+     */
+    bool writable = false;
+
+    /** Scalar type of a Uniform field with size > 0. Unknown for structs, bools and other types. */
+    ScalarType scalar_type = ScalarType::Unknown;
+
+    /**
+     * Rows and columns of a numeric Uniform field: 1x1 for scalars, 1xN for vectors, RxC for
+     * matrices. Arrays describe their element type. Zero if scalar_type is Unknown.
+     */
+    u8 row_count = 0;
+    u8 column_count = 0;
 };
 
 /**
@@ -134,6 +151,23 @@ struct EntryPointInfo
     ShaderStage stage = ShaderStage::Unknown;
 };
 
+/**
+ * A specialization constant of a compiled entry point, declared in Slang with
+ * `[vk::constant_id(N)] const bool k_name = false;`. Specializing a constant lets the driver fold
+ * the branches that depend on it, so one SPIR-V module can produce several optimized variants.
+ */
+struct SpecializationConstant
+{
+    /** Name as declared in the shader source. Empty if the compiler did not emit a name. */
+    Opal::StringUtf8 name;
+
+    /** The N of [vk::constant_id(N)]. */
+    u32 constant_id = 0;
+
+    /** Value used when the constant is not specialized. Booleans are 0 or 1. */
+    u32 default_value = 0;
+};
+
 /** Result of compiling a single entry point. */
 struct CompileResult
 {
@@ -151,12 +185,31 @@ struct CompileResult
 
     /** Compute thread group size. Only populated for compute stage entry points. */
     NumThreads num_threads;
+
+    /** Specialization constants used by the entry point. */
+    Opal::DynamicArray<SpecializationConstant> specialization_constants;
+};
+
+/** One entry point to compile with ShaderCompiler::CompileBatch. */
+struct CompileRequest
+{
+    /** Slang source code of the module containing the entry point. */
+    Opal::StringUtf8 source;
+
+    /** Name of the entry point to compile. */
+    Opal::StringUtf8 entry_point;
 };
 
 /**
  * Compiles Slang shader source to SPIR-V and extracts reflection data. This is the shared
  * compilation layer used by both Canvas (OpenGL) and Forge (Vulkan) APIs.
  *
+ * Each compiler checks out a Slang global session and a compile session created from it from a
+ * process-wide pool when it loads a module, and returns them when it is destroyed. Returned
+ * sessions are reused, so only the first compilers pay for creating a global session. No two live
+ * compilers share a global session, so different compilers can be used from different threads at
+ * the same time; a single compiler must not be used from two threads at once.
+ *
  * Usage:
  * @code
  *   ShaderCompiler compiler;
@@ -179,7 +232,7 @@ public:
     ShaderCompiler(ShaderCompiler&& other) noexcept;
     ShaderCompiler& operator=(ShaderCompiler&& other) noexcept;
 
-    /** Load a Slang module from source code in memory. */
+    /** Load a Slang module from source code in memory. Replaces the previously loaded module. */
     void LoadModule(const Opal::StringUtf8& source);
 
     /** Discover all annotated entry points in the loaded module. */
@@ -188,6 +241,21 @@ public:
     /** Compile a specific entry point to SPIR-V and extract reflection data. */
     [[nodiscard]] CompileResult CompileEntryPoint(const Opal::StringUtf8& entry_point) const;
 
+    /**
+     * Compile many entry points concurrently. Every request is compiled by its own compiler, with its
+     * own Slang global session, on a worker thread, and the results are returned in submission order.
+     * Batches can run on several threads at once. If any request fails, the error of the first
+     * failing request is rethrown once all requests finished.
+     * @param requests Sources and entry points to compile.
+     * @param max_threads Maximum number of threads to use. Zero uses one thread per hardware thread.
+     * @return One result per request, in the order of the requests.
+     */
+    [[nodiscard]] static Opal::DynamicArray<CompileResult> CompileBatch(const Opal::DynamicArray<CompileRequest>& requests,
+                                                                        u32 max_threads = 0);
+
+    /** @return Build tag of the Slang compiler. Compiled output is only reproducible with the same version. */
+    [[nodiscard]] static Opal::StringUtf8 GetCompilerVersion();
+
     /** Find exactly one entry point of the given stage. Throws if 0 or >1 found. */
     [[nodiscard]] static Opal::StringUtf8 FindSingleEntryPoint(const Opal::DynamicArray<EntryPointInfo>& entries,
                                                                 ShaderStage target_stage, const char* stage_name);
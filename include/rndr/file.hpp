@@ -1,8 +1,10 @@
 #pragma once
 
 #include <cstdio>
+#include <mutex>
 
 #include "opal/container/dynamic-array.h"
+#include "opal/container/hash-map.h"
 #include "opal/container/string.h"
 
 #include "rndr/bitmap.hpp"
@@ -36,6 +38,55 @@ private:
     struct _iobuf* m_file_handle = 0;
 };
 
+/** Counters of a ShaderFileCache. */
+struct ShaderFileCacheStats
+{
+    /** Number of requests served from memory. */
+    u64 hits = 0;
+
+    /** Number of times a file was read from disk because it was new or its modification time changed. */
+    u64 reads = 0;
+};
+
+/**
+ * Memoizes the files read by File::ReadShader. A file is read from disk the first time it is
+ * requested and afterwards only when its modification time changes, so include files shared by
+ * many shaders are read once. Thread safe.
+ */
+class ShaderFileCache
+{
+public:
+    /**
+     * @param file_path Absolute or relative path to the file on the disc.
+     * @param out_contents Receives the contents of the file without the UTF-8 BOM. An empty file gives an empty string.
+     * @return False if the file does not exist.
+     */
+    [[nodiscard]] bool GetContents(const Opal::StringUtf8& file_path, Opal::StringUtf8& out_contents);
+
+    /**
+     * @param file_path Path as passed to GetContents().
+     * @return Modification time read before the cached contents of the file, or zero if the file is not cached. A change
+     * made while the file was being read shows up as a newer time on disk.
+     */
+    [[nodiscard]] i64 GetLastWriteTime(const Opal::StringUtf8& file_path) const;
+
+    /** Forget all files, the next request of each file reads it from disk. */
+    void Clear();
+
+    [[nodiscard]] ShaderFileCacheStats GetStats() const;
+
+private:
+    struct Entry
+    {
+        i64 last_write_time = 0;
+        Opal::StringUtf8 contents;
+    };
+
+    Opal::HashMap<Opal::StringUtf8, Entry> m_entries;
+    mutable std::mutex m_mutex;
+    ShaderFileCacheStats m_stats;
+};
+
 namespace File
 {
 
@@ -57,16 +108,31 @@ namespace File
  */
 [[nodiscard]] Opal::StringUtf8 ReadEntireTextFile(const Opal::StringUtf8& file_path);
 
+/**
+ * @param file_path Absolute or relative path to the file on the disc.
+ * @return Modification time of the file in an unspecified unit, or zero if it does not exist. Only meant to be compared with
+ * other values returned by this function.
+ */
+[[nodiscard]] i64 GetLastWriteTime(const Opal::StringUtf8& file_path);
+
 /**
  * Reads the contents of the text file that contains a shader. The function will also resolve the includes
- * in the shader file.
+ * in the shader file. Includes are expanded in a single pass over each file and every file is expanded at
+ * most once, so a file included again, directly or through an include cycle, is skipped as if it had an
+ * include guard.
  *
  * @param ref_path Reference path compared to which both shader_path and include paths will be resolved.
  * @param shader_path Path relative to the ref_path to the shader file.
+ * @param out_dependencies If not nullptr, receives the paths of the shader file and of every file it includes,
+ * directly or indirectly. Each path is added once.
+ * @param cache If not nullptr, files are read through this cache, so repeated calls only read files that
+ * changed. Otherwise each file is read at most once per call.
  *
  * @return Returns a valid String object containing the text representing the shader contents. Returns empty string in case of an error.
  */
-[[nodiscard]] Opal::StringUtf8 ReadShader(const Opal::StringUtf8& ref_path, const Opal::StringUtf8& shader_path);
+[[nodiscard]] Opal::StringUtf8 ReadShader(const Opal::StringUtf8& ref_path, const Opal::StringUtf8& shader_path,
+                                          Opal::DynamicArray<Opal::StringUtf8>* out_dependencies = nullptr,
+                                          ShaderFileCache* cache = nullptr);
 
 /**
  * Prints the shader contents to the console.
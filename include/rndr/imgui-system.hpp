@@ -10,6 +10,13 @@ namespace Rndr
 
 class Application;
 
+#if RNDR_CANVAS
+namespace Canvas
+{
+struct DrawListStats;
+}
+#endif
+
 struct ImGuiContextDesc : Opal::ClonableBase<ImGuiContextDesc>
 {
     bool enable_keyboard_navigation = true;
@@ -32,6 +39,16 @@ public:
     void StartFrame();
     void EndFrame();
 
+#if RNDR_CANVAS
+    /**
+     * Show the stats of a DrawList execution in an ImGui window. Call between StartFrame() and
+     * EndFrame().
+     * @param stats Stats to show, usually DrawList::GetStats().
+     * @param title Window title. Lists sharing a title share a window.
+     */
+    void ShowDrawListStats(const Canvas::DrawListStats& stats, const char* title = "Draw List Stats");
+#endif
+
     bool OnWindowClose(GenericWindow&) override { return false; }
     void OnWindowSizeChanged(const GenericWindow& window, i32 width, i32 height) override;
     bool OnButtonDown(const GenericWindow& window, InputPrimitive key_code, bool is_repeated) override;
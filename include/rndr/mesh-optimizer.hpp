@@ -0,0 +1,115 @@
+#pragma once
+
+#include "opal/container/array-view.h"
+#include "opal/container/dynamic-array.h"
+
+#include "rndr/types.hpp"
+
+namespace Rndr
+{
+
+/** FIFO cache size used to report vertex cache statistics. Matches common desktop GPUs. */
+constexpr u32 k_default_vertex_cache_size = 16;
+
+/** Post-transform vertex cache efficiency of an index buffer. */
+struct VertexCacheStats
+{
+    /** Vertex shader invocations. */
+    u64 transformed_vertex_count = 0;
+
+    /** Average cache miss ratio, transformed vertices per triangle. 0.5 is ideal for large grids, 3 is the worst case. */
+    f32 acmr = 0.0f;
+
+    /** Average transformed vertex ratio, transformed vertices per referenced vertex. 1 is ideal. */
+    f32 atvr = 0.0f;
+};
+
+/** Overdraw of a mesh, measured by rasterizing it from the six axis directions with back face culling. */
+struct OverdrawStats
+{
+    /** Pixels covered by at least one triangle. */
+    u64 covered_pixel_count = 0;
+
+    /** Pixels that passed the depth test, each of them is a fragment shader invocation. */
+    u64 shaded_pixel_count = 0;
+
+    /** Shaded pixels per covered pixel. 1 means no overdraw. */
+    f32 overdraw_ratio = 0.0f;
+};
+
+/** Vertex memory traffic of an index buffer, measured with a small cache of 64 byte lines. */
+struct VertexFetchStats
+{
+    u64 fetched_byte_count = 0;
+
+    /** Fetched bytes per byte of referenced vertex data. 1 means each vertex is read once. */
+    f32 overfetch_ratio = 0.0f;
+};
+
+/**
+ * Reorder triangles to reuse the post-transform vertex cache, using Forsyth's linear-speed
+ * algorithm. The winding of each triangle is kept.
+ * @param indices Triangle list to reorder in place.
+ * @param vertex_count Number of vertices the indices point into.
+ */
+void OptimizeVertexCache(Opal::ArrayView<u32> indices, u32 vertex_count);
+
+/**
+ * Reorder clusters of triangles so that outward facing clusters are drawn first and occlude the
+ * rest. Run after OptimizeVertexCache: clusters are cut where the cache order allows it, so the
+ * ACMR grows by at most the threshold.
+ * @param indices Cache optimized triangle list to reorder in place.
+ * @param vertex_data Vertices with a float3 position at the start of each vertex.
+ * @param vertex_stride Size of a vertex in bytes.
+ * @param threshold Allowed ACMR growth. 1.05 allows 5% more vertex shader invocations.
+ */
+void OptimizeOverdraw(Opal::ArrayView<u32> indices, Opal::ArrayView<const u8> vertex_data, u32 vertex_stride, f32 threshold = 1.05f);
+
+/**
+ * Lay vertices out in the order the index buffer first uses them and remap the indices, so vertex
+ * fetches walk memory linearly. Unreferenced vertices are moved past the returned count.
+ * @param vertex_data Interleaved vertices to reorder in place.
+ * @param vertex_stride Size of a vertex in bytes.
+ * @param indices Triangle list to remap in place.
+ * @return Number of referenced vertices, which now come first.
+ */
+u32 OptimizeVertexFetch(Opal::ArrayView<u8> vertex_data, u32 vertex_stride, Opal::ArrayView<u32> indices);
+
+/**
+ * Run OptimizeVertexCache, OptimizeOverdraw and OptimizeVertexFetch and drop unreferenced
+ * vertices from vertex_data.
+ * @param vertex_data Interleaved vertices with a float3 position at the start of each vertex.
+ * @param vertex_stride Size of a vertex in bytes.
+ * @param indices Triangle list into vertex_data.
+ * @param overdraw_threshold Allowed ACMR growth of OptimizeOverdraw.
+ * @return New number of vertices.
+ */
+u32 OptimizeMesh(Opal::DynamicArray<u8>& vertex_data, u32 vertex_stride, Opal::ArrayView<u32> indices, f32 overdraw_threshold = 1.05f);
+
+/**
+ * Simulate a FIFO post-transform cache.
+ * @param indices Triangle list.
+ * @param vertex_count Number of vertices the indices point into.
+ * @param cache_size Number of cache entries.
+ */
+[[nodiscard]] VertexCacheStats AnalyzeVertexCache(Opal::ArrayView<const u32> indices, u32 vertex_count,
+                                                  u32 cache_size = k_default_vertex_cache_size);
+
+/**
+ * Rasterize the mesh from the six axis directions at a fixed resolution with an early depth test
+ * and count how often covered pixels are shaded. Counter-clockwise triangles are front facing.
+ * @param indices Triangle list.
+ * @param vertex_data Vertices with a float3 position at the start of each vertex.
+ * @param vertex_stride Size of a vertex in bytes.
+ */
+[[nodiscard]] OverdrawStats AnalyzeOverdraw(Opal::ArrayView<const u32> indices, Opal::ArrayView<const u8> vertex_data, u32 vertex_stride);
+
+/**
+ * Count the vertex bytes fetched for the vertices that miss the post-transform cache.
+ * @param indices Triangle list.
+ * @param vertex_count Number of vertices the indices point into.
+ * @param vertex_stride Size of a vertex in bytes.
+ */
+[[nodiscard]] VertexFetchStats AnalyzeVertexFetch(Opal::ArrayView<const u32> indices, u32 vertex_count, u32 vertex_stride);
+
+}  // namespace Rndr
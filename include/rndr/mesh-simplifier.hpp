@@ -0,0 +1,89 @@
+#pragma once
+
+#include "opal/container/array-view.h"
+#include "opal/container/dynamic-array.h"
+
+#include "rndr/math.hpp"
+#include "rndr/types.hpp"
+
+namespace Rndr
+{
+
+/** Level of detail of a mesh, a range of an index buffer shared by all LODs of the mesh. */
+struct MeshLod
+{
+    u32 first_index = 0;
+    u32 index_count = 0;
+
+    /** Largest distance from the full detail surface, relative to the bounding sphere radius. 0 for LOD 0. */
+    f32 error = 0.0f;
+};
+
+/** LODs of a mesh, finest first, with the bounding sphere used to pick one by screen size. */
+struct MeshLodChain
+{
+    Point3f bounds_center;
+    f32 bounds_radius = 0.0f;
+    Opal::DynamicArray<MeshLod> lods;
+};
+
+struct MeshLodDesc
+{
+    /** Maximum number of LODs, including LOD 0. */
+    u32 max_lod_count = 4;
+
+    /** Target index count of a LOD relative to the previous one. */
+    f32 reduction = 0.5f;
+
+    /** A LOD that keeps more than this fraction of the previous LOD's indices is dropped and ends the chain. */
+    f32 max_kept_ratio = 0.8f;
+
+    /** Largest error a LOD may add to the previous one, relative to the bounding sphere radius. */
+    f32 max_error = 0.05f;
+
+    /** Weights of the float attributes that follow the position in each vertex, see SimplifyMesh. */
+    Opal::ArrayView<const f32> attribute_weights;
+};
+
+/**
+ * Simplify a triangle list by collapsing edges in order of their quadric error. Vertices only move
+ * onto their neighbours, so the result indexes the same vertex data. Vertices on open edges and
+ * vertices that share their position with another vertex, like the ones on UV seams, are kept.
+ * @param indices Triangle list to simplify.
+ * @param vertex_data Vertices with a float3 position at the start of each vertex.
+ * @param vertex_stride Size of a vertex in bytes.
+ * @param target_index_count Stop once the result has at most this many indices.
+ * @param target_error Stop before a collapse whose error exceeds this, relative to the bounding sphere radius of vertex_data.
+ * @param attribute_weights Weight of each float that follows the position. A collapse adds the weighted difference of the
+ *                          attributes of its two vertices to its error, so weighted attributes are kept where they change.
+ * @param out_error If not null, receives the largest error of a collapse, relative to the bounding sphere radius.
+ * @return Simplified triangle list.
+ */
+[[nodiscard]] Opal::DynamicArray<u32> SimplifyMesh(Opal::ArrayView<const u32> indices, Opal::ArrayView<const u8> vertex_data,
+                                                   u32 vertex_stride, u32 target_index_count, f32 target_error,
+                                                   Opal::ArrayView<const f32> attribute_weights = {}, f32* out_error = nullptr);
+
+/**
+ * Build a LOD chain by simplifying each LOD from the previous one. All LODs index the same vertex
+ * data and their indices are packed one after another, LOD 0 first. Each simplified LOD is
+ * reordered with OptimizeVertexCache.
+ * @param indices Triangle list of LOD 0.
+ * @param vertex_data Vertices with a float3 position at the start of each vertex.
+ * @param vertex_stride Size of a vertex in bytes.
+ * @param out_indices Receives the indices of all LODs.
+ * @param desc Simplification settings.
+ * @return LOD ranges of out_indices and the bounding sphere of vertex_data.
+ */
+[[nodiscard]] MeshLodChain GenerateMeshLods(Opal::ArrayView<const u32> indices, Opal::ArrayView<const u8> vertex_data, u32 vertex_stride,
+                                            Opal::DynamicArray<u32>& out_indices, const MeshLodDesc& desc = {});
+
+/**
+ * Pick the coarsest LOD whose error, projected to the screen, is within max_screen_error.
+ * @param lods LODs, finest first.
+ * @param projected_radius Radius of the bounding sphere on screen, in the unit of max_screen_error, e.g. pixels.
+ * @param max_screen_error Largest allowed error on screen.
+ * @return Index of the LOD to draw.
+ */
+[[nodiscard]] u32 SelectMeshLod(Opal::ArrayView<const MeshLod> lods, f32 projected_radius, f32 max_screen_error);
+
+}  // namespace Rndr
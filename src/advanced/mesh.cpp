@@ -9,11 +9,12 @@
 #include "opal/paths.h"
 
 #include "rndr/math.hpp"
+#include "rndr/mesh-optimizer.hpp"
 
 void Rndr::Forge::LoadMesh(const Opal::StringUtf8& file_path, Mesh& out_mesh)
 {
     constexpr u32 k_ai_process_flags = aiProcess_JoinIdenticalVertices | aiProcess_Triangulate | aiProcess_GenSmoothNormals |
-                                       aiProcess_LimitBoneWeights | aiProcess_SplitLargeMeshes | aiProcess_ImproveCacheLocality |
+                                       aiProcess_LimitBoneWeights | aiProcess_SplitLargeMeshes |
                                        aiProcess_RemoveRedundantMaterials | aiProcess_FindDegenerates | aiProcess_FindInvalidData |
                                        aiProcess_GenUVCoords | aiProcess_CalcTangentSpace;
     const aiScene* scene = aiImportFile(*file_path, k_ai_process_flags);
@@ -74,5 +75,8 @@ void Rndr::Forge::LoadMesh(const Opal::StringUtf8& file_path, Mesh& out_mesh)
         }
     }
 
+    out_mesh.vertex_count = OptimizeMesh(out_mesh.vertices, out_mesh.vertex_size,
+                                         Opal::ArrayView<u32>(reinterpret_cast<u32*>(out_mesh.indices.GetData()), out_mesh.index_count));
+
     aiReleaseImport(scene);
 }
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include "canvas/barrier-tracker.hpp"
+
+#include "glad/glad.h"
+
+#include "rndr/canvas/buffer.hpp"
+#include "rndr/canvas/shader.hpp"
+
+namespace
+{
+
+/** @return Barrier bits of every way a buffer with the given usage can be consumed after a write. */
+Rndr::u32 GetConsumerBarrierBits(Rndr::Canvas::BufferUsage usage)
+{
+    // Written buffers can always be read back or updated from the CPU.
+    Rndr::u32 bits = GL_BUFFER_UPDATE_BARRIER_BIT;
+    switch (usage)
+    {
+        case Rndr::Canvas::BufferUsage::Vertex:
+            bits |= GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT;
+            break;
+        case Rndr::Canvas::BufferUsage::Index:
+            bits |= GL_ELEMENT_ARRAY_BARRIER_BIT;
+            break;
+        case Rndr::Canvas::BufferUsage::Uniform:
+            bits |= GL_UNIFORM_BARRIER_BIT;
+            break;
+        case Rndr::Canvas::BufferUsage::Storage:
+            // Indirect draw commands and draw counts live in storage buffers.
+            bits |= GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT;
+            break;
+        default:
+            bits = GL_ALL_BARRIER_BITS;
+            break;
+    }
+    return bits;
+}
+
+bool Contains(const Opal::DynamicArray<Rndr::u32>& handles, Rndr::u32 handle)
+{
+    for (Rndr::u64 i = 0; i < handles.GetSize(); ++i)
+    {
+        if (handles[i] == handle)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Call @p fn with the handle, usage and write flag of every storage buffer bound to the brush.
+ * @return True if the shader has a writable parameter with no buffer bound to it.
+ */
+template <typename Fn>
+bool ForEachStorageAccess(const Rndr::Canvas::Brush& brush, Fn&& fn)
+{
+    using namespace Rndr::Canvas;
+
+    const Shader* shader = brush.GetShader();
+    if (shader == nullptr)
+    {
+        return false;
+    }
+
+    const Opal::DynamicArray<BufferBinding>& buffers = brush.GetBuffers();
+    for (Rndr::u64 i = 0; i < buffers.GetSize(); ++i)
+    {
+        const BufferBinding& bb = buffers[i];
+        if (bb.buffer == nullptr || !bb.buffer->IsValid())
+        {
+            continue;
+        }
+        const ShaderParameter* param = shader->FindParameter(bb.name);
+        if (param != nullptr && param->category == ParameterCategory::StorageBuffer)
+        {
+            fn(bb.buffer->GetNativeHandle(), bb.buffer->GetUsage(), param->writable);
+        }
+    }
+
+    const Opal::DynamicArray<ShaderParameter>& params = shader->GetParameters();
+    for (Rndr::u64 i = 0; i < params.GetSize(); ++i)
+    {
+        const ShaderParameter& param = params[i];
+        if (param.category != ParameterCategory::StorageBuffer || !param.writable)
+        {
+            continue;
+        }
+        bool is_bound = false;
+        for (Rndr::u64 j = 0; j < buffers.GetSize() && !is_bound; ++j)
+        {
+            is_bound = buffers[j].buffer != nullptr && buffers[j].buffer->IsValid() && buffers[j].name == param.name;
+        }
+        if (!is_bound)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+Rndr::u32 Rndr::Canvas::Impl::BarrierTracker::AddDispatch(const Brush& brush)
+{
+    m_dispatch_reads.Clear();
+    m_dispatch_writes.Clear();
+    const bool untracked_write = ForEachStorageAccess(brush,
+                                                      [this](u32 handle, BufferUsage usage, bool write)
+                                                      {
+                                                          if (write)
+                                                          {
+                                                              m_dispatch_writes.PushBack(handle);
+                                                              m_flush_bits |= GetConsumerBarrierBits(usage);
+                                                          }
+                                                          else
+                                                          {
+                                                              m_dispatch_reads.PushBack(handle);
+                                                          }
+                                                      });
+    if (untracked_write)
+    {
+        m_flush_bits = GL_ALL_BARRIER_BITS;
+    }
+
+    const bool batch_is_empty = m_batch_reads.IsEmpty() && m_batch_writes.IsEmpty() && !m_batch_untracked_write;
+    u32 barrier_bits = 0;
+    if (m_batch_untracked_write || (untracked_write && !batch_is_empty))
+    {
+        barrier_bits = GL_ALL_BARRIER_BITS;
+    }
+    else
+    {
+        for (u64 i = 0; i < m_dispatch_reads.GetSize() && barrier_bits == 0; ++i)
+        {
+            if (Contains(m_batch_writes, m_dispatch_reads[i]))
+            {
+                barrier_bits = GL_SHADER_STORAGE_BARRIER_BIT;
+            }
+        }
+        for (u64 i = 0; i < m_dispatch_writes.GetSize() && barrier_bits == 0; ++i)
+        {
+            if (Contains(m_batch_writes, m_dispatch_writes[i]) || Contains(m_batch_reads, m_dispatch_writes[i]))
+            {
+                barrier_bits = GL_SHADER_STORAGE_BARRIER_BIT;
+            }
+        }
+    }
+
+    // A barrier starts a new batch of independent dispatches.
+    if (barrier_bits != 0)
+    {
+        m_batch_reads.Clear();
+        m_batch_writes.Clear();
+        m_batch_untracked_write = false;
+    }
+    for (u64 i = 0; i < m_dispatch_reads.GetSize(); ++i)
+    {
+        m_batch_reads.PushBack(m_dispatch_reads[i]);
+    }
+    for (u64 i = 0; i < m_dispatch_writes.GetSize(); ++i)
+    {
+        m_batch_writes.PushBack(m_dispatch_writes[i]);
+    }
+    m_batch_untracked_write = m_batch_untracked_write || untracked_write;
+    return barrier_bits;
+}
+
+Rndr::u32 Rndr::Canvas::Impl::BarrierTracker::Flush()
+{
+    const u32 bits = m_flush_bits;
+    m_batch_reads.Clear();
+    m_batch_writes.Clear();
+    m_batch_untracked_write = false;
+    m_flush_bits = 0;
+    return bits;
+}
+
+Rndr::u32 Rndr::Canvas::Impl::GetDispatchBarrierBits(const Brush& brush)
+{
+    u32 bits = 0;
+    const bool untracked_write = ForEachStorageAccess(brush,
+                                                      [&bits](u32, BufferUsage usage, bool write)
+                                                      {
+                                                          if (write)
+                                                          {
+                                                              bits |= GetConsumerBarrierBits(usage);
+                                                          }
+                                                      });
+    return untracked_write ? GL_ALL_BARRIER_BITS : bits;
+}
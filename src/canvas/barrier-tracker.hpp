@@ -0,0 +1,54 @@
+#pragma once
+
+#include "opal/container/dynamic-array.h"
+
+#include "rndr/canvas/brush.hpp"
+#include "rndr/types.hpp"
+
+namespace Rndr::Canvas::Impl
+{
+
+/**
+ * Tracks the storage buffers read and written by consecutive compute dispatches and derives the
+ * smallest memory barrier each one needs. Accesses are resolved through the shader's reflection:
+ * a buffer bound to a read-only StorageBuffer parameter is read, one bound to a writable parameter
+ * is written.
+ *
+ * Dispatches that do not touch a buffer written by an earlier dispatch, and do not write a buffer an
+ * earlier dispatch accessed, since the last barrier run back to back. A writable parameter without
+ * a bound buffer, e.g. an image, can't be tracked, so it falls back to GL_ALL_BARRIER_BITS.
+ */
+class BarrierTracker
+{
+public:
+    /**
+     * Register the accesses of a dispatch that is about to be issued.
+     * @param brush Brush the dispatch is issued with.
+     * @return Barrier bits to issue before the dispatch, or 0 if it is independent of the
+     *         dispatches issued since the last barrier.
+     */
+    u32 AddDispatch(const Brush& brush);
+
+    /**
+     * Forget all tracked accesses.
+     * @return Barrier bits that make every write since the last Flush() visible to all possible
+     *         consumers of the written buffers, or 0 if nothing was written.
+     */
+    u32 Flush();
+
+private:
+    Opal::DynamicArray<u32> m_batch_reads;
+    Opal::DynamicArray<u32> m_batch_writes;
+    bool m_batch_untracked_write = false;
+    Opal::DynamicArray<u32> m_dispatch_reads;
+    Opal::DynamicArray<u32> m_dispatch_writes;
+    u32 m_flush_bits = 0;
+};
+
+/**
+ * @return Barrier bits that make the writes of a single dispatch visible to all possible consumers
+ *         of the written buffers, or 0 if the dispatch does not write to memory.
+ */
+u32 GetDispatchBarrierBits(const Brush& brush);
+
+}  // namespace Rndr::Canvas::Impl
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "opal/container/dynamic-array.h"
+#include "opal/container/string.h"
+#include "opal/exceptions.h"
+
+#include "rndr/types.hpp"
+
+#include <cstring>
+#include <type_traits>
+
+namespace Rndr::Canvas::Impl
+{
+
+/** Appends plain values, byte arrays and strings to a byte stream. */
+class BinaryWriter
+{
+public:
+    explicit BinaryWriter(Opal::DynamicArray<u8>& out) : m_out(out) {}
+
+    template <typename T>
+    void Write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be written directly!");
+        WriteBytes(&value, sizeof(T));
+    }
+
+    template <typename T>
+    void WriteArray(const Opal::DynamicArray<T>& values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only arrays of trivially copyable values can be written directly!");
+        Write<u64>(values.GetSize());
+        WriteBytes(values.GetData(), values.GetSize() * sizeof(T));
+    }
+
+    void WriteString(const Opal::StringUtf8& str)
+    {
+        Write<u64>(str.GetSize());
+        WriteBytes(str.GetData(), str.GetSize());
+    }
+
+    void WriteBytes(const void* data, u64 size)
+    {
+        if (size == 0)
+        {
+            return;
+        }
+        const u64 offset = m_out.GetSize();
+        m_out.Resize(offset + size);
+        memcpy(m_out.GetData() + offset, data, size);
+    }
+
+private:
+    Opal::DynamicArray<u8>& m_out;
+};
+
+/** Reads back what BinaryWriter wrote. Throws if the stream ends early. */
+class BinaryReader
+{
+public:
+    BinaryReader(const u8* data, u64 size) : m_data(data), m_size(size) {}
+
+    template <typename T>
+    T Read()
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be read directly!");
+        T value;
+        ReadBytes(&value, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    Opal::DynamicArray<T> ReadArray()
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only arrays of trivially copyable values can be read directly!");
+        const u64 count = Read<u64>();
+        if (count > (m_size - m_offset) / sizeof(T))
+        {
+            throw Opal::Exception("Binary stream is truncated!");
+        }
+        Opal::DynamicArray<T> values;
+        values.Resize(count);
+        ReadBytes(values.GetData(), count * sizeof(T));
+        return values;
+    }
+
+    Opal::StringUtf8 ReadString()
+    {
+        const u64 size = Read<u64>();
+        if (size > m_size - m_offset)
+        {
+            throw Opal::Exception("Binary stream is truncated!");
+        }
+        Opal::StringUtf8 str;
+        str.Resize(size);
+        ReadBytes(str.GetData(), size);
+        return str;
+    }
+
+    void ReadBytes(void* out, u64 size)
+    {
+        if (size > m_size - m_offset)
+        {
+            throw Opal::Exception("Binary stream is truncated!");
+        }
+        if (size > 0)
+        {
+            memcpy(out, m_data + m_offset, size);
+            m_offset += size;
+        }
+    }
+
+private:
+    const u8* m_data;
+    u64 m_size;
+    u64 m_offset = 0;
+};
+
+}  // namespace Rndr::Canvas::Impl
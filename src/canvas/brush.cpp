@@ -1,50 +1,24 @@
 #include "rndr/canvas/brush.hpp"
 
-#include "glad/glad.h"
 #include "opal/exceptions.h"
 
+#include "canvas/draw-list-stats.hpp"
+#include "canvas/gl-state-cache.hpp"
+#include "canvas/pipeline-state.hpp"
+#include "canvas/uniform-ring-buffer.hpp"
+
 #include "rndr/canvas/shader.hpp"
 #include "rndr/canvas/texture.hpp"
+#include "rndr/definitions.hpp"
 #include "rndr/exception.hpp"
 #include "rndr/trace.hpp"
 
 #include <algorithm>
-#include <cstdio>
 
-namespace
-{
-
-GLenum ToGLCompareFunc(Rndr::Canvas::CompareFunc func)
-{
-    switch (func)
-    {
-        case Rndr::Canvas::CompareFunc::Less:
-            return GL_LESS;
-        case Rndr::Canvas::CompareFunc::LessEqual:
-            return GL_LEQUAL;
-        case Rndr::Canvas::CompareFunc::Greater:
-            return GL_GREATER;
-        case Rndr::Canvas::CompareFunc::GreaterEqual:
-            return GL_GEQUAL;
-        case Rndr::Canvas::CompareFunc::Equal:
-            return GL_EQUAL;
-        case Rndr::Canvas::CompareFunc::NotEqual:
-            return GL_NOTEQUAL;
-        case Rndr::Canvas::CompareFunc::Always:
-            return GL_ALWAYS;
-        case Rndr::Canvas::CompareFunc::Never:
-            return GL_NEVER;
-        default:
-            return GL_LESS;
-    }
-}
-
-}  // namespace
-
-Rndr::Canvas::Brush::Brush(const BrushDesc& desc) : m_desc(desc) {}
+Rndr::Canvas::Brush::Brush(const BrushDesc& desc) : m_desc(desc), m_pipeline_state_id(Impl::InternPipelineState(desc)) {}
 
 Rndr::Canvas::Brush::Brush(const BrushDesc& desc, Opal::StringUtf8 debug_name)
-    : m_debug_name(std::move(debug_name)), m_desc(desc)
+    : m_debug_name(std::move(debug_name)), m_desc(desc), m_pipeline_state_id(Impl::InternPipelineState(desc))
 {
 }
 
@@ -54,13 +28,20 @@ Rndr::Canvas::Brush::Brush(Brush&& other) noexcept
     : m_debug_name(std::move(other.m_debug_name)),
       m_shader(other.m_shader),
       m_desc(other.m_desc),
+      m_pipeline_state_id(other.m_pipeline_state_id),
       m_uniforms(std::move(other.m_uniforms)),
       m_textures(std::move(other.m_textures)),
       m_buffers(std::move(other.m_buffers)),
-      m_uniform_buffer_slots(std::move(other.m_uniform_buffer_slots))
+      m_uniform_buffer_slots(std::move(other.m_uniform_buffer_slots)),
+      m_parent(other.m_parent),
+      m_uniform_version(other.m_uniform_version),
+      m_parent_uniform_version(other.m_parent_uniform_version),
+      m_uniform_layout_hash(other.m_uniform_layout_hash)
 {
     other.m_shader = nullptr;
+    other.m_parent = nullptr;
     other.m_desc = {};
+    other.m_pipeline_state_id = 0;
 }
 
 Rndr::Canvas::Brush& Rndr::Canvas::Brush::operator=(Brush&& other) noexcept
@@ -70,12 +51,19 @@ Rndr::Canvas::Brush& Rndr::Canvas::Brush::operator=(Brush&& other) noexcept
         m_debug_name = std::move(other.m_debug_name);
         m_shader = other.m_shader;
         m_desc = other.m_desc;
+        m_pipeline_state_id = other.m_pipeline_state_id;
         m_uniforms = std::move(other.m_uniforms);
         m_textures = std::move(other.m_textures);
         m_buffers = std::move(other.m_buffers);
         m_uniform_buffer_slots = std::move(other.m_uniform_buffer_slots);
+        m_parent = other.m_parent;
+        m_uniform_version = other.m_uniform_version;
+        m_parent_uniform_version = other.m_parent_uniform_version;
+        m_uniform_layout_hash = other.m_uniform_layout_hash;
         other.m_shader = nullptr;
+        other.m_parent = nullptr;
         other.m_desc = {};
+        other.m_pipeline_state_id = 0;
     }
     return *this;
 }
@@ -85,6 +73,9 @@ Rndr::Canvas::Brush Rndr::Canvas::Brush::Clone() const
     Brush clone(m_desc);
     clone.m_debug_name = m_debug_name.Clone();
     clone.m_shader = m_shader;
+    clone.m_parent = m_parent;
+    clone.m_parent_uniform_version = m_parent_uniform_version;
+    clone.m_uniform_layout_hash = m_uniform_layout_hash;
 
     for (u64 i = 0; i < m_uniforms.GetSize(); ++i)
     {
@@ -95,43 +86,110 @@ Rndr::Canvas::Brush Rndr::Canvas::Brush::Clone() const
         clone.m_uniforms.PushBack(std::move(binding));
     }
 
-    for (u64 i = 0; i < m_textures.GetSize(); ++i)
-    {
-        TextureBinding binding;
-        binding.name = m_textures[i].name.Clone();
-        binding.texture = m_textures[i].texture;
-        clone.m_textures.PushBack(std::move(binding));
-    }
-
-    for (u64 i = 0; i < m_buffers.GetSize(); ++i)
-    {
-        BufferBinding binding;
-        binding.name = m_buffers[i].name.Clone();
-        binding.buffer = m_buffers[i].buffer;
-        clone.m_buffers.PushBack(std::move(binding));
-    }
+    CopyResourceBindings(clone);
 
     for (u64 i = 0; i < m_uniform_buffer_slots.GetSize(); ++i)
     {
+        // Inherited slots have no data of their own, the clone keeps reading the parent's.
         UniformBufferSlot slot;
-        slot.gpu_buffer = m_uniform_buffer_slots[i].gpu_buffer.Clone();
         slot.cpu_data.Resize(m_uniform_buffer_slots[i].cpu_data.GetSize());
         memcpy(slot.cpu_data.GetData(), m_uniform_buffer_slots[i].cpu_data.GetData(), m_uniform_buffer_slots[i].cpu_data.GetSize());
         slot.binding_index = m_uniform_buffer_slots[i].binding_index;
         slot.binding_space = m_uniform_buffer_slots[i].binding_space;
+        slot.ring_offset = m_uniform_buffer_slots[i].ring_offset;
+        slot.ring_generation = m_uniform_buffer_slots[i].ring_generation;
         slot.dirty = m_uniform_buffer_slots[i].dirty;
+        slot.inherited = m_uniform_buffer_slots[i].inherited;
         clone.m_uniform_buffer_slots.PushBack(std::move(slot));
     }
 
     return clone;
 }
 
+Rndr::Canvas::Brush Rndr::Canvas::Brush::CreateInstance(Opal::StringUtf8 debug_name) const
+{
+    if (m_shader == nullptr)
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Brush instances require a brush with a shader!");
+    }
+
+    // Instances of an instance share its parent, so uniform lookups never chain.
+    if (m_parent != nullptr)
+    {
+        Brush sibling = Clone();
+        sibling.m_debug_name = std::move(debug_name);
+        return sibling;
+    }
+
+    Brush instance(m_desc, std::move(debug_name));
+    instance.m_shader = m_shader;
+    instance.m_parent = this;
+    instance.m_uniform_layout_hash = m_uniform_layout_hash;
+    CopyResourceBindings(instance);
+
+    for (u64 i = 0; i < m_uniform_buffer_slots.GetSize(); ++i)
+    {
+        UniformBufferSlot slot;
+        slot.binding_index = m_uniform_buffer_slots[i].binding_index;
+        slot.binding_space = m_uniform_buffer_slots[i].binding_space;
+        slot.dirty = true;
+        slot.inherited = true;
+        instance.m_uniform_buffer_slots.PushBack(std::move(slot));
+    }
+
+    return instance;
+}
+
+const Rndr::Canvas::Brush* Rndr::Canvas::Brush::GetParent() const
+{
+    return m_parent;
+}
+
+void Rndr::Canvas::Brush::CopyResourceBindings(Brush& target) const
+{
+    for (u64 i = 0; i < m_textures.GetSize(); ++i)
+    {
+        TextureBinding binding;
+        binding.name = m_textures[i].name.Clone();
+        binding.texture = m_textures[i].texture;
+        target.m_textures.PushBack(std::move(binding));
+    }
+
+    for (u64 i = 0; i < m_buffers.GetSize(); ++i)
+    {
+        BufferBinding binding;
+        binding.name = m_buffers[i].name.Clone();
+        binding.buffer = m_buffers[i].buffer;
+        target.m_buffers.PushBack(std::move(binding));
+    }
+}
+
 void Rndr::Canvas::Brush::SetShader(const Shader& shader)
 {
     m_shader = &shader;
+    m_parent = nullptr;
+    ++m_uniform_version;
     CreateUniformBufferSlots();
 }
 
+void Rndr::Canvas::Brush::SetShaderVariant(const Shader& variant)
+{
+    if (m_shader == &variant)
+    {
+        return;
+    }
+    if (m_shader == nullptr)
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Brush has no shader!");
+    }
+    SyncUniformLayout();
+    if (variant.GetUniformLayoutHash() != m_uniform_layout_hash)
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Shader variant has a different uniform layout!");
+    }
+    m_shader = &variant;
+}
+
 const Rndr::Canvas::Shader* Rndr::Canvas::Brush::GetShader() const
 {
     return m_shader;
@@ -140,42 +198,50 @@ const Rndr::Canvas::Shader* Rndr::Canvas::Brush::GetShader() const
 void Rndr::Canvas::Brush::SetBlendMode(BlendMode mode)
 {
     m_desc.blend_mode = mode;
+    m_pipeline_state_id = Impl::InternPipelineState(m_desc);
 }
 
 void Rndr::Canvas::Brush::SetDepthTest(bool enabled)
 {
     m_desc.depth_test = enabled;
+    m_pipeline_state_id = Impl::InternPipelineState(m_desc);
 }
 
 void Rndr::Canvas::Brush::SetDepthWrite(bool enabled)
 {
     m_desc.depth_write = enabled;
+    m_pipeline_state_id = Impl::InternPipelineState(m_desc);
 }
 
 void Rndr::Canvas::Brush::SetDepthCompare(CompareFunc func)
 {
     m_desc.depth_compare = func;
+    m_pipeline_state_id = Impl::InternPipelineState(m_desc);
 }
 
 void Rndr::Canvas::Brush::SetCullMode(CullMode mode)
 {
     m_desc.cull_mode = mode;
+    m_pipeline_state_id = Impl::InternPipelineState(m_desc);
 }
 
 void Rndr::Canvas::Brush::SetWindingOrder(WindingOrder order)
 {
     m_desc.winding_order = order;
+    m_pipeline_state_id = Impl::InternPipelineState(m_desc);
 }
 
 void Rndr::Canvas::Brush::SetFillMode(FillMode mode)
 {
     m_desc.fill_mode = mode;
+    m_pipeline_state_id = Impl::InternPipelineState(m_desc);
 }
 
 void Rndr::Canvas::Brush::SetDepthBias(f32 factor, f32 units)
 {
     m_desc.depth_bias_factor = factor;
     m_desc.depth_bias_units = units;
+    m_pipeline_state_id = Impl::InternPipelineState(m_desc);
 }
 
 const Rndr::Canvas::BrushDesc& Rndr::Canvas::Brush::GetDesc() const
@@ -183,6 +249,11 @@ const Rndr::Canvas::BrushDesc& Rndr::Canvas::Brush::GetDesc() const
     return m_desc;
 }
 
+Rndr::Canvas::PipelineStateId Rndr::Canvas::Brush::GetPipelineStateId() const
+{
+    return m_pipeline_state_id;
+}
+
 void Rndr::Canvas::Brush::SetTexture(const char* name, const Texture& texture)
 {
     for (u64 i = 0; i < m_textures.GetSize(); ++i)
@@ -245,72 +316,59 @@ bool Rndr::Canvas::Brush::IsValid() const
 void Rndr::Canvas::Brush::CreateUniformBufferSlots()
 {
     m_uniform_buffer_slots.Clear();
+    m_uniform_layout_hash = 0;
 
     if (m_shader == nullptr)
     {
         return;
     }
+    m_uniform_layout_hash = m_shader->GetUniformLayoutHash();
 
-    const Opal::DynamicArray<ShaderParameter>& params = m_shader->GetParameters();
+    // One slot per uniform block, in block order, so UniformHandle::block_index indexes the slots directly.
+    const Opal::DynamicArray<UniformBlock>& blocks = m_shader->GetUniformBlocks();
 
-    // Collect unique UBO binding points and compute sizes from uniform fields (size > 0).
-    struct UBOInfo
+    // Create a CPU staging area for each UBO. GPU copies are sub-allocated from the Context's uniform ring buffer.
+    for (u64 i = 0; i < blocks.GetSize(); ++i)
     {
-        i32 binding_index;
-        i32 binding_space;
-        i32 total_size;
-    };
-    Opal::DynamicArray<UBOInfo> ubo_infos;
+        UniformBufferSlot slot;
+        slot.binding_index = blocks[i].binding_index;
+        slot.binding_space = blocks[i].binding_space;
+        slot.cpu_data.Resize(static_cast<u64>(blocks[i].size));
+        memset(slot.cpu_data.GetData(), 0, slot.cpu_data.GetSize());
+        m_uniform_buffer_slots.PushBack(std::move(slot));
+    }
+}
 
-    for (u64 i = 0; i < params.GetSize(); ++i)
+void Rndr::Canvas::Brush::SyncUniformLayout()
+{
+    if (m_shader == nullptr || m_shader->GetUniformLayoutHash() == m_uniform_layout_hash)
     {
-        const ShaderParameter& p = params[i];
-        if (p.category != ParameterCategory::Uniform || p.size <= 0)
-        {
-            continue;
-        }
-
-        const i32 end = p.offset + p.size;
-        bool found = false;
-        for (u64 j = 0; j < ubo_infos.GetSize(); ++j)
-        {
-            if (ubo_infos[j].binding_index == p.binding_index && ubo_infos[j].binding_space == p.binding_space)
-            {
-                ubo_infos[j].total_size = std::max(ubo_infos[j].total_size, end);
-                found = true;
-                break;
-            }
-        }
-
-        if (!found)
-        {
-            UBOInfo info;
-            info.binding_index = p.binding_index;
-            info.binding_space = p.binding_space;
-            info.total_size = end;
-            ubo_infos.PushBack(info);
-        }
+        return;
     }
 
-    // Create a GPU buffer + CPU staging area for each UBO.
-    for (u64 i = 0; i < ubo_infos.GetSize(); ++i)
+    if (m_parent == nullptr)
     {
-        Opal::StringUtf8 ubo_name;
-        if (!m_debug_name.IsEmpty())
-        {
-            char buf[256];
-            snprintf(buf, sizeof(buf), "%s - Uniform Buffer bound at %d", m_debug_name.GetData(), ubo_infos[i].binding_index);
-            ubo_name = buf;
-        }
+        CreateUniformBufferSlots();
+        ++m_uniform_version;
+        return;
+    }
 
+    // Inherited slots index the parent's slots, so the parent has to match the new layout first.
+    // CreateInstance() hands out a const pointer, the parent itself is a mutable brush.
+    const_cast<Brush*>(m_parent)->SyncUniformLayout();
+    m_uniform_buffer_slots.Clear();
+    const Opal::DynamicArray<UniformBufferSlot>& parent_slots = m_parent->m_uniform_buffer_slots;
+    for (u64 i = 0; i < parent_slots.GetSize(); ++i)
+    {
         UniformBufferSlot slot;
-        slot.binding_index = ubo_infos[i].binding_index;
-        slot.binding_space = ubo_infos[i].binding_space;
-        slot.cpu_data.Resize(static_cast<u64>(ubo_infos[i].total_size));
-        memset(slot.cpu_data.GetData(), 0, slot.cpu_data.GetSize());
-        slot.gpu_buffer = Buffer(BufferUsage::Uniform, static_cast<u64>(ubo_infos[i].total_size), 0, {}, std::move(ubo_name));
+        slot.binding_index = parent_slots[i].binding_index;
+        slot.binding_space = parent_slots[i].binding_space;
+        slot.dirty = true;
+        slot.inherited = true;
         m_uniform_buffer_slots.PushBack(std::move(slot));
     }
+    m_uniform_layout_hash = m_parent->m_uniform_layout_hash;
+    ++m_uniform_version;
 }
 
 void Rndr::Canvas::Brush::SetUniformRaw(const char* name, const void* data, u64 size)
@@ -325,6 +383,7 @@ void Rndr::Canvas::Brush::SetUniformRaw(const char* name, const void* data, u64
     }
 
     // If a shader is set, try to write into the appropriate UBO slot.
+    SyncUniformLayout();
     if (m_shader != nullptr)
     {
         const ShaderParameter* param = m_shader->FindParameter(name);
@@ -336,11 +395,10 @@ void Rndr::Canvas::Brush::SetUniformRaw(const char* name, const void* data, u64
             }
             for (u64 i = 0; i < m_uniform_buffer_slots.GetSize(); ++i)
             {
-                UniformBufferSlot& slot = m_uniform_buffer_slots[i];
+                const UniformBufferSlot& slot = m_uniform_buffer_slots[i];
                 if (slot.binding_index == param->binding_index && slot.binding_space == param->binding_space)
                 {
-                    memcpy(slot.cpu_data.GetData() + param->offset, data, size);
-                    slot.dirty = true;
+                    memcpy(GetWritableSlot(i).cpu_data.GetData() + param->offset, data, size);
                     return;
                 }
             }
@@ -406,124 +464,212 @@ void Rndr::Canvas::Brush::SetUniformRaw(const char* name, i32 index, const void*
         throw Opal::InvalidArgumentException(__FUNCTION__, "Uniform data size exceeds the array element size!");
     }
 
+    SyncUniformLayout();
     const i32 element_offset = param->offset + index * param->array_stride;
     for (u64 i = 0; i < m_uniform_buffer_slots.GetSize(); ++i)
     {
-        UniformBufferSlot& slot = m_uniform_buffer_slots[i];
+        const UniformBufferSlot& slot = m_uniform_buffer_slots[i];
         if (slot.binding_index == param->binding_index && slot.binding_space == param->binding_space)
         {
-            memcpy(slot.cpu_data.GetData() + element_offset, data, size);
-            slot.dirty = true;
+            memcpy(GetWritableSlot(i).cpu_data.GetData() + element_offset, data, size);
             return;
         }
     }
 }
 
-void Rndr::Canvas::Brush::UploadUniforms()
+void Rndr::Canvas::Brush::SetUniformRaw(const UniformHandle& handle, i32 index, const void* data, u64 size)
+{
+    // Uniforms that the compiler optimized out resolve to invalid handles, writing them is a no-op.
+    if (!handle.IsValid())
+    {
+        return;
+    }
+    SyncUniformLayout();
+
+#if RNDR_HARDENING
+    if (data == nullptr || size == 0)
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Uniform data is null or size is 0!");
+    }
+    const i32 element_count = std::max(handle.array_element_count, 1);
+    if (index < 0 || index >= element_count)
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Array index is out of bounds!");
+    }
+    const i32 element_size = handle.array_element_count > 0 ? handle.array_stride : handle.size;
+    if (static_cast<i32>(size) > element_size)
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Uniform data size exceeds the parameter size!");
+    }
+    const u64 end = static_cast<u64>(handle.offset + index * handle.array_stride) + size;
+    if (static_cast<u64>(handle.block_index) >= m_uniform_buffer_slots.GetSize() ||
+        end > GetUniformData(static_cast<u64>(handle.block_index)).GetSize())
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Uniform handle was not resolved from the brush's shader!");
+    }
+#endif
+
+    UniformBufferSlot& slot = GetWritableSlot(static_cast<u64>(handle.block_index));
+    memcpy(slot.cpu_data.GetData() + handle.offset + index * handle.array_stride, data, size);
+}
+
+void Rndr::Canvas::Brush::SetParameterBlockRaw(i32 binding_index, i32 binding_space, const void* data, u64 size)
 {
+    if (m_shader == nullptr)
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Cannot set a parameter block without a shader!");
+    }
+
+    SyncUniformLayout();
     for (u64 i = 0; i < m_uniform_buffer_slots.GetSize(); ++i)
     {
         UniformBufferSlot& slot = m_uniform_buffer_slots[i];
-        if (slot.dirty && slot.gpu_buffer.IsValid())
+        if (slot.binding_index != binding_index || slot.binding_space != binding_space)
+        {
+            continue;
+        }
+        if (size != GetUniformData(i).GetSize())
         {
-            slot.gpu_buffer.Update(Opal::ArrayView<const u8>(slot.cpu_data.GetData(), slot.cpu_data.GetSize()));
-            slot.dirty = false;
+            throw Opal::InvalidArgumentException(__FUNCTION__, "Parameter block size does not match the uniform block size!");
         }
+        // The whole block is overwritten, so an inherited slot skips the copy of the parent's data.
+        if (slot.inherited)
+        {
+            slot.cpu_data.Resize(size);
+            slot.inherited = false;
+        }
+        memcpy(slot.cpu_data.GetData(), data, size);
+        slot.dirty = true;
+        ++m_uniform_version;
+        return;
     }
+    throw Opal::InvalidArgumentException(__FUNCTION__, "Shader has no uniform block at the parameter block's binding!");
 }
 
-const Opal::DynamicArray<Rndr::Canvas::UniformBufferSlot>& Rndr::Canvas::Brush::GetUniformBufferSlots() const
+Rndr::Canvas::UniformBufferSlot& Rndr::Canvas::Brush::GetWritableSlot(u64 slot_index)
 {
-    return m_uniform_buffer_slots;
+    UniformBufferSlot& slot = m_uniform_buffer_slots[slot_index];
+    if (slot.inherited)
+    {
+        // Copy on write: the instance takes its own copy of the parent's block on the first write.
+        const Opal::ArrayView<const u8> parent_data = m_parent->GetUniformData(slot_index);
+        slot.cpu_data.Resize(parent_data.GetSize());
+        memcpy(slot.cpu_data.GetData(), parent_data.GetData(), parent_data.GetSize());
+        slot.inherited = false;
+    }
+    slot.dirty = true;
+    ++m_uniform_version;
+    return slot;
 }
 
-void Rndr::Canvas::Brush::Apply()
+Opal::ArrayView<const Rndr::u8> Rndr::Canvas::Brush::GetUniformData(u64 slot_index) const
 {
-    RNDR_CPU_EVENT_SCOPED("Canvas::Brush::Apply");
+    const UniformBufferSlot& slot = m_uniform_buffer_slots[slot_index];
+    if (slot.inherited)
+    {
+        return m_parent->GetUniformData(slot_index);
+    }
+    return Opal::ArrayView<const u8>(slot.cpu_data.GetData(), slot.cpu_data.GetSize());
+}
 
-    if (m_shader == nullptr)
+void Rndr::Canvas::Brush::UploadUniforms()
+{
+    SyncUniformLayout();
+    if (m_uniform_buffer_slots.IsEmpty())
     {
         return;
     }
 
-    // 1. Bind shader program.
-    glUseProgram(m_shader->GetNativeHandle());
+    Impl::UniformRingBuffer* ring_buffer = Impl::GetUniformRingBuffer();
+    RNDR_ASSERT(ring_buffer != nullptr, "Brush::UploadUniforms called without a live Canvas::Context!");
 
-    // 2. Depth state.
-    if (m_desc.depth_test)
+    // Copies made in an earlier generation of the ring may already be overwritten. Instances also
+    // upload when the parent changed, since they copy the blocks they inherit.
+    const u64 generation = ring_buffer->GetGeneration();
+    bool needs_upload = m_parent != nullptr && m_parent->m_uniform_version != m_parent_uniform_version;
+    for (u64 i = 0; i < m_uniform_buffer_slots.GetSize(); ++i)
     {
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(ToGLCompareFunc(m_desc.depth_compare));
+        needs_upload |= m_uniform_buffer_slots[i].dirty || m_uniform_buffer_slots[i].ring_generation != generation;
     }
-    else
+    if (!needs_upload)
     {
-        glDisable(GL_DEPTH_TEST);
+        return;
     }
-    glDepthMask(m_desc.depth_write ? GL_TRUE : GL_FALSE);
 
-    // 3. Blend state.
-    switch (m_desc.blend_mode)
+    // Upload all slots in one allocation so that they always share a generation.
+    const u64 alignment = ring_buffer->GetAlignment();
+    u64 upload_size = 0;
+    for (u64 i = 0; i < m_uniform_buffer_slots.GetSize(); ++i)
     {
-        case BlendMode::None:
-            glDisable(GL_BLEND);
-            break;
-        case BlendMode::Alpha:
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-            break;
-        case BlendMode::Additive:
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_ONE, GL_ONE);
-            break;
-        case BlendMode::Multiply:
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_DST_COLOR, GL_ZERO);
-            break;
-        default:
-            glDisable(GL_BLEND);
-            break;
+        upload_size = (upload_size + alignment - 1) / alignment * alignment + GetUniformData(i).GetSize();
     }
 
-    // 4. Rasterizer state.
-    glPolygonMode(GL_FRONT_AND_BACK, m_desc.fill_mode == FillMode::Wireframe ? GL_LINE : GL_FILL);
-
-    if (m_desc.cull_mode != CullMode::None)
+    u64 block_offset = 0;
+    u8* block = ring_buffer->Allocate(upload_size, block_offset);
+    u64 offset = 0;
+    for (u64 i = 0; i < m_uniform_buffer_slots.GetSize(); ++i)
+    {
+        UniformBufferSlot& slot = m_uniform_buffer_slots[i];
+        const Opal::ArrayView<const u8> data = GetUniformData(i);
+        offset = (offset + alignment - 1) / alignment * alignment;
+        memcpy(block + offset, data.GetData(), data.GetSize());
+        slot.ring_offset = block_offset + offset;
+        slot.ring_generation = ring_buffer->GetGeneration();
+        slot.dirty = false;
+        offset += data.GetSize();
+    }
+    if (m_parent != nullptr)
     {
-        glEnable(GL_CULL_FACE);
-        glCullFace(m_desc.cull_mode == CullMode::Front ? GL_FRONT : GL_BACK);
+        m_parent_uniform_version = m_parent->m_uniform_version;
     }
-    else
+
+    if (DrawListStats* stats = Impl::GetActiveDrawListStats(); stats != nullptr)
     {
-        glDisable(GL_CULL_FACE);
+        stats->uniform_bytes_uploaded += upload_size;
     }
-    glFrontFace(m_desc.winding_order == WindingOrder::CW ? GL_CW : GL_CCW);
+}
 
-    if (m_desc.depth_bias_factor != 0.0f || m_desc.depth_bias_units != 0.0f)
+const Opal::DynamicArray<Rndr::Canvas::UniformBufferSlot>& Rndr::Canvas::Brush::GetUniformBufferSlots() const
+{
+    return m_uniform_buffer_slots;
+}
+
+void Rndr::Canvas::Brush::Apply()
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::Brush::Apply");
+
+    if (m_shader == nullptr)
     {
-        glEnable(GL_POLYGON_OFFSET_FILL);
-        glEnable(GL_POLYGON_OFFSET_LINE);
-        glPolygonOffset(m_desc.depth_bias_factor, m_desc.depth_bias_units);
+        return;
     }
-    else
+
+    Impl::GLStateCache* state_cache = Impl::GetStateCache();
+    RNDR_ASSERT(state_cache != nullptr, "Brush::Apply called without a live Canvas::Context!");
+
+    if (DrawListStats* stats = Impl::GetActiveDrawListStats(); stats != nullptr)
     {
-        glDisable(GL_POLYGON_OFFSET_FILL);
-        glDisable(GL_POLYGON_OFFSET_LINE);
+        ++stats->brush_applies;
     }
 
-    // 5. Upload dirty uniform buffers to the GPU.
+    // 1. Bind shader program.
+    state_cache->UseProgram(m_shader->GetNativeHandle());
+
+    // 2. Depth, blend and rasterizer state.
+    state_cache->ApplyPipelineState(m_pipeline_state_id, m_desc);
+
+    // 3. Upload dirty uniform buffers to the GPU.
     UploadUniforms();
 
-    // 6. Bind UBOs to their binding points.
+    // 4. Bind the uniform ring buffer ranges holding the UBOs to their binding points.
+    const u32 ring_buffer = Impl::GetUniformRingBuffer()->GetNativeHandle();
     for (u64 i = 0; i < m_uniform_buffer_slots.GetSize(); ++i)
     {
         const UniformBufferSlot& slot = m_uniform_buffer_slots[i];
-        if (slot.gpu_buffer.IsValid())
-        {
-            glBindBufferBase(GL_UNIFORM_BUFFER, static_cast<GLuint>(slot.binding_index), slot.gpu_buffer.GetNativeHandle());
-        }
+        const u64 size = GetUniformData(i).GetSize();
+        state_cache->BindUniformBufferRange(static_cast<u32>(slot.binding_index), ring_buffer, slot.ring_offset, size);
     }
 
-    // 7. Bind textures. Look up the binding index from shader reflection.
+    // 5. Bind textures. Look up the binding index from shader reflection.
     for (u64 i = 0; i < m_textures.GetSize(); ++i)
     {
         const TextureBinding& tb = m_textures[i];
@@ -534,11 +680,11 @@ void Rndr::Canvas::Brush::Apply()
         const ShaderParameter* param = m_shader->FindParameter(tb.name);
         if (param != nullptr && param->category == ParameterCategory::Texture)
         {
-            glBindTextureUnit(static_cast<GLuint>(param->binding_index), tb.texture->GetNativeHandle());
+            state_cache->BindTextureUnit(static_cast<u32>(param->binding_index), tb.texture->GetNativeHandle());
         }
     }
 
-    // 8. Bind storage buffers. Look up the binding index from shader reflection.
+    // 6. Bind storage buffers. Look up the binding index from shader reflection.
     for (u64 i = 0; i < m_buffers.GetSize(); ++i)
     {
         const BufferBinding& bb = m_buffers[i];
@@ -549,7 +695,7 @@ void Rndr::Canvas::Brush::Apply()
         const ShaderParameter* param = m_shader->FindParameter(bb.name);
         if (param != nullptr && param->category == ParameterCategory::StorageBuffer)
         {
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, static_cast<GLuint>(param->binding_index), bb.buffer->GetNativeHandle());
+            state_cache->BindStorageBuffer(static_cast<u32>(param->binding_index), bb.buffer->GetNativeHandle());
         }
     }
 }
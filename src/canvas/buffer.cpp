@@ -2,6 +2,8 @@
 
 #include "glad/glad.h"
 
+#include "canvas/gl-state-cache.hpp"
+
 #include "rndr/exception.hpp"
 #include "rndr/log.hpp"
 #include "rndr/trace.hpp"
@@ -81,6 +83,10 @@ void Rndr::Canvas::Buffer::Destroy()
 {
     if (m_handle != 0)
     {
+        if (Impl::GLStateCache* state_cache = Impl::GetStateCache(); state_cache != nullptr)
+        {
+            state_cache->ForgetBuffer(m_handle);
+        }
         glDeleteBuffers(1, &m_handle);
         m_handle = 0;
         m_size = 0;
@@ -104,6 +110,20 @@ void Rndr::Canvas::Buffer::Update(const Opal::ArrayView<const u8>& data) const
     glNamedBufferSubData(m_handle, static_cast<GLintptr>(m_offset), static_cast<GLsizeiptr>(data.GetSize()), data.GetData());
 }
 
+Opal::DynamicArray<Rndr::u8> Rndr::Canvas::Buffer::ReadData() const
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::Buffer::ReadData");
+
+    if (m_handle == 0)
+    {
+        throw GraphicsAPIException(0, "Cannot read an invalid buffer!");
+    }
+
+    Opal::DynamicArray<u8> data(m_size);
+    glGetNamedBufferSubData(m_handle, 0, static_cast<GLsizeiptr>(m_size), data.GetData());
+    return data;
+}
+
 Rndr::Canvas::BufferUsage Rndr::Canvas::Buffer::GetUsage() const
 {
     return m_usage;
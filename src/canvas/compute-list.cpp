@@ -0,0 +1,64 @@
+#include "rndr/canvas/compute-list.hpp"
+
+#include "glad/glad.h"
+
+#include "canvas/barrier-tracker.hpp"
+
+#include "rndr/canvas/brush.hpp"
+#include "rndr/trace.hpp"
+
+Rndr::Canvas::ComputeList::ComputeList() : m_barrier_tracker(Opal::MakeScoped<Impl::BarrierTracker>(nullptr)) {}
+
+Rndr::Canvas::ComputeList::~ComputeList() = default;
+
+Rndr::Canvas::ComputeList::ComputeList(ComputeList&& other) noexcept = default;
+
+Rndr::Canvas::ComputeList& Rndr::Canvas::ComputeList::operator=(ComputeList&& other) noexcept = default;
+
+void Rndr::Canvas::ComputeList::Dispatch(Brush& brush, u32 group_count_x, u32 group_count_y, u32 group_count_z)
+{
+    Impl::DispatchCommand cmd;
+    cmd.brush = &brush;
+    cmd.group_count_x = group_count_x;
+    cmd.group_count_y = group_count_y;
+    cmd.group_count_z = group_count_z;
+    m_dispatches.PushBack(cmd);
+}
+
+Rndr::u64 Rndr::Canvas::ComputeList::GetCommandCount() const
+{
+    return m_dispatches.GetSize();
+}
+
+void Rndr::Canvas::ComputeList::Execute()
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::ComputeList::Execute");
+
+    m_stats = {};
+    for (u64 i = 0; i < m_dispatches.GetSize(); ++i)
+    {
+        const Impl::DispatchCommand& c = m_dispatches[i];
+        const u32 barrier_bits = m_barrier_tracker->AddDispatch(*c.brush);
+        if (barrier_bits != 0)
+        {
+            glMemoryBarrier(barrier_bits);
+            ++m_stats.barrier_count;
+        }
+        c.brush->Apply();
+        glDispatchCompute(c.group_count_x, c.group_count_y, c.group_count_z);
+        ++m_stats.dispatch_count;
+    }
+
+    const u32 flush_bits = m_barrier_tracker->Flush();
+    if (flush_bits != 0)
+    {
+        glMemoryBarrier(flush_bits);
+        ++m_stats.barrier_count;
+    }
+    m_dispatches.Clear();
+}
+
+const Rndr::Canvas::ComputeListStats& Rndr::Canvas::ComputeList::GetStats() const
+{
+    return m_stats;
+}
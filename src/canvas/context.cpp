@@ -3,6 +3,12 @@
 #include "glad/glad_wgl.h"
 
 #include "opal/container/hash-set.h"
+#include "opal/exceptions.h"
+
+#include "canvas/gl-state-cache.hpp"
+#include "canvas/shader-archive.hpp"
+#include "canvas/shader-cache.hpp"
+#include "canvas/uniform-ring-buffer.hpp"
 
 #include "rndr/definitions.hpp"
 #include "rndr/exception.hpp"
@@ -108,7 +114,11 @@ Rndr::Canvas::Context::Context(Context&& other) noexcept
       m_device_context(other.m_device_context),
       m_graphics_context(other.m_graphics_context),
       m_width(other.m_width),
-      m_height(other.m_height)
+      m_height(other.m_height),
+      m_state_cache(std::move(other.m_state_cache)),
+      m_uniform_ring_buffer(std::move(other.m_uniform_ring_buffer)),
+      m_shader_cache(std::move(other.m_shader_cache)),
+      m_shader_archive(std::move(other.m_shader_archive))
 {
     other.m_window = nullptr;
     other.m_device_context = k_invalid_device_context_handle;
@@ -130,6 +140,10 @@ Rndr::Canvas::Context& Rndr::Canvas::Context::operator=(Context&& other) noexcep
         m_graphics_context = other.m_graphics_context;
         m_width = other.m_width;
         m_height = other.m_height;
+        m_state_cache = std::move(other.m_state_cache);
+        m_uniform_ring_buffer = std::move(other.m_uniform_ring_buffer);
+        m_shader_cache = std::move(other.m_shader_cache);
+        m_shader_archive = std::move(other.m_shader_archive);
         other.m_window = nullptr;
         other.m_device_context = k_invalid_device_context_handle;
         other.m_graphics_context = k_invalid_graphics_context_handle;
@@ -142,6 +156,12 @@ Rndr::Canvas::Context& Rndr::Canvas::Context::operator=(Context&& other) noexcep
 void Rndr::Canvas::Context::Destroy()
 {
 #if RNDR_WINDOWS
+    // The ring buffer must be unmapped and deleted while the GL context is still alive.
+    if (m_uniform_ring_buffer.Get() != nullptr)
+    {
+        Impl::SetUniformRingBuffer(nullptr);
+        m_uniform_ring_buffer = Opal::ScopePtr<Impl::UniformRingBuffer>();
+    }
     if (m_graphics_context != k_invalid_graphics_context_handle)
     {
         const BOOL status = wglDeleteContext(m_graphics_context);
@@ -159,6 +179,21 @@ void Rndr::Canvas::Context::Destroy()
     m_window = nullptr;
     m_width = 0;
     m_height = 0;
+    if (m_state_cache.Get() != nullptr)
+    {
+        Impl::SetStateCache(nullptr);
+        m_state_cache = Opal::ScopePtr<Impl::GLStateCache>();
+    }
+    if (m_shader_cache.Get() != nullptr)
+    {
+        Impl::SetShaderCache(nullptr);
+        m_shader_cache = Opal::ScopePtr<Impl::ShaderCache>();
+    }
+    if (m_shader_archive.Get() != nullptr)
+    {
+        Impl::SetShaderArchive(nullptr);
+        m_shader_archive = Opal::ScopePtr<Impl::ShaderArchive>();
+    }
     g_context_exists = false;
 #endif
 }
@@ -168,6 +203,10 @@ void Rndr::Canvas::Context::Present()
     RNDR_CPU_EVENT_SCOPED("Canvas::Context::Present");
 
 #if RNDR_WINDOWS
+    if (m_uniform_ring_buffer.Get() != nullptr)
+    {
+        m_uniform_ring_buffer->EndFrame();
+    }
     if (m_device_context != k_invalid_device_context_handle)
     {
         SwapBuffers(m_device_context);
@@ -214,6 +253,37 @@ Rndr::Canvas::Format Rndr::Canvas::Context::GetDepthStencilFormat() const
     return m_depth_stencil_format;
 }
 
+Rndr::Canvas::StateCacheStats Rndr::Canvas::Context::GetStateCacheStats() const
+{
+    return m_state_cache.Get() != nullptr ? m_state_cache->GetStats() : StateCacheStats{};
+}
+
+void Rndr::Canvas::Context::ResetStateCacheStats()
+{
+    if (m_state_cache.Get() != nullptr)
+    {
+        m_state_cache->ResetStats();
+    }
+}
+
+void Rndr::Canvas::Context::InvalidateStateCache()
+{
+    if (m_state_cache.Get() != nullptr)
+    {
+        m_state_cache->Invalidate();
+    }
+}
+
+Rndr::Canvas::ShaderCacheStats Rndr::Canvas::Context::GetShaderCacheStats() const
+{
+    return m_shader_cache.Get() != nullptr ? m_shader_cache->GetStats() : ShaderCacheStats{};
+}
+
+Rndr::Canvas::ShaderArchiveStats Rndr::Canvas::Context::GetShaderArchiveStats() const
+{
+    return m_shader_archive.Get() != nullptr ? m_shader_archive->GetStats() : ShaderArchiveStats{};
+}
+
 bool Rndr::Canvas::Context::IsValid() const
 {
     return m_device_context != k_invalid_device_context_handle && m_graphics_context != k_invalid_graphics_context_handle;
@@ -381,6 +451,28 @@ Rndr::Canvas::Context Rndr::Canvas::Context::Init(Opal::Ref<GenericWindow> windo
     glGetIntegerv(GL_MAJOR_VERSION, &major);
     glGetIntegerv(GL_MINOR_VERSION, &minor);
 
+    ctx.m_state_cache = Opal::MakeScoped<Impl::GLStateCache>(nullptr);
+    Impl::SetStateCache(ctx.m_state_cache.Get());
+    ctx.m_uniform_ring_buffer = Opal::MakeScoped<Impl::UniformRingBuffer>(nullptr, desc.uniform_ring_buffer_size);
+    Impl::SetUniformRingBuffer(ctx.m_uniform_ring_buffer.Get());
+    if (!desc.shader_cache_directory.IsEmpty())
+    {
+        ctx.m_shader_cache = Opal::MakeScoped<Impl::ShaderCache>(nullptr, desc.shader_cache_directory.Clone());
+        Impl::SetShaderCache(ctx.m_shader_cache.Get());
+    }
+    if (!desc.shader_archive_path.IsEmpty())
+    {
+        try
+        {
+            ctx.m_shader_archive = Opal::MakeScoped<Impl::ShaderArchive>(nullptr, desc.shader_archive_path);
+            Impl::SetShaderArchive(ctx.m_shader_archive.Get());
+        }
+        catch (const Opal::Exception& e)
+        {
+            RNDR_LOG_WARNING("Failed to open the shader archive {}: {}", *desc.shader_archive_path, *e.What());
+        }
+    }
+
     g_context_exists = true;
     RNDR_LOG_INFO("OpenGL {}.{} context initialized successfully.", major, minor);
     return ctx;
@@ -1,5 +1,6 @@
 #include "../../include/rndr/canvas/renderers/cubemap-renderer.hpp"
 
+#include "canvas/embedded-shaders.hpp"
 #include "rndr/canvas/context.hpp"
 
 static const Opal::StringUtf8 k_shader_source = R"(
@@ -35,6 +36,11 @@ float4 FragmentMain(VertexOutput in)
 }
 )";
 
+const Opal::StringUtf8& Rndr::Canvas::Impl::GetCubeMapRendererShaderSource()
+{
+    return k_shader_source;
+}
+
 Rndr::Canvas::CubemapRenderer::CubemapRenderer(Opal::Ref<Context> context)
     : m_context(std::move(context))
 {
@@ -0,0 +1,175 @@
+#include "rndr/canvas/draw-command-buffer.hpp"
+
+#include "opal/exceptions.h"
+
+#include "rndr/trace.hpp"
+
+#include <cstring>
+
+template <typename T>
+Rndr::Canvas::DrawCommandBuffer<T>::DrawCommandBuffer(u32 max_count, Opal::StringUtf8 name) : m_max_count(max_count)
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::DrawCommandBuffer::DrawCommandBuffer");
+
+    if (max_count == 0)
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Max count must be larger than 0!");
+    }
+
+    Opal::StringUtf8 count_name = name.IsEmpty() ? Opal::StringUtf8() : name + " Count";
+    m_buffer = Buffer(BufferUsage::Storage, static_cast<u64>(max_count) * sizeof(T), 0, {}, std::move(name));
+    const u32 zero = 0;
+    m_count_buffer = Buffer(BufferUsage::Storage, sizeof(u32), 0, Opal::AsBytes(zero), std::move(count_name));
+}
+
+template <typename T>
+Rndr::Canvas::DrawCommandBuffer<T>::~DrawCommandBuffer()
+{
+    Destroy();
+}
+
+template <typename T>
+Rndr::Canvas::DrawCommandBuffer<T>::DrawCommandBuffer(DrawCommandBuffer&& other) noexcept
+    : m_max_count(other.m_max_count),
+      m_buffer(std::move(other.m_buffer)),
+      m_count_buffer(std::move(other.m_count_buffer)),
+      m_staging(std::move(other.m_staging)),
+      m_dirty(other.m_dirty)
+{
+    other.m_max_count = 0;
+    other.m_dirty = false;
+}
+
+template <typename T>
+Rndr::Canvas::DrawCommandBuffer<T>& Rndr::Canvas::DrawCommandBuffer<T>::operator=(DrawCommandBuffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        Destroy();
+        m_max_count = other.m_max_count;
+        m_buffer = std::move(other.m_buffer);
+        m_count_buffer = std::move(other.m_count_buffer);
+        m_staging = std::move(other.m_staging);
+        m_dirty = other.m_dirty;
+        other.m_max_count = 0;
+        other.m_dirty = false;
+    }
+    return *this;
+}
+
+template <typename T>
+Rndr::Canvas::DrawCommandBuffer<T> Rndr::Canvas::DrawCommandBuffer<T>::Clone() const
+{
+    if (!IsValid())
+    {
+        return {};
+    }
+    DrawCommandBuffer clone;
+    clone.m_max_count = m_max_count;
+    clone.m_buffer = m_buffer.Clone();
+    clone.m_count_buffer = m_count_buffer.Clone();
+    clone.m_staging.Resize(m_staging.GetSize());
+    if (!m_staging.IsEmpty())
+    {
+        memcpy(clone.m_staging.GetData(), m_staging.GetData(), m_staging.GetSize() * sizeof(T));
+    }
+    clone.m_dirty = m_dirty;
+    return clone;
+}
+
+template <typename T>
+void Rndr::Canvas::DrawCommandBuffer<T>::Destroy()
+{
+    m_buffer.Destroy();
+    m_count_buffer.Destroy();
+    m_staging.Clear();
+    m_max_count = 0;
+    m_dirty = false;
+}
+
+template <typename T>
+void Rndr::Canvas::DrawCommandBuffer<T>::Add(const T& command)
+{
+    if (m_staging.GetSize() >= m_max_count)
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Draw command buffer is full!");
+    }
+    m_staging.PushBack(command);
+    m_dirty = true;
+}
+
+template <typename T>
+Opal::ArrayView<T> Rndr::Canvas::DrawCommandBuffer<T>::Append(u32 count)
+{
+    const u64 first = m_staging.GetSize();
+    if (first + count > m_max_count)
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Draw command buffer doesn't have room for the requested commands!");
+    }
+    m_staging.Resize(first + count);
+    m_dirty = true;
+    T* data = m_staging.GetData() + first;
+    return Opal::ArrayView<T>(data, data + count);
+}
+
+template <typename T>
+void Rndr::Canvas::DrawCommandBuffer<T>::Clear()
+{
+    m_staging.Clear();
+    m_dirty = false;
+}
+
+template <typename T>
+void Rndr::Canvas::DrawCommandBuffer<T>::Upload()
+{
+    if (!m_dirty)
+    {
+        return;
+    }
+
+    RNDR_CPU_EVENT_SCOPED("Canvas::DrawCommandBuffer::Upload");
+    if (!m_staging.IsEmpty())
+    {
+        m_buffer.Update(Opal::AsBytes(m_staging));
+    }
+    m_dirty = false;
+}
+
+template <typename T>
+Rndr::u32 Rndr::Canvas::DrawCommandBuffer<T>::GetCount() const
+{
+    return static_cast<u32>(m_staging.GetSize());
+}
+
+template <typename T>
+Opal::ArrayView<const T> Rndr::Canvas::DrawCommandBuffer<T>::GetCommands() const
+{
+    return {m_staging.GetData(), m_staging.GetData() + m_staging.GetSize()};
+}
+
+template <typename T>
+Rndr::u32 Rndr::Canvas::DrawCommandBuffer<T>::GetMaxCount() const
+{
+    return m_max_count;
+}
+
+template <typename T>
+const Rndr::Canvas::Buffer& Rndr::Canvas::DrawCommandBuffer<T>::GetBuffer() const
+{
+    return m_buffer;
+}
+
+template <typename T>
+const Rndr::Canvas::Buffer& Rndr::Canvas::DrawCommandBuffer<T>::GetCountBuffer() const
+{
+    return m_count_buffer;
+}
+
+template <typename T>
+bool Rndr::Canvas::DrawCommandBuffer<T>::IsValid() const
+{
+    return m_buffer.IsValid() && m_count_buffer.IsValid();
+}
+
+template class Rndr::Canvas::DrawCommandBuffer<Rndr::Canvas::DrawCommand>;
+template class Rndr::Canvas::DrawCommandBuffer<Rndr::Canvas::DrawIndexedCommand>;
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "rndr/canvas/draw-list.hpp"
+
+namespace Rndr::Canvas::Impl
+{
+
+/**
+ * @return Stats of the DrawList that is currently executing, or nullptr outside of
+ * DrawList::Execute(). Brushes and meshes report the work they do on the list's behalf through it.
+ */
+DrawListStats* GetActiveDrawListStats();
+
+/** Routes reported work to a list's stats for its lifetime and restores the previous stats, even if execution throws. */
+struct ScopedActiveDrawListStats
+{
+    explicit ScopedActiveDrawListStats(DrawListStats* stats);
+    ~ScopedActiveDrawListStats();
+
+    ScopedActiveDrawListStats(const ScopedActiveDrawListStats&) = delete;
+    ScopedActiveDrawListStats& operator=(const ScopedActiveDrawListStats&) = delete;
+
+private:
+    DrawListStats* m_previous_stats;
+};
+
+}  // namespace Rndr::Canvas::Impl
@@ -2,12 +2,367 @@
 
 #include "glad/glad.h"
 
+#include "canvas/barrier-tracker.hpp"
+#include "canvas/draw-list-stats.hpp"
+#include "canvas/draw-sort.hpp"
+#include "canvas/gl-state-cache.hpp"
+#include "canvas/uniform-ring-buffer.hpp"
+
 #include "rndr/canvas/brush.hpp"
+#include "rndr/canvas/buffer.hpp"
 #include "rndr/canvas/context.hpp"
+#include "rndr/canvas/draw-command-buffer.hpp"
 #include "rndr/canvas/mesh.hpp"
 #include "rndr/canvas/render-target.hpp"
+#include "rndr/canvas/shader.hpp"
+#include "rndr/canvas/texture.hpp"
+#include "rndr/definitions.hpp"
+#include "rndr/time.hpp"
 #include "rndr/trace.hpp"
 
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace
+{
+
+Rndr::Canvas::DrawListStats* g_active_stats = nullptr;
+
+Rndr::u32 HashTextureSet(const Rndr::Canvas::Brush& brush)
+{
+    Rndr::u32 hash = 0;
+    const Opal::DynamicArray<Rndr::Canvas::TextureBinding>& textures = brush.GetTextures();
+    for (Rndr::u64 i = 0; i < textures.GetSize(); ++i)
+    {
+        const Rndr::u32 handle = textures[i].texture != nullptr ? textures[i].texture->GetNativeHandle() : 0;
+        hash = hash * 31 + handle;
+    }
+    return hash;
+}
+
+Rndr::u64 GetTriangleCount(const Rndr::Canvas::Mesh& mesh)
+{
+    return (mesh.HasIndices() ? mesh.GetIndexCount() : mesh.GetVertexCount()) / 3;
+}
+
+void BindVertexArray(Rndr::u32 vertex_array)
+{
+    Rndr::Canvas::Impl::GLStateCache* state_cache = Rndr::Canvas::Impl::GetStateCache();
+    RNDR_ASSERT(state_cache != nullptr, "Draw executed without a live Canvas::Context!");
+    state_cache->BindVertexArray(vertex_array);
+}
+
+void ExecuteClear(const Rndr::Canvas::Impl::ClearCommand& c)
+{
+    GLbitfield mask = 0;
+    if (c.clear_color)
+    {
+        glClearColor(c.color.x, c.color.y, c.color.z, c.color.w);
+        mask |= GL_COLOR_BUFFER_BIT;
+    }
+    if (c.clear_depth)
+    {
+        glClearDepth(static_cast<GLdouble>(c.depth));
+        mask |= GL_DEPTH_BUFFER_BIT;
+    }
+    if (c.clear_stencil)
+    {
+        glClearStencil(c.stencil);
+        mask |= GL_STENCIL_BUFFER_BIT;
+    }
+    if (mask != 0)
+    {
+        glClear(mask);
+    }
+}
+
+void AppendBrushBindings(const Rndr::Canvas::Brush& brush, Opal::DynamicArray<Rndr::Canvas::Impl::BakedBinding>& out_bindings)
+{
+    using namespace Rndr::Canvas;
+
+    const Shader* shader = brush.GetShader();
+    const Opal::DynamicArray<TextureBinding>& textures = brush.GetTextures();
+    for (Rndr::u64 i = 0; i < textures.GetSize(); ++i)
+    {
+        const TextureBinding& tb = textures[i];
+        if (tb.texture == nullptr || !tb.texture->IsValid())
+        {
+            continue;
+        }
+        const ShaderParameter* param = shader->FindParameter(tb.name);
+        if (param != nullptr && param->category == ParameterCategory::Texture)
+        {
+            out_bindings.PushBack(
+                {Impl::BakedBindingType::Texture, static_cast<Rndr::u32>(param->binding_index), tb.texture->GetNativeHandle()});
+        }
+    }
+
+    const Opal::DynamicArray<BufferBinding>& buffers = brush.GetBuffers();
+    for (Rndr::u64 i = 0; i < buffers.GetSize(); ++i)
+    {
+        const BufferBinding& bb = buffers[i];
+        if (bb.buffer == nullptr || !bb.buffer->IsValid())
+        {
+            continue;
+        }
+        const ShaderParameter* param = shader->FindParameter(bb.name);
+        if (param != nullptr && param->category == ParameterCategory::StorageBuffer)
+        {
+            out_bindings.PushBack(
+                {Impl::BakedBindingType::StorageBuffer, static_cast<Rndr::u32>(param->binding_index), bb.buffer->GetNativeHandle()});
+        }
+    }
+}
+
+/** Bind the program, pipeline state, uniforms and resources of a baked draw or dispatch. */
+void ApplyBakedBrush(Rndr::Canvas::Brush& brush, Rndr::u32 program, const Rndr::Canvas::Impl::BakedBinding* bindings,
+                     Rndr::u32 binding_count)
+{
+    using namespace Rndr::Canvas;
+
+    if (program == 0)
+    {
+        return;
+    }
+
+    Impl::GLStateCache* state_cache = Impl::GetStateCache();
+    RNDR_ASSERT(state_cache != nullptr, "BakedDrawList::Execute called without a live Canvas::Context!");
+
+    state_cache->UseProgram(program);
+    state_cache->ApplyPipelineState(brush.GetPipelineStateId(), brush.GetDesc());
+    // Uniform ring buffer ranges change whenever uniforms are uploaded, so they are not baked.
+    brush.UploadUniforms();
+    const Rndr::u32 ring_buffer = Impl::GetUniformRingBuffer()->GetNativeHandle();
+    const Opal::DynamicArray<UniformBufferSlot>& slots = brush.GetUniformBufferSlots();
+    for (Rndr::u64 i = 0; i < slots.GetSize(); ++i)
+    {
+        state_cache->BindUniformBufferRange(static_cast<Rndr::u32>(slots[i].binding_index), ring_buffer, slots[i].ring_offset,
+                                            brush.GetUniformData(i).GetSize());
+    }
+    for (Rndr::u32 i = 0; i < binding_count; ++i)
+    {
+        const Impl::BakedBinding& binding = bindings[i];
+        switch (binding.type)
+        {
+            case Impl::BakedBindingType::Texture:
+                state_cache->BindTextureUnit(binding.index, binding.handle);
+                break;
+            case Impl::BakedBindingType::StorageBuffer:
+                state_cache->BindStorageBuffer(binding.index, binding.handle);
+                break;
+        }
+    }
+}
+
+void BakeDraw(Rndr::Canvas::Mesh& mesh, Rndr::Canvas::Brush& brush, Rndr::Canvas::Impl::BakedDrawCommand& out_cmd,
+              Opal::DynamicArray<Rndr::Canvas::Impl::BakedBinding>& out_bindings)
+{
+    mesh.Upload();
+    out_cmd.brush = &brush;
+    out_cmd.vertex_array = mesh.GetNativeHandle();
+    out_cmd.indexed = mesh.HasIndices();
+    out_cmd.element_count = static_cast<Rndr::u32>(out_cmd.indexed ? mesh.GetIndexCount() : mesh.GetVertexCount());
+    if (brush.GetShader() != nullptr)
+    {
+        out_cmd.program = brush.GetShader()->GetNativeHandle();
+        out_cmd.first_binding = static_cast<Rndr::u32>(out_bindings.GetSize());
+        AppendBrushBindings(brush, out_bindings);
+        out_cmd.binding_count = static_cast<Rndr::u32>(out_bindings.GetSize()) - out_cmd.first_binding;
+    }
+}
+
+/** Execute an indirect draw. Counts it in @p stats unless it is nullptr. */
+template <typename Command>
+void ExecuteIndirect(const Command& c, Rndr::Canvas::DrawListStats* stats)
+{
+    using namespace Rndr::Canvas;
+    constexpr bool k_indexed = std::is_same_v<Command, Impl::DrawIndexedIndirectCommand>;
+
+    Mesh& mesh = *c.mesh;
+    Brush& brush = *c.brush;
+    auto& commands = *c.commands;
+    const bool gpu_count = c.gpu_count;
+
+    if (!gpu_count && commands.GetCount() == 0)
+    {
+        return;
+    }
+
+    if (stats != nullptr)
+    {
+        ++stats->indirect_draw_count;
+        if (!gpu_count)
+        {
+            const auto staged_commands = commands.GetCommands();
+            for (Rndr::u64 i = 0; i < staged_commands.GetSize(); ++i)
+            {
+                Rndr::u64 element_count = 0;
+                if constexpr (k_indexed)
+                {
+                    element_count = staged_commands[i].index_count;
+                }
+                else
+                {
+                    element_count = staged_commands[i].vertex_count;
+                }
+                stats->triangle_count += element_count / 3 * staged_commands[i].instance_count;
+                stats->instance_count += staged_commands[i].instance_count;
+            }
+        }
+    }
+
+    brush.Apply();
+    mesh.Upload();
+    commands.Upload();
+
+    Impl::GLStateCache* state_cache = Impl::GetStateCache();
+    RNDR_ASSERT(state_cache != nullptr, "Indirect draw executed without a live Canvas::Context!");
+    state_cache->BindVertexArray(mesh.GetNativeHandle());
+    state_cache->BindDrawIndirectBuffer(commands.GetBuffer().GetNativeHandle());
+    if (gpu_count)
+    {
+        state_cache->BindParameterBuffer(commands.GetCountBuffer().GetNativeHandle());
+        const GLsizei max_count = static_cast<GLsizei>(commands.GetMaxCount());
+        if constexpr (k_indexed)
+        {
+            glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 0, max_count, 0);
+        }
+        else
+        {
+            glMultiDrawArraysIndirectCount(GL_TRIANGLES, nullptr, 0, max_count, 0);
+        }
+    }
+    else
+    {
+        const GLsizei count = static_cast<GLsizei>(commands.GetCount());
+        if constexpr (k_indexed)
+        {
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, count, 0);
+        }
+        else
+        {
+            glMultiDrawArraysIndirect(GL_TRIANGLES, nullptr, count, 0);
+        }
+    }
+}
+
+void ExecuteResetDrawCount(const Rndr::Canvas::Impl::ResetDrawCountCommand& c)
+{
+    // Dispatches that write the count end with a barrier that covers buffer updates.
+    const Rndr::u32 zero = 0;
+    c.count_buffer->Update(Opal::AsBytes(zero));
+}
+
+void ExecuteCommand(const Rndr::Canvas::Impl::CommandHeader& command, Rndr::Canvas::DrawListStats& stats)
+{
+    using namespace Rndr::Canvas;
+
+    Impl::VisitCommand(command, Opal::Overloaded{
+        [](const Impl::SetViewportCommand& c) { glViewport(c.x, c.y, c.width, c.height); },
+        [&stats](const Impl::SetRenderTargetCommand& c)
+        {
+            ++stats.render_target_switches;
+            glBindFramebuffer(GL_FRAMEBUFFER, c.target->GetNativeHandle());
+        },
+        [&stats](const Impl::SetContextCommand& c)
+        {
+            ++stats.render_target_switches;
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(0, 0, c.context->GetWidth(), c.context->GetHeight());
+        },
+        [&stats](const Impl::DrawMeshCommand& c)
+        {
+            c.brush->Apply();
+            c.mesh->Upload();
+            ++stats.draw_count;
+            ++stats.instance_count;
+            stats.triangle_count += GetTriangleCount(*c.mesh);
+            BindVertexArray(c.mesh->GetNativeHandle());
+            if (c.mesh->HasIndices())
+            {
+                glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(c.mesh->GetIndexCount()), GL_UNSIGNED_INT, nullptr);
+            }
+            else
+            {
+                glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(c.mesh->GetVertexCount()));
+            }
+        },
+        [&stats](const Impl::DrawMeshInstancedCommand& c)
+        {
+            c.brush->Apply();
+            c.mesh->Upload();
+            ++stats.instanced_draw_count;
+            stats.instance_count += c.instance_count;
+            stats.triangle_count += GetTriangleCount(*c.mesh) * c.instance_count;
+            BindVertexArray(c.mesh->GetNativeHandle());
+            if (c.mesh->HasIndices())
+            {
+                glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(c.mesh->GetIndexCount()), GL_UNSIGNED_INT,
+                                        nullptr, static_cast<GLsizei>(c.instance_count));
+            }
+            else
+            {
+                glDrawArraysInstanced(GL_TRIANGLES, 0, static_cast<GLsizei>(c.mesh->GetVertexCount()),
+                                      static_cast<GLsizei>(c.instance_count));
+            }
+        },
+        [&stats](const Impl::DrawMeshRangeCommand& c)
+        {
+            c.brush->Apply();
+            c.mesh->Upload();
+            if (c.instance_count == 1)
+            {
+                ++stats.draw_count;
+            }
+            else
+            {
+                ++stats.instanced_draw_count;
+            }
+            stats.instance_count += c.instance_count;
+            stats.triangle_count += static_cast<Rndr::u64>(c.index_count / 3) * c.instance_count;
+            BindVertexArray(c.mesh->GetNativeHandle());
+            if (c.mesh->HasIndices())
+            {
+                const auto* first_index = reinterpret_cast<const void*>(static_cast<uintptr_t>(c.first_index) * sizeof(Rndr::u32));
+                glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, static_cast<GLsizei>(c.index_count), GL_UNSIGNED_INT,
+                                                              first_index, static_cast<GLsizei>(c.instance_count), c.base_vertex,
+                                                              c.first_instance);
+            }
+            else
+            {
+                glDrawArraysInstancedBaseInstance(GL_TRIANGLES, c.base_vertex, static_cast<GLsizei>(c.index_count),
+                                                  static_cast<GLsizei>(c.instance_count), c.first_instance);
+            }
+        },
+        [&stats](const Impl::DrawIndirectCommand& c) { ExecuteIndirect(c, &stats); },
+        [&stats](const Impl::DrawIndexedIndirectCommand& c) { ExecuteIndirect(c, &stats); },
+        [](const Impl::ResetDrawCountCommand& c) { ExecuteResetDrawCount(c); },
+        [&stats](const Impl::DispatchCommand& c)
+        {
+            c.brush->Apply();
+            ++stats.dispatch_count;
+            glDispatchCompute(c.group_count_x, c.group_count_y, c.group_count_z);
+            const Rndr::u32 barrier_bits = Impl::GetDispatchBarrierBits(*c.brush);
+            if (barrier_bits != 0)
+            {
+                glMemoryBarrier(barrier_bits);
+            }
+        },
+        [](const Impl::ClearCommand& c) { ExecuteClear(c); },
+        [](const Impl::BeginEventCommand& c)
+        {
+            Trace::BeginGpuEvent(c.event_name);
+        },
+        [](const Impl::EndEventCommand& c)
+        {
+            Trace::EndGpuEvent(c.event_name);
+        }
+    });
+}
+
+}  // namespace
+
 void Rndr::Canvas::DrawList::SetViewport(i32 x, i32 y, i32 width, i32 height)
 {
     Impl::SetViewportCommand cmd;
@@ -15,21 +370,21 @@ void Rndr::Canvas::DrawList::SetViewport(i32 x, i32 y, i32 width, i32 height)
     cmd.y = y;
     cmd.width = width;
     cmd.height = height;
-    m_commands.EmplaceBack(cmd);
+    Record(cmd);
 }
 
 void Rndr::Canvas::DrawList::SetRenderTarget(const RenderTarget& target)
 {
     Impl::SetRenderTargetCommand cmd;
     cmd.target = &target;
-    m_commands.PushBack(std::move(cmd));
+    Record(cmd);
 }
 
 void Rndr::Canvas::DrawList::SetRenderTarget(const Context& context)
 {
     Impl::SetContextCommand cmd;
     cmd.context = &context;
-    m_commands.PushBack(std::move(cmd));
+    Record(cmd);
 }
 
 void Rndr::Canvas::DrawList::Clear(const Vector4f& color, f32 depth, i32 stencil)
@@ -41,7 +396,7 @@ void Rndr::Canvas::DrawList::Clear(const Vector4f& color, f32 depth, i32 stencil
     cmd.clear_color = true;
     cmd.clear_depth = true;
     cmd.clear_stencil = true;
-    m_commands.EmplaceBack(cmd);
+    Record(cmd);
 }
 
 void Rndr::Canvas::DrawList::ClearColor(const Vector4f& color)
@@ -51,7 +406,7 @@ void Rndr::Canvas::DrawList::ClearColor(const Vector4f& color)
     cmd.clear_color = true;
     cmd.clear_depth = false;
     cmd.clear_stencil = false;
-    m_commands.EmplaceBack(cmd);
+    Record(cmd);
 }
 
 void Rndr::Canvas::DrawList::ClearDepthStencil(f32 depth, i32 stencil)
@@ -62,7 +417,7 @@ void Rndr::Canvas::DrawList::ClearDepthStencil(f32 depth, i32 stencil)
     cmd.clear_color = false;
     cmd.clear_depth = true;
     cmd.clear_stencil = true;
-    m_commands.EmplaceBack(cmd);
+    Record(cmd);
 }
 
 void Rndr::Canvas::DrawList::Draw(Mesh& mesh, Brush& brush)
@@ -70,7 +425,7 @@ void Rndr::Canvas::DrawList::Draw(Mesh& mesh, Brush& brush)
     Impl::DrawMeshCommand cmd;
     cmd.mesh = &mesh;
     cmd.brush = &brush;
-    m_commands.PushBack(std::move(cmd));
+    Record(cmd);
 }
 
 void Rndr::Canvas::DrawList::DrawInstanced(Mesh& mesh, Brush& brush, u32 instance_count)
@@ -79,26 +434,81 @@ void Rndr::Canvas::DrawList::DrawInstanced(Mesh& mesh, Brush& brush, u32 instanc
     cmd.mesh = &mesh;
     cmd.brush = &brush;
     cmd.instance_count = instance_count;
-    m_commands.PushBack(std::move(cmd));
-}
-
-// void Rndr::Canvas::DrawList::DrawIndirect(const Mesh& mesh, Brush& brush, const DrawCommandBuffer<DrawCommand>& commands)
-// {
-//     Impl::DrawIndirectCommand cmd;
-//     cmd.mesh = &mesh;
-//     cmd.brush = &brush;
-//     cmd.commands = &commands;
-//     m_commands.EmplaceBack(cmd);
-// }
-//
-// void Rndr::Canvas::DrawList::DrawIndexedIndirect(const Mesh& mesh, Brush& brush, const DrawCommandBuffer<DrawIndexedCommand>& commands)
-// {
-//     Impl::DrawIndexedIndirectCommand cmd;
-//     cmd.mesh = &mesh;
-//     cmd.brush = &brush;
-//     cmd.commands = &commands;
-//     m_commands.EmplaceBack(cmd);
-// }
+    Record(cmd);
+}
+
+void Rndr::Canvas::DrawList::Draw(Mesh& mesh, Brush& brush, const MeshRange& range)
+{
+    DrawInstanced(mesh, brush, range, 1, 0);
+}
+
+void Rndr::Canvas::DrawList::DrawInstanced(Mesh& mesh, Brush& brush, const MeshRange& range, u32 instance_count, u32 first_instance)
+{
+    Impl::DrawMeshRangeCommand cmd;
+    cmd.mesh = &mesh;
+    cmd.brush = &brush;
+    cmd.first_index = range.first_index;
+    cmd.index_count = range.index_count;
+    cmd.base_vertex = range.base_vertex;
+    cmd.instance_count = instance_count;
+    cmd.first_instance = first_instance;
+    Record(cmd);
+}
+
+void Rndr::Canvas::DrawList::DrawIndirect(Mesh& mesh, Brush& brush, DrawCommandBuffer<DrawCommand>& commands)
+{
+    Impl::DrawIndirectCommand cmd;
+    cmd.mesh = &mesh;
+    cmd.brush = &brush;
+    cmd.commands = &commands;
+    Record(cmd);
+}
+
+void Rndr::Canvas::DrawList::DrawIndexedIndirect(Mesh& mesh, Brush& brush, DrawCommandBuffer<DrawIndexedCommand>& commands)
+{
+    Impl::DrawIndexedIndirectCommand cmd;
+    cmd.mesh = &mesh;
+    cmd.brush = &brush;
+    cmd.commands = &commands;
+    Record(cmd);
+}
+
+void Rndr::Canvas::DrawList::DrawIndirectCount(Mesh& mesh, Brush& brush, DrawCommandBuffer<DrawCommand>& commands)
+{
+    Impl::DrawIndirectCommand cmd;
+    cmd.mesh = &mesh;
+    cmd.brush = &brush;
+    cmd.commands = &commands;
+    cmd.gpu_count = true;
+    Record(cmd);
+}
+
+void Rndr::Canvas::DrawList::DrawIndexedIndirectCount(Mesh& mesh, Brush& brush, DrawCommandBuffer<DrawIndexedCommand>& commands)
+{
+    Impl::DrawIndexedIndirectCommand cmd;
+    cmd.mesh = &mesh;
+    cmd.brush = &brush;
+    cmd.commands = &commands;
+    cmd.gpu_count = true;
+    Record(cmd);
+}
+
+void Rndr::Canvas::DrawList::ResetDrawCount(const DrawCommandBuffer<DrawCommand>& commands)
+{
+    ResetDrawCount(commands.GetCountBuffer());
+}
+
+void Rndr::Canvas::DrawList::ResetDrawCount(const DrawCommandBuffer<DrawIndexedCommand>& commands)
+{
+    ResetDrawCount(commands.GetCountBuffer());
+}
+
+void Rndr::Canvas::DrawList::ResetDrawCount(const Buffer& count_buffer)
+{
+    Impl::ResetDrawCountCommand cmd;
+    cmd.count_buffer = &count_buffer;
+    Record(cmd);
+}
 
 void Rndr::Canvas::DrawList::Dispatch(Brush& brush, u32 group_count_x, u32 group_count_y, u32 group_count_z)
 {
@@ -107,102 +517,436 @@ void Rndr::Canvas::DrawList::Dispatch(Brush& brush, u32 group_count_x, u32 group
     cmd.group_count_x = group_count_x;
     cmd.group_count_y = group_count_y;
     cmd.group_count_z = group_count_z;
-    m_commands.EmplaceBack(cmd);
+    Record(cmd);
 }
 
 void Rndr::Canvas::DrawList::BeginEvent(const char* event_name)
 {
-    m_commands.EmplaceBack<Impl::BeginEventCommand>({event_name});
+    Record(Impl::BeginEventCommand{event_name});
 }
 
 void Rndr::Canvas::DrawList::EndEvent(const char* event_name)
 {
-    m_commands.EmplaceBack<Impl::EndEventCommand>({event_name});
+    Record(Impl::EndEventCommand{event_name});
+}
+
+void Rndr::Canvas::DrawList::Append(DrawList& secondary)
+{
+    RNDR_ASSERT(&secondary != this, "Can't append a draw list to itself!");
+
+    secondary.m_arena.ForEach([this](const Impl::CommandHeader& header) { RecordRaw(header); });
+    secondary.Reset();
+}
+
+void Rndr::Canvas::DrawList::Append(Opal::ArrayView<DrawList> secondaries)
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::DrawList::Append");
+
+    for (u64 i = 0; i < secondaries.GetSize(); ++i)
+    {
+        Append(secondaries[i]);
+    }
+}
+
+Rndr::u64 Rndr::Canvas::DrawList::GetCommandCount() const
+{
+    return m_command_count;
+}
+
+void Rndr::Canvas::DrawList::SetSortMode(DrawSortMode mode)
+{
+    m_sort_mode = mode;
+}
+
+Rndr::Canvas::DrawSortMode Rndr::Canvas::DrawList::GetSortMode() const
+{
+    return m_sort_mode;
+}
+
+void Rndr::Canvas::DrawList::SetCommandTimingEnabled(bool enabled)
+{
+    m_command_timing_enabled = enabled;
+}
+
+bool Rndr::Canvas::DrawList::IsCommandTimingEnabled() const
+{
+    return m_command_timing_enabled;
+}
+
+template <typename T>
+void Rndr::Canvas::DrawList::Record(const T& command)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Commands are copied into the arena and never destroyed!");
+    constexpr u64 k_payload_size = sizeof(T);
+    constexpr u64 k_record_size =
+        (sizeof(Impl::CommandHeader) + k_payload_size + Impl::CommandArena::k_alignment - 1) & ~(Impl::CommandArena::k_alignment - 1);
+
+    Impl::CommandHeader* header = static_cast<Impl::CommandHeader*>(m_arena.Allocate(k_record_size));
+    header->type = T::k_type;
+    header->size = static_cast<u32>(k_record_size);
+    memcpy(header + 1, &command, k_payload_size);
+    ++m_command_count;
+}
+
+void Rndr::Canvas::DrawList::RecordRaw(const Impl::CommandHeader& header)
+{
+    memcpy(m_arena.Allocate(header.size), &header, header.size);
+    ++m_command_count;
+}
+
+void Rndr::Canvas::DrawList::Reset()
+{
+    m_arena.Reset();
+    m_command_count = 0;
+    m_sort_entries.Clear();
+    m_sort_runs.Clear();
+    m_sort_records.Clear();
+}
+
+void Rndr::Canvas::DrawList::SortDraws()
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::DrawList::SortDraws");
+
+    m_sort_entries.Clear();
+    m_sort_runs.Clear();
+    m_sort_records.Clear();
+
+    u32 command_index = 0;
+    m_arena.ForEach(
+        [this, &command_index](const Impl::CommandHeader& header)
+        {
+            const u32 index = command_index++;
+            const Brush* brush = nullptr;
+            const Mesh* mesh = nullptr;
+            Impl::VisitCommand(header, Opal::Overloaded{[&](const Impl::DrawMeshCommand& c)
+                                                  {
+                                                      brush = c.brush;
+                                                      mesh = c.mesh;
+                                                  },
+                                                  [&](const Impl::DrawMeshInstancedCommand& c)
+                                                  {
+                                                      brush = c.brush;
+                                                      mesh = c.mesh;
+                                                  },
+                                                  [&](const Impl::DrawMeshRangeCommand& c)
+                                                  {
+                                                      brush = c.brush;
+                                                      mesh = c.mesh;
+                                                  },
+                                                  [](const auto&) {}});
+            if (brush == nullptr || brush->GetShader() == nullptr || !Impl::IsDrawReorderable(brush->GetDesc()))
+            {
+                return;
+            }
+
+            Impl::DrawSortEntry entry;
+            entry.key = Impl::MakeDrawSortKey(brush->GetShader()->GetNativeHandle(), brush->GetPipelineStateId(), HashTextureSet(*brush),
+                                              mesh->GetNativeHandle());
+            entry.command_index = index;
+
+            // Extend the current run if this draw directly follows its last command, otherwise start a new one.
+            const u32 entry_index = static_cast<u32>(m_sort_entries.GetSize());
+            const u64 run_count = m_sort_runs.GetSize();
+            if (run_count > 0 && m_sort_runs[run_count - 1].first_command + m_sort_runs[run_count - 1].count == index)
+            {
+                ++m_sort_runs[run_count - 1].count;
+            }
+            else
+            {
+                Impl::DrawSortRun run;
+                run.first_command = index;
+                run.first_entry = entry_index;
+                run.count = 1;
+                m_sort_runs.PushBack(run);
+            }
+            m_sort_entries.PushBack(entry);
+            m_sort_records.PushBack(&header);
+        });
+
+    m_sort_scratch.Resize(m_sort_entries.GetSize());
+    for (u64 i = 0; i < m_sort_runs.GetSize(); ++i)
+    {
+        const Impl::DrawSortRun& run = m_sort_runs[i];
+        Impl::RadixSortDrawEntries(m_sort_entries.GetData() + run.first_entry, m_sort_scratch.GetData(), run.count);
+    }
+}
+
+template <typename Fn>
+void Rndr::Canvas::DrawList::ForEachInExecutionOrder(Fn&& fn)
+{
+    if (m_sort_mode == DrawSortMode::StateSorted)
+    {
+        SortDraws();
+    }
+
+    // Records of a run are only known in recording order, so the k-th command of a run is found at
+    // m_sort_records[run.first_entry + k]. Once a run is emitted, its remaining records are skipped.
+    u64 run_index = 0;
+    u32 command_index = 0;
+    u32 skip_count = 0;
+    m_arena.ForEach(
+        [&](const Impl::CommandHeader& header)
+        {
+            const u32 index = command_index++;
+            if (skip_count > 0)
+            {
+                --skip_count;
+                return;
+            }
+            if (run_index < m_sort_runs.GetSize() && m_sort_runs[run_index].first_command == index)
+            {
+                const Impl::DrawSortRun& run = m_sort_runs[run_index];
+                for (u32 j = 0; j < run.count; ++j)
+                {
+                    const u32 position_in_run = m_sort_entries[run.first_entry + j].command_index - run.first_command;
+                    fn(*m_sort_records[run.first_entry + position_in_run]);
+                }
+                skip_count = run.count - 1;
+                ++run_index;
+                return;
+            }
+            fn(header);
+        });
+
+    Reset();
 }
 
 void Rndr::Canvas::DrawList::Execute()
 {
     RNDR_CPU_EVENT_SCOPED("Canvas::DrawList::Execute");
 
+    m_stats = {};
+    const Timestamp execute_start = GetTimestamp();
+    {
+        const Impl::ScopedActiveDrawListStats active_stats(&m_stats);
+        if (m_command_timing_enabled)
+        {
+            ForEachInExecutionOrder(
+                [this](const Impl::CommandHeader& command)
+                {
+                    const Timestamp command_start = GetTimestamp();
+                    ExecuteCommand(command, m_stats);
+                    m_stats.command_cpu_time[static_cast<u64>(command.type)] += GetDuration(command_start, GetTimestamp());
+                });
+        }
+        else
+        {
+            ForEachInExecutionOrder([this](const Impl::CommandHeader& command) { ExecuteCommand(command, m_stats); });
+        }
+    }
+    m_stats.total_cpu_time = GetDuration(execute_start, GetTimestamp());
+}
+
+const Rndr::Canvas::DrawListStats& Rndr::Canvas::DrawList::GetStats() const
+{
+    return m_stats;
+}
+
+Rndr::Canvas::BakedDrawList Rndr::Canvas::DrawList::Bake()
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::DrawList::Bake");
+
+    BakedDrawList baked;
+    ForEachInExecutionOrder(
+        [&baked](const Impl::CommandHeader& command)
+        {
+            Impl::VisitCommand(command, Opal::Overloaded{
+                [&baked](const Impl::SetViewportCommand& c) { baked.m_commands.PushBack(c); },
+                [&baked](const Impl::SetRenderTargetCommand& c)
+                {
+                    Impl::BakedSetRenderTargetCommand cmd;
+                    cmd.framebuffer = c.target->GetNativeHandle();
+                    baked.m_commands.PushBack(cmd);
+                },
+                [&baked](const Impl::SetContextCommand& c) { baked.m_commands.PushBack(c); },
+                [&baked](const Impl::DrawMeshCommand& c)
+                {
+                    Impl::BakedDrawCommand cmd;
+                    BakeDraw(*c.mesh, *c.brush, cmd, baked.m_bindings);
+                    baked.m_commands.PushBack(cmd);
+                },
+                [&baked](const Impl::DrawMeshInstancedCommand& c)
+                {
+                    Impl::BakedDrawCommand cmd;
+                    BakeDraw(*c.mesh, *c.brush, cmd, baked.m_bindings);
+                    cmd.instance_count = c.instance_count;
+                    baked.m_commands.PushBack(cmd);
+                },
+                [&baked](const Impl::DrawMeshRangeCommand& c)
+                {
+                    Impl::BakedDrawCommand cmd;
+                    BakeDraw(*c.mesh, *c.brush, cmd, baked.m_bindings);
+                    cmd.first_element = c.first_index;
+                    cmd.element_count = c.index_count;
+                    cmd.base_vertex = c.base_vertex;
+                    cmd.instance_count = c.instance_count;
+                    cmd.first_instance = c.first_instance;
+                    baked.m_commands.PushBack(cmd);
+                },
+                [&baked](const Impl::DrawIndirectCommand& c) { baked.m_commands.PushBack(c); },
+                [&baked](const Impl::DrawIndexedIndirectCommand& c) { baked.m_commands.PushBack(c); },
+                [&baked](const Impl::ResetDrawCountCommand& c) { baked.m_commands.PushBack(c); },
+                [&baked](const Impl::DispatchCommand& c)
+                {
+                    Impl::BakedDispatchCommand cmd;
+                    cmd.brush = c.brush;
+                    cmd.group_count_x = c.group_count_x;
+                    cmd.group_count_y = c.group_count_y;
+                    cmd.group_count_z = c.group_count_z;
+                    cmd.barrier_bits = Impl::GetDispatchBarrierBits(*c.brush);
+                    if (c.brush->GetShader() != nullptr)
+                    {
+                        cmd.program = c.brush->GetShader()->GetNativeHandle();
+                        cmd.first_binding = static_cast<u32>(baked.m_bindings.GetSize());
+                        AppendBrushBindings(*c.brush, baked.m_bindings);
+                        cmd.binding_count = static_cast<u32>(baked.m_bindings.GetSize()) - cmd.first_binding;
+                    }
+                    baked.m_commands.PushBack(cmd);
+                },
+                [&baked](const Impl::ClearCommand& c) { baked.m_commands.PushBack(c); },
+                [&baked](const Impl::BeginEventCommand& c) { baked.m_commands.PushBack(c); },
+                [&baked](const Impl::EndEventCommand& c) { baked.m_commands.PushBack(c); }});
+        });
+    return baked;
+}
+
+void Rndr::Canvas::BakedDrawList::Execute()
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::BakedDrawList::Execute");
+
     for (u64 i = 0; i < m_commands.GetSize(); ++i)
     {
         m_commands[i].Visit(Opal::Overloaded{
             [](const Impl::SetViewportCommand& c) { glViewport(c.x, c.y, c.width, c.height); },
-            [](const Impl::SetRenderTargetCommand& c) { glBindFramebuffer(GL_FRAMEBUFFER, c.target->GetNativeHandle()); },
+            [](const Impl::BakedSetRenderTargetCommand& c) { glBindFramebuffer(GL_FRAMEBUFFER, c.framebuffer); },
             [](const Impl::SetContextCommand& c)
             {
                 glBindFramebuffer(GL_FRAMEBUFFER, 0);
                 glViewport(0, 0, c.context->GetWidth(), c.context->GetHeight());
             },
-            [](const Impl::DrawMeshCommand& c)
+            [this](const Impl::BakedDrawCommand& c)
             {
-                c.brush->Apply();
-                c.mesh->Upload();
-                glBindVertexArray(c.mesh->GetNativeHandle());
-                if (c.mesh->HasIndices())
+                ApplyBakedBrush(*c.brush, c.program, m_bindings.GetData() + c.first_binding, c.binding_count);
+                BindVertexArray(c.vertex_array);
+                if (c.indexed)
                 {
-                    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(c.mesh->GetIndexCount()), GL_UNSIGNED_INT, nullptr);
+                    const auto* first_index = reinterpret_cast<const void*>(static_cast<uintptr_t>(c.first_element) * sizeof(u32));
+                    glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, static_cast<GLsizei>(c.element_count), GL_UNSIGNED_INT,
+                                                                  first_index, static_cast<GLsizei>(c.instance_count), c.base_vertex,
+                                                                  c.first_instance);
                 }
                 else
                 {
-                    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(c.mesh->GetVertexCount()));
+                    glDrawArraysInstancedBaseInstance(GL_TRIANGLES, c.base_vertex, static_cast<GLsizei>(c.element_count),
+                                                      static_cast<GLsizei>(c.instance_count), c.first_instance);
                 }
             },
-            [](const Impl::DrawMeshInstancedCommand& c)
+            [](const Impl::DrawIndirectCommand& c) { ExecuteIndirect(c, nullptr); },
+            [](const Impl::DrawIndexedIndirectCommand& c) { ExecuteIndirect(c, nullptr); },
+            [](const Impl::ResetDrawCountCommand& c) { ExecuteResetDrawCount(c); },
+            [this](const Impl::BakedDispatchCommand& c)
             {
-                c.brush->Apply();
-                c.mesh->Upload();
-                glBindVertexArray(c.mesh->GetNativeHandle());
-                if (c.mesh->HasIndices())
-                {
-                    glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(c.mesh->GetIndexCount()), GL_UNSIGNED_INT,
-                                            nullptr, static_cast<GLsizei>(c.instance_count));
-                }
-                else
-                {
-                    glDrawArraysInstanced(GL_TRIANGLES, 0, static_cast<GLsizei>(c.mesh->GetVertexCount()),
-                                          static_cast<GLsizei>(c.instance_count));
-                }
-            },
-            [](const Impl::DispatchCommand& c)
-            {
-                c.brush->Apply();
+                ApplyBakedBrush(*c.brush, c.program, m_bindings.GetData() + c.first_binding, c.binding_count);
                 glDispatchCompute(c.group_count_x, c.group_count_y, c.group_count_z);
-                glMemoryBarrier(GL_ALL_BARRIER_BITS);
-            },
-            [](const Impl::ClearCommand& c)
-            {
-                GLbitfield mask = 0;
-                if (c.clear_color)
-                {
-                    glClearColor(c.color.x, c.color.y, c.color.z, c.color.w);
-                    mask |= GL_COLOR_BUFFER_BIT;
-                }
-                if (c.clear_depth)
-                {
-                    glClearDepth(static_cast<GLdouble>(c.depth));
-                    mask |= GL_DEPTH_BUFFER_BIT;
-                }
-                if (c.clear_stencil)
-                {
-                    glClearStencil(c.stencil);
-                    mask |= GL_STENCIL_BUFFER_BIT;
-                }
-                if (mask != 0)
+                if (c.barrier_bits != 0)
                 {
-                    glClear(mask);
+                    glMemoryBarrier(c.barrier_bits);
                 }
             },
-            [](const Impl::BeginEventCommand& c)
-            {
-                Trace::BeginGpuEvent(c.event_name);
-            },
-            [](const Impl::EndEventCommand& c)
-            {
-                Trace::EndGpuEvent(c.event_name);
-            }
-        });
+            [](const Impl::ClearCommand& c) { ExecuteClear(c); },
+            [](const Impl::BeginEventCommand& c) { Trace::BeginGpuEvent(c.event_name); },
+            [](const Impl::EndEventCommand& c) { Trace::EndGpuEvent(c.event_name); }});
+    }
+}
+
+Rndr::u64 Rndr::Canvas::BakedDrawList::GetCommandCount() const
+{
+    return m_commands.GetSize();
+}
+
+const char* Rndr::Canvas::GetCommandTypeName(DrawListCommandType type)
+{
+    switch (type)
+    {
+        case DrawListCommandType::SetViewport:
+            return "SetViewport";
+        case DrawListCommandType::SetRenderTarget:
+            return "SetRenderTarget";
+        case DrawListCommandType::SetContext:
+            return "SetContext";
+        case DrawListCommandType::DrawMesh:
+            return "DrawMesh";
+        case DrawListCommandType::DrawMeshInstanced:
+            return "DrawMeshInstanced";
+        case DrawListCommandType::DrawMeshRange:
+            return "DrawMeshRange";
+        case DrawListCommandType::DrawIndirect:
+            return "DrawIndirect";
+        case DrawListCommandType::DrawIndexedIndirect:
+            return "DrawIndexedIndirect";
+        case DrawListCommandType::ResetDrawCount:
+            return "ResetDrawCount";
+        case DrawListCommandType::Dispatch:
+            return "Dispatch";
+        case DrawListCommandType::Clear:
+            return "Clear";
+        case DrawListCommandType::BeginEvent:
+            return "BeginEvent";
+        case DrawListCommandType::EndEvent:
+            return "EndEvent";
+        default:
+            return "Unknown";
+    }
+}
+
+Rndr::Canvas::DrawListStats* Rndr::Canvas::Impl::GetActiveDrawListStats()
+{
+    return g_active_stats;
+}
+
+Rndr::Canvas::Impl::ScopedActiveDrawListStats::ScopedActiveDrawListStats(DrawListStats* stats) : m_previous_stats(g_active_stats)
+{
+    g_active_stats = stats;
+}
+
+Rndr::Canvas::Impl::ScopedActiveDrawListStats::~ScopedActiveDrawListStats()
+{
+    g_active_stats = m_previous_stats;
+}
+
+void* Rndr::Canvas::Impl::CommandArena::Allocate(u64 size)
+{
+    RNDR_ASSERT(size % k_alignment == 0, "Allocation size must be a multiple of the alignment!");
+    RNDR_ASSERT(size <= k_chunk_size, "Allocation does not fit in a chunk!");
+
+    if (m_chunks.IsEmpty())
+    {
+        m_chunks.PushBack(Chunk{});
+        m_chunks[0].data.Resize(k_chunk_size / sizeof(u64));
+        m_current_chunk = 0;
+    }
+    if (m_chunks[m_current_chunk].used + size > k_chunk_size)
+    {
+        ++m_current_chunk;
+        if (m_current_chunk == m_chunks.GetSize())
+        {
+            m_chunks.PushBack(Chunk{});
+            m_chunks[m_current_chunk].data.Resize(k_chunk_size / sizeof(u64));
+        }
+        m_chunks[m_current_chunk].used = 0;
     }
 
-    m_commands.Clear();
+    Chunk& chunk = m_chunks[m_current_chunk];
+    u8* memory = reinterpret_cast<u8*>(chunk.data.GetData()) + chunk.used;
+    chunk.used += size;
+    return memory;
+}
+
+void Rndr::Canvas::Impl::CommandArena::Reset()
+{
+    for (u64 i = 0; i < m_chunks.GetSize(); ++i)
+    {
+        m_chunks[i].used = 0;
+    }
+    m_current_chunk = 0;
 }
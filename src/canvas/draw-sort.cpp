@@ -0,0 +1,87 @@
+#include "canvas/draw-sort.hpp"
+
+#include <cstring>
+
+namespace
+{
+
+Rndr::u64 Fold16(Rndr::u32 value)
+{
+    return static_cast<Rndr::u64>((value ^ (value >> 16)) & 0xFFFF);
+}
+
+}  // namespace
+
+Rndr::u64 Rndr::Canvas::Impl::MakeDrawSortKey(u32 program, PipelineStateId pipeline_state, u32 texture_set, u32 mesh)
+{
+    u64 key = 0;
+    key |= Fold16(program) << 48;
+    key |= static_cast<u64>(pipeline_state) << 32;
+    key |= Fold16(texture_set) << 16;
+    key |= Fold16(mesh);
+    return key;
+}
+
+bool Rndr::Canvas::Impl::IsDrawReorderable(const BrushDesc& desc)
+{
+    if (!desc.depth_test || !desc.depth_write || desc.blend_mode != BlendMode::None)
+    {
+        return false;
+    }
+    switch (desc.depth_compare)
+    {
+        case CompareFunc::Less:
+        case CompareFunc::LessEqual:
+        case CompareFunc::Greater:
+        case CompareFunc::GreaterEqual:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void Rndr::Canvas::Impl::RadixSortDrawEntries(DrawSortEntry* entries, DrawSortEntry* scratch, u64 count)
+{
+    if (count < 2)
+    {
+        return;
+    }
+
+    DrawSortEntry* src = entries;
+    DrawSortEntry* dst = scratch;
+    for (u32 shift = 0; shift < 64; shift += 8)
+    {
+        u64 histogram[256] = {};
+        for (u64 i = 0; i < count; ++i)
+        {
+            ++histogram[(src[i].key >> shift) & 0xFF];
+        }
+
+        // All keys share this byte, the pass would not change the order.
+        if (histogram[(src[0].key >> shift) & 0xFF] == count)
+        {
+            continue;
+        }
+
+        u64 offset = 0;
+        for (u64& bucket : histogram)
+        {
+            const u64 bucket_size = bucket;
+            bucket = offset;
+            offset += bucket_size;
+        }
+        for (u64 i = 0; i < count; ++i)
+        {
+            dst[histogram[(src[i].key >> shift) & 0xFF]++] = src[i];
+        }
+
+        DrawSortEntry* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != entries)
+    {
+        memcpy(entries, src, count * sizeof(DrawSortEntry));
+    }
+}
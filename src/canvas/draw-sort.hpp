@@ -0,0 +1,40 @@
+#pragma once
+
+#include "rndr/canvas/brush.hpp"
+#include "rndr/canvas/draw-list.hpp"
+#include "rndr/types.hpp"
+
+namespace Rndr::Canvas::Impl
+{
+
+/**
+ * Build a 64-bit sort key for a draw. The key is laid out from the most significant bits down as
+ * shader program (16 bits), pipeline state id (16 bits), texture set (16 bits) and mesh (16 bits),
+ * so that sorting by key minimizes the most expensive state changes first.
+ * @param program Native handle of the shader program.
+ * @param pipeline_state Interned pipeline state of the brush.
+ * @param texture_set Hash of the textures bound by the brush.
+ * @param mesh Native handle of the mesh vertex array.
+ * @return Sort key.
+ */
+u64 MakeDrawSortKey(u32 program, PipelineStateId pipeline_state, u32 texture_set, u32 mesh);
+
+/**
+ * Check if a draw recorded with the given brush state can be reordered relative to other draws
+ * without changing the rendered image. This is the case for opaque draws that test and write depth
+ * with an ordering compare (Less, LessEqual, Greater or GreaterEqual), so the nearest surface wins
+ * regardless of the draw order. Draws that skip the depth write, like decals, or compare with
+ * Equal, NotEqual, Always or Never depend on what was drawn before them.
+ */
+bool IsDrawReorderable(const BrushDesc& desc);
+
+/**
+ * Stable LSD radix sort of draw entries by their key, 8 bits per pass. Passes where all keys share
+ * the same byte are skipped.
+ * @param entries Entries to sort. Sorted in place.
+ * @param scratch Scratch storage with room for at least @p count entries.
+ * @param count Number of entries.
+ */
+void RadixSortDrawEntries(DrawSortEntry* entries, DrawSortEntry* scratch, u64 count);
+
+}  // namespace Rndr::Canvas::Impl
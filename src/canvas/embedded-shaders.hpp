@@ -0,0 +1,13 @@
+#pragma once
+
+#include "opal/container/string.h"
+
+namespace Rndr::Canvas::Impl
+{
+
+/** Sources of the shaders that renderers embed instead of loading from assets. Used to add them to shader archives. */
+const Opal::StringUtf8& GetShapeRendererShaderSource();
+const Opal::StringUtf8& GetCubeMapRendererShaderSource();
+const Opal::StringUtf8& GetGridRendererShaderSource();
+
+}  // namespace Rndr::Canvas::Impl
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "opal/container/string.h"
+
+#include "rndr/types.hpp"
+
+namespace Rndr::Canvas::Impl
+{
+
+/** Start value of a 64-bit FNV-1a hash. */
+constexpr u64 k_fnv_offset_basis = 0xcbf29ce484222325ULL;
+
+/** Multiplier applied after each value is mixed into a 64-bit FNV-1a hash. */
+constexpr u64 k_fnv_prime = 0x100000001b3ULL;
+
+/** Mix raw bytes into an FNV-1a hash, one byte at a time. */
+inline void HashBytes(u64& hash, const void* data, u64 size)
+{
+    const auto* bytes = static_cast<const u8*>(data);
+    for (u64 i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= k_fnv_prime;
+    }
+}
+
+/** Mix a string prefixed by its size into an FNV-1a hash, so that consecutive strings can't shift into each other. */
+inline void HashString(u64& hash, const Opal::StringUtf8& str)
+{
+    const u64 size = str.GetSize();
+    HashBytes(hash, &size, sizeof(size));
+    HashBytes(hash, str.GetData(), size);
+}
+
+/** Mix a whole value into an FNV-1a hash in one step. Cheaper than HashBytes for hashes that never leave the process. */
+inline void HashValue(u64& hash, u64 value)
+{
+    hash ^= value;
+    hash *= k_fnv_prime;
+}
+
+}  // namespace Rndr::Canvas::Impl
@@ -0,0 +1,1053 @@
+#include "rndr/canvas/frame-capture.hpp"
+
+#include "opal/exceptions.h"
+
+#include "canvas/binary-stream.hpp"
+
+#include "rndr/canvas/context.hpp"
+#include "rndr/definitions.hpp"
+#include "rndr/file.hpp"
+#include "rndr/trace.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+namespace
+{
+
+constexpr Rndr::u32 k_capture_magic = 0x50414352;  // "RCAP"
+constexpr Rndr::u32 k_capture_version = 4;
+
+Opal::DynamicArray<Rndr::u8> CopyBytes(Opal::ArrayView<const Rndr::u8> bytes)
+{
+    Opal::DynamicArray<Rndr::u8> copy;
+    copy.Resize(bytes.GetSize());
+    if (!bytes.IsEmpty())
+    {
+        memcpy(copy.GetData(), bytes.GetData(), bytes.GetSize());
+    }
+    return copy;
+}
+
+/**
+ * Look up an entry of a replay table by an index read from a capture.
+ * @throw Opal::Exception if the index is out of range.
+ */
+template <typename Table>
+auto& GetCapturedEntry(Table& table, Rndr::u64 index)
+{
+    if (index >= table.GetSize())
+    {
+        throw Opal::Exception("Frame capture is corrupt!");
+    }
+    return table[index];
+}
+
+/** Capture tables being filled, plus the source object of every entry, used to deduplicate. */
+struct CaptureTables
+{
+    Opal::DynamicArray<Rndr::Canvas::Impl::CapturedShader>& shaders;
+    Opal::DynamicArray<Rndr::Canvas::Impl::CapturedRenderTarget>& render_targets;
+    Opal::DynamicArray<Rndr::Canvas::Impl::CapturedTexture>& textures;
+    Opal::DynamicArray<Rndr::Canvas::Impl::CapturedCommandBuffer>& command_buffers;
+    Opal::DynamicArray<Rndr::Canvas::Impl::CapturedBuffer>& buffers;
+    Opal::DynamicArray<Rndr::Canvas::Impl::CapturedMesh>& meshes;
+    Opal::DynamicArray<Rndr::Canvas::Impl::CapturedBrush>& brushes;
+    Opal::DynamicArray<Opal::StringUtf8>& event_names;
+
+    Opal::DynamicArray<const void*> shader_sources;
+    Opal::DynamicArray<const Rndr::Canvas::RenderTarget*> render_target_sources;
+    Opal::DynamicArray<const void*> texture_sources;
+    Opal::DynamicArray<const void*> command_buffer_sources;
+    Opal::DynamicArray<const void*> buffer_sources;
+    Opal::DynamicArray<const void*> mesh_sources;
+    Opal::DynamicArray<const void*> brush_sources;
+};
+
+template <typename T>
+Rndr::u32 FindSource(const Opal::DynamicArray<T>& sources, const void* object)
+{
+    for (Rndr::u64 i = 0; i < sources.GetSize(); ++i)
+    {
+        if (sources[i] == object)
+        {
+            return static_cast<Rndr::u32>(i);
+        }
+    }
+    return Rndr::Canvas::Impl::k_no_captured_resource;
+}
+
+Rndr::u32 CaptureShader(CaptureTables& tables, const Rndr::Canvas::Shader& shader)
+{
+    Rndr::u32 index = FindSource(tables.shader_sources, &shader);
+    if (index != Rndr::Canvas::Impl::k_no_captured_resource)
+    {
+        return index;
+    }
+
+    Rndr::Canvas::Impl::CapturedShader captured;
+    captured.name = shader.GetDebugName().Clone();
+    if (const Rndr::Canvas::Shader* parent = shader.GetVariantParent(); parent != nullptr)
+    {
+        // Variants are recreated from their parent on replay, which is captured first.
+        captured.variant_parent = CaptureShader(tables, *parent);
+        const Opal::ArrayView<const Rndr::u32> values = shader.GetVariantValues();
+        for (Rndr::u64 i = 0; i < values.GetSize(); ++i)
+        {
+            captured.variant_values.PushBack(values[i]);
+        }
+    }
+    else
+    {
+        captured.vertex_source = shader.GetVertexSource().Clone();
+        captured.fragment_source = shader.GetFragmentSource().Clone();
+        const Opal::ArrayView<const Rndr::Canvas::PermutationKey> keys = shader.GetPermutationKeys();
+        for (Rndr::u64 i = 0; i < keys.GetSize(); ++i)
+        {
+            captured.permutation_keys.PushBack(keys[i]);
+        }
+    }
+
+    index = static_cast<Rndr::u32>(tables.shaders.GetSize());
+    tables.shaders.PushBack(std::move(captured));
+    tables.shader_sources.PushBack(&shader);
+    return index;
+}
+
+Rndr::u32 CaptureRenderTarget(CaptureTables& tables, const Rndr::Canvas::RenderTarget& render_target)
+{
+    Rndr::u32 index = FindSource(tables.render_target_sources, &render_target);
+    if (index != Rndr::Canvas::Impl::k_no_captured_resource)
+    {
+        return index;
+    }
+
+    Rndr::Canvas::Impl::CapturedRenderTarget captured;
+    captured.name = render_target.GetName().Clone();
+    for (Rndr::i32 i = 0; i < render_target.GetColorAttachmentCount(); ++i)
+    {
+        captured.color_attachments.PushBack(render_target.GetColorAttachment(i).GetDesc());
+    }
+    captured.use_depth_stencil = render_target.GetDepthStencilAttachment().IsValid();
+    if (captured.use_depth_stencil)
+    {
+        captured.depth_stencil_attachment = render_target.GetDepthStencilAttachment().GetDesc();
+    }
+
+    index = static_cast<Rndr::u32>(tables.render_targets.GetSize());
+    tables.render_targets.PushBack(std::move(captured));
+    tables.render_target_sources.PushBack(&render_target);
+    return index;
+}
+
+Rndr::u32 CaptureTexture(CaptureTables& tables, const Rndr::Canvas::Texture& texture)
+{
+    Rndr::u32 index = FindSource(tables.texture_sources, &texture);
+    if (index != Rndr::Canvas::Impl::k_no_captured_resource)
+    {
+        return index;
+    }
+
+    Rndr::Canvas::Impl::CapturedTexture captured;
+    captured.name = texture.GetName().Clone();
+    captured.desc = texture.GetDesc();
+    for (Rndr::u64 i = 0; i < tables.render_target_sources.GetSize(); ++i)
+    {
+        const Rndr::Canvas::RenderTarget& render_target = *tables.render_target_sources[i];
+        if (&render_target.GetDepthStencilAttachment() == &texture)
+        {
+            captured.render_target = static_cast<Rndr::u32>(i);
+            captured.attachment = -1;
+        }
+        for (Rndr::i32 j = 0; j < render_target.GetColorAttachmentCount(); ++j)
+        {
+            if (&render_target.GetColorAttachment(j) == &texture)
+            {
+                captured.render_target = static_cast<Rndr::u32>(i);
+                captured.attachment = j;
+            }
+        }
+    }
+    if (captured.render_target == Rndr::Canvas::Impl::k_no_captured_resource)
+    {
+        captured.data = texture.ReadData();
+    }
+
+    index = static_cast<Rndr::u32>(tables.textures.GetSize());
+    tables.textures.PushBack(std::move(captured));
+    tables.texture_sources.PushBack(&texture);
+    return index;
+}
+
+void RegisterCommandBufferStorage(CaptureTables& tables, const Rndr::Canvas::Buffer& buffer, Rndr::u32 command_buffer,
+                                  bool is_count_buffer)
+{
+    Rndr::Canvas::Impl::CapturedBuffer captured;
+    captured.name = buffer.GetName().Clone();
+    captured.usage = buffer.GetUsage();
+    captured.size = buffer.GetSize();
+    captured.offset = buffer.GetOffset();
+    captured.command_buffer = command_buffer;
+    captured.is_count_buffer = is_count_buffer;
+    tables.buffers.PushBack(std::move(captured));
+    tables.buffer_sources.PushBack(&buffer);
+}
+
+template <typename T>
+Rndr::u32 CaptureCommandBuffer(CaptureTables& tables, const Rndr::Canvas::DrawCommandBuffer<T>& commands)
+{
+    Rndr::u32 index = FindSource(tables.command_buffer_sources, &commands);
+    if (index != Rndr::Canvas::Impl::k_no_captured_resource)
+    {
+        return index;
+    }
+
+    const Opal::ArrayView<const T> staged = commands.GetCommands();
+    Rndr::Canvas::Impl::CapturedCommandBuffer captured;
+    captured.indexed = std::is_same_v<T, Rndr::Canvas::DrawIndexedCommand>;
+    captured.max_count = commands.GetMaxCount();
+    const Rndr::u8* staged_bytes = reinterpret_cast<const Rndr::u8*>(staged.GetData());
+    captured.staged_commands = CopyBytes(Opal::ArrayView<const Rndr::u8>(staged_bytes, staged_bytes + staged.GetSize() * sizeof(T)));
+    captured.gpu_commands = commands.GetBuffer().ReadData();
+    captured.gpu_count = commands.GetCountBuffer().ReadData();
+
+    index = static_cast<Rndr::u32>(tables.command_buffers.GetSize());
+    tables.command_buffers.PushBack(std::move(captured));
+    tables.command_buffer_sources.PushBack(&commands);
+    RegisterCommandBufferStorage(tables, commands.GetBuffer(), index, false);
+    RegisterCommandBufferStorage(tables, commands.GetCountBuffer(), index, true);
+    return index;
+}
+
+Rndr::u32 CaptureBuffer(CaptureTables& tables, const Rndr::Canvas::Buffer& buffer)
+{
+    Rndr::u32 index = FindSource(tables.buffer_sources, &buffer);
+    if (index != Rndr::Canvas::Impl::k_no_captured_resource)
+    {
+        return index;
+    }
+
+    Rndr::Canvas::Impl::CapturedBuffer captured;
+    captured.name = buffer.GetName().Clone();
+    captured.usage = buffer.GetUsage();
+    captured.size = buffer.GetSize();
+    captured.offset = buffer.GetOffset();
+    captured.data = buffer.ReadData();
+
+    index = static_cast<Rndr::u32>(tables.buffers.GetSize());
+    tables.buffers.PushBack(std::move(captured));
+    tables.buffer_sources.PushBack(&buffer);
+    return index;
+}
+
+Rndr::u32 CaptureMesh(CaptureTables& tables, const Rndr::Canvas::Mesh& mesh)
+{
+    Rndr::u32 index = FindSource(tables.mesh_sources, &mesh);
+    if (index != Rndr::Canvas::Impl::k_no_captured_resource)
+    {
+        return index;
+    }
+
+    Rndr::Canvas::Impl::CapturedMesh captured;
+    captured.name = mesh.GetDebugName().Clone();
+    const Rndr::Canvas::VertexLayout& layout = mesh.GetVertexLayout();
+    for (Rndr::u32 i = 0; i < layout.GetAttributeCount(); ++i)
+    {
+        captured.layout.PushBack(layout.GetAttribute(i));
+    }
+    captured.vertex_data = CopyBytes(mesh.GetVertexData());
+    captured.index_data = CopyBytes(mesh.GetIndexData());
+
+    index = static_cast<Rndr::u32>(tables.meshes.GetSize());
+    tables.meshes.PushBack(std::move(captured));
+    tables.mesh_sources.PushBack(&mesh);
+    return index;
+}
+
+Rndr::u32 CaptureBrush(CaptureTables& tables, const Rndr::Canvas::Brush& brush)
+{
+    Rndr::u32 index = FindSource(tables.brush_sources, &brush);
+    if (index != Rndr::Canvas::Impl::k_no_captured_resource)
+    {
+        return index;
+    }
+
+    Rndr::Canvas::Impl::CapturedBrush captured;
+    captured.name = brush.GetDebugName().Clone();
+    captured.desc = brush.GetDesc();
+    if (brush.GetShader() != nullptr)
+    {
+        captured.shader = CaptureShader(tables, *brush.GetShader());
+    }
+    const Opal::DynamicArray<Rndr::Canvas::UniformBufferSlot>& slots = brush.GetUniformBufferSlots();
+    for (Rndr::u64 i = 0; i < slots.GetSize(); ++i)
+    {
+        Rndr::Canvas::Impl::CapturedUniformSlot slot;
+        slot.binding_index = slots[i].binding_index;
+        slot.binding_space = slots[i].binding_space;
+        slot.data = CopyBytes(brush.GetUniformData(i));
+        captured.uniform_slots.PushBack(std::move(slot));
+    }
+    const Opal::DynamicArray<Rndr::Canvas::UniformBinding>& uniforms = brush.GetUniforms();
+    for (Rndr::u64 i = 0; i < uniforms.GetSize(); ++i)
+    {
+        Rndr::Canvas::UniformBinding uniform;
+        uniform.name = uniforms[i].name.Clone();
+        uniform.data = CopyBytes(uniforms[i].data);
+        captured.uniforms.PushBack(std::move(uniform));
+    }
+    const Opal::DynamicArray<Rndr::Canvas::TextureBinding>& textures = brush.GetTextures();
+    for (Rndr::u64 i = 0; i < textures.GetSize(); ++i)
+    {
+        if (textures[i].texture != nullptr)
+        {
+            captured.textures.PushBack({textures[i].name.Clone(), CaptureTexture(tables, *textures[i].texture)});
+        }
+    }
+    const Opal::DynamicArray<Rndr::Canvas::BufferBinding>& buffers = brush.GetBuffers();
+    for (Rndr::u64 i = 0; i < buffers.GetSize(); ++i)
+    {
+        if (buffers[i].buffer != nullptr)
+        {
+            captured.buffers.PushBack({buffers[i].name.Clone(), CaptureBuffer(tables, *buffers[i].buffer)});
+        }
+    }
+
+    index = static_cast<Rndr::u32>(tables.brushes.GetSize());
+    tables.brushes.PushBack(std::move(captured));
+    tables.brush_sources.PushBack(&brush);
+    return index;
+}
+
+Rndr::u32 CaptureEventName(CaptureTables& tables, const char* event_name)
+{
+    for (Rndr::u64 i = 0; i < tables.event_names.GetSize(); ++i)
+    {
+        if (tables.event_names[i] == event_name)
+        {
+            return static_cast<Rndr::u32>(i);
+        }
+    }
+    tables.event_names.PushBack(Opal::StringUtf8(event_name));
+    return static_cast<Rndr::u32>(tables.event_names.GetSize() - 1);
+}
+
+void WriteResourceBindings(Rndr::Canvas::Impl::BinaryWriter& writer,
+                           const Opal::DynamicArray<Rndr::Canvas::Impl::CapturedResourceBinding>& bindings)
+{
+    writer.Write<Rndr::u64>(bindings.GetSize());
+    for (Rndr::u64 i = 0; i < bindings.GetSize(); ++i)
+    {
+        writer.WriteString(bindings[i].name);
+        writer.Write(bindings[i].resource);
+    }
+}
+
+Opal::DynamicArray<Rndr::Canvas::Impl::CapturedResourceBinding> ReadResourceBindings(Rndr::Canvas::Impl::BinaryReader& reader)
+{
+    Opal::DynamicArray<Rndr::Canvas::Impl::CapturedResourceBinding> bindings;
+    const Rndr::u64 count = reader.Read<Rndr::u64>();
+    for (Rndr::u64 i = 0; i < count; ++i)
+    {
+        Rndr::Canvas::Impl::CapturedResourceBinding binding;
+        binding.name = reader.ReadString();
+        binding.resource = reader.Read<Rndr::u32>();
+        bindings.PushBack(std::move(binding));
+    }
+    return bindings;
+}
+
+template <typename T>
+void RestoreCommandBuffer(Rndr::Canvas::DrawCommandBuffer<T>& commands, const Rndr::Canvas::Impl::CapturedCommandBuffer& captured)
+{
+    if (!captured.gpu_commands.IsEmpty())
+    {
+        commands.GetBuffer().Update(captured.gpu_commands);
+    }
+    if (!captured.gpu_count.IsEmpty())
+    {
+        commands.GetCountBuffer().Update(captured.gpu_count);
+    }
+    const Rndr::u32 staged_count = static_cast<Rndr::u32>(captured.staged_commands.GetSize() / sizeof(T));
+    if (staged_count > 0)
+    {
+        Opal::ArrayView<T> staged = commands.Append(staged_count);
+        memcpy(staged.GetData(), captured.staged_commands.GetData(), staged_count * sizeof(T));
+    }
+}
+
+}  // namespace
+
+Rndr::Canvas::FrameCapture Rndr::Canvas::FrameCapture::Capture(const DrawList& list)
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::FrameCapture::Capture");
+
+    FrameCapture capture;
+    capture.m_sort_mode = list.m_sort_mode;
+    capture.m_command_count = list.m_command_count;
+    CaptureTables tables{capture.m_shaders, capture.m_render_targets, capture.m_textures, capture.m_command_buffers,
+                         capture.m_buffers, capture.m_meshes,         capture.m_brushes,  capture.m_event_names};
+
+    // Render targets and draw command buffers go first, so that brushes binding their attachments
+    // or buffers reference them instead of capturing separate copies.
+    list.m_arena.ForEach(
+        [&tables](const Impl::CommandHeader& header)
+        {
+            Impl::VisitCommand(header, Opal::Overloaded{
+                [&tables](const Impl::SetRenderTargetCommand& c) { CaptureRenderTarget(tables, *c.target); },
+                [&tables](const Impl::DrawIndirectCommand& c) { CaptureCommandBuffer(tables, *c.commands); },
+                [&tables](const Impl::DrawIndexedIndirectCommand& c) { CaptureCommandBuffer(tables, *c.commands); },
+                [](const auto&) {}});
+        });
+
+    Impl::BinaryWriter writer(capture.m_commands);
+    list.m_arena.ForEach(
+        [&tables, &writer](const Impl::CommandHeader& header)
+        {
+            writer.Write(header.type);
+            Impl::VisitCommand(header, Opal::Overloaded{
+                [&writer](const Impl::SetViewportCommand& c) { writer.Write(c); },
+                [&](const Impl::SetRenderTargetCommand& c) { writer.Write(CaptureRenderTarget(tables, *c.target)); },
+                [](const Impl::SetContextCommand&) {},
+                [&](const Impl::DrawMeshCommand& c)
+                {
+                    writer.Write(CaptureMesh(tables, *c.mesh));
+                    writer.Write(CaptureBrush(tables, *c.brush));
+                },
+                [&](const Impl::DrawMeshInstancedCommand& c)
+                {
+                    writer.Write(CaptureMesh(tables, *c.mesh));
+                    writer.Write(CaptureBrush(tables, *c.brush));
+                    writer.Write(c.instance_count);
+                },
+                [&](const Impl::DrawMeshRangeCommand& c)
+                {
+                    writer.Write(CaptureMesh(tables, *c.mesh));
+                    writer.Write(CaptureBrush(tables, *c.brush));
+                    writer.Write(c.first_index);
+                    writer.Write(c.index_count);
+                    writer.Write(c.base_vertex);
+                    writer.Write(c.instance_count);
+                    writer.Write(c.first_instance);
+                },
+                [&](const Impl::DrawIndirectCommand& c)
+                {
+                    writer.Write(CaptureMesh(tables, *c.mesh));
+                    writer.Write(CaptureBrush(tables, *c.brush));
+                    writer.Write(CaptureCommandBuffer(tables, *c.commands));
+                    writer.Write(c.gpu_count);
+                },
+                [&](const Impl::DrawIndexedIndirectCommand& c)
+                {
+                    writer.Write(CaptureMesh(tables, *c.mesh));
+                    writer.Write(CaptureBrush(tables, *c.brush));
+                    writer.Write(CaptureCommandBuffer(tables, *c.commands));
+                    writer.Write(c.gpu_count);
+                },
+                [&](const Impl::ResetDrawCountCommand& c) { writer.Write(CaptureBuffer(tables, *c.count_buffer)); },
+                [&](const Impl::DispatchCommand& c)
+                {
+                    writer.Write(CaptureBrush(tables, *c.brush));
+                    writer.Write(c.group_count_x);
+                    writer.Write(c.group_count_y);
+                    writer.Write(c.group_count_z);
+                },
+                [&writer](const Impl::ClearCommand& c) { writer.Write(c); },
+                [&](const Impl::BeginEventCommand& c) { writer.Write(CaptureEventName(tables, c.event_name)); },
+                [&](const Impl::EndEventCommand& c) { writer.Write(CaptureEventName(tables, c.event_name)); }});
+        });
+    return capture;
+}
+
+Rndr::Canvas::FrameCapture Rndr::Canvas::FrameCapture::Load(const Opal::StringUtf8& path)
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::FrameCapture::Load");
+
+    const Opal::DynamicArray<u8> contents = File::ReadEntireFile(path);
+    if (contents.IsEmpty())
+    {
+        throw Opal::Exception("Failed to read the frame capture file!");
+    }
+
+    Impl::BinaryReader reader(contents.GetData(), contents.GetSize());
+    if (reader.Read<u32>() != k_capture_magic)
+    {
+        throw Opal::Exception("File is not a frame capture!");
+    }
+    if (reader.Read<u32>() != k_capture_version)
+    {
+        throw Opal::Exception("Frame capture was written by an incompatible version!");
+    }
+
+    FrameCapture capture;
+    capture.m_sort_mode = reader.Read<DrawSortMode>();
+
+    const u64 shader_count = reader.Read<u64>();
+    for (u64 i = 0; i < shader_count; ++i)
+    {
+        Impl::CapturedShader shader;
+        shader.name = reader.ReadString();
+        shader.vertex_source = reader.ReadString();
+        shader.fragment_source = reader.ReadString();
+        shader.permutation_keys = reader.ReadArray<PermutationKey>();
+        shader.variant_parent = reader.Read<u32>();
+        shader.variant_values = reader.ReadArray<u32>();
+        capture.m_shaders.PushBack(std::move(shader));
+    }
+
+    const u64 render_target_count = reader.Read<u64>();
+    for (u64 i = 0; i < render_target_count; ++i)
+    {
+        Impl::CapturedRenderTarget render_target;
+        render_target.name = reader.ReadString();
+        render_target.color_attachments = reader.ReadArray<TextureDesc>();
+        render_target.use_depth_stencil = reader.Read<bool>();
+        render_target.depth_stencil_attachment = reader.Read<TextureDesc>();
+        capture.m_render_targets.PushBack(std::move(render_target));
+    }
+
+    const u64 texture_count = reader.Read<u64>();
+    for (u64 i = 0; i < texture_count; ++i)
+    {
+        Impl::CapturedTexture texture;
+        texture.name = reader.ReadString();
+        texture.desc = reader.Read<TextureDesc>();
+        texture.render_target = reader.Read<u32>();
+        texture.attachment = reader.Read<i32>();
+        texture.data = reader.ReadArray<u8>();
+        capture.m_textures.PushBack(std::move(texture));
+    }
+
+    const u64 command_buffer_count = reader.Read<u64>();
+    for (u64 i = 0; i < command_buffer_count; ++i)
+    {
+        Impl::CapturedCommandBuffer command_buffer;
+        command_buffer.indexed = reader.Read<bool>();
+        command_buffer.max_count = reader.Read<u32>();
+        command_buffer.staged_commands = reader.ReadArray<u8>();
+        command_buffer.gpu_commands = reader.ReadArray<u8>();
+        command_buffer.gpu_count = reader.ReadArray<u8>();
+        capture.m_command_buffers.PushBack(std::move(command_buffer));
+    }
+
+    const u64 buffer_count = reader.Read<u64>();
+    for (u64 i = 0; i < buffer_count; ++i)
+    {
+        Impl::CapturedBuffer buffer;
+        buffer.name = reader.ReadString();
+        buffer.usage = reader.Read<BufferUsage>();
+        buffer.size = reader.Read<u64>();
+        buffer.offset = reader.Read<u64>();
+        buffer.command_buffer = reader.Read<u32>();
+        buffer.is_count_buffer = reader.Read<bool>();
+        buffer.data = reader.ReadArray<u8>();
+        capture.m_buffers.PushBack(std::move(buffer));
+    }
+
+    const u64 mesh_count = reader.Read<u64>();
+    for (u64 i = 0; i < mesh_count; ++i)
+    {
+        Impl::CapturedMesh mesh;
+        mesh.name = reader.ReadString();
+        mesh.layout = reader.ReadArray<VertexLayout::Entry>();
+        mesh.vertex_data = reader.ReadArray<u8>();
+        mesh.index_data = reader.ReadArray<u8>();
+        capture.m_meshes.PushBack(std::move(mesh));
+    }
+
+    const u64 brush_count = reader.Read<u64>();
+    for (u64 i = 0; i < brush_count; ++i)
+    {
+        Impl::CapturedBrush brush;
+        brush.name = reader.ReadString();
+        brush.desc = reader.Read<BrushDesc>();
+        brush.shader = reader.Read<u32>();
+        const u64 slot_count = reader.Read<u64>();
+        for (u64 j = 0; j < slot_count; ++j)
+        {
+            Impl::CapturedUniformSlot slot;
+            slot.binding_index = reader.Read<i32>();
+            slot.binding_space = reader.Read<i32>();
+            slot.data = reader.ReadArray<u8>();
+            brush.uniform_slots.PushBack(std::move(slot));
+        }
+        const u64 uniform_count = reader.Read<u64>();
+        for (u64 j = 0; j < uniform_count; ++j)
+        {
+            UniformBinding uniform;
+            uniform.name = reader.ReadString();
+            uniform.data = reader.ReadArray<u8>();
+            brush.uniforms.PushBack(std::move(uniform));
+        }
+        brush.textures = ReadResourceBindings(reader);
+        brush.buffers = ReadResourceBindings(reader);
+        capture.m_brushes.PushBack(std::move(brush));
+    }
+
+    const u64 event_name_count = reader.Read<u64>();
+    for (u64 i = 0; i < event_name_count; ++i)
+    {
+        capture.m_event_names.PushBack(reader.ReadString());
+    }
+
+    capture.m_command_count = reader.Read<u32>();
+    capture.m_commands = reader.ReadArray<u8>();
+    return capture;
+}
+
+void Rndr::Canvas::FrameCapture::Save(const Opal::StringUtf8& path) const
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::FrameCapture::Save");
+
+    Opal::DynamicArray<u8> contents;
+    Impl::BinaryWriter writer(contents);
+    writer.Write(k_capture_magic);
+    writer.Write(k_capture_version);
+    writer.Write(m_sort_mode);
+
+    writer.Write<u64>(m_shaders.GetSize());
+    for (u64 i = 0; i < m_shaders.GetSize(); ++i)
+    {
+        writer.WriteString(m_shaders[i].name);
+        writer.WriteString(m_shaders[i].vertex_source);
+        writer.WriteString(m_shaders[i].fragment_source);
+        writer.WriteArray(m_shaders[i].permutation_keys);
+        writer.Write(m_shaders[i].variant_parent);
+        writer.WriteArray(m_shaders[i].variant_values);
+    }
+
+    writer.Write<u64>(m_render_targets.GetSize());
+    for (u64 i = 0; i < m_render_targets.GetSize(); ++i)
+    {
+        writer.WriteString(m_render_targets[i].name);
+        writer.WriteArray(m_render_targets[i].color_attachments);
+        writer.Write(m_render_targets[i].use_depth_stencil);
+        writer.Write(m_render_targets[i].depth_stencil_attachment);
+    }
+
+    writer.Write<u64>(m_textures.GetSize());
+    for (u64 i = 0; i < m_textures.GetSize(); ++i)
+    {
+        writer.WriteString(m_textures[i].name);
+        writer.Write(m_textures[i].desc);
+        writer.Write(m_textures[i].render_target);
+        writer.Write(m_textures[i].attachment);
+        writer.WriteArray(m_textures[i].data);
+    }
+
+    writer.Write<u64>(m_command_buffers.GetSize());
+    for (u64 i = 0; i < m_command_buffers.GetSize(); ++i)
+    {
+        writer.Write(m_command_buffers[i].indexed);
+        writer.Write(m_command_buffers[i].max_count);
+        writer.WriteArray(m_command_buffers[i].staged_commands);
+        writer.WriteArray(m_command_buffers[i].gpu_commands);
+        writer.WriteArray(m_command_buffers[i].gpu_count);
+    }
+
+    writer.Write<u64>(m_buffers.GetSize());
+    for (u64 i = 0; i < m_buffers.GetSize(); ++i)
+    {
+        writer.WriteString(m_buffers[i].name);
+        writer.Write(m_buffers[i].usage);
+        writer.Write(m_buffers[i].size);
+        writer.Write(m_buffers[i].offset);
+        writer.Write(m_buffers[i].command_buffer);
+        writer.Write(m_buffers[i].is_count_buffer);
+        writer.WriteArray(m_buffers[i].data);
+    }
+
+    writer.Write<u64>(m_meshes.GetSize());
+    for (u64 i = 0; i < m_meshes.GetSize(); ++i)
+    {
+        writer.WriteString(m_meshes[i].name);
+        writer.WriteArray(m_meshes[i].layout);
+        writer.WriteArray(m_meshes[i].vertex_data);
+        writer.WriteArray(m_meshes[i].index_data);
+    }
+
+    writer.Write<u64>(m_brushes.GetSize());
+    for (u64 i = 0; i < m_brushes.GetSize(); ++i)
+    {
+        const Impl::CapturedBrush& brush = m_brushes[i];
+        writer.WriteString(brush.name);
+        writer.Write(brush.desc);
+        writer.Write(brush.shader);
+        writer.Write<u64>(brush.uniform_slots.GetSize());
+        for (u64 j = 0; j < brush.uniform_slots.GetSize(); ++j)
+        {
+            writer.Write(brush.uniform_slots[j].binding_index);
+            writer.Write(brush.uniform_slots[j].binding_space);
+            writer.WriteArray(brush.uniform_slots[j].data);
+        }
+        writer.Write<u64>(brush.uniforms.GetSize());
+        for (u64 j = 0; j < brush.uniforms.GetSize(); ++j)
+        {
+            writer.WriteString(brush.uniforms[j].name);
+            writer.WriteArray(brush.uniforms[j].data);
+        }
+        WriteResourceBindings(writer, brush.textures);
+        WriteResourceBindings(writer, brush.buffers);
+    }
+
+    writer.Write<u64>(m_event_names.GetSize());
+    for (u64 i = 0; i < m_event_names.GetSize(); ++i)
+    {
+        writer.WriteString(m_event_names[i]);
+    }
+
+    writer.Write(m_command_count);
+    writer.WriteArray(m_commands);
+
+    Opal::StringLocale path_locale;
+    path_locale.Resize(300);
+    if (Opal::Transcode(path, path_locale) != Opal::ErrorCode::Success)
+    {
+        throw Opal::Exception("Failed to transcode the frame capture path!");
+    }
+    FILE* file = nullptr;
+    fopen_s(&file, path_locale.GetData(), "wb");
+    if (file == nullptr)
+    {
+        throw Opal::Exception("Failed to open the frame capture file for writing!");
+    }
+    const u64 written_bytes = fwrite(contents.GetData(), 1, contents.GetSize(), file);
+    fclose(file);
+    if (written_bytes != contents.GetSize())
+    {
+        throw Opal::Exception("Failed to write the frame capture file!");
+    }
+}
+
+Rndr::u32 Rndr::Canvas::FrameCapture::GetCommandCount() const
+{
+    return m_command_count;
+}
+
+Rndr::u32 Rndr::Canvas::FrameCapture::GetResourceCount() const
+{
+    const u64 count = m_shaders.GetSize() + m_render_targets.GetSize() + m_textures.GetSize() + m_buffers.GetSize() +
+                      m_meshes.GetSize() + m_brushes.GetSize();
+    return static_cast<u32>(count);
+}
+
+Rndr::Canvas::FrameReplay::FrameReplay(const Context& context, const FrameCapture& capture)
+    : m_context(context), m_sort_mode(capture.m_sort_mode), m_command_count(capture.m_command_count)
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::FrameReplay::FrameReplay");
+
+    for (u64 i = 0; i < capture.m_shaders.GetSize(); ++i)
+    {
+        const Impl::CapturedShader& shader = capture.m_shaders[i];
+        if (shader.variant_parent != Impl::k_no_captured_resource)
+        {
+            continue;
+        }
+        if (shader.fragment_source.IsEmpty())
+        {
+            m_shaders.PushBack(Shader::FromSourceInMemory(shader.vertex_source, shader.name.Clone()));
+        }
+        else
+        {
+            m_shaders.PushBack(Shader::FromSourcesInMemory(shader.vertex_source, shader.fragment_source, shader.name.Clone()));
+        }
+        if (!shader.permutation_keys.IsEmpty())
+        {
+            m_shaders.Back().SetPermutationKeys(shader.permutation_keys);
+        }
+    }
+
+    for (u64 i = 0; i < capture.m_render_targets.GetSize(); ++i)
+    {
+        const Impl::CapturedRenderTarget& render_target = capture.m_render_targets[i];
+        RenderTargetDesc desc;
+        for (u64 j = 0; j < render_target.color_attachments.GetSize(); ++j)
+        {
+            desc.AddColor(render_target.color_attachments[j]);
+        }
+        desc.use_depth_stencil = render_target.use_depth_stencil;
+        desc.depth_stencil_attachment = render_target.depth_stencil_attachment;
+        m_render_targets.PushBack(RenderTarget(context, desc, render_target.name));
+    }
+
+    for (u64 i = 0; i < capture.m_textures.GetSize(); ++i)
+    {
+        const Impl::CapturedTexture& texture = capture.m_textures[i];
+        if (texture.render_target == Impl::k_no_captured_resource)
+        {
+            m_textures.PushBack(Texture(context, texture.desc, texture.data, texture.name));
+        }
+    }
+
+    for (u64 i = 0; i < capture.m_command_buffers.GetSize(); ++i)
+    {
+        const Impl::CapturedCommandBuffer& command_buffer = capture.m_command_buffers[i];
+        if (command_buffer.indexed)
+        {
+            m_command_buffer_slots.PushBack(static_cast<u32>(m_indexed_command_buffers.GetSize()));
+            m_indexed_command_buffers.PushBack(DrawCommandBuffer<DrawIndexedCommand>(command_buffer.max_count));
+            RestoreCommandBuffer(m_indexed_command_buffers.Back(), command_buffer);
+        }
+        else
+        {
+            m_command_buffer_slots.PushBack(static_cast<u32>(m_draw_command_buffers.GetSize()));
+            m_draw_command_buffers.PushBack(DrawCommandBuffer<DrawCommand>(command_buffer.max_count));
+            RestoreCommandBuffer(m_draw_command_buffers.Back(), command_buffer);
+        }
+    }
+
+    for (u64 i = 0; i < capture.m_buffers.GetSize(); ++i)
+    {
+        const Impl::CapturedBuffer& buffer = capture.m_buffers[i];
+        if (buffer.command_buffer == Impl::k_no_captured_resource)
+        {
+            m_buffers.PushBack(Buffer(buffer.usage, buffer.size, buffer.offset, buffer.data, buffer.name.Clone()));
+        }
+    }
+
+    // All owning arrays are complete, so pointers into them stay valid from here on.
+    u64 owned_shader_index = 0;
+    for (u64 i = 0; i < capture.m_shaders.GetSize(); ++i)
+    {
+        const Impl::CapturedShader& shader = capture.m_shaders[i];
+        if (shader.variant_parent == Impl::k_no_captured_resource)
+        {
+            m_shader_refs.PushBack(&m_shaders[owned_shader_index++]);
+            continue;
+        }
+        // Parents are captured before their variants, so only earlier entries are valid parents.
+        const Shader& parent = *GetCapturedEntry(m_shader_refs, shader.variant_parent);
+        const Opal::ArrayView<const u32> values(shader.variant_values.GetData(), shader.variant_values.GetSize());
+        m_shader_refs.PushBack(&parent.GetVariant(values));
+    }
+    u64 owned_texture_index = 0;
+    for (u64 i = 0; i < capture.m_textures.GetSize(); ++i)
+    {
+        const Impl::CapturedTexture& texture = capture.m_textures[i];
+        if (texture.render_target == Impl::k_no_captured_resource)
+        {
+            m_texture_refs.PushBack(&m_textures[owned_texture_index++]);
+        }
+        else
+        {
+            const RenderTarget& render_target = GetCapturedEntry(m_render_targets, texture.render_target);
+            if (texture.attachment >= render_target.GetColorAttachmentCount())
+            {
+                throw Opal::Exception("Frame capture is corrupt!");
+            }
+            m_texture_refs.PushBack(texture.attachment < 0 ? &render_target.GetDepthStencilAttachment()
+                                                           : &render_target.GetColorAttachment(texture.attachment));
+        }
+    }
+    u64 owned_buffer_index = 0;
+    for (u64 i = 0; i < capture.m_buffers.GetSize(); ++i)
+    {
+        const Impl::CapturedBuffer& buffer = capture.m_buffers[i];
+        if (buffer.command_buffer == Impl::k_no_captured_resource)
+        {
+            m_buffer_refs.PushBack(&m_buffers[owned_buffer_index++]);
+            continue;
+        }
+        const u32 slot = GetCapturedEntry(m_command_buffer_slots, buffer.command_buffer);
+        if (capture.m_command_buffers[buffer.command_buffer].indexed)
+        {
+            const DrawCommandBuffer<DrawIndexedCommand>& commands = m_indexed_command_buffers[slot];
+            m_buffer_refs.PushBack(buffer.is_count_buffer ? &commands.GetCountBuffer() : &commands.GetBuffer());
+        }
+        else
+        {
+            const DrawCommandBuffer<DrawCommand>& commands = m_draw_command_buffers[slot];
+            m_buffer_refs.PushBack(buffer.is_count_buffer ? &commands.GetCountBuffer() : &commands.GetBuffer());
+        }
+    }
+
+    for (u64 i = 0; i < capture.m_meshes.GetSize(); ++i)
+    {
+        const Impl::CapturedMesh& mesh = capture.m_meshes[i];
+        VertexLayout layout;
+        for (u64 j = 0; j < mesh.layout.GetSize(); ++j)
+        {
+            layout.Add(mesh.layout[j].attrib, mesh.layout[j].format);
+        }
+        // Dynamic meshes may be empty, which the data constructor rejects, so all meshes are recreated
+        // as dynamic ones and filled on their first upload.
+        const i32 vertex_count = static_cast<i32>(mesh.vertex_data.GetSize() / layout.GetStride());
+        const i32 index_count = static_cast<i32>(mesh.index_data.GetSize() / sizeof(u32));
+        Mesh replay_mesh(layout, vertex_count > 0 ? vertex_count : 1, index_count > 0 ? index_count : 1, mesh.name.Clone());
+        replay_mesh.Append(mesh.vertex_data, mesh.index_data);
+        m_meshes.PushBack(std::move(replay_mesh));
+    }
+
+    for (u64 i = 0; i < capture.m_brushes.GetSize(); ++i)
+    {
+        const Impl::CapturedBrush& captured = capture.m_brushes[i];
+        Brush brush(captured.desc, captured.name.Clone());
+        if (captured.shader != Impl::k_no_captured_resource)
+        {
+            brush.SetShader(*GetCapturedEntry(m_shader_refs, captured.shader));
+        }
+        for (u64 j = 0; j < captured.uniform_slots.GetSize(); ++j)
+        {
+            const Impl::CapturedUniformSlot& captured_slot = captured.uniform_slots[j];
+            for (u64 k = 0; k < brush.m_uniform_buffer_slots.GetSize(); ++k)
+            {
+                UniformBufferSlot& slot = brush.m_uniform_buffer_slots[k];
+                if (slot.binding_index == captured_slot.binding_index && slot.binding_space == captured_slot.binding_space &&
+                    slot.cpu_data.GetSize() == captured_slot.data.GetSize())
+                {
+                    memcpy(slot.cpu_data.GetData(), captured_slot.data.GetData(), captured_slot.data.GetSize());
+                    slot.dirty = true;
+                }
+            }
+        }
+        for (u64 j = 0; j < captured.uniforms.GetSize(); ++j)
+        {
+            UniformBinding uniform;
+            uniform.name = captured.uniforms[j].name.Clone();
+            uniform.data = CopyBytes(captured.uniforms[j].data);
+            brush.m_uniforms.PushBack(std::move(uniform));
+        }
+        for (u64 j = 0; j < captured.textures.GetSize(); ++j)
+        {
+            brush.SetTexture(captured.textures[j].name.GetData(), *GetCapturedEntry(m_texture_refs, captured.textures[j].resource));
+        }
+        for (u64 j = 0; j < captured.buffers.GetSize(); ++j)
+        {
+            brush.SetBuffer(captured.buffers[j].name.GetData(), *GetCapturedEntry(m_buffer_refs, captured.buffers[j].resource));
+        }
+        m_brushes.PushBack(std::move(brush));
+    }
+
+    for (u64 i = 0; i < capture.m_event_names.GetSize(); ++i)
+    {
+        m_event_names.PushBack(capture.m_event_names[i].Clone());
+    }
+    m_commands = CopyBytes(capture.m_commands);
+}
+
+void Rndr::Canvas::FrameReplay::Execute()
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::FrameReplay::Execute");
+
+    m_draw_list.SetSortMode(m_sort_mode);
+    Impl::BinaryReader reader(m_commands.GetData(), m_commands.GetSize());
+    for (u32 i = 0; i < m_command_count; ++i)
+    {
+        switch (reader.Read<DrawListCommandType>())
+        {
+            case DrawListCommandType::SetViewport:
+            {
+                const Impl::SetViewportCommand c = reader.Read<Impl::SetViewportCommand>();
+                m_draw_list.SetViewport(c.x, c.y, c.width, c.height);
+                break;
+            }
+            case DrawListCommandType::SetRenderTarget:
+                m_draw_list.SetRenderTarget(GetCapturedEntry(m_render_targets, reader.Read<u32>()));
+                break;
+            case DrawListCommandType::SetContext:
+                m_draw_list.SetRenderTarget(m_context);
+                break;
+            case DrawListCommandType::DrawMesh:
+            {
+                Mesh& mesh = GetCapturedEntry(m_meshes, reader.Read<u32>());
+                m_draw_list.Draw(mesh, GetCapturedEntry(m_brushes, reader.Read<u32>()));
+                break;
+            }
+            case DrawListCommandType::DrawMeshInstanced:
+            {
+                Mesh& mesh = GetCapturedEntry(m_meshes, reader.Read<u32>());
+                Brush& brush = GetCapturedEntry(m_brushes, reader.Read<u32>());
+                m_draw_list.DrawInstanced(mesh, brush, reader.Read<u32>());
+                break;
+            }
+            case DrawListCommandType::DrawMeshRange:
+            {
+                Mesh& mesh = GetCapturedEntry(m_meshes, reader.Read<u32>());
+                Brush& brush = GetCapturedEntry(m_brushes, reader.Read<u32>());
+                MeshRange range;
+                range.first_index = reader.Read<u32>();
+                range.index_count = reader.Read<u32>();
+                range.base_vertex = reader.Read<i32>();
+                const u32 instance_count = reader.Read<u32>();
+                m_draw_list.DrawInstanced(mesh, brush, range, instance_count, reader.Read<u32>());
+                break;
+            }
+            case DrawListCommandType::DrawIndirect:
+            {
+                Mesh& mesh = GetCapturedEntry(m_meshes, reader.Read<u32>());
+                Brush& brush = GetCapturedEntry(m_brushes, reader.Read<u32>());
+                const u32 slot = GetCapturedEntry(m_command_buffer_slots, reader.Read<u32>());
+                DrawCommandBuffer<DrawCommand>& commands = GetCapturedEntry(m_draw_command_buffers, slot);
+                if (reader.Read<bool>())
+                {
+                    m_draw_list.DrawIndirectCount(mesh, brush, commands);
+                }
+                else
+                {
+                    m_draw_list.DrawIndirect(mesh, brush, commands);
+                }
+                break;
+            }
+            case DrawListCommandType::DrawIndexedIndirect:
+            {
+                Mesh& mesh = GetCapturedEntry(m_meshes, reader.Read<u32>());
+                Brush& brush = GetCapturedEntry(m_brushes, reader.Read<u32>());
+                const u32 slot = GetCapturedEntry(m_command_buffer_slots, reader.Read<u32>());
+                DrawCommandBuffer<DrawIndexedCommand>& commands = GetCapturedEntry(m_indexed_command_buffers, slot);
+                if (reader.Read<bool>())
+                {
+                    m_draw_list.DrawIndexedIndirectCount(mesh, brush, commands);
+                }
+                else
+                {
+                    m_draw_list.DrawIndexedIndirect(mesh, brush, commands);
+                }
+                break;
+            }
+            case DrawListCommandType::ResetDrawCount:
+                m_draw_list.ResetDrawCount(*GetCapturedEntry(m_buffer_refs, reader.Read<u32>()));
+                break;
+            case DrawListCommandType::Dispatch:
+            {
+                Brush& brush = GetCapturedEntry(m_brushes, reader.Read<u32>());
+                const u32 group_count_x = reader.Read<u32>();
+                const u32 group_count_y = reader.Read<u32>();
+                const u32 group_count_z = reader.Read<u32>();
+                m_draw_list.Dispatch(brush, group_count_x, group_count_y, group_count_z);
+                break;
+            }
+            case DrawListCommandType::Clear:
+            {
+                const Impl::ClearCommand c = reader.Read<Impl::ClearCommand>();
+                if (c.clear_color && c.clear_depth)
+                {
+                    m_draw_list.Clear(c.color, c.depth, c.stencil);
+                }
+                else if (c.clear_color)
+                {
+                    m_draw_list.ClearColor(c.color);
+                }
+                else
+                {
+                    m_draw_list.ClearDepthStencil(c.depth, c.stencil);
+                }
+                break;
+            }
+            case DrawListCommandType::BeginEvent:
+                m_draw_list.BeginEvent(GetCapturedEntry(m_event_names, reader.Read<u32>()).GetData());
+                break;
+            case DrawListCommandType::EndEvent:
+                m_draw_list.EndEvent(GetCapturedEntry(m_event_names, reader.Read<u32>()).GetData());
+                break;
+            default:
+                throw Opal::Exception("Frame capture is corrupt!");
+        }
+    }
+    m_draw_list.Execute();
+}
+
+Rndr::u32 Rndr::Canvas::FrameReplay::GetCommandCount() const
+{
+    return m_command_count;
+}
@@ -0,0 +1,366 @@
+#include "canvas/gl-state-cache.hpp"
+
+#include "glad/glad.h"
+
+namespace
+{
+
+constexpr Rndr::u32 k_unknown = 0xFFFFFFFF;
+
+Rndr::Canvas::Impl::GLStateCache* g_state_cache = nullptr;
+
+GLenum ToGLCompareFunc(Rndr::Canvas::CompareFunc func)
+{
+    switch (func)
+    {
+        case Rndr::Canvas::CompareFunc::Less:
+            return GL_LESS;
+        case Rndr::Canvas::CompareFunc::LessEqual:
+            return GL_LEQUAL;
+        case Rndr::Canvas::CompareFunc::Greater:
+            return GL_GREATER;
+        case Rndr::Canvas::CompareFunc::GreaterEqual:
+            return GL_GEQUAL;
+        case Rndr::Canvas::CompareFunc::Equal:
+            return GL_EQUAL;
+        case Rndr::Canvas::CompareFunc::NotEqual:
+            return GL_NOTEQUAL;
+        case Rndr::Canvas::CompareFunc::Always:
+            return GL_ALWAYS;
+        case Rndr::Canvas::CompareFunc::Never:
+            return GL_NEVER;
+        default:
+            return GL_LESS;
+    }
+}
+
+GLenum ToGLCapability(Rndr::u64 capability_index)
+{
+    constexpr GLenum k_capabilities[] = {GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE, GL_POLYGON_OFFSET_FILL, GL_POLYGON_OFFSET_LINE};
+    return k_capabilities[capability_index];
+}
+
+}  // namespace
+
+Rndr::Canvas::Impl::GLStateCache::GLStateCache()
+{
+    Invalidate();
+}
+
+bool Rndr::Canvas::Impl::GLStateCache::ShouldIssue(u32& cached, u32 value)
+{
+    if (cached == value)
+    {
+        ++m_stats.skipped_calls;
+        return false;
+    }
+    cached = value;
+    ++m_stats.issued_calls;
+    return true;
+}
+
+void Rndr::Canvas::Impl::GLStateCache::UseProgram(u32 program)
+{
+    if (ShouldIssue(m_program, program))
+    {
+        glUseProgram(program);
+    }
+}
+
+void Rndr::Canvas::Impl::GLStateCache::SetCapability(Capability capability, bool enabled)
+{
+    const u64 index = static_cast<u64>(capability);
+    if (!ShouldIssue(m_capabilities[index], enabled ? 1 : 0))
+    {
+        return;
+    }
+    if (enabled)
+    {
+        glEnable(ToGLCapability(index));
+    }
+    else
+    {
+        glDisable(ToGLCapability(index));
+    }
+}
+
+void Rndr::Canvas::Impl::GLStateCache::ApplyPipelineState(PipelineStateId id, const BrushDesc& desc)
+{
+    // Brushes with the same id have the same descriptor, so the whole state can be skipped at once.
+    if (m_pipeline_state == id)
+    {
+        ++m_stats.skipped_calls;
+        return;
+    }
+    m_pipeline_state = id;
+
+    // Depth state.
+    SetCapability(Capability::DepthTest, desc.depth_test);
+    if (desc.depth_test)
+    {
+        const GLenum depth_func = ToGLCompareFunc(desc.depth_compare);
+        if (ShouldIssue(m_depth_func, depth_func))
+        {
+            glDepthFunc(depth_func);
+        }
+    }
+    if (ShouldIssue(m_depth_mask, desc.depth_write ? GL_TRUE : GL_FALSE))
+    {
+        glDepthMask(desc.depth_write ? GL_TRUE : GL_FALSE);
+    }
+
+    // Blend state.
+    GLenum blend_src = GL_ONE;
+    GLenum blend_dst = GL_ZERO;
+    switch (desc.blend_mode)
+    {
+        case BlendMode::Alpha:
+            blend_src = GL_SRC_ALPHA;
+            blend_dst = GL_ONE_MINUS_SRC_ALPHA;
+            break;
+        case BlendMode::Additive:
+            blend_src = GL_ONE;
+            blend_dst = GL_ONE;
+            break;
+        case BlendMode::Multiply:
+            blend_src = GL_DST_COLOR;
+            blend_dst = GL_ZERO;
+            break;
+        default:
+            break;
+    }
+    const bool blend_enabled = desc.blend_mode == BlendMode::Alpha || desc.blend_mode == BlendMode::Additive ||
+                               desc.blend_mode == BlendMode::Multiply;
+    SetCapability(Capability::Blend, blend_enabled);
+    if (blend_enabled)
+    {
+        if (m_blend_src == blend_src && m_blend_dst == blend_dst)
+        {
+            ++m_stats.skipped_calls;
+        }
+        else
+        {
+            m_blend_src = blend_src;
+            m_blend_dst = blend_dst;
+            ++m_stats.issued_calls;
+            glBlendFunc(blend_src, blend_dst);
+        }
+    }
+
+    // Rasterizer state.
+    const GLenum polygon_mode = desc.fill_mode == FillMode::Wireframe ? GL_LINE : GL_FILL;
+    if (ShouldIssue(m_polygon_mode, polygon_mode))
+    {
+        glPolygonMode(GL_FRONT_AND_BACK, polygon_mode);
+    }
+
+    SetCapability(Capability::CullFace, desc.cull_mode != CullMode::None);
+    if (desc.cull_mode != CullMode::None)
+    {
+        const GLenum cull_face = desc.cull_mode == CullMode::Front ? GL_FRONT : GL_BACK;
+        if (ShouldIssue(m_cull_face, cull_face))
+        {
+            glCullFace(cull_face);
+        }
+    }
+    const GLenum front_face = desc.winding_order == WindingOrder::CW ? GL_CW : GL_CCW;
+    if (ShouldIssue(m_front_face, front_face))
+    {
+        glFrontFace(front_face);
+    }
+
+    const bool depth_bias_enabled = desc.depth_bias_factor != 0.0f || desc.depth_bias_units != 0.0f;
+    SetCapability(Capability::PolygonOffsetFill, depth_bias_enabled);
+    SetCapability(Capability::PolygonOffsetLine, depth_bias_enabled);
+    if (depth_bias_enabled)
+    {
+        if (m_polygon_offset_known && m_polygon_offset_factor == desc.depth_bias_factor &&
+            m_polygon_offset_units == desc.depth_bias_units)
+        {
+            ++m_stats.skipped_calls;
+        }
+        else
+        {
+            m_polygon_offset_known = true;
+            m_polygon_offset_factor = desc.depth_bias_factor;
+            m_polygon_offset_units = desc.depth_bias_units;
+            ++m_stats.issued_calls;
+            glPolygonOffset(desc.depth_bias_factor, desc.depth_bias_units);
+        }
+    }
+}
+
+void Rndr::Canvas::Impl::GLStateCache::BindTextureUnit(u32 unit, u32 texture)
+{
+    if (unit >= k_max_texture_units)
+    {
+        ++m_stats.issued_calls;
+        glBindTextureUnit(unit, texture);
+        return;
+    }
+    if (ShouldIssue(m_texture_units[unit], texture))
+    {
+        glBindTextureUnit(unit, texture);
+    }
+}
+
+void Rndr::Canvas::Impl::GLStateCache::BindUniformBufferRange(u32 binding_index, u32 buffer, u64 offset, u64 size)
+{
+    const auto gl_offset = static_cast<GLintptr>(offset);
+    const auto gl_size = static_cast<GLsizeiptr>(size);
+    if (binding_index >= k_max_buffer_bindings)
+    {
+        ++m_stats.issued_calls;
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding_index, buffer, gl_offset, gl_size);
+        return;
+    }
+    if (m_uniform_buffers[binding_index] == buffer && m_uniform_buffer_offsets[binding_index] == offset &&
+        m_uniform_buffer_sizes[binding_index] == size)
+    {
+        ++m_stats.skipped_calls;
+        return;
+    }
+    m_uniform_buffers[binding_index] = buffer;
+    m_uniform_buffer_offsets[binding_index] = offset;
+    m_uniform_buffer_sizes[binding_index] = size;
+    ++m_stats.issued_calls;
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding_index, buffer, gl_offset, gl_size);
+}
+
+void Rndr::Canvas::Impl::GLStateCache::BindStorageBuffer(u32 binding_index, u32 buffer)
+{
+    if (binding_index >= k_max_buffer_bindings)
+    {
+        ++m_stats.issued_calls;
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding_index, buffer);
+        return;
+    }
+    if (ShouldIssue(m_storage_buffers[binding_index], buffer))
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding_index, buffer);
+    }
+}
+
+void Rndr::Canvas::Impl::GLStateCache::BindDrawIndirectBuffer(u32 buffer)
+{
+    if (ShouldIssue(m_draw_indirect_buffer, buffer))
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+    }
+}
+
+void Rndr::Canvas::Impl::GLStateCache::BindParameterBuffer(u32 buffer)
+{
+    if (ShouldIssue(m_parameter_buffer, buffer))
+    {
+        glBindBuffer(GL_PARAMETER_BUFFER, buffer);
+    }
+}
+
+void Rndr::Canvas::Impl::GLStateCache::BindVertexArray(u32 vertex_array)
+{
+    if (ShouldIssue(m_vertex_array, vertex_array))
+    {
+        glBindVertexArray(vertex_array);
+    }
+}
+
+void Rndr::Canvas::Impl::GLStateCache::ForgetProgram(u32 program)
+{
+    if (m_program == program)
+    {
+        m_program = k_unknown;
+    }
+}
+
+void Rndr::Canvas::Impl::GLStateCache::ForgetTexture(u32 texture)
+{
+    for (u64 i = 0; i < k_max_texture_units; ++i)
+    {
+        if (m_texture_units[i] == texture)
+        {
+            m_texture_units[i] = k_unknown;
+        }
+    }
+}
+
+void Rndr::Canvas::Impl::GLStateCache::ForgetBuffer(u32 buffer)
+{
+    if (m_draw_indirect_buffer == buffer)
+    {
+        m_draw_indirect_buffer = k_unknown;
+    }
+    if (m_parameter_buffer == buffer)
+    {
+        m_parameter_buffer = k_unknown;
+    }
+    for (u64 i = 0; i < k_max_buffer_bindings; ++i)
+    {
+        if (m_uniform_buffers[i] == buffer)
+        {
+            m_uniform_buffers[i] = k_unknown;
+        }
+        if (m_storage_buffers[i] == buffer)
+        {
+            m_storage_buffers[i] = k_unknown;
+        }
+    }
+}
+
+void Rndr::Canvas::Impl::GLStateCache::ForgetVertexArray(u32 vertex_array)
+{
+    if (m_vertex_array == vertex_array)
+    {
+        m_vertex_array = k_unknown;
+    }
+}
+
+void Rndr::Canvas::Impl::GLStateCache::Invalidate()
+{
+    m_program = k_unknown;
+    m_pipeline_state = k_unknown;
+    for (u64 i = 0; i < static_cast<u64>(Capability::EnumCount); ++i)
+    {
+        m_capabilities[i] = k_unknown;
+    }
+    m_depth_func = k_unknown;
+    m_depth_mask = k_unknown;
+    m_blend_src = k_unknown;
+    m_blend_dst = k_unknown;
+    m_polygon_mode = k_unknown;
+    m_cull_face = k_unknown;
+    m_front_face = k_unknown;
+    m_polygon_offset_known = false;
+    for (u64 i = 0; i < k_max_texture_units; ++i)
+    {
+        m_texture_units[i] = k_unknown;
+    }
+    for (u64 i = 0; i < k_max_buffer_bindings; ++i)
+    {
+        m_uniform_buffers[i] = k_unknown;
+        m_storage_buffers[i] = k_unknown;
+    }
+    m_draw_indirect_buffer = k_unknown;
+    m_parameter_buffer = k_unknown;
+    m_vertex_array = k_unknown;
+}
+
+const Rndr::Canvas::StateCacheStats& Rndr::Canvas::Impl::GLStateCache::GetStats() const
+{
+    return m_stats;
+}
+
+void Rndr::Canvas::Impl::GLStateCache::ResetStats()
+{
+    m_stats = {};
+}
+
+Rndr::Canvas::Impl::GLStateCache* Rndr::Canvas::Impl::GetStateCache()
+{
+    return g_state_cache;
+}
+
+void Rndr::Canvas::Impl::SetStateCache(GLStateCache* cache)
+{
+    g_state_cache = cache;
+}
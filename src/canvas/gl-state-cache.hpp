@@ -0,0 +1,97 @@
+#pragma once
+
+#include "opal/container/in-place-array.h"
+
+#include "rndr/canvas/brush.hpp"
+#include "rndr/canvas/context.hpp"
+#include "rndr/types.hpp"
+
+namespace Rndr::Canvas::Impl
+{
+
+/**
+ * Shadow copy of the GL state touched by Brush::Apply and the DrawList. Every setter compares
+ * against the cached value and only issues the GL call if the state would change. Values start out
+ * unknown, so the first call after construction or Invalidate() is always issued.
+ *
+ * One cache exists per Context. Objects that get deleted must be forgotten, otherwise a newly
+ * created object reusing the same GL name would be considered bound.
+ */
+class GLStateCache
+{
+public:
+    static constexpr u32 k_max_texture_units = 64;
+    static constexpr u32 k_max_buffer_bindings = 32;
+
+    GLStateCache();
+
+    void UseProgram(u32 program);
+    /**
+     * Apply the depth, blend and rasterizer state of a brush. If the id matches the last applied id
+     * the whole state is skipped, otherwise each field is compared against the cached value.
+     */
+    void ApplyPipelineState(PipelineStateId id, const BrushDesc& desc);
+    void BindTextureUnit(u32 unit, u32 texture);
+    void BindUniformBufferRange(u32 binding_index, u32 buffer, u64 offset, u64 size);
+    void BindStorageBuffer(u32 binding_index, u32 buffer);
+    void BindDrawIndirectBuffer(u32 buffer);
+    void BindParameterBuffer(u32 buffer);
+    void BindVertexArray(u32 vertex_array);
+
+    /** Drop cached bindings of a GL object that is about to be deleted. */
+    void ForgetProgram(u32 program);
+    void ForgetTexture(u32 texture);
+    void ForgetBuffer(u32 buffer);
+    void ForgetVertexArray(u32 vertex_array);
+
+    /** Mark all cached state as unknown. Call after GL state was changed outside the cache. */
+    void Invalidate();
+
+    [[nodiscard]] const StateCacheStats& GetStats() const;
+    void ResetStats();
+
+private:
+    enum class Capability : u8
+    {
+        DepthTest,
+        Blend,
+        CullFace,
+        PolygonOffsetFill,
+        PolygonOffsetLine,
+        EnumCount
+    };
+
+    void SetCapability(Capability capability, bool enabled);
+    bool ShouldIssue(u32& cached, u32 value);
+
+    u32 m_program;
+    u32 m_pipeline_state;
+    Opal::InPlaceArray<u32, static_cast<u64>(Capability::EnumCount)> m_capabilities;
+    u32 m_depth_func;
+    u32 m_depth_mask;
+    u32 m_blend_src;
+    u32 m_blend_dst;
+    u32 m_polygon_mode;
+    u32 m_cull_face;
+    u32 m_front_face;
+    f32 m_polygon_offset_factor = 0.0f;
+    f32 m_polygon_offset_units = 0.0f;
+    bool m_polygon_offset_known = false;
+    Opal::InPlaceArray<u32, k_max_texture_units> m_texture_units;
+    Opal::InPlaceArray<u32, k_max_buffer_bindings> m_uniform_buffers;
+    Opal::InPlaceArray<u64, k_max_buffer_bindings> m_uniform_buffer_offsets;
+    Opal::InPlaceArray<u64, k_max_buffer_bindings> m_uniform_buffer_sizes;
+    Opal::InPlaceArray<u32, k_max_buffer_bindings> m_storage_buffers;
+    u32 m_draw_indirect_buffer;
+    u32 m_parameter_buffer;
+    u32 m_vertex_array;
+    StateCacheStats m_stats;
+};
+
+/** @return State cache of the live Context, or nullptr if no Context exists. */
+GLStateCache* GetStateCache();
+
+/** Register the state cache of the live Context. Pass nullptr when the Context is destroyed. */
+void SetStateCache(GLStateCache* cache);
+
+}  // namespace Rndr::Canvas::Impl
@@ -1,5 +1,6 @@
 #include "rndr/canvas/renderers/grid-renderer.hpp"
 
+#include "canvas/embedded-shaders.hpp"
 #include "rndr/canvas/context.hpp"
 #include "rndr/trace.hpp"
 
@@ -71,6 +72,11 @@ float4 FragmentMain(VertexOutput in)
 }
 )";
 
+const Opal::StringUtf8& Rndr::Canvas::Impl::GetGridRendererShaderSource()
+{
+    return k_shader_source;
+}
+
 Rndr::Canvas::GridRenderer::GridRenderer(Opal::Ref<Context> context)
     : m_context(std::move(context))
 {
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "opal/container/string.h"
+
+namespace Rndr::Canvas::Impl
+{
+
+/**
+ * Convert a UTF-8 path to the locale encoding expected by the C runtime and std::filesystem.
+ * @return False if the path can't be converted.
+ */
+inline bool ToLocalePath(const Opal::StringUtf8& path, Opal::StringLocale& out_path)
+{
+    out_path.Resize(300);
+    return Opal::Transcode(path, out_path) == Opal::ErrorCode::Success;
+}
+
+}  // namespace Rndr::Canvas::Impl
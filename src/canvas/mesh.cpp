@@ -2,6 +2,9 @@
 
 #include "glad/glad.h"
 
+#include "canvas/draw-list-stats.hpp"
+#include "canvas/gl-state-cache.hpp"
+
 #include "rndr/exception.hpp"
 #include "rndr/trace.hpp"
 
@@ -201,6 +204,10 @@ void Rndr::Canvas::Mesh::Destroy()
     m_vertex_buffer.Destroy();
     if (m_vao != 0)
     {
+        if (Impl::GLStateCache* state_cache = Impl::GetStateCache(); state_cache != nullptr)
+        {
+            state_cache->ForgetVertexArray(m_vao);
+        }
         glDeleteVertexArrays(1, &m_vao);
         m_vao = 0;
     }
@@ -220,6 +227,10 @@ void Rndr::Canvas::Mesh::Upload()
         m_dirty = false;
         m_vertex_buffer.Update(m_vertex_data);
         m_index_buffer.Update(m_index_data);
+        if (DrawListStats* stats = Impl::GetActiveDrawListStats(); stats != nullptr)
+        {
+            ++stats->mesh_uploads;
+        }
     }
 }
 
@@ -236,6 +247,43 @@ void Rndr::Canvas::Mesh::Append(Opal::ArrayView<const u8> vertex_data, Opal::Arr
     m_dirty = true;
 }
 
+Rndr::Canvas::MeshRange Rndr::Canvas::Mesh::AddRange(Opal::ArrayView<const u8> vertex_data, Opal::ArrayView<const u8> index_data)
+{
+    if (vertex_data.IsEmpty() || index_data.IsEmpty())
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Vertex or index data is empty!");
+    }
+    const u32 stride = m_layout.GetStride();
+    if (stride == 0 || vertex_data.GetSize() % stride != 0)
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Vertex data size is not a multiple of the layout stride!");
+    }
+    if (index_data.GetSize() % sizeof(u32) != 0)
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Index data size is not a multiple of 4 bytes!");
+    }
+    const u32 vertex_count = static_cast<u32>(vertex_data.GetSize() / stride);
+    const u32 index_count = static_cast<u32>(index_data.GetSize() / sizeof(u32));
+    if (m_vertex_count + vertex_count > m_max_vertex_count || m_index_count + index_count > m_max_index_count)
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Sub-mesh does not fit in the mesh!");
+    }
+
+    MeshRange range;
+    range.first_index = m_index_count;
+    range.index_count = index_count;
+    range.base_vertex = static_cast<i32>(m_vertex_count);
+    Append(vertex_data, index_data);
+    return range;
+}
+
+Rndr::Canvas::MeshRange Rndr::Canvas::Mesh::GetFullRange() const
+{
+    MeshRange range;
+    range.index_count = HasIndices() ? m_index_count : m_vertex_count;
+    return range;
+}
+
 void Rndr::Canvas::Mesh::Clear()
 {
     m_vertex_data.Clear();
@@ -275,6 +323,21 @@ const Rndr::Canvas::VertexLayout& Rndr::Canvas::Mesh::GetVertexLayout() const
     return m_layout;
 }
 
+Opal::ArrayView<const Rndr::u8> Rndr::Canvas::Mesh::GetVertexData() const
+{
+    return {m_vertex_data.GetData(), m_vertex_data.GetData() + m_vertex_data.GetSize()};
+}
+
+Opal::ArrayView<const Rndr::u8> Rndr::Canvas::Mesh::GetIndexData() const
+{
+    return {m_index_data.GetData(), m_index_data.GetData() + m_index_data.GetSize()};
+}
+
+const Opal::StringUtf8& Rndr::Canvas::Mesh::GetDebugName() const
+{
+    return m_debug_name;
+}
+
 void Rndr::Canvas::Mesh::SetupVAO()
 {
     // Create VAO.
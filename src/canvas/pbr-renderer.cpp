@@ -1,5 +1,7 @@
 #include "rndr/canvas/renderers/pbr-renderer.hpp"
 
+#include <cmath>
+
 #include "assimp/cimport.h"
 #include "assimp/GltfMaterial.h"
 #include "assimp/material.h"
@@ -13,6 +15,32 @@
 
 #include "rndr/canvas/context.hpp"
 #include "rndr/log.hpp"
+#include "rndr/mesh-optimizer.hpp"
+
+namespace
+{
+
+/** Position, normal and UV, the vertex layout of the PBR shader. */
+constexpr Rndr::u32 k_vertex_stride = sizeof(Rndr::Point3f) + sizeof(Rndr::Normal3f) + sizeof(Rndr::Point2f);
+
+/** Simplification weights of the normal and UV, so LODs keep more triangles where shading and texturing change. */
+constexpr Rndr::f32 k_lod_attribute_weights[] = {0.1f, 0.1f, 0.1f, 0.1f, 0.1f};
+
+Rndr::MeshLodChain GenerateLods(const Opal::ArrayView<const Rndr::u8>& vertex_data, const Opal::ArrayView<const Rndr::u8>& index_data,
+                                Opal::DynamicArray<Rndr::u32>& out_indices)
+{
+    const Opal::ArrayView<const Rndr::u32> indices(reinterpret_cast<const Rndr::u32*>(index_data.GetData()),
+                                                   index_data.GetSize() / sizeof(Rndr::u32));
+    const Rndr::MeshLodDesc desc{.attribute_weights = Opal::ArrayView<const Rndr::f32>(k_lod_attribute_weights, 5)};
+    return Rndr::GenerateMeshLods(indices, vertex_data, k_vertex_stride, out_indices, desc);
+}
+
+Rndr::MeshLodChain CloneLodChain(const Rndr::MeshLodChain& lod_chain)
+{
+    return {.bounds_center = lod_chain.bounds_center, .bounds_radius = lod_chain.bounds_radius, .lods = lod_chain.lods.Clone()};
+}
+
+}  // namespace
 
 // BatchKey ==================================================================
 
@@ -50,6 +78,26 @@ Rndr::Canvas::PbrRenderer::PbrRenderer(Opal::Ref<Context> context) : m_context(s
     m_shader = Shader::FromSource(shader_path, "PBR Renderer");
     RNDR_ASSERT(m_shader.IsValid(), "Failed to create PbrRenderer shader!");
 
+    Opal::DynamicArray<PermutationKey> permutation_keys;
+    for (u32 i = 0; i < k_texture_slot_count; ++i)
+    {
+        permutation_keys.PushBack({.constant_id = i, .value_count = 2});
+    }
+    permutation_keys.PushBack({.constant_id = k_draw_mode_constant_id, .value_count = k_draw_mode_count});
+    m_shader.SetPermutationKeys(permutation_keys);
+
+    m_uniforms.view_projection = m_shader.GetUniformHandle("view_projection");
+    m_uniforms.camera_position = m_shader.GetUniformHandle("camera_position");
+    m_uniforms.directional_light_count = m_shader.GetUniformHandle("directional_light_count");
+    m_uniforms.directional_light_directions = m_shader.GetUniformHandle("directional_light_directions");
+    m_uniforms.directional_light_colors = m_shader.GetUniformHandle("directional_light_colors");
+    m_uniforms.point_light_count = m_shader.GetUniformHandle("point_light_count");
+    m_uniforms.point_light_positions = m_shader.GetUniformHandle("point_light_positions");
+    m_uniforms.point_light_colors = m_shader.GetUniformHandle("point_light_colors");
+
+    m_base_brush = Opal::MakeScoped<Brush>(nullptr, BrushDesc{.depth_test = true, .depth_write = true}, "PBR Renderer - Base");
+    m_base_brush->SetShader(m_shader);
+
     // 1x1 white dummy texture for unused texture slots.
     m_dummy_texture =
         Texture(*m_context, TextureDesc{.width = 1, .height = 1}, Opal::AsBytes(Colors::k_white), "PBR Renderer - Dummy Texture");
@@ -62,8 +110,11 @@ Rndr::Canvas::PbrRenderer::~PbrRenderer()
 
 void Rndr::Canvas::PbrRenderer::Destroy()
 {
+    // Batch brushes are instances of the base brush, so they go first.
     m_batches.Clear();
+    m_base_brush = Opal::ScopePtr<Brush>();
     m_geometry_cache.Clear();
+    m_geometry_lods.Clear();
     m_dummy_texture.Destroy();
     m_shader.Destroy();
 }
@@ -72,7 +123,10 @@ void Rndr::Canvas::PbrRenderer::BeginFrame()
 {
     for (auto& batch : m_batches)
     {
-        batch.value.instances.Clear();
+        for (u64 i = 0; i < batch.value.lod_instances.GetSize(); ++i)
+        {
+            batch.value.lod_instances[i].Clear();
+        }
     }
     m_directional_lights.Clear();
     m_point_lights.Clear();
@@ -88,6 +142,11 @@ void Rndr::Canvas::PbrRenderer::SetCameraPosition(const Point3f& camera_position
     m_camera_position = camera_position;
 }
 
+void Rndr::Canvas::PbrRenderer::SetLodErrorThreshold(f32 max_pixel_error)
+{
+    m_lod_error_threshold = max_pixel_error;
+}
+
 void Rndr::Canvas::PbrRenderer::AddDirectionalLight(const Vector3f& direction, const Vector4f& color)
 {
     m_directional_lights.PushBack({.direction = direction, .color = color});
@@ -107,10 +166,13 @@ void Rndr::Canvas::PbrRenderer::EnsureGeometry(const Opal::StringUtf8& key, cons
     {
         return;
     }
+    Opal::DynamicArray<u32> lod_indices;
+    MeshLodChain lod_chain = GenerateLods(vertex_data, index_data, lod_indices);
     const VertexLayout vertex_layout = m_shader.GetVertexLayout().Clone();
-    Canvas::Mesh mesh(vertex_layout, vertex_data, index_data, key.Clone());
+    Canvas::Mesh mesh(vertex_layout, vertex_data, Opal::AsBytes(lod_indices), key.Clone());
     RNDR_ASSERT(mesh.IsValid(), "Failed to create PbrRenderer mesh!");
     m_geometry_cache.Insert(key.Clone(), std::move(mesh));
+    m_geometry_lods.Insert(key.Clone(), std::move(lod_chain));
 }
 
 void Rndr::Canvas::PbrRenderer::DrawCube(const Matrix4x4f& transform, const PbrMaterialDesc& material, f32 u_tiling, f32 v_tiling)
@@ -223,19 +285,87 @@ void Rndr::Canvas::PbrRenderer::AddDrawEntry(const Opal::StringUtf8& geometry_ke
     if (it == m_batches.end())
     {
         BatchData data;
-        data.brush = Brush(BrushDesc{.depth_test = true, .depth_write = true}, "PBR Renderer - " + material.material_name.Clone());
-        data.brush.SetShader(m_shader);
+        data.brush = m_base_brush->CreateInstance("PBR Renderer - " + material.material_name.Clone());
+        data.material_flags = ComputeMaterialFlags(material);
         data.instance_buffer = Buffer(BufferUsage::Storage, k_max_instance_count * sizeof(InstanceData), 0, {},
                                       "PBR Renderer - " + material.material_name.Clone() + " - Instance Buffer");
+        if (auto lods_it = m_geometry_lods.Find(geometry_key); lods_it != m_geometry_lods.end())
+        {
+            data.lod_chain = CloneLodChain(lods_it.GetValue());
+        }
+        data.lod_instances.Resize(data.lod_chain.lods.IsEmpty() ? 1 : data.lod_chain.lods.GetSize());
         BindTextures(data.brush, batch_key);
         m_batches.Insert(batch_key.Clone(), std::move(data));
         it = m_batches.Find(batch_key);
     }
-    it.GetValue().instances.PushBack(MakeInstanceData(transform, material));
+    BatchData& batch_data = it.GetValue();
+    batch_data.lod_instances[SelectLod(batch_data.lod_chain, transform)].PushBack(MakeInstanceData(transform, material));
+}
+
+Rndr::u32 Rndr::Canvas::PbrRenderer::SelectLod(const MeshLodChain& lod_chain, const Matrix4x4f& transform) const
+{
+    if (lod_chain.lods.GetSize() <= 1)
+    {
+        return 0;
+    }
+
+    // World space bounding sphere. The radius grows with the largest axis scale of the transform.
+    const Point3f& center = lod_chain.bounds_center;
+    f32 world_center[3] = {};
+    f32 max_scale_squared = 0.0f;
+    for (i32 i = 0; i < 3; ++i)
+    {
+        world_center[i] = transform.elements[i][0] * center.x + transform.elements[i][1] * center.y + transform.elements[i][2] * center.z +
+                          transform.elements[i][3];
+        const f32 scale_squared = transform.elements[0][i] * transform.elements[0][i] +
+                                  transform.elements[1][i] * transform.elements[1][i] + transform.elements[2][i] * transform.elements[2][i];
+        max_scale_squared = Opal::Max(max_scale_squared, scale_squared);
+    }
+    const f32 radius = lod_chain.bounds_radius * std::sqrt(max_scale_squared);
+
+    // Clip space w is the view depth, and the length of the second row of the view-projection is
+    // the vertical focal scale, so this works for any camera orientation.
+    const Matrix4x4f& vp = m_view_projection;
+    const f32 depth = vp.elements[3][0] * world_center[0] + vp.elements[3][1] * world_center[1] + vp.elements[3][2] * world_center[2] +
+                      vp.elements[3][3];
+    if (depth <= 0.0f)
+    {
+        return 0;
+    }
+    const f32 focal_scale = std::sqrt(vp.elements[1][0] * vp.elements[1][0] + vp.elements[1][1] * vp.elements[1][1] +
+                                       vp.elements[1][2] * vp.elements[1][2]);
+    const f32 projected_radius = radius * focal_scale / depth * 0.5f * static_cast<f32>(m_context->GetHeight());
+    return SelectMeshLod(Opal::ArrayView<const MeshLod>(lod_chain.lods.GetData(), lod_chain.lods.GetSize()), projected_radius,
+                         m_lod_error_threshold);
 }
 
 // Rendering -----------------------------------------------------------------
 
+Rndr::u32 Rndr::Canvas::PbrRenderer::GetDrawMode() const
+{
+    // Draw flag bits: 1 is unlit, 2 is normals. Unlit wins if both are set.
+    if ((m_draw_flags & 1) != 0)
+    {
+        return k_draw_mode_unlit;
+    }
+    if ((m_draw_flags & 2) != 0)
+    {
+        return k_draw_mode_normals;
+    }
+    return k_draw_mode_lit;
+}
+
+const Rndr::Canvas::Shader& Rndr::Canvas::PbrRenderer::GetShaderVariant(u32 material_flags, u32 draw_mode) const
+{
+    u32 values[k_permutation_key_count] = {};
+    for (u32 i = 0; i < k_texture_slot_count; ++i)
+    {
+        values[i] = (material_flags >> i) & 1;
+    }
+    values[k_draw_mode_constant_id] = draw_mode;
+    return m_shader.GetVariant(Opal::ArrayView<const u32>(values, k_permutation_key_count));
+}
+
 void Rndr::Canvas::PbrRenderer::BindTextures(Brush& brush, const BatchKey& key)
 {
     static constexpr const char* k_texture_names[] = {
@@ -251,42 +381,52 @@ void Rndr::Canvas::PbrRenderer::BindTextures(Brush& brush, const BatchKey& key)
 void Rndr::Canvas::PbrRenderer::Render(DrawList& draw_list)
 {
     draw_list.BeginEvent("PbrRenderer::Render");
+
+    // Per-frame uniforms are set once on the base brush and inherited by every batch brush.
+    m_base_brush->SetUniform(m_uniforms.view_projection, m_view_projection);
+    m_base_brush->SetUniform(m_uniforms.camera_position, m_camera_position);
+
+    const u32 dir_count = Opal::Min(static_cast<u32>(m_directional_lights.GetSize()), k_max_light_count);
+    m_base_brush->SetUniform(m_uniforms.directional_light_count, dir_count);
+    for (u32 i = 0; i < dir_count; ++i)
+    {
+        const Vector4f dir = {m_directional_lights[i].direction.x, m_directional_lights[i].direction.y,
+                              m_directional_lights[i].direction.z, 0.0f};
+        m_base_brush->SetUniform(m_uniforms.directional_light_directions, static_cast<i32>(i), dir);
+        m_base_brush->SetUniform(m_uniforms.directional_light_colors, static_cast<i32>(i), m_directional_lights[i].color);
+    }
+
+    const u32 point_count = Opal::Min(static_cast<u32>(m_point_lights.GetSize()), k_max_light_count);
+    m_base_brush->SetUniform(m_uniforms.point_light_count, point_count);
+    for (u32 i = 0; i < point_count; ++i)
+    {
+        const Vector4f pos = {m_point_lights[i].position.x, m_point_lights[i].position.y, m_point_lights[i].position.z, 0.0f};
+        m_base_brush->SetUniform(m_uniforms.point_light_positions, static_cast<i32>(i), pos);
+        m_base_brush->SetUniform(m_uniforms.point_light_colors, static_cast<i32>(i), m_point_lights[i].color);
+    }
+
+    const u32 draw_mode = GetDrawMode();
     for (auto& batch : m_batches)
     {
         const BatchKey& batch_key = batch.key;
         BatchData& batch_data = batch.value;
 
+        batch_data.instances.Clear();
+        for (u64 lod = 0; lod < batch_data.lod_instances.GetSize(); ++lod)
+        {
+            const Opal::DynamicArray<InstanceData>& lod_instances = batch_data.lod_instances[lod];
+            for (u64 i = 0; i < lod_instances.GetSize(); ++i)
+            {
+                batch_data.instances.PushBack(lod_instances[i]);
+            }
+        }
         if (batch_data.instances.IsEmpty())
         {
             continue;
         }
 
         Brush& brush = batch_data.brush;
-
-        brush.SetUniform("draw_flags", m_draw_flags);
-
-        // Set per-frame uniforms on this batch's brush.
-        brush.SetUniform("view_projection", m_view_projection);
-        brush.SetUniform("camera_position", m_camera_position);
-
-        const u32 dir_count = Opal::Min(static_cast<u32>(m_directional_lights.GetSize()), k_max_light_count);
-        brush.SetUniform("directional_light_count", dir_count);
-        for (u32 i = 0; i < dir_count; ++i)
-        {
-            const Vector4f dir = {m_directional_lights[i].direction.x, m_directional_lights[i].direction.y,
-                                  m_directional_lights[i].direction.z, 0.0f};
-            brush.SetUniform("directional_light_directions", static_cast<i32>(i), dir);
-            brush.SetUniform("directional_light_colors", static_cast<i32>(i), m_directional_lights[i].color);
-        }
-
-        const u32 point_count = Opal::Min(static_cast<u32>(m_point_lights.GetSize()), k_max_light_count);
-        brush.SetUniform("point_light_count", point_count);
-        for (u32 i = 0; i < point_count; ++i)
-        {
-            const Vector4f pos = {m_point_lights[i].position.x, m_point_lights[i].position.y, m_point_lights[i].position.z, 0.0f};
-            brush.SetUniform("point_light_positions", static_cast<i32>(i), pos);
-            brush.SetUniform("point_light_colors", static_cast<i32>(i), m_point_lights[i].color);
-        }
+        brush.SetShaderVariant(GetShaderVariant(batch_data.material_flags, draw_mode));
 
         Canvas::Mesh* mesh = nullptr;
         if (auto external_it = m_external_geometry.Find(batch_key.geometry_key); external_it != m_external_geometry.end())
@@ -303,7 +443,27 @@ void Rndr::Canvas::PbrRenderer::Render(DrawList& draw_list)
         batch_data.instance_buffer.Update(Opal::AsBytes(batch_data.instances));
         brush.SetBuffer("instances", batch_data.instance_buffer);
 
-        draw_list.DrawInstanced(*mesh, brush, static_cast<u32>(batch_data.instances.GetSize()));
+        if (batch_data.lod_chain.lods.IsEmpty())
+        {
+            draw_list.DrawInstanced(*mesh, brush, static_cast<u32>(batch_data.instances.GetSize()));
+            continue;
+        }
+
+        // One draw per LOD in use. The LODs share the vertex array and the instance buffer, the
+        // first instance selects each LOD's slice of it.
+        u32 first_instance = 0;
+        for (u64 lod = 0; lod < batch_data.lod_instances.GetSize(); ++lod)
+        {
+            const auto instance_count = static_cast<u32>(batch_data.lod_instances[lod].GetSize());
+            if (instance_count == 0)
+            {
+                continue;
+            }
+            const MeshLod& mesh_lod = batch_data.lod_chain.lods[lod];
+            const MeshRange range{.first_index = mesh_lod.first_index, .index_count = mesh_lod.index_count};
+            draw_list.DrawInstanced(*mesh, brush, range, instance_count, first_instance);
+            first_instance += instance_count;
+        }
     }
     draw_list.EndEvent("PbrRenderer::Render");
 }
@@ -630,7 +790,7 @@ Rndr::Canvas::PbrModel Rndr::Canvas::PbrRenderer::LoadModel(const Opal::StringUt
                                                              bool flip_vertically)
 {
     constexpr u32 k_ai_process_flags = aiProcess_JoinIdenticalVertices | aiProcess_Triangulate | aiProcess_GenSmoothNormals |
-                                       aiProcess_LimitBoneWeights | aiProcess_SplitLargeMeshes | aiProcess_ImproveCacheLocality |
+                                       aiProcess_LimitBoneWeights | aiProcess_SplitLargeMeshes |
                                        aiProcess_RemoveRedundantMaterials | aiProcess_FindDegenerates | aiProcess_FindInvalidData |
                                        aiProcess_GenUVCoords;
 
@@ -646,6 +806,8 @@ Rndr::Canvas::PbrModel Rndr::Canvas::PbrRenderer::LoadModel(const Opal::StringUt
     Opal::DynamicArray<u8> vertex_data;
     Opal::DynamicArray<u8> index_data;
     ExtractMeshDataFromScene(*scene, vertex_data, index_data);
+    OptimizeMesh(vertex_data, k_vertex_stride,
+                 Opal::ArrayView<u32>(reinterpret_cast<u32*>(index_data.GetData()), index_data.GetSize() / sizeof(u32)));
     const VertexLayout vertex_layout = m_shader.GetVertexLayout().Clone();
     model.mesh = Mesh(vertex_layout, Opal::AsBytes(vertex_data), Opal::AsBytes(index_data), mesh_name.Clone());
 
@@ -693,5 +855,7 @@ void Rndr::Canvas::PbrRenderer::DrawModel(const Opal::StringUtf8& key, const Pbr
     {
         desc.opacity_texture = Opal::Ref<const Texture>(model.opacity_texture);
     }
-    DrawMesh(key, model.mesh, transform, desc);
+    // The model's mesh only holds LOD 0, the renderer owns a copy with the whole LOD chain.
+    EnsureGeometry(key, model.mesh.GetVertexData(), model.mesh.GetIndexData());
+    AddDrawEntry(key, transform, desc);
 }
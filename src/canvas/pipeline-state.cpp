@@ -0,0 +1,117 @@
+#include "canvas/pipeline-state.hpp"
+
+#include "opal/container/dynamic-array.h"
+#include "opal/container/hash-map.h"
+#include "opal/exceptions.h"
+
+#include "canvas/fnv-hash.hpp"
+
+#include <cstring>
+#include <mutex>
+
+namespace
+{
+
+bool AreDescsEqual(const Rndr::Canvas::BrushDesc& a, const Rndr::Canvas::BrushDesc& b)
+{
+    // Depth bias is compared bitwise so that the same bits always map to the same id.
+    return a.blend_mode == b.blend_mode && a.depth_test == b.depth_test && a.depth_write == b.depth_write &&
+           a.depth_compare == b.depth_compare && a.cull_mode == b.cull_mode && a.winding_order == b.winding_order &&
+           a.fill_mode == b.fill_mode && memcmp(&a.depth_bias_factor, &b.depth_bias_factor, sizeof(Rndr::f32)) == 0 &&
+           memcmp(&a.depth_bias_units, &b.depth_bias_units, sizeof(Rndr::f32)) == 0;
+}
+
+Rndr::u64 HashDesc(const Rndr::Canvas::BrushDesc& desc)
+{
+    Rndr::u32 factor_bits = 0;
+    Rndr::u32 units_bits = 0;
+    memcpy(&factor_bits, &desc.depth_bias_factor, sizeof(factor_bits));
+    memcpy(&units_bits, &desc.depth_bias_units, sizeof(units_bits));
+
+    // FNV-1a over the fields.
+    Rndr::u64 hash = Rndr::Canvas::Impl::k_fnv_offset_basis;
+    const auto mix = [&hash](Rndr::u64 value) { Rndr::Canvas::Impl::HashValue(hash, value); };
+    mix(static_cast<Rndr::u64>(desc.blend_mode));
+    mix(desc.depth_test ? 1 : 0);
+    mix(desc.depth_write ? 1 : 0);
+    mix(static_cast<Rndr::u64>(desc.depth_compare));
+    mix(static_cast<Rndr::u64>(desc.cull_mode));
+    mix(static_cast<Rndr::u64>(desc.winding_order));
+    mix(static_cast<Rndr::u64>(desc.fill_mode));
+    mix(factor_bits);
+    mix(units_bits);
+    return hash;
+}
+
+struct PipelineStateRegistry
+{
+    std::mutex mutex;
+    Opal::DynamicArray<Rndr::Canvas::BrushDesc> states;
+
+    /** Id of the first state interned with a given hash. States with colliding hashes are found by a linear scan. */
+    Opal::HashMap<Rndr::u64, Rndr::Canvas::PipelineStateId> ids_by_hash;
+
+    PipelineStateRegistry()
+    {
+        const Rndr::Canvas::BrushDesc default_desc;
+        states.PushBack(default_desc);
+        ids_by_hash.Insert(HashDesc(default_desc), 0);
+    }
+};
+
+PipelineStateRegistry& GetRegistry()
+{
+    static PipelineStateRegistry s_registry;
+    return s_registry;
+}
+
+}  // namespace
+
+Rndr::Canvas::PipelineStateId Rndr::Canvas::Impl::InternPipelineState(const BrushDesc& desc)
+{
+    PipelineStateRegistry& registry = GetRegistry();
+    const u64 hash = HashDesc(desc);
+
+    std::scoped_lock lock(registry.mutex);
+    if (auto it = registry.ids_by_hash.Find(hash); it != registry.ids_by_hash.end())
+    {
+        const PipelineStateId id = it.GetValue();
+        if (AreDescsEqual(registry.states[id], desc))
+        {
+            return id;
+        }
+        for (u64 i = 0; i < registry.states.GetSize(); ++i)
+        {
+            if (AreDescsEqual(registry.states[i], desc))
+            {
+                return static_cast<PipelineStateId>(i);
+            }
+        }
+    }
+
+    if (registry.states.GetSize() > k_max_pipeline_state_id)
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Too many distinct pipeline states!");
+    }
+    const auto id = static_cast<PipelineStateId>(registry.states.GetSize());
+    registry.states.PushBack(desc);
+    if (registry.ids_by_hash.Find(hash) == registry.ids_by_hash.end())
+    {
+        registry.ids_by_hash.Insert(hash, id);
+    }
+    return id;
+}
+
+Rndr::Canvas::BrushDesc Rndr::Canvas::Impl::GetPipelineState(PipelineStateId id)
+{
+    PipelineStateRegistry& registry = GetRegistry();
+    std::scoped_lock lock(registry.mutex);
+    return id < registry.states.GetSize() ? registry.states[id] : BrushDesc{};
+}
+
+Rndr::u32 Rndr::Canvas::Impl::GetPipelineStateCount()
+{
+    PipelineStateRegistry& registry = GetRegistry();
+    std::scoped_lock lock(registry.mutex);
+    return static_cast<u32>(registry.states.GetSize());
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "rndr/canvas/brush.hpp"
+#include "rndr/types.hpp"
+
+namespace Rndr::Canvas::Impl
+{
+
+/**
+ * Intern a pipeline state. Descriptors that are equal field by field get the same id, so two
+ * brushes with the same state can be recognized by comparing ids. The default BrushDesc always
+ * has id 0. Interned states live for the lifetime of the process. Thread safe.
+ * @param desc Pipeline state to intern.
+ * @return Id of the interned state.
+ * @throw Opal::InvalidArgumentException if more than 65535 distinct states are interned.
+ */
+PipelineStateId InternPipelineState(const BrushDesc& desc);
+
+/**
+ * Look up an interned pipeline state. Thread safe.
+ * @param id Id returned by InternPipelineState().
+ * @return Copy of the interned descriptor.
+ */
+BrushDesc GetPipelineState(PipelineStateId id);
+
+/** @return Number of distinct pipeline states interned so far, including the default one. */
+u32 GetPipelineStateCount();
+
+}  // namespace Rndr::Canvas::Impl
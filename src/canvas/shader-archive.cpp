@@ -0,0 +1,356 @@
+#include "canvas/shader-archive.hpp"
+
+#include "opal/exceptions.h"
+
+#include "canvas/binary-stream.hpp"
+#include "canvas/fnv-hash.hpp"
+#include "canvas/locale-path.hpp"
+
+#include "rndr/log.hpp"
+#include "rndr/trace.hpp"
+
+#if RNDR_WINDOWS
+#include "rndr/platform/windows-header.hpp"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+
+Rndr::Canvas::Impl::ShaderArchive* g_shader_archive = nullptr;
+
+constexpr Rndr::u32 k_archive_magic = 0x41485352;  // "RSHA"
+
+/** Bump when the file layout, WriteCompiledShader, the compiler options or the SPIR-V patching change. */
+constexpr Rndr::u32 k_archive_version = 3;
+
+struct ArchiveHeader
+{
+    Rndr::u32 magic = k_archive_magic;
+    Rndr::u32 version = k_archive_version;
+    Rndr::u64 entry_count = 0;
+
+    /** Offset of the TOC, entry_count TocEntry records sorted by name hash. */
+    Rndr::u64 toc_offset = 0;
+
+    /** Offset of entry_count u32 TOC indices sorted by the source hash of their entry. */
+    Rndr::u64 source_index_offset = 0;
+};
+
+Rndr::u64 HashName(const Opal::StringUtf8& name)
+{
+    Rndr::u64 hash = Rndr::Canvas::Impl::k_fnv_offset_basis;
+    Rndr::Canvas::Impl::HashString(hash, name);
+    return hash;
+}
+
+Rndr::u64 HashSources(const Opal::StringUtf8& vertex_source, const Opal::StringUtf8& fragment_source)
+{
+    Rndr::u64 hash = Rndr::Canvas::Impl::k_fnv_offset_basis;
+    Rndr::Canvas::Impl::HashString(hash, vertex_source);
+    Rndr::Canvas::Impl::HashString(hash, fragment_source);
+    return hash;
+}
+
+}  // namespace
+
+struct Rndr::Canvas::Impl::ShaderArchive::TocEntry
+{
+    u64 name_hash = 0;
+    u64 source_hash = 0;
+
+    /** Byte range of the entry in the file. */
+    u64 offset = 0;
+    u64 size = 0;
+};
+
+Rndr::Canvas::Impl::ShaderArchive::ShaderArchive(const Opal::StringUtf8& path)
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::ShaderArchive::Open");
+
+    Opal::StringLocale path_locale;
+    if (!ToLocalePath(path, path_locale))
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Failed to transcode the shader archive path!");
+    }
+
+#if RNDR_WINDOWS
+    m_file_handle =
+        CreateFileA(path_locale.GetData(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file_handle == INVALID_HANDLE_VALUE)
+    {
+        m_file_handle = nullptr;
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Failed to open the shader archive!");
+    }
+    LARGE_INTEGER file_size = {};
+    GetFileSizeEx(m_file_handle, &file_size);
+    m_size = static_cast<u64>(file_size.QuadPart);
+    m_mapping_handle = m_size > 0 ? CreateFileMappingA(m_file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    if (m_mapping_handle != nullptr)
+    {
+        m_data = static_cast<const u8*>(MapViewOfFile(m_mapping_handle, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (m_data == nullptr)
+    {
+        if (m_mapping_handle != nullptr)
+        {
+            CloseHandle(m_mapping_handle);
+        }
+        CloseHandle(m_file_handle);
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Failed to map the shader archive!");
+    }
+#else
+    const int file = open(path_locale.GetData(), O_RDONLY);
+    if (file < 0)
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Failed to open the shader archive!");
+    }
+    struct stat file_stat = {};
+    fstat(file, &file_stat);
+    m_size = static_cast<u64>(file_stat.st_size);
+    void* view = m_size > 0 ? mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED;
+    close(file);
+    if (view == MAP_FAILED)
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Failed to map the shader archive!");
+    }
+    m_data = static_cast<const u8*>(view);
+#endif
+
+    ArchiveHeader header;
+    bool is_valid = m_size >= sizeof(ArchiveHeader);
+    if (is_valid)
+    {
+        memcpy(&header, m_data, sizeof(header));
+        const u64 toc_size = header.entry_count * sizeof(TocEntry);
+        const u64 source_index_size = header.entry_count * sizeof(u32);
+        is_valid = header.magic == k_archive_magic && header.version == k_archive_version &&
+                   header.entry_count <= m_size / sizeof(TocEntry) && header.toc_offset % alignof(TocEntry) == 0 &&
+                   header.toc_offset <= m_size && toc_size <= m_size - header.toc_offset &&
+                   header.source_index_offset % alignof(u32) == 0 && header.source_index_offset <= m_size &&
+                   source_index_size <= m_size - header.source_index_offset;
+    }
+    if (!is_valid)
+    {
+        // The destructor does not run for a throwing constructor.
+#if RNDR_WINDOWS
+        UnmapViewOfFile(m_data);
+        CloseHandle(m_mapping_handle);
+        CloseHandle(m_file_handle);
+#else
+        munmap(const_cast<u8*>(m_data), m_size);
+#endif
+        throw Opal::InvalidArgumentException(__FUNCTION__, "File is not a shader archive or was built by another version!");
+    }
+
+    m_entry_count = header.entry_count;
+    m_toc = reinterpret_cast<const TocEntry*>(m_data + header.toc_offset);
+    m_source_index = reinterpret_cast<const u32*>(m_data + header.source_index_offset);
+}
+
+Rndr::Canvas::Impl::ShaderArchive::~ShaderArchive()
+{
+#if RNDR_WINDOWS
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapping_handle);
+    CloseHandle(m_file_handle);
+#else
+    munmap(const_cast<u8*>(m_data), m_size);
+#endif
+}
+
+bool Rndr::Canvas::Impl::ShaderArchive::FindByName(const Opal::StringUtf8& name, ShaderArchiveEntry& out_entry)
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::ShaderArchive::FindByName");
+
+    const u64 name_hash = HashName(name);
+    const TocEntry* toc_end = m_toc + m_entry_count;
+    const TocEntry* it =
+        std::lower_bound(m_toc, toc_end, name_hash, [](const TocEntry& entry, u64 hash) { return entry.name_hash < hash; });
+    for (; it != toc_end && it->name_hash == name_hash; ++it)
+    {
+        ShaderArchiveEntry entry = ReadEntry(static_cast<u64>(it - m_toc));
+        if (entry.name == name)
+        {
+            out_entry = std::move(entry);
+            RecordLookup(true);
+            return true;
+        }
+    }
+    RecordLookup(false);
+    return false;
+}
+
+bool Rndr::Canvas::Impl::ShaderArchive::FindBySources(const Opal::StringUtf8& vertex_source, const Opal::StringUtf8& fragment_source,
+                                                      ShaderArchiveEntry& out_entry)
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::ShaderArchive::FindBySources");
+
+    const u64 source_hash = HashSources(vertex_source, fragment_source);
+    const u32* index_end = m_source_index + m_entry_count;
+    const u32* it = std::lower_bound(m_source_index, index_end, source_hash,
+                                     [this](u32 toc_index, u64 hash) { return m_toc[toc_index].source_hash < hash; });
+    for (; it != index_end && m_toc[*it].source_hash == source_hash; ++it)
+    {
+        // The sources are compared in full, so a hash collision is a miss and not a wrong shader.
+        ShaderArchiveEntry entry = ReadEntry(*it);
+        if (entry.vertex_source == vertex_source && entry.fragment_source == fragment_source)
+        {
+            out_entry = std::move(entry);
+            RecordLookup(true);
+            return true;
+        }
+    }
+    RecordLookup(false);
+    return false;
+}
+
+Rndr::u64 Rndr::Canvas::Impl::ShaderArchive::GetShaderCount() const
+{
+    return m_entry_count;
+}
+
+Rndr::Canvas::ShaderArchiveStats Rndr::Canvas::Impl::ShaderArchive::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+Rndr::Canvas::Impl::ShaderArchiveEntry Rndr::Canvas::Impl::ShaderArchive::ReadEntry(u64 toc_index) const
+{
+    ShaderArchiveEntry entry;
+    const TocEntry& toc_entry = m_toc[toc_index];
+    if (toc_entry.offset > m_size || toc_entry.size > m_size - toc_entry.offset)
+    {
+        RNDR_LOG_WARNING("Shader archive entry {} is out of bounds!", toc_index);
+        return entry;
+    }
+    try
+    {
+        BinaryReader reader(m_data + toc_entry.offset, toc_entry.size);
+        entry.name = reader.ReadString();
+        entry.vertex_source = reader.ReadString();
+        entry.fragment_source = reader.ReadString();
+        entry.compiled = ReadCompiledShader(reader);
+    }
+    catch (const Opal::Exception&)
+    {
+        RNDR_LOG_WARNING("Shader archive entry {} is corrupt!", toc_index);
+        entry = ShaderArchiveEntry();
+    }
+    return entry;
+}
+
+void Rndr::Canvas::Impl::ShaderArchive::RecordLookup(bool hit)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (hit)
+    {
+        ++m_stats.hits;
+    }
+    else
+    {
+        ++m_stats.misses;
+    }
+}
+
+void Rndr::Canvas::Impl::WriteShaderArchive(const Opal::StringUtf8& path, const Opal::DynamicArray<ShaderArchiveEntry>& entries)
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::WriteShaderArchive");
+
+    const u64 entry_count = entries.GetSize();
+    Opal::DynamicArray<u64> name_hashes(entry_count);
+    Opal::DynamicArray<u64> source_hashes(entry_count);
+    Opal::DynamicArray<u32> name_order(entry_count);
+    for (u64 i = 0; i < entry_count; ++i)
+    {
+        for (u64 j = 0; j < i; ++j)
+        {
+            if (entries[j].name == entries[i].name)
+            {
+                throw Opal::InvalidArgumentException(__FUNCTION__, "Shader archive entries must have unique names!");
+            }
+        }
+        name_hashes[i] = HashName(entries[i].name);
+        source_hashes[i] = HashSources(entries[i].vertex_source, entries[i].fragment_source);
+        name_order[i] = static_cast<u32>(i);
+    }
+    std::sort(name_order.GetData(), name_order.GetData() + entry_count,
+              [&name_hashes](u32 a, u32 b) { return name_hashes[a] < name_hashes[b]; });
+
+    // TOC index i holds entries[name_order[i]].
+    Opal::DynamicArray<u32> source_index(entry_count);
+    for (u64 i = 0; i < entry_count; ++i)
+    {
+        source_index[i] = static_cast<u32>(i);
+    }
+    std::sort(source_index.GetData(), source_index.GetData() + entry_count,
+              [&source_hashes, &name_order](u32 a, u32 b) { return source_hashes[name_order[a]] < source_hashes[name_order[b]]; });
+
+    ArchiveHeader header;
+    header.entry_count = entry_count;
+    header.toc_offset = sizeof(ArchiveHeader);
+    header.source_index_offset = header.toc_offset + entry_count * sizeof(ShaderArchive::TocEntry);
+    const u64 payload_offset = (header.source_index_offset + entry_count * sizeof(u32) + 7) & ~7ULL;
+
+    Opal::DynamicArray<u8> payload;
+    BinaryWriter payload_writer(payload);
+    Opal::DynamicArray<ShaderArchive::TocEntry> toc(entry_count);
+    for (u64 i = 0; i < entry_count; ++i)
+    {
+        const ShaderArchiveEntry& entry = entries[name_order[i]];
+        toc[i].name_hash = name_hashes[name_order[i]];
+        toc[i].source_hash = source_hashes[name_order[i]];
+        toc[i].offset = payload_offset + payload.GetSize();
+        payload_writer.WriteString(entry.name);
+        payload_writer.WriteString(entry.vertex_source);
+        payload_writer.WriteString(entry.fragment_source);
+        WriteCompiledShader(payload_writer, entry.compiled);
+        toc[i].size = payload_offset + payload.GetSize() - toc[i].offset;
+    }
+
+    Opal::DynamicArray<u8> contents;
+    BinaryWriter writer(contents);
+    writer.Write(header);
+    writer.WriteBytes(toc.GetData(), toc.GetSize() * sizeof(ShaderArchive::TocEntry));
+    writer.WriteBytes(source_index.GetData(), source_index.GetSize() * sizeof(u32));
+    const u8 padding[8] = {};
+    writer.WriteBytes(padding, payload_offset - contents.GetSize());
+    writer.WriteBytes(payload.GetData(), payload.GetSize());
+
+    Opal::StringLocale path_locale;
+    if (!ToLocalePath(path, path_locale))
+    {
+        throw Opal::Exception("Failed to transcode the shader archive path!");
+    }
+    FILE* file = nullptr;
+    fopen_s(&file, path_locale.GetData(), "wb");
+    if (file == nullptr)
+    {
+        throw Opal::Exception("Failed to open the shader archive for writing!");
+    }
+    const u64 written_bytes = fwrite(contents.GetData(), 1, contents.GetSize(), file);
+    fclose(file);
+    if (written_bytes != contents.GetSize())
+    {
+        throw Opal::Exception("Failed to write the shader archive!");
+    }
+}
+
+Rndr::Canvas::Impl::ShaderArchive* Rndr::Canvas::Impl::GetShaderArchive()
+{
+    return g_shader_archive;
+}
+
+void Rndr::Canvas::Impl::SetShaderArchive(ShaderArchive* archive)
+{
+    g_shader_archive = archive;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "opal/container/dynamic-array.h"
+#include "opal/container/string.h"
+
+#include "canvas/shader-cache.hpp"
+
+#include "rndr/canvas/context.hpp"
+#include "rndr/definitions.hpp"
+#include "rndr/types.hpp"
+
+#include <mutex>
+
+namespace Rndr::Canvas::Impl
+{
+
+/** One shader of a shader archive. */
+struct ShaderArchiveEntry
+{
+    /** Name the shader is looked up by with Shader::FromArchive, usually its file name. */
+    Opal::StringUtf8 name;
+
+    /** Sources the shader was compiled from. Kept so that Clone() and source lookups work. */
+    Opal::StringUtf8 vertex_source;
+    Opal::StringUtf8 fragment_source;
+
+    CompiledShader compiled;
+};
+
+/**
+ * Read-only, memory-mapped pack of precompiled shaders written by WriteShaderArchive. A table of
+ * contents sorted by name hash and a second index sorted by source hash let lookups binary search
+ * the mapped file directly, so opening an archive does not read or parse the entries.
+ *
+ * The archive of a Context is opened from ContextDesc::shader_archive_path. Thread safe.
+ */
+class ShaderArchive
+{
+public:
+    /**
+     * Map an archive file.
+     * @throw Opal::InvalidArgumentException if the file can't be mapped or is not a valid archive.
+     */
+    explicit ShaderArchive(const Opal::StringUtf8& path);
+    ~ShaderArchive();
+
+    ShaderArchive(const ShaderArchive&) = delete;
+    ShaderArchive& operator=(const ShaderArchive&) = delete;
+    ShaderArchive(ShaderArchive&&) = delete;
+    ShaderArchive& operator=(ShaderArchive&&) = delete;
+
+    /**
+     * Look up a shader by name.
+     * @return True if the archive has the shader.
+     */
+    bool FindByName(const Opal::StringUtf8& name, ShaderArchiveEntry& out_entry);
+
+    /**
+     * Look up a shader by its sources, as passed to CompileShaderSources.
+     * @return True if the archive has a shader compiled from these sources.
+     */
+    bool FindBySources(const Opal::StringUtf8& vertex_source, const Opal::StringUtf8& fragment_source, ShaderArchiveEntry& out_entry);
+
+    [[nodiscard]] u64 GetShaderCount() const;
+
+    [[nodiscard]] ShaderArchiveStats GetStats() const;
+
+private:
+    struct TocEntry;
+
+    friend void WriteShaderArchive(const Opal::StringUtf8& path, const Opal::DynamicArray<ShaderArchiveEntry>& entries);
+
+    /** @return Entry at the given TOC index, or an empty entry if it is corrupt. */
+    [[nodiscard]] ShaderArchiveEntry ReadEntry(u64 toc_index) const;
+
+    void RecordLookup(bool hit);
+
+    const u8* m_data = nullptr;
+    u64 m_size = 0;
+    const TocEntry* m_toc = nullptr;
+    const u32* m_source_index = nullptr;
+    u64 m_entry_count = 0;
+
+#if RNDR_WINDOWS
+    void* m_file_handle = nullptr;
+    void* m_mapping_handle = nullptr;
+#endif
+
+    mutable std::mutex m_mutex;
+    ShaderArchiveStats m_stats;
+};
+
+/**
+ * Write an archive of precompiled shaders, replacing the file if it exists.
+ * @throw Opal::InvalidArgumentException if two entries have the same name.
+ * @throw Opal::Exception if the file can't be written.
+ */
+void WriteShaderArchive(const Opal::StringUtf8& path, const Opal::DynamicArray<ShaderArchiveEntry>& entries);
+
+/** @return Shader archive of the live Context, or nullptr if no Context exists or it has no archive. */
+ShaderArchive* GetShaderArchive();
+
+/** Register the shader archive of the live Context. Pass nullptr when the Context is destroyed. */
+void SetShaderArchive(ShaderArchive* archive);
+
+}  // namespace Rndr::Canvas::Impl
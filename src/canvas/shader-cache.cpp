@@ -0,0 +1,285 @@
+#include "canvas/shader-cache.hpp"
+
+#include "opal/exceptions.h"
+#include "opal/file-system.h"
+#include "opal/paths.h"
+
+#include "canvas/binary-stream.hpp"
+#include "canvas/fnv-hash.hpp"
+#include "canvas/locale-path.hpp"
+
+#include "rndr/file.hpp"
+#include "rndr/log.hpp"
+#include "rndr/trace.hpp"
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <system_error>
+
+namespace
+{
+
+Rndr::Canvas::Impl::ShaderCache* g_shader_cache = nullptr;
+
+constexpr Rndr::u32 k_cache_magic = 0x43485352;  // "RSHC"
+
+/** Bump when WriteCompiledShader, the compiler options or the SPIR-V patching change. */
+constexpr Rndr::u32 k_cache_version = 4;
+
+/**
+ * Path of the temporary file a store writes before renaming it to path. It is unique across the threads of this
+ * process, and the random per-process token keeps processes sharing the cache directory from writing to the same file.
+ */
+Opal::StringUtf8 GetUniqueTempPath(const Opal::StringUtf8& path)
+{
+    static const Rndr::u64 s_process_token = (static_cast<Rndr::u64>(std::random_device{}()) << 32) | std::random_device{}();
+    static std::atomic<Rndr::u64> s_store_counter = 0;
+    char suffix[64];
+    snprintf(suffix, sizeof(suffix), ".%016" PRIx64 ".%" PRIu64 ".tmp", s_process_token, s_store_counter.fetch_add(1));
+    return path + suffix;
+}
+
+}  // namespace
+
+void Rndr::Canvas::Impl::WriteCompiledShader(BinaryWriter& writer, const CompiledShader& shader)
+{
+    writer.Write<Rndr::u64>(shader.stages.GetSize());
+    for (Rndr::u64 i = 0; i < shader.stages.GetSize(); ++i)
+    {
+        writer.Write(shader.stages[i].stage);
+        writer.WriteString(shader.stages[i].entry_point);
+        writer.WriteArray(shader.stages[i].spirv);
+        writer.WriteArray(shader.stages[i].specialization_constant_ids);
+    }
+
+    writer.Write<Rndr::u64>(shader.parameters.GetSize());
+    for (Rndr::u64 i = 0; i < shader.parameters.GetSize(); ++i)
+    {
+        const Rndr::ShaderParameter& param = shader.parameters[i];
+        writer.WriteString(param.name);
+        writer.Write(param.binding_index);
+        writer.Write(param.binding_space);
+        writer.Write(param.offset);
+        writer.Write(param.size);
+        writer.Write(param.array_element_count);
+        writer.Write(param.array_stride);
+        writer.Write(param.category);
+        writer.Write(param.writable);
+        writer.Write(param.scalar_type);
+        writer.Write(param.row_count);
+        writer.Write(param.column_count);
+    }
+
+    writer.Write<Rndr::u64>(shader.vertex_inputs.GetSize());
+    for (Rndr::u64 i = 0; i < shader.vertex_inputs.GetSize(); ++i)
+    {
+        writer.WriteString(shader.vertex_inputs[i].name);
+        writer.Write(shader.vertex_inputs[i].component_count);
+        writer.Write(shader.vertex_inputs[i].scalar_type);
+    }
+
+    writer.Write(shader.num_threads);
+
+    writer.Write<Rndr::u64>(shader.specialization_constants.GetSize());
+    for (Rndr::u64 i = 0; i < shader.specialization_constants.GetSize(); ++i)
+    {
+        writer.WriteString(shader.specialization_constants[i].name);
+        writer.Write(shader.specialization_constants[i].constant_id);
+        writer.Write(shader.specialization_constants[i].default_value);
+    }
+}
+
+Rndr::Canvas::Impl::CompiledShader Rndr::Canvas::Impl::ReadCompiledShader(BinaryReader& reader)
+{
+    CompiledShader shader;
+
+    const Rndr::u64 stage_count = reader.Read<Rndr::u64>();
+    for (Rndr::u64 i = 0; i < stage_count; ++i)
+    {
+        CompiledStage stage;
+        stage.stage = reader.Read<Rndr::ShaderStage>();
+        stage.entry_point = reader.ReadString();
+        stage.spirv = reader.ReadArray<Rndr::u32>();
+        stage.specialization_constant_ids = reader.ReadArray<Rndr::u32>();
+        shader.stages.PushBack(std::move(stage));
+    }
+
+    const Rndr::u64 param_count = reader.Read<Rndr::u64>();
+    for (Rndr::u64 i = 0; i < param_count; ++i)
+    {
+        Rndr::ShaderParameter param;
+        param.name = reader.ReadString();
+        param.binding_index = reader.Read<Rndr::i32>();
+        param.binding_space = reader.Read<Rndr::i32>();
+        param.offset = reader.Read<Rndr::i32>();
+        param.size = reader.Read<Rndr::i32>();
+        param.array_element_count = reader.Read<Rndr::i32>();
+        param.array_stride = reader.Read<Rndr::i32>();
+        param.category = reader.Read<Rndr::ParameterCategory>();
+        param.writable = reader.Read<bool>();
+        param.scalar_type = reader.Read<Rndr::ScalarType>();
+        param.row_count = reader.Read<Rndr::u8>();
+        param.column_count = reader.Read<Rndr::u8>();
+        shader.parameters.PushBack(std::move(param));
+    }
+
+    const Rndr::u64 input_count = reader.Read<Rndr::u64>();
+    for (Rndr::u64 i = 0; i < input_count; ++i)
+    {
+        Rndr::VertexInputAttribute input;
+        input.name = reader.ReadString();
+        input.component_count = reader.Read<Rndr::u8>();
+        input.scalar_type = reader.Read<Rndr::ScalarType>();
+        shader.vertex_inputs.PushBack(std::move(input));
+    }
+
+    shader.num_threads = reader.Read<Rndr::NumThreads>();
+
+    const Rndr::u64 constant_count = reader.Read<Rndr::u64>();
+    for (Rndr::u64 i = 0; i < constant_count; ++i)
+    {
+        Rndr::SpecializationConstant constant;
+        constant.name = reader.ReadString();
+        constant.constant_id = reader.Read<Rndr::u32>();
+        constant.default_value = reader.Read<Rndr::u32>();
+        shader.specialization_constants.PushBack(std::move(constant));
+    }
+    return shader;
+}
+
+Rndr::Canvas::Impl::ShaderCache::ShaderCache(Opal::StringUtf8 directory)
+    : m_directory(std::move(directory)), m_compiler_version(ShaderCompiler::GetCompilerVersion())
+{
+    Opal::StringLocale directory_locale;
+    bool created = ToLocalePath(m_directory, directory_locale);
+    if (created)
+    {
+        std::error_code error;
+        std::filesystem::create_directories(directory_locale.GetData(), error);
+        created = !error;
+    }
+    if (!created)
+    {
+        RNDR_LOG_WARNING("Failed to create the shader cache directory {}!", *m_directory);
+    }
+}
+
+bool Rndr::Canvas::Impl::ShaderCache::Load(const Opal::StringUtf8& vertex_source, const Opal::StringUtf8& fragment_source,
+                                           CompiledShader& out_shader)
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::ShaderCache::Load");
+
+    const Opal::StringUtf8 path = GetEntryPath(vertex_source, fragment_source);
+    bool hit = false;
+    if (Opal::Exists(path))
+    {
+        const Opal::DynamicArray<u8> contents = File::ReadEntireFile(path);
+        try
+        {
+            BinaryReader reader(contents.GetData(), contents.GetSize());
+            // The sources are compared in full, so a hash collision is a miss and not a wrong shader.
+            if (reader.Read<u32>() == k_cache_magic && reader.Read<u32>() == k_cache_version &&
+                reader.ReadString() == m_compiler_version && reader.ReadString() == vertex_source &&
+                reader.ReadString() == fragment_source)
+            {
+                out_shader = ReadCompiledShader(reader);
+                hit = true;
+            }
+        }
+        catch (const Opal::Exception&)
+        {
+            RNDR_LOG_WARNING("Shader cache entry {} is corrupt and will be replaced!", *path);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (hit)
+    {
+        ++m_stats.hits;
+    }
+    else
+    {
+        ++m_stats.misses;
+    }
+    return hit;
+}
+
+void Rndr::Canvas::Impl::ShaderCache::Store(const Opal::StringUtf8& vertex_source, const Opal::StringUtf8& fragment_source,
+                                            const CompiledShader& shader)
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::ShaderCache::Store");
+
+    Opal::DynamicArray<u8> contents;
+    BinaryWriter writer(contents);
+    writer.Write(k_cache_magic);
+    writer.Write(k_cache_version);
+    writer.WriteString(m_compiler_version);
+    writer.WriteString(vertex_source);
+    writer.WriteString(fragment_source);
+    WriteCompiledShader(writer, shader);
+
+    // Write to a temporary file and rename it, so a concurrent Load never sees a partial entry. Each store gets its own
+    // temporary file, so concurrent stores of the same entry never interleave their writes.
+    const Opal::StringUtf8 path = GetEntryPath(vertex_source, fragment_source);
+    const Opal::StringUtf8 temp_path = GetUniqueTempPath(path);
+    Opal::StringLocale path_locale;
+    Opal::StringLocale temp_path_locale;
+    if (!ToLocalePath(path, path_locale) || !ToLocalePath(temp_path, temp_path_locale))
+    {
+        RNDR_LOG_WARNING("Failed to transcode the shader cache path {}!", *path);
+        return;
+    }
+    FILE* file = nullptr;
+    fopen_s(&file, temp_path_locale.GetData(), "wb");
+    if (file == nullptr)
+    {
+        RNDR_LOG_WARNING("Failed to open the shader cache entry {} for writing!", *temp_path);
+        return;
+    }
+    const u64 written_bytes = fwrite(contents.GetData(), 1, contents.GetSize(), file);
+    fclose(file);
+
+    std::error_code error;
+    if (written_bytes == contents.GetSize())
+    {
+        std::filesystem::rename(temp_path_locale.GetData(), path_locale.GetData(), error);
+    }
+    if (written_bytes != contents.GetSize() || error)
+    {
+        RNDR_LOG_WARNING("Failed to write the shader cache entry {}!", *path);
+        std::filesystem::remove(temp_path_locale.GetData(), error);
+    }
+}
+
+Rndr::Canvas::ShaderCacheStats Rndr::Canvas::Impl::ShaderCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+Opal::StringUtf8 Rndr::Canvas::Impl::ShaderCache::GetEntryPath(const Opal::StringUtf8& vertex_source,
+                                                               const Opal::StringUtf8& fragment_source) const
+{
+    u64 hash = k_fnv_offset_basis;
+    HashBytes(hash, &k_cache_version, sizeof(k_cache_version));
+    HashString(hash, m_compiler_version);
+    HashString(hash, vertex_source);
+    HashString(hash, fragment_source);
+
+    char file_name[32] = {};
+    snprintf(file_name, sizeof(file_name), "%016llx.rshader", static_cast<unsigned long long>(hash));
+    return Opal::Paths::Combine(m_directory, file_name);
+}
+
+Rndr::Canvas::Impl::ShaderCache* Rndr::Canvas::Impl::GetShaderCache()
+{
+    return g_shader_cache;
+}
+
+void Rndr::Canvas::Impl::SetShaderCache(ShaderCache* cache)
+{
+    g_shader_cache = cache;
+}
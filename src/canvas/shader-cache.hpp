@@ -0,0 +1,106 @@
+#pragma once
+
+#include "opal/container/dynamic-array.h"
+#include "opal/container/string.h"
+
+#include "rndr/canvas/context.hpp"
+#include "rndr/core/shader-compiler.hpp"
+#include "rndr/types.hpp"
+
+#include <mutex>
+
+namespace Rndr::Canvas::Impl
+{
+
+class BinaryReader;
+class BinaryWriter;
+
+/** One compiled stage of a shader. The SPIR-V is already patched for OpenGL. */
+struct CompiledStage
+{
+    ShaderStage stage = ShaderStage::Unknown;
+    Opal::StringUtf8 entry_point;
+    Opal::DynamicArray<u32> spirv;
+
+    /** Ids of the specialization constants used by this stage. */
+    Opal::DynamicArray<u32> specialization_constant_ids;
+};
+
+/** Everything needed to create the GL program of a shader without invoking Slang. */
+struct CompiledShader
+{
+    /** Vertex and fragment stage for graphics shaders, a single compute stage for compute shaders. */
+    Opal::DynamicArray<CompiledStage> stages;
+
+    /** Reflection data merged from all stages. */
+    Opal::DynamicArray<ShaderParameter> parameters;
+
+    /** Vertex stage inputs. Empty for compute shaders. */
+    Opal::DynamicArray<VertexInputAttribute> vertex_inputs;
+
+    NumThreads num_threads;
+
+    /** Specialization constants of all stages, one entry per constant id. */
+    Opal::DynamicArray<SpecializationConstant> specialization_constants;
+};
+
+/** Serialize a compiled shader. Shared by the shader cache and shader archives. */
+void WriteCompiledShader(BinaryWriter& writer, const CompiledShader& shader);
+
+/**
+ * Read back a shader written by WriteCompiledShader.
+ * @throw Opal::Exception if the stream is truncated.
+ */
+CompiledShader ReadCompiledShader(BinaryReader& reader);
+
+/**
+ * Content addressed on-disk cache of compiled shaders. An entry is keyed by a hash of the Slang
+ * sources and the compiler version, and stores the sources themselves so that hash collisions
+ * and stale entries are detected on load. Missing, stale and corrupt entries are cache misses.
+ *
+ * One cache exists per Context, created when ContextDesc::shader_cache_directory is set. Thread safe.
+ */
+class ShaderCache
+{
+public:
+    explicit ShaderCache(Opal::StringUtf8 directory);
+
+    /**
+     * Look up a compiled shader.
+     * @param vertex_source Source of a single-source shader, or the vertex source of a two-source shader.
+     * @param fragment_source Fragment source of a two-source shader. Empty for single-source shaders.
+     * @param out_shader Filled with the cached shader on a hit.
+     * @return True on a hit.
+     */
+    bool Load(const Opal::StringUtf8& vertex_source, const Opal::StringUtf8& fragment_source, CompiledShader& out_shader);
+
+    /** Store a compiled shader. Failures to write are logged and otherwise ignored. */
+    void Store(const Opal::StringUtf8& vertex_source, const Opal::StringUtf8& fragment_source, const CompiledShader& shader);
+
+    [[nodiscard]] ShaderCacheStats GetStats() const;
+
+private:
+    [[nodiscard]] Opal::StringUtf8 GetEntryPath(const Opal::StringUtf8& vertex_source, const Opal::StringUtf8& fragment_source) const;
+
+    Opal::StringUtf8 m_directory;
+    Opal::StringUtf8 m_compiler_version;
+    mutable std::mutex m_mutex;
+    ShaderCacheStats m_stats;
+};
+
+/**
+ * Compile shader sources to patched SPIR-V and reflection data. Looks the sources up in the shader
+ * archive and then in the shader cache of the live Context, and only invokes Slang if neither has
+ * them. Does not touch GL, so it can run on any thread.
+ * @param vertex_source Source of a single-source shader, or the vertex source of a two-source shader.
+ * @param fragment_source Fragment source of a two-source shader. Empty for single-source shaders.
+ */
+CompiledShader CompileShaderSources(const Opal::StringUtf8& vertex_source, const Opal::StringUtf8& fragment_source);
+
+/** @return Shader cache of the live Context, or nullptr if no Context exists or the cache is disabled. */
+ShaderCache* GetShaderCache();
+
+/** Register the shader cache of the live Context. Pass nullptr when the Context is destroyed. */
+void SetShaderCache(ShaderCache* cache);
+
+}  // namespace Rndr::Canvas::Impl
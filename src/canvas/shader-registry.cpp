@@ -0,0 +1,281 @@
+#include "rndr/canvas/shader-registry.hpp"
+
+#include "opal/exceptions.h"
+
+#include "canvas/shader-cache.hpp"
+
+#include "rndr/log.hpp"
+#include "rndr/trace.hpp"
+
+#include <chrono>
+
+namespace
+{
+
+/**
+ * Read the sources of a shader, expanding includes.
+ * @return False if any of the source files can't be read. The dependencies are filled in either way.
+ */
+bool ReadSources(const Rndr::Canvas::ShaderFileDesc& desc, Rndr::ShaderFileCache& file_cache, Opal::StringUtf8& out_vertex_source,
+                 Opal::StringUtf8& out_fragment_source, Opal::DynamicArray<Opal::StringUtf8>& out_dependencies)
+{
+    out_vertex_source = Rndr::File::ReadShader(desc.ref_path, desc.vertex_path, &out_dependencies, &file_cache);
+    if (!desc.fragment_path.IsEmpty())
+    {
+        out_fragment_source = Rndr::File::ReadShader(desc.ref_path, desc.fragment_path, &out_dependencies, &file_cache);
+        if (out_fragment_source.IsEmpty())
+        {
+            return false;
+        }
+    }
+    return !out_vertex_source.IsEmpty();
+}
+
+}  // namespace
+
+struct Rndr::Canvas::ShaderRegistry::Entry
+{
+    ShaderFileDesc desc;
+    Opal::ScopePtr<Shader> shader;
+
+    /** Files the shader was built from. Guarded by m_mutex. */
+    Opal::DynamicArray<Opal::StringUtf8> dependencies;
+};
+
+struct Rndr::Canvas::ShaderRegistry::PendingReload
+{
+    Entry* entry = nullptr;
+    Impl::CompiledShader compiled;
+    Opal::StringUtf8 vertex_source;
+    Opal::StringUtf8 fragment_source;
+};
+
+Rndr::Canvas::ShaderRegistry::ShaderRegistry(const ShaderRegistryDesc& desc) : m_desc(desc)
+{
+    m_watch_thread = std::thread([this]() { WatchLoop(); });
+}
+
+Rndr::Canvas::ShaderRegistry::~ShaderRegistry()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_stop_condition.notify_all();
+    m_watch_thread.join();
+}
+
+const Rndr::Canvas::Shader& Rndr::Canvas::ShaderRegistry::Load(const ShaderFileDesc& desc)
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::ShaderRegistry::Load");
+
+    Opal::ScopePtr<Entry> entry = Opal::MakeScoped<Entry>(nullptr);
+    entry->desc.ref_path = desc.ref_path.Clone();
+    entry->desc.vertex_path = desc.vertex_path.Clone();
+    entry->desc.fragment_path = desc.fragment_path.Clone();
+    entry->desc.debug_name = desc.debug_name.Clone();
+
+    Opal::StringUtf8 vertex_source;
+    Opal::StringUtf8 fragment_source;
+    Opal::DynamicArray<Opal::StringUtf8> dependencies;
+    if (!ReadSources(entry->desc, m_file_cache, vertex_source, fragment_source, dependencies))
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Failed to read shader file or file is empty!");
+    }
+
+    Impl::CompiledShader compiled = Impl::CompileShaderSources(vertex_source, fragment_source);
+    entry->shader = Opal::MakeScoped<Shader>(nullptr);
+    *entry->shader = Shader::FromCompiled(compiled, vertex_source, fragment_source, desc.debug_name.Clone());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    WatchDependencies(dependencies);
+    entry->dependencies = std::move(dependencies);
+    m_entries.PushBack(std::move(entry));
+    return *m_entries.Back()->shader;
+}
+
+Rndr::u32 Rndr::Canvas::ShaderRegistry::Update()
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::ShaderRegistry::Update");
+
+    Opal::DynamicArray<Opal::ScopePtr<PendingReload>> pending_reloads;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pending_reloads.IsEmpty())
+        {
+            return 0;
+        }
+        pending_reloads = std::move(m_pending_reloads);
+        m_pending_reloads.Clear();
+    }
+
+    u32 reloaded_count = 0;
+    for (u64 i = 0; i < pending_reloads.GetSize(); ++i)
+    {
+        PendingReload& reload = *pending_reloads[i];
+        Shader& shader = *reload.entry->shader;
+        try
+        {
+            // Linking happens before the swap, so a failure leaves the old program in place.
+            shader.Reload(
+                Shader::FromCompiled(reload.compiled, reload.vertex_source, reload.fragment_source, shader.GetDebugName().Clone()));
+            ++reloaded_count;
+            RNDR_LOG_INFO("Reloaded shader '{}'", *shader.GetDebugName());
+        }
+        catch (const Opal::Exception& e)
+        {
+            RNDR_LOG_ERROR("Failed to reload shader '{}': {}", *shader.GetDebugName(), *e.What());
+        }
+    }
+    return reloaded_count;
+}
+
+Opal::DynamicArray<Opal::StringUtf8> Rndr::Canvas::ShaderRegistry::GetDependencies(const Shader& shader) const
+{
+    Opal::DynamicArray<Opal::StringUtf8> dependencies;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (u64 i = 0; i < m_entries.GetSize(); ++i)
+    {
+        if (m_entries[i]->shader.Get() == &shader)
+        {
+            for (u64 j = 0; j < m_entries[i]->dependencies.GetSize(); ++j)
+            {
+                dependencies.PushBack(m_entries[i]->dependencies[j].Clone());
+            }
+            break;
+        }
+    }
+    return dependencies;
+}
+
+Rndr::u64 Rndr::Canvas::ShaderRegistry::GetShaderCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.GetSize();
+}
+
+Rndr::ShaderFileCacheStats Rndr::Canvas::ShaderRegistry::GetFileCacheStats() const
+{
+    return m_file_cache.GetStats();
+}
+
+void Rndr::Canvas::ShaderRegistry::WatchDependencies(const Opal::DynamicArray<Opal::StringUtf8>& dependencies)
+{
+    for (u64 i = 0; i < dependencies.GetSize(); ++i)
+    {
+        bool is_watched = false;
+        for (u64 j = 0; j < m_files.GetSize() && !is_watched; ++j)
+        {
+            is_watched = m_files[j].path == dependencies[i];
+        }
+        if (!is_watched)
+        {
+            WatchedFile file;
+            file.path = dependencies[i].Clone();
+            // The time the sources were read at, not the current one, so edits made since then trigger a reload.
+            file.last_write_time = m_file_cache.GetLastWriteTime(file.path);
+            m_files.PushBack(std::move(file));
+        }
+    }
+}
+
+void Rndr::Canvas::ShaderRegistry::WatchLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_stop_condition.wait_for(lock, std::chrono::milliseconds(m_desc.poll_interval_ms), [this]() { return m_stop; });
+        if (m_stop)
+        {
+            return;
+        }
+
+        // Files are only ever appended, so the first file_count entries stay valid while unlocked.
+        Opal::DynamicArray<Opal::StringUtf8> paths;
+        for (u64 i = 0; i < m_files.GetSize(); ++i)
+        {
+            paths.PushBack(m_files[i].path.Clone());
+        }
+        const u64 file_count = paths.GetSize();
+        lock.unlock();
+        Opal::DynamicArray<i64> write_times(file_count);
+        for (u64 i = 0; i < file_count; ++i)
+        {
+            write_times[i] = Rndr::File::GetLastWriteTime(paths[i]);
+        }
+        lock.lock();
+
+        Opal::DynamicArray<Opal::StringUtf8> changed_files;
+        for (u64 i = 0; i < file_count; ++i)
+        {
+            if (m_files[i].last_write_time != write_times[i])
+            {
+                m_files[i].last_write_time = write_times[i];
+                changed_files.PushBack(std::move(paths[i]));
+            }
+        }
+        if (changed_files.IsEmpty())
+        {
+            continue;
+        }
+
+        // Only the shaders that depend on a changed file are rebuilt.
+        Opal::DynamicArray<Entry*> affected_entries;
+        for (u64 i = 0; i < m_entries.GetSize(); ++i)
+        {
+            bool is_affected = false;
+            const Opal::DynamicArray<Opal::StringUtf8>& dependencies = m_entries[i]->dependencies;
+            for (u64 j = 0; j < dependencies.GetSize() && !is_affected; ++j)
+            {
+                for (u64 k = 0; k < changed_files.GetSize() && !is_affected; ++k)
+                {
+                    is_affected = dependencies[j] == changed_files[k];
+                }
+            }
+            if (is_affected)
+            {
+                affected_entries.PushBack(m_entries[i].Get());
+            }
+        }
+
+        // Entries are never removed and their desc never changes, so they can be used unlocked.
+        lock.unlock();
+        for (u64 i = 0; i < affected_entries.GetSize(); ++i)
+        {
+            RNDR_CPU_EVENT_SCOPED("Canvas::ShaderRegistry::Recompile");
+
+            Entry* entry = affected_entries[i];
+            Opal::ScopePtr<PendingReload> reload = Opal::MakeScoped<PendingReload>(nullptr);
+            reload->entry = entry;
+            Opal::DynamicArray<Opal::StringUtf8> dependencies;
+            bool is_compiled = false;
+            if (ReadSources(entry->desc, m_file_cache, reload->vertex_source, reload->fragment_source, dependencies))
+            {
+                try
+                {
+                    reload->compiled = Impl::CompileShaderSources(reload->vertex_source, reload->fragment_source);
+                    is_compiled = true;
+                }
+                catch (const Opal::Exception& e)
+                {
+                    RNDR_LOG_ERROR("Failed to recompile shader '{}': {}", *entry->desc.debug_name, *e.What());
+                }
+            }
+            else
+            {
+                RNDR_LOG_ERROR("Failed to read the sources of shader '{}'!", *entry->desc.debug_name);
+            }
+
+            // Includes may have been added or removed, so the dependencies are refreshed even on failure.
+            lock.lock();
+            WatchDependencies(dependencies);
+            entry->dependencies = std::move(dependencies);
+            if (is_compiled)
+            {
+                m_pending_reloads.PushBack(std::move(reload));
+            }
+            lock.unlock();
+        }
+        lock.lock();
+    }
+}
@@ -2,13 +2,24 @@
 
 #include "glad/glad.h"
 
+#include "opal/container/hash-map.h"
+#include "opal/container/scope-ptr.h"
+
+#include "canvas/fnv-hash.hpp"
+#include "canvas/gl-state-cache.hpp"
+#include "canvas/shader-archive.hpp"
+#include "canvas/shader-cache.hpp"
 #include "canvas/spirv-patch.hpp"
+#include "core/parallel-for.hpp"
 #include "rndr/core/shader-compiler.hpp"
 #include "rndr/exception.hpp"
 #include "rndr/file.hpp"
 #include "rndr/log.hpp"
 #include "rndr/trace.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
 
 namespace
@@ -127,12 +138,17 @@ Rndr::Canvas::VertexLayout BuildVertexLayout(const Opal::DynamicArray<Rndr::Vert
 // OpenGL shader and program creation.
 // ---------------------------------------------------------------------------
 
-GLuint CreateShaderFromSpirv(GLenum stage, const void* spirv_data, size_t spirv_size, const char* entry_point)
+/** Values of specialization constants to apply when creating GL shaders. Empty for the default values. */
+struct SpecializationValues
 {
-    const size_t word_count = spirv_size / sizeof(Rndr::u32);
-    Opal::DynamicArray<Rndr::u32> patched(word_count);
-    memcpy(patched.GetData(), spirv_data, spirv_size);
-    Rndr::Impl::PatchSpirv(patched);
+    Opal::DynamicArray<Rndr::u32> constant_ids;
+    Opal::DynamicArray<Rndr::u32> values;
+};
+
+GLuint CreateShaderFromSpirv(GLenum stage, const Rndr::Canvas::Impl::CompiledStage& compiled_stage,
+                             const SpecializationValues& specialization)
+{
+    const Opal::DynamicArray<Rndr::u32>& spirv = compiled_stage.spirv;
 
     const GLuint shader = glCreateShader(stage);
     if (shader == 0)
@@ -140,7 +156,7 @@ GLuint CreateShaderFromSpirv(GLenum stage, const void* spirv_data, size_t spirv_
         throw Rndr::GraphicsAPIException(0, "Failed to create GL shader!");
     }
 
-    glShaderBinary(1, &shader, GL_SHADER_BINARY_FORMAT_SPIR_V, patched.GetData(), static_cast<GLsizei>(spirv_size));
+    glShaderBinary(1, &shader, GL_SHADER_BINARY_FORMAT_SPIR_V, spirv.GetData(), static_cast<GLsizei>(spirv.GetSize() * sizeof(Rndr::u32)));
 
     const GLenum err = glGetError();
     if (err != GL_NO_ERROR)
@@ -149,7 +165,23 @@ GLuint CreateShaderFromSpirv(GLenum stage, const void* spirv_data, size_t spirv_
         throw Rndr::GraphicsAPIException(err, "Failed to upload SPIR-V binary!");
     }
 
-    glSpecializeShader(shader, entry_point, 0, nullptr, nullptr);
+    // GL rejects ids that the module does not declare, so each stage only gets its own constants.
+    Opal::DynamicArray<Rndr::u32> constant_ids;
+    Opal::DynamicArray<Rndr::u32> values;
+    for (Rndr::u64 i = 0; i < specialization.constant_ids.GetSize(); ++i)
+    {
+        for (Rndr::u64 j = 0; j < compiled_stage.specialization_constant_ids.GetSize(); ++j)
+        {
+            if (compiled_stage.specialization_constant_ids[j] == specialization.constant_ids[i])
+            {
+                constant_ids.PushBack(specialization.constant_ids[i]);
+                values.PushBack(specialization.values[i]);
+                break;
+            }
+        }
+    }
+    glSpecializeShader(shader, *compiled_stage.entry_point, static_cast<GLuint>(constant_ids.GetSize()), constant_ids.GetData(),
+                       values.GetData());
 
     GLint compiled = 0;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
@@ -239,20 +271,66 @@ GLuint LinkProgram(GLuint shader)
 }
 
 // ---------------------------------------------------------------------------
-// Core build: compile stages via ShaderCompiler, link GL program.
+// Compilation: Slang source to patched SPIR-V and reflection data.
 // ---------------------------------------------------------------------------
 
-struct ShaderBuildResult
+Rndr::Canvas::Impl::CompiledStage MakeCompiledStage(Rndr::ShaderStage stage, Opal::StringUtf8 entry_point,
+                                                    const Rndr::CompileResult& result)
 {
-    GLuint program = 0;
-    Opal::StringUtf8 vertex_entry;
-    Opal::StringUtf8 fragment_entry;
-    Opal::DynamicArray<Rndr::ShaderParameter> parameters;
-    Rndr::Canvas::VertexLayout vertex_layout;
-    Rndr::NumThreads num_threads;
-};
+    Rndr::Canvas::Impl::CompiledStage out;
+    out.stage = stage;
+    out.entry_point = std::move(entry_point);
+    out.spirv.Resize(result.spirv.GetSize() / sizeof(Rndr::u32));
+    memcpy(out.spirv.GetData(), result.spirv.GetData(), out.spirv.GetSize() * sizeof(Rndr::u32));
+    Rndr::Impl::PatchSpirv(out.spirv);
+    for (Rndr::u64 i = 0; i < result.specialization_constants.GetSize(); ++i)
+    {
+        out.specialization_constant_ids.PushBack(result.specialization_constants[i].constant_id);
+    }
+    return out;
+}
+
+/** Add the specialization constants of a stage to the shader, skipping ids already declared by another stage. */
+void AddSpecializationConstants(Rndr::Canvas::Impl::CompiledShader& shader, const Rndr::CompileResult& result)
+{
+    for (Rndr::u64 i = 0; i < result.specialization_constants.GetSize(); ++i)
+    {
+        const Rndr::SpecializationConstant& constant = result.specialization_constants[i];
+        bool found = false;
+        for (Rndr::u64 j = 0; j < shader.specialization_constants.GetSize() && !found; ++j)
+        {
+            found = shader.specialization_constants[j].constant_id == constant.constant_id;
+        }
+        if (!found)
+        {
+            Rndr::SpecializationConstant copy;
+            copy.name = constant.name.Clone();
+            copy.constant_id = constant.constant_id;
+            copy.default_value = constant.default_value;
+            shader.specialization_constants.PushBack(std::move(copy));
+        }
+    }
+}
+
+Rndr::ShaderParameter CloneParameter(const Rndr::ShaderParameter& param)
+{
+    Rndr::ShaderParameter out;
+    out.name = param.name.Clone();
+    out.binding_index = param.binding_index;
+    out.binding_space = param.binding_space;
+    out.offset = param.offset;
+    out.size = param.size;
+    out.array_element_count = param.array_element_count;
+    out.array_stride = param.array_stride;
+    out.category = param.category;
+    out.writable = param.writable;
+    out.scalar_type = param.scalar_type;
+    out.row_count = param.row_count;
+    out.column_count = param.column_count;
+    return out;
+}
 
-ShaderBuildResult BuildFromSingleSource(const Opal::StringUtf8& source, Opal::StringUtf8 debug_name)
+Rndr::Canvas::Impl::CompiledShader CompileSingleSource(const Opal::StringUtf8& source)
 {
     Rndr::ShaderCompiler compiler;
     compiler.LoadModule(source);
@@ -285,35 +363,20 @@ ShaderBuildResult BuildFromSingleSource(const Opal::StringUtf8& source, Opal::St
         throw Rndr::GraphicsAPIException(0, "Shader source contains both compute and graphics entry points!");
     }
 
+    Rndr::Canvas::Impl::CompiledShader out;
+
     // Compute path.
     if (compute_count > 0)
     {
-        const Opal::StringUtf8 cs_entry = Rndr::ShaderCompiler::FindSingleEntryPoint(entries, Rndr::ShaderStage::Compute, "compute");
+        Opal::StringUtf8 cs_entry = Rndr::ShaderCompiler::FindSingleEntryPoint(entries, Rndr::ShaderStage::Compute, "compute");
         Rndr::CompileResult cs_result = compiler.CompileEntryPoint(cs_entry);
         if (cs_result.stage != Rndr::ShaderStage::Compute)
         {
             throw Rndr::GraphicsAPIException(0, "Compute entry point does not have [shader(\"compute\")] annotation!");
         }
 
-        const GLuint cs = CreateShaderFromSpirv(GL_COMPUTE_SHADER, cs_result.spirv.GetData(), cs_result.spirv.GetSize(), *cs_entry);
-        const Opal::StringUtf8 shader_name = debug_name + " - Compute Shader";
-        glObjectLabel(GL_SHADER, cs, static_cast<GLsizei>(shader_name.GetSize()), *shader_name);
-        GLuint program = 0;
-        try
-        {
-            program = LinkProgram(cs);
-            const Opal::StringUtf8 program_name = debug_name + " - Shader Program";
-            glObjectLabel(GL_PROGRAM, program, static_cast<GLsizei>(program_name.GetSize()), *program_name);
-        }
-        catch (...)
-        {
-            glDeleteShader(cs);
-            throw;
-        }
-        glDeleteShader(cs);
-
-        ShaderBuildResult out;
-        out.program = program;
+        out.stages.PushBack(MakeCompiledStage(Rndr::ShaderStage::Compute, std::move(cs_entry), cs_result));
+        AddSpecializationConstants(out, cs_result);
         out.parameters = std::move(cs_result.parameters);
         out.num_threads = cs_result.num_threads;
         return out;
@@ -335,51 +398,16 @@ ShaderBuildResult BuildFromSingleSource(const Opal::StringUtf8& source, Opal::St
         throw Rndr::GraphicsAPIException(0, "Fragment entry point does not have [shader(\"fragment\")] annotation!");
     }
 
-    Opal::DynamicArray<Rndr::ShaderParameter> merged = Rndr::ShaderCompiler::MergeParameters(vs_result.parameters, fs_result.parameters);
-
-    const GLuint vs = CreateShaderFromSpirv(GL_VERTEX_SHADER, vs_result.spirv.GetData(), vs_result.spirv.GetSize(), *vs_entry);
-    const Opal::StringUtf8 vertex_shader_name = debug_name + " - Vertex Shader";
-    glObjectLabel(GL_SHADER, vs, static_cast<GLsizei>(vertex_shader_name.GetSize()), *vertex_shader_name);
-    GLuint fs = 0;
-    try
-    {
-        fs = CreateShaderFromSpirv(GL_FRAGMENT_SHADER, fs_result.spirv.GetData(), fs_result.spirv.GetSize(), *fs_entry);
-        const Opal::StringUtf8 fragment_shader_name = debug_name + " - Fragment Shader";
-        glObjectLabel(GL_SHADER, fs, static_cast<GLsizei>(fragment_shader_name.GetSize()), *fragment_shader_name);
-    }
-    catch (...)
-    {
-        glDeleteShader(vs);
-        throw;
-    }
-
-    GLuint program = 0;
-    try
-    {
-        program = LinkProgram(vs, fs);
-        const Opal::StringUtf8 program_name = debug_name + " - Shader Program";
-        glObjectLabel(GL_PROGRAM, program, static_cast<GLsizei>(program_name.GetSize()), *program_name);
-    }
-    catch (...)
-    {
-        glDeleteShader(vs);
-        glDeleteShader(fs);
-        throw;
-    }
-    glDeleteShader(vs);
-    glDeleteShader(fs);
-
-    ShaderBuildResult out;
-    out.program = program;
-    out.vertex_entry = std::move(vs_entry);
-    out.fragment_entry = std::move(fs_entry);
-    out.parameters = std::move(merged);
-    out.vertex_layout = BuildVertexLayout(vs_result.vertex_inputs);
+    out.stages.PushBack(MakeCompiledStage(Rndr::ShaderStage::Vertex, std::move(vs_entry), vs_result));
+    out.stages.PushBack(MakeCompiledStage(Rndr::ShaderStage::Fragment, std::move(fs_entry), fs_result));
+    AddSpecializationConstants(out, vs_result);
+    AddSpecializationConstants(out, fs_result);
+    out.parameters = Rndr::ShaderCompiler::MergeParameters(vs_result.parameters, fs_result.parameters);
+    out.vertex_inputs = std::move(vs_result.vertex_inputs);
     return out;
 }
 
-ShaderBuildResult BuildFromTwoSources(const Opal::StringUtf8& vertex_source, const Opal::StringUtf8& fragment_source,
-                                      Opal::StringUtf8 debug_name)
+Rndr::Canvas::Impl::CompiledShader CompileTwoSources(const Opal::StringUtf8& vertex_source, const Opal::StringUtf8& fragment_source)
 {
     Rndr::ShaderCompiler vs_compiler;
     vs_compiler.LoadModule(vertex_source);
@@ -403,15 +431,53 @@ ShaderBuildResult BuildFromTwoSources(const Opal::StringUtf8& vertex_source, con
         throw Rndr::GraphicsAPIException(0, "Fragment entry point does not have [shader(\"fragment\")] annotation!");
     }
 
-    Opal::DynamicArray<Rndr::ShaderParameter> merged = Rndr::ShaderCompiler::MergeParameters(vs_result.parameters, fs_result.parameters);
+    Rndr::Canvas::Impl::CompiledShader out;
+    out.stages.PushBack(MakeCompiledStage(Rndr::ShaderStage::Vertex, std::move(vs_entry), vs_result));
+    out.stages.PushBack(MakeCompiledStage(Rndr::ShaderStage::Fragment, std::move(fs_entry), fs_result));
+    AddSpecializationConstants(out, vs_result);
+    AddSpecializationConstants(out, fs_result);
+    out.parameters = Rndr::ShaderCompiler::MergeParameters(vs_result.parameters, fs_result.parameters);
+    out.vertex_inputs = std::move(vs_result.vertex_inputs);
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+// Linking: create the GL program from compiled stages.
+// ---------------------------------------------------------------------------
+
+GLuint LinkCompiledShader(const Opal::DynamicArray<Rndr::Canvas::Impl::CompiledStage>& stages, const SpecializationValues& specialization,
+                          const Opal::StringUtf8& debug_name)
+{
+    // Compute path.
+    if (stages.GetSize() == 1)
+    {
+        const GLuint cs = CreateShaderFromSpirv(GL_COMPUTE_SHADER, stages[0], specialization);
+        const Opal::StringUtf8 shader_name = debug_name + " - Compute Shader";
+        glObjectLabel(GL_SHADER, cs, static_cast<GLsizei>(shader_name.GetSize()), *shader_name);
+        GLuint program = 0;
+        try
+        {
+            program = LinkProgram(cs);
+            const Opal::StringUtf8 program_name = debug_name + " - Shader Program";
+            glObjectLabel(GL_PROGRAM, program, static_cast<GLsizei>(program_name.GetSize()), *program_name);
+        }
+        catch (...)
+        {
+            glDeleteShader(cs);
+            throw;
+        }
+        glDeleteShader(cs);
+        return program;
+    }
 
-    const GLuint vs = CreateShaderFromSpirv(GL_VERTEX_SHADER, vs_result.spirv.GetData(), vs_result.spirv.GetSize(), *vs_entry);
+    // Graphics path.
+    const GLuint vs = CreateShaderFromSpirv(GL_VERTEX_SHADER, stages[0], specialization);
     const Opal::StringUtf8 vertex_shader_name = debug_name + " - Vertex Shader";
     glObjectLabel(GL_SHADER, vs, static_cast<GLsizei>(vertex_shader_name.GetSize()), *vertex_shader_name);
     GLuint fs = 0;
     try
     {
-        fs = CreateShaderFromSpirv(GL_FRAGMENT_SHADER, fs_result.spirv.GetData(), fs_result.spirv.GetSize(), *fs_entry);
+        fs = CreateShaderFromSpirv(GL_FRAGMENT_SHADER, stages[1], specialization);
         const Opal::StringUtf8 fragment_shader_name = debug_name + " - Fragment Shader";
         glObjectLabel(GL_SHADER, fs, static_cast<GLsizei>(fragment_shader_name.GetSize()), *fragment_shader_name);
     }
@@ -436,18 +502,47 @@ ShaderBuildResult BuildFromTwoSources(const Opal::StringUtf8& vertex_source, con
     }
     glDeleteShader(vs);
     glDeleteShader(fs);
-
-    ShaderBuildResult out;
-    out.program = program;
-    out.vertex_entry = std::move(vs_entry);
-    out.fragment_entry = std::move(fs_entry);
-    out.parameters = std::move(merged);
-    out.vertex_layout = BuildVertexLayout(vs_result.vertex_inputs);
-    return out;
+    return program;
 }
 
 }  // namespace
 
+struct Rndr::Canvas::Shader::VariantData
+{
+    /** Patched SPIR-V of all stages. Variants are linked from it without invoking Slang. */
+    Opal::DynamicArray<Impl::CompiledStage> stages;
+
+    Opal::DynamicArray<PermutationKey> keys;
+
+    /** Variants by packed key values, see PackVariantKey(). */
+    Opal::HashMap<u64, Opal::ScopePtr<Shader>> variants;
+};
+
+Rndr::Canvas::Impl::CompiledShader Rndr::Canvas::Impl::CompileShaderSources(const Opal::StringUtf8& vertex_source,
+                                                                             const Opal::StringUtf8& fragment_source)
+{
+    ShaderArchive* archive = GetShaderArchive();
+    ShaderArchiveEntry entry;
+    if (archive != nullptr && archive->FindBySources(vertex_source, fragment_source, entry))
+    {
+        return std::move(entry.compiled);
+    }
+
+    ShaderCache* cache = GetShaderCache();
+    CompiledShader compiled;
+    if (cache != nullptr && cache->Load(vertex_source, fragment_source, compiled))
+    {
+        return compiled;
+    }
+
+    compiled = fragment_source.IsEmpty() ? CompileSingleSource(vertex_source) : CompileTwoSources(vertex_source, fragment_source);
+    if (cache != nullptr)
+    {
+        cache->Store(vertex_source, fragment_source, compiled);
+    }
+    return compiled;
+}
+
 Rndr::Canvas::Shader Rndr::Canvas::Shader::FromSource(const Opal::StringUtf8& path, Opal::StringUtf8 debug_name)
 {
     RNDR_CPU_EVENT_SCOPED("Canvas::Shader::FromSource");
@@ -470,19 +565,8 @@ Rndr::Canvas::Shader Rndr::Canvas::Shader::FromSourceInMemory(const Opal::String
         throw Opal::InvalidArgumentException(__FUNCTION__, "Shader source is empty!");
     }
 
-    ShaderBuildResult build = BuildFromSingleSource(source, debug_name.Clone());
-
-    Shader shader;
-    shader.m_program = build.program;
-    shader.m_vertex_source = source.Clone();
-    shader.m_vertex_entry = std::move(build.vertex_entry);
-    shader.m_fragment_entry = std::move(build.fragment_entry);
-    shader.m_parameters = std::move(build.parameters);
-    shader.m_vertex_layout = std::move(build.vertex_layout);
-    shader.m_num_threads = build.num_threads;
-    shader.m_debug_name = std::move(debug_name);
-
-    return shader;
+    Impl::CompiledShader compiled = Impl::CompileShaderSources(source, "");
+    return FromCompiled(compiled, source, "", std::move(debug_name));
 }
 
 Rndr::Canvas::Shader Rndr::Canvas::Shader::FromSources(const Opal::StringUtf8& vertex_path, const Opal::StringUtf8& fragment_path,
@@ -519,17 +603,88 @@ Rndr::Canvas::Shader Rndr::Canvas::Shader::FromSourcesInMemory(const Opal::Strin
         throw Opal::InvalidArgumentException(__FUNCTION__, "Fragment shader source is empty!");
     }
 
-    ShaderBuildResult build = BuildFromTwoSources(vertex_source, fragment_source, std::move(debug_name));
+    Impl::CompiledShader compiled = Impl::CompileShaderSources(vertex_source, fragment_source);
+    return FromCompiled(compiled, vertex_source, fragment_source, std::move(debug_name));
+}
+
+Rndr::Canvas::Shader Rndr::Canvas::Shader::FromArchive(const Opal::StringUtf8& name, Opal::StringUtf8 debug_name)
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::Shader::FromArchive");
 
+    Impl::ShaderArchive* archive = Impl::GetShaderArchive();
+    if (archive == nullptr)
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "The Context has no shader archive!");
+    }
+    Impl::ShaderArchiveEntry entry;
+    if (!archive->FindByName(name, entry))
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Shader is not in the shader archive!");
+    }
+
+    if (debug_name.IsEmpty())
+    {
+        debug_name = name.Clone();
+    }
+    return FromCompiled(entry.compiled, entry.vertex_source, entry.fragment_source, std::move(debug_name));
+}
+
+Opal::DynamicArray<Rndr::Canvas::Shader> Rndr::Canvas::Shader::FromSourcesBatch(const Opal::DynamicArray<ShaderSourceDesc>& descs,
+                                                                                u32 max_threads)
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::Shader::FromSourcesBatch");
+
+    for (u64 i = 0; i < descs.GetSize(); ++i)
+    {
+        if (descs[i].vertex_source.IsEmpty())
+        {
+            throw Opal::InvalidArgumentException(__FUNCTION__, "Shader source is empty!");
+        }
+    }
+
+    // Slang compilation and cache lookups do not touch GL, so they run on worker threads.
+    Opal::DynamicArray<Impl::CompiledShader> compiled(descs.GetSize());
+    Rndr::Impl::ParallelFor(descs.GetSize(), max_threads,
+                            [&descs, &compiled](u64 index)
+                            {
+                                RNDR_CPU_EVENT_SCOPED("Canvas::Shader::FromSourcesBatch::Compile");
+                                compiled[index] = Impl::CompileShaderSources(descs[index].vertex_source, descs[index].fragment_source);
+                            });
+
+    Opal::DynamicArray<Shader> shaders;
+    for (u64 i = 0; i < descs.GetSize(); ++i)
+    {
+        shaders.PushBack(
+            FromCompiled(compiled[i], descs[i].vertex_source, descs[i].fragment_source, descs[i].debug_name.Clone()));
+    }
+    return shaders;
+}
+
+Rndr::Canvas::Shader Rndr::Canvas::Shader::FromCompiled(Impl::CompiledShader& compiled, const Opal::StringUtf8& vertex_source,
+                                                        const Opal::StringUtf8& fragment_source, Opal::StringUtf8 debug_name)
+{
     Shader shader;
-    shader.m_program = build.program;
+    shader.m_program = LinkCompiledShader(compiled.stages, {}, debug_name);
     shader.m_vertex_source = vertex_source.Clone();
-    shader.m_vertex_entry = std::move(build.vertex_entry);
     shader.m_fragment_source = fragment_source.Clone();
-    shader.m_fragment_entry = std::move(build.fragment_entry);
-    shader.m_parameters = std::move(build.parameters);
-    shader.m_vertex_layout = std::move(build.vertex_layout);
-    shader.m_num_threads = build.num_threads;
+    if (compiled.stages.GetSize() == 2)
+    {
+        shader.m_vertex_entry = compiled.stages[0].entry_point.Clone();
+        shader.m_fragment_entry = compiled.stages[1].entry_point.Clone();
+    }
+    shader.m_parameters = std::move(compiled.parameters);
+    shader.BuildUniformBlocks();
+    shader.m_vertex_layout = BuildVertexLayout(compiled.vertex_inputs);
+    shader.m_num_threads = compiled.num_threads;
+    shader.m_debug_name = std::move(debug_name);
+
+    // Only shaders with specialization constants can have variants, so only they keep their SPIR-V.
+    if (!compiled.specialization_constants.IsEmpty())
+    {
+        shader.m_specialization_constants = std::move(compiled.specialization_constants);
+        shader.m_variant_data = new VariantData();
+        shader.m_variant_data->stages = std::move(compiled.stages);
+    }
 
     return shader;
 }
@@ -541,16 +696,26 @@ Rndr::Canvas::Shader::~Shader()
 
 Rndr::Canvas::Shader::Shader(Shader&& other) noexcept
     : m_program(other.m_program),
+      m_debug_name(std::move(other.m_debug_name)),
       m_vertex_source(std::move(other.m_vertex_source)),
       m_vertex_entry(std::move(other.m_vertex_entry)),
       m_fragment_source(std::move(other.m_fragment_source)),
       m_fragment_entry(std::move(other.m_fragment_entry)),
       m_parameters(std::move(other.m_parameters)),
+      m_uniform_blocks(std::move(other.m_uniform_blocks)),
+      m_uniform_layout_hash(other.m_uniform_layout_hash),
       m_vertex_layout(std::move(other.m_vertex_layout)),
-      m_num_threads(other.m_num_threads)
+      m_num_threads(other.m_num_threads),
+      m_specialization_constants(std::move(other.m_specialization_constants)),
+      m_variant_data(other.m_variant_data),
+      m_variant_parent(other.m_variant_parent),
+      m_variant_values(std::move(other.m_variant_values))
 {
     other.m_program = 0;
     other.m_num_threads = {};
+    other.m_variant_data = nullptr;
+    other.m_variant_parent = nullptr;
+    UpdateVariantParents();
 }
 
 Rndr::Canvas::Shader& Rndr::Canvas::Shader::operator=(Shader&& other) noexcept
@@ -559,15 +724,25 @@ Rndr::Canvas::Shader& Rndr::Canvas::Shader::operator=(Shader&& other) noexcept
     {
         Destroy();
         m_program = other.m_program;
+        m_debug_name = std::move(other.m_debug_name);
         m_vertex_source = std::move(other.m_vertex_source);
         m_vertex_entry = std::move(other.m_vertex_entry);
         m_fragment_source = std::move(other.m_fragment_source);
         m_fragment_entry = std::move(other.m_fragment_entry);
         m_parameters = std::move(other.m_parameters);
+        m_uniform_blocks = std::move(other.m_uniform_blocks);
+        m_uniform_layout_hash = other.m_uniform_layout_hash;
         m_vertex_layout = std::move(other.m_vertex_layout);
         m_num_threads = other.m_num_threads;
+        m_specialization_constants = std::move(other.m_specialization_constants);
+        m_variant_data = other.m_variant_data;
+        m_variant_parent = other.m_variant_parent;
+        m_variant_values = std::move(other.m_variant_values);
         other.m_program = 0;
         other.m_num_threads = {};
+        other.m_variant_data = nullptr;
+        other.m_variant_parent = nullptr;
+        UpdateVariantParents();
     }
     return *this;
 }
@@ -580,21 +755,34 @@ Rndr::Canvas::Shader Rndr::Canvas::Shader::Clone() const
     }
 
     Opal::StringUtf8 clone_debug_name = m_debug_name.Clone() + " Clone";
-    if (m_fragment_source.IsEmpty())
+    Shader clone = m_fragment_source.IsEmpty() ? FromSourceInMemory(m_vertex_source, std::move(clone_debug_name))
+                                               : FromSourcesInMemory(m_vertex_source, m_fragment_source, std::move(clone_debug_name));
+    if (m_variant_data != nullptr && !m_variant_data->keys.IsEmpty())
     {
-        return FromSourceInMemory(m_vertex_source, std::move(clone_debug_name));
+        clone.SetPermutationKeys(m_variant_data->keys);
     }
-    return FromSourcesInMemory(m_vertex_source, m_fragment_source, std::move(clone_debug_name));
+    return clone;
 }
 
 void Rndr::Canvas::Shader::Destroy()
 {
     if (m_program != 0)
     {
+        if (Impl::GLStateCache* state_cache = Impl::GetStateCache(); state_cache != nullptr)
+        {
+            state_cache->ForgetProgram(m_program);
+        }
         glDeleteProgram(m_program);
         m_program = 0;
     }
+    delete m_variant_data;
+    m_variant_data = nullptr;
+    m_variant_parent = nullptr;
+    m_variant_values.Clear();
+    m_specialization_constants.Clear();
     m_parameters.Clear();
+    m_uniform_blocks.Clear();
+    m_uniform_layout_hash = 0;
     m_vertex_layout = VertexLayout();
     m_num_threads = {};
 }
@@ -626,6 +814,274 @@ const Rndr::ShaderParameter* Rndr::Canvas::Shader::FindParameter(const Opal::Str
     return nullptr;
 }
 
+const Opal::DynamicArray<Rndr::Canvas::UniformBlock>& Rndr::Canvas::Shader::GetUniformBlocks() const
+{
+    return m_uniform_blocks;
+}
+
+Rndr::Canvas::UniformHandle Rndr::Canvas::Shader::GetUniformHandle(const Opal::StringUtf8& name) const
+{
+    UniformHandle handle;
+    const ShaderParameter* param = FindParameter(name);
+    if (param == nullptr || param->category != ParameterCategory::Uniform || param->size <= 0)
+    {
+        return handle;
+    }
+    for (u64 i = 0; i < m_uniform_blocks.GetSize(); ++i)
+    {
+        if (m_uniform_blocks[i].binding_index == param->binding_index && m_uniform_blocks[i].binding_space == param->binding_space)
+        {
+            handle.block_index = static_cast<i32>(i);
+            handle.offset = param->offset;
+            handle.size = param->size;
+            handle.array_element_count = param->array_element_count;
+            handle.array_stride = param->array_stride;
+            break;
+        }
+    }
+    return handle;
+}
+
+void Rndr::Canvas::Shader::BuildUniformBlocks()
+{
+    m_uniform_blocks.Clear();
+    m_uniform_layout_hash = Impl::k_fnv_offset_basis;
+    for (u64 i = 0; i < m_parameters.GetSize(); ++i)
+    {
+        const ShaderParameter& p = m_parameters[i];
+        if (p.category != ParameterCategory::Uniform || p.size <= 0)
+        {
+            continue;
+        }
+
+        const u64 name_size = p.name.GetSize();
+        Impl::HashBytes(m_uniform_layout_hash, &name_size, sizeof(name_size));
+        Impl::HashBytes(m_uniform_layout_hash, p.name.GetData(), name_size);
+        const i32 layout[] = {p.binding_index, p.binding_space, p.offset, p.size, p.array_element_count, p.array_stride};
+        Impl::HashBytes(m_uniform_layout_hash, layout, sizeof(layout));
+
+        const i32 end = p.offset + p.size;
+        bool found = false;
+        for (u64 j = 0; j < m_uniform_blocks.GetSize(); ++j)
+        {
+            if (m_uniform_blocks[j].binding_index == p.binding_index && m_uniform_blocks[j].binding_space == p.binding_space)
+            {
+                m_uniform_blocks[j].size = std::max(m_uniform_blocks[j].size, end);
+                found = true;
+                break;
+            }
+        }
+
+        if (!found)
+        {
+            UniformBlock block;
+            block.binding_index = p.binding_index;
+            block.binding_space = p.binding_space;
+            block.size = end;
+            m_uniform_blocks.PushBack(block);
+        }
+    }
+}
+
+Rndr::u64 Rndr::Canvas::Shader::GetUniformLayoutHash() const
+{
+    return m_uniform_layout_hash;
+}
+
+const Opal::DynamicArray<Rndr::SpecializationConstant>& Rndr::Canvas::Shader::GetSpecializationConstants() const
+{
+    return m_specialization_constants;
+}
+
+void Rndr::Canvas::Shader::SetPermutationKeys(const Opal::DynamicArray<PermutationKey>& keys)
+{
+    if (m_variant_data == nullptr)
+    {
+        if (keys.IsEmpty())
+        {
+            return;
+        }
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Shader has no specialization constants!");
+    }
+
+    u64 variant_count = 1;
+    for (u64 i = 0; i < keys.GetSize(); ++i)
+    {
+        bool found = false;
+        for (u64 j = 0; j < m_specialization_constants.GetSize() && !found; ++j)
+        {
+            found = m_specialization_constants[j].constant_id == keys[i].constant_id;
+        }
+        if (!found)
+        {
+            throw Opal::InvalidArgumentException(__FUNCTION__, "Permutation key does not name a specialization constant of the shader!");
+        }
+        if (keys[i].value_count < 2)
+        {
+            throw Opal::InvalidArgumentException(__FUNCTION__, "Permutation key must have at least two values!");
+        }
+        if (variant_count > UINT64_MAX / keys[i].value_count)
+        {
+            throw Opal::InvalidArgumentException(__FUNCTION__, "Too many permutation keys!");
+        }
+        variant_count *= keys[i].value_count;
+    }
+
+    m_variant_data->variants.Clear();
+    m_variant_data->keys.Clear();
+    for (u64 i = 0; i < keys.GetSize(); ++i)
+    {
+        m_variant_data->keys.PushBack(keys[i]);
+    }
+}
+
+Opal::ArrayView<const Rndr::Canvas::PermutationKey> Rndr::Canvas::Shader::GetPermutationKeys() const
+{
+    if (m_variant_data == nullptr)
+    {
+        return {};
+    }
+    return Opal::ArrayView<const PermutationKey>(m_variant_data->keys.GetData(), m_variant_data->keys.GetSize());
+}
+
+const Rndr::Canvas::Shader& Rndr::Canvas::Shader::GetVariant(Opal::ArrayView<const u32> values) const
+{
+    const u64 key_count = m_variant_data != nullptr ? m_variant_data->keys.GetSize() : 0;
+    if (values.GetSize() != key_count)
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Number of values does not match the number of permutation keys!");
+    }
+    if (key_count == 0)
+    {
+        return *this;
+    }
+
+    const u64 packed_key = PackVariantKey(values);
+    auto it = m_variant_data->variants.Find(packed_key);
+    if (it == m_variant_data->variants.end())
+    {
+        RNDR_CPU_EVENT_SCOPED("Canvas::Shader::LinkVariant");
+        Opal::ScopePtr<Shader> variant = Opal::MakeScoped<Shader>(nullptr);
+        *variant = LinkVariant(values);
+        m_variant_data->variants.Insert(packed_key, std::move(variant));
+        it = m_variant_data->variants.Find(packed_key);
+    }
+    return *it.GetValue();
+}
+
+Rndr::u64 Rndr::Canvas::Shader::GetVariantCount() const
+{
+    return m_variant_data != nullptr ? m_variant_data->variants.GetSize() : 0;
+}
+
+const Rndr::Canvas::Shader* Rndr::Canvas::Shader::GetVariantParent() const
+{
+    return m_variant_parent;
+}
+
+Opal::ArrayView<const Rndr::u32> Rndr::Canvas::Shader::GetVariantValues() const
+{
+    return Opal::ArrayView<const u32>(m_variant_values.GetData(), m_variant_values.GetSize());
+}
+
+Rndr::u64 Rndr::Canvas::Shader::PackVariantKey(Opal::ArrayView<const u32> values) const
+{
+    // Mixed radix, each key is a digit with value_count possible values.
+    u64 packed_key = 0;
+    u64 radix = 1;
+    for (u64 i = 0; i < values.GetSize(); ++i)
+    {
+        const PermutationKey& key = m_variant_data->keys[i];
+        if (values[i] >= key.value_count)
+        {
+            throw Opal::InvalidArgumentException(__FUNCTION__, "Permutation key value is out of range!");
+        }
+        packed_key += values[i] * radix;
+        radix *= key.value_count;
+    }
+    return packed_key;
+}
+
+Rndr::Canvas::Shader Rndr::Canvas::Shader::LinkVariant(Opal::ArrayView<const u32> values) const
+{
+    SpecializationValues specialization;
+    Opal::StringUtf8 debug_name = m_debug_name.Clone() + " - Variant";
+    for (u64 i = 0; i < values.GetSize(); ++i)
+    {
+        specialization.constant_ids.PushBack(m_variant_data->keys[i].constant_id);
+        specialization.values.PushBack(values[i]);
+        char value_str[16] = {};
+        snprintf(value_str, sizeof(value_str), " %u", values[i]);
+        debug_name = debug_name + value_str;
+    }
+
+    Shader variant;
+    variant.m_program = LinkCompiledShader(m_variant_data->stages, specialization, debug_name);
+    variant.m_debug_name = std::move(debug_name);
+    variant.m_vertex_source = m_vertex_source.Clone();
+    variant.m_vertex_entry = m_vertex_entry.Clone();
+    variant.m_fragment_source = m_fragment_source.Clone();
+    variant.m_fragment_entry = m_fragment_entry.Clone();
+    for (u64 i = 0; i < m_parameters.GetSize(); ++i)
+    {
+        variant.m_parameters.PushBack(CloneParameter(m_parameters[i]));
+    }
+    variant.BuildUniformBlocks();
+    variant.m_vertex_layout = m_vertex_layout.Clone();
+    variant.m_num_threads = m_num_threads;
+    variant.m_variant_parent = this;
+    for (u64 i = 0; i < values.GetSize(); ++i)
+    {
+        variant.m_variant_values.PushBack(values[i]);
+    }
+    return variant;
+}
+
+void Rndr::Canvas::Shader::UpdateVariantParents()
+{
+    if (m_variant_data == nullptr)
+    {
+        return;
+    }
+    for (auto& variant : m_variant_data->variants)
+    {
+        variant.value->m_variant_parent = this;
+    }
+}
+
+void Rndr::Canvas::Shader::Reload(Shader&& rebuilt)
+{
+    // Link the new variants first, so a failure leaves this shader and its variants untouched.
+    Opal::DynamicArray<u64> packed_keys;
+    Opal::DynamicArray<Shader> relinked_variants;
+    if (m_variant_data != nullptr && !m_variant_data->keys.IsEmpty())
+    {
+        rebuilt.SetPermutationKeys(m_variant_data->keys);
+        Opal::DynamicArray<u32> values(m_variant_data->keys.GetSize());
+        for (auto& variant : m_variant_data->variants)
+        {
+            u64 remaining_key = variant.key;
+            for (u64 i = 0; i < values.GetSize(); ++i)
+            {
+                values[i] = static_cast<u32>(remaining_key % m_variant_data->keys[i].value_count);
+                remaining_key /= m_variant_data->keys[i].value_count;
+            }
+            relinked_variants.PushBack(rebuilt.LinkVariant(Opal::ArrayView<const u32>(values.GetData(), values.GetSize())));
+            packed_keys.PushBack(variant.key);
+        }
+    }
+
+    // Variant objects are reused, so brushes that point to them stay valid.
+    for (u64 i = 0; i < packed_keys.GetSize(); ++i)
+    {
+        auto it = m_variant_data->variants.Find(packed_keys[i]);
+        Opal::ScopePtr<Shader> variant = std::move(it.GetValue());
+        *variant = std::move(relinked_variants[i]);
+        rebuilt.m_variant_data->variants.Insert(packed_keys[i], std::move(variant));
+    }
+    *this = std::move(rebuilt);
+}
+
 const Rndr::Canvas::VertexLayout& Rndr::Canvas::Shader::GetVertexLayout() const
 {
     return m_vertex_layout;
@@ -634,4 +1090,19 @@ const Rndr::Canvas::VertexLayout& Rndr::Canvas::Shader::GetVertexLayout() const
 const Rndr::NumThreads& Rndr::Canvas::Shader::GetNumThreads() const
 {
     return m_num_threads;
+}
+
+const Opal::StringUtf8& Rndr::Canvas::Shader::GetVertexSource() const
+{
+    return m_vertex_source;
+}
+
+const Opal::StringUtf8& Rndr::Canvas::Shader::GetFragmentSource() const
+{
+    return m_fragment_source;
+}
+
+const Opal::StringUtf8& Rndr::Canvas::Shader::GetDebugName() const
+{
+    return m_debug_name;
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "../../include/rndr/canvas/renderers/shape-renderer.hpp"
 
+#include "canvas/embedded-shaders.hpp"
 #include "rndr/canvas/context.hpp"
 #include "rndr/canvas/projections.hpp"
 
@@ -34,6 +35,11 @@ float4 FragmentMain(VertexOutput in)
 }
 )";
 
+const Opal::StringUtf8& Rndr::Canvas::Impl::GetShapeRendererShaderSource()
+{
+    return k_shader_source;
+}
+
 Rndr::Canvas::ShapeRenderer::ShapeRenderer(Opal::Ref<Context> context)
     : m_context(std::move(context))
 {
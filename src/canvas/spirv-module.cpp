@@ -0,0 +1,166 @@
+#include "canvas/spirv-module.hpp"
+
+#include "opal/exceptions.h"
+
+#include "rndr/definitions.hpp"
+#include "rndr/trace.hpp"
+
+#include <cstring>
+
+namespace
+{
+constexpr Rndr::u32 k_magic = 0x07230203;
+constexpr Rndr::u32 k_bound_word = 3;
+
+Rndr::u32 CreateOp(Rndr::u32 word_count, Rndr::u32 op_code)
+{
+    return (word_count << 16) | (op_code & 0xFFFF);
+}
+}  // namespace
+
+Rndr::Impl::SpirvModule::SpirvModule(Opal::DynamicArray<u32> words) : m_words(std::move(words))
+{
+    if (m_words.GetSize() < k_header_word_count)
+    {
+        throw Opal::Exception("Spir-V module too small, can't fit the header!");
+    }
+    if (m_words[0] != k_magic)
+    {
+        throw Opal::Exception("Not a Spir-V module, bad magic value!");
+    }
+
+    const u64 size = m_words.GetSize();
+    for (u64 i = k_header_word_count; i < size;)
+    {
+        const u32 word_count = m_words[i] >> 16;
+        if (word_count == 0)
+        {
+            throw Opal::Exception("Zero word count instruction detected!");
+        }
+        if (word_count > size - i)
+        {
+            throw Opal::Exception("Spir-V instruction runs past the end of the module!");
+        }
+        m_instructions.PushBack({.offset = static_cast<u32>(i), .word_count = word_count});
+        i += word_count;
+    }
+    m_word_count = size;
+}
+
+Rndr::u32 Rndr::Impl::SpirvModule::GetIdBound() const
+{
+    return m_words[k_bound_word];
+}
+
+Rndr::u64 Rndr::Impl::SpirvModule::GetInstructionCount() const
+{
+    return m_instructions.GetSize();
+}
+
+Rndr::u64 Rndr::Impl::SpirvModule::GetWordCount() const
+{
+    return m_word_count;
+}
+
+bool Rndr::Impl::SpirvModule::IsRemoved(u64 index) const
+{
+    return m_instructions[index].word_count == 0;
+}
+
+Rndr::u32 Rndr::Impl::SpirvModule::GetOpCode(u64 index) const
+{
+    return m_words[m_instructions[index].offset] & 0xFFFF;
+}
+
+Rndr::u32 Rndr::Impl::SpirvModule::GetOperandCount(u64 index) const
+{
+    const u32 word_count = m_instructions[index].word_count;
+    return word_count > 0 ? word_count - 1 : 0;
+}
+
+Rndr::u32* Rndr::Impl::SpirvModule::GetOperands(u64 index)
+{
+    return m_words.GetData() + m_instructions[index].offset + 1;
+}
+
+const Rndr::u32* Rndr::Impl::SpirvModule::GetOperands(u64 index) const
+{
+    return m_words.GetData() + m_instructions[index].offset + 1;
+}
+
+void Rndr::Impl::SpirvModule::Remove(u64 index)
+{
+    m_word_count -= m_instructions[index].word_count;
+    m_instructions[index].word_count = 0;
+}
+
+void Rndr::Impl::SpirvModule::Rewrite(u64 index, u32 op_code, u32 operand_count)
+{
+    Instruction& instruction = m_instructions[index];
+    RNDR_ASSERT(operand_count < instruction.word_count, "Rewrite can't grow an instruction!");
+    m_word_count -= instruction.word_count - (operand_count + 1);
+    instruction.word_count = operand_count + 1;
+    m_words[instruction.offset] = CreateOp(instruction.word_count, op_code);
+}
+
+void Rndr::Impl::SpirvModule::RemoveOperand(u64 index, u32 operand_index)
+{
+    Instruction& instruction = m_instructions[index];
+    RNDR_ASSERT(operand_index + 1 < instruction.word_count, "Operand index out of range!");
+    u32* operands = m_words.GetData() + instruction.offset + 1;
+    const u32 operand_count = instruction.word_count - 1;
+    memmove(operands + operand_index, operands + operand_index + 1, (operand_count - operand_index - 1) * sizeof(u32));
+    --instruction.word_count;
+    --m_word_count;
+    m_words[instruction.offset] = CreateOp(instruction.word_count, m_words[instruction.offset] & 0xFFFF);
+}
+
+Opal::DynamicArray<Rndr::u32> Rndr::Impl::SpirvModule::Emit() const
+{
+    Opal::DynamicArray<u32> out(m_word_count);
+    u32* dst = out.GetData();
+    memcpy(dst, m_words.GetData(), k_header_word_count * sizeof(u32));
+    dst += k_header_word_count;
+    for (u64 i = 0; i < m_instructions.GetSize(); ++i)
+    {
+        const Instruction& instruction = m_instructions[i];
+        memcpy(dst, m_words.GetData() + instruction.offset, instruction.word_count * sizeof(u32));
+        dst += instruction.word_count;
+    }
+    return out;
+}
+
+Rndr::Impl::SpirvPipeline& Rndr::Impl::SpirvPipeline::AddPass(const SpirvPass& pass)
+{
+    RNDR_ASSERT(pass.run != nullptr, "Pass has no run function!");
+    m_passes.PushBack(pass);
+    return *this;
+}
+
+Rndr::u64 Rndr::Impl::SpirvPipeline::GetPassCount() const
+{
+    return m_passes.GetSize();
+}
+
+const Rndr::Impl::SpirvPass& Rndr::Impl::SpirvPipeline::GetPass(u64 index) const
+{
+    return m_passes[index];
+}
+
+Rndr::Impl::SpirvTransformStats Rndr::Impl::SpirvPipeline::Run(Opal::DynamicArray<u32>& bytecode) const
+{
+    RNDR_CPU_EVENT_SCOPED("SpirvPipeline::Run");
+
+    SpirvTransformStats stats;
+    stats.input_word_count = bytecode.GetSize();
+    SpirvModule spirv_module(std::move(bytecode));
+    for (u64 i = 0; i < m_passes.GetSize(); ++i)
+    {
+        const u64 word_count = spirv_module.GetWordCount();
+        m_passes[i].run(spirv_module);
+        stats.removed_word_counts.PushBack(word_count - spirv_module.GetWordCount());
+    }
+    bytecode = spirv_module.Emit();
+    stats.output_word_count = bytecode.GetSize();
+    return stats;
+}
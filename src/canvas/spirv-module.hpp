@@ -0,0 +1,108 @@
+#pragma once
+
+#include "opal/container/dynamic-array.h"
+
+#include "rndr/types.hpp"
+
+namespace Rndr::Impl
+{
+
+/**
+ * SPIR-V module split into an index of its instructions in a single scan. Passes look instructions
+ * up by index and edit them in place. Removed and shrunk instructions are only dropped when Emit()
+ * writes the compacted module, so indices stay stable while passes run.
+ */
+class SpirvModule
+{
+public:
+    static constexpr u32 k_header_word_count = 5;
+
+    /**
+     * Index a module.
+     * @param words Module words, including the header.
+     * @throw Opal::Exception if the words are not a valid SPIR-V module.
+     */
+    explicit SpirvModule(Opal::DynamicArray<u32> words);
+
+    /** @return Upper bound of the result ids, as stored in the header. */
+    [[nodiscard]] u32 GetIdBound() const;
+
+    /** @return Number of instructions, including removed ones. */
+    [[nodiscard]] u64 GetInstructionCount() const;
+
+    /** @return Number of words Emit() would write. */
+    [[nodiscard]] u64 GetWordCount() const;
+
+    [[nodiscard]] bool IsRemoved(u64 index) const;
+    [[nodiscard]] u32 GetOpCode(u64 index) const;
+
+    /** @return Number of operand words of the instruction, not counting the opcode word. */
+    [[nodiscard]] u32 GetOperandCount(u64 index) const;
+
+    /** @return Operand words of the instruction. Valid until Emit() or the module is destroyed. */
+    [[nodiscard]] u32* GetOperands(u64 index);
+    [[nodiscard]] const u32* GetOperands(u64 index) const;
+
+    /** Drop the instruction from the emitted module. */
+    void Remove(u64 index);
+
+    /** Change the opcode of an instruction and keep only its first operand_count operands. */
+    void Rewrite(u64 index, u32 op_code, u32 operand_count);
+
+    /** Remove one operand of an instruction, shifting the operands after it. */
+    void RemoveOperand(u64 index, u32 operand_index);
+
+    /** @return Compacted module without the removed instructions and words. */
+    [[nodiscard]] Opal::DynamicArray<u32> Emit() const;
+
+private:
+    struct Instruction
+    {
+        u32 offset = 0;
+
+        /** Words including the opcode word. Zero if the instruction was removed. */
+        u32 word_count = 0;
+    };
+
+    Opal::DynamicArray<u32> m_words;
+    Opal::DynamicArray<Instruction> m_instructions;
+    u64 m_word_count = 0;
+};
+
+/** Transform run by a SpirvPipeline. */
+struct SpirvPass
+{
+    const char* name = "";
+    void (*run)(SpirvModule& spirv_module) = nullptr;
+};
+
+/** Size change of a module run through a SpirvPipeline. */
+struct SpirvTransformStats
+{
+    u64 input_word_count = 0;
+    u64 output_word_count = 0;
+
+    /** Words removed by each pass, in the order the passes ran. */
+    Opal::DynamicArray<u64> removed_word_counts;
+};
+
+/** Ordered list of passes that transform a module indexed once. */
+class SpirvPipeline
+{
+public:
+    SpirvPipeline& AddPass(const SpirvPass& pass);
+
+    [[nodiscard]] u64 GetPassCount() const;
+    [[nodiscard]] const SpirvPass& GetPass(u64 index) const;
+
+    /**
+     * Index the module, run the passes in order and replace the bytecode with the compacted result.
+     * @throw Opal::Exception if the bytecode is not a valid SPIR-V module.
+     */
+    SpirvTransformStats Run(Opal::DynamicArray<u32>& bytecode) const;
+
+private:
+    Opal::DynamicArray<SpirvPass> m_passes;
+};
+
+}  // namespace Rndr::Impl
@@ -1,21 +1,33 @@
 #include "canvas/spirv-patch.hpp"
 
+#include <cstring>
+
 namespace
 {
-// Layout
-constexpr uint32_t k_header_words = 5;
-constexpr uint32_t k_magic = 0x07230203;
-
 // Opcodes
 constexpr uint32_t k_op_nop = 0;
-constexpr uint32_t k_op_ext_inst_import = 11;
-constexpr uint32_t k_op_capability = 17;
+constexpr uint32_t k_op_source_continued = 2;
+constexpr uint32_t k_op_source = 3;
+constexpr uint32_t k_op_source_extension = 4;
+constexpr uint32_t k_op_name = 5;
+constexpr uint32_t k_op_member_name = 6;
+constexpr uint32_t k_op_string = 7;
+constexpr uint32_t k_op_line = 8;
 constexpr uint32_t k_op_extension = 10;
+constexpr uint32_t k_op_entry_point = 15;
+constexpr uint32_t k_op_capability = 17;
+constexpr uint32_t k_op_function = 54;
+constexpr uint32_t k_op_variable = 59;
+constexpr uint32_t k_op_load = 61;
 constexpr uint32_t k_op_decorate = 71;
-constexpr uint32_t OpLoad = 61;
-constexpr uint32_t OpISub = 130;
-constexpr uint32_t OpVariable = 59;
-constexpr uint32_t OpCopyObject = 83;
+constexpr uint32_t k_op_member_decorate = 72;
+constexpr uint32_t k_op_copy_object = 83;
+constexpr uint32_t k_op_isub = 130;
+constexpr uint32_t k_op_no_line = 317;
+constexpr uint32_t k_op_module_processed = 330;
+constexpr uint32_t k_op_decorate_id = 332;
+constexpr uint32_t k_op_decorate_string = 5632;
+constexpr uint32_t k_op_member_decorate_string = 5633;
 
 // Decoration
 constexpr uint32_t k_decoration_built_in = 11;
@@ -23,37 +35,18 @@ constexpr uint32_t k_decoration_built_in = 11;
 // BuiltIn values
 constexpr uint32_t k_built_in_vertex_id = 5;
 constexpr uint32_t k_built_in_instance_id = 6;
-constexpr uint32_t BuiltInVertexIndex = 42;
-constexpr uint32_t BuiltInInstanceIndex = 43;
-constexpr uint32_t BuiltInBaseVertex = 4424;
-constexpr uint32_t BuiltInBaseInstance = 4425;
+constexpr uint32_t k_built_in_vertex_index = 42;
+constexpr uint32_t k_built_in_instance_index = 43;
+constexpr uint32_t k_built_in_base_vertex = 4424;
+constexpr uint32_t k_built_in_base_instance = 4425;
+
+// Storage classes
+constexpr uint32_t k_storage_class_input = 1;
+constexpr uint32_t k_storage_class_output = 3;
 
 // Capabilities
 constexpr uint32_t k_capability_draw_parameters = 4427;
 
-uint32_t GetWordCount(uint32_t word)
-{
-    return word >> 16;
-}
-uint32_t GetOpCode(uint32_t word)
-{
-    return word & 0xFFFF;
-}
-
-uint32_t CreateOp(uint32_t wc, uint32_t opcode)
-{
-    return (wc << 16) | (opcode & 0xFFFF);
-}
-
-// Nop-out an instruction: fill its words with single-word OpNop instructions.
-void ReplaceWithNop(uint32_t* ptr, uint32_t word_count)
-{
-    for (uint32_t i = 0; i < word_count; ++i)
-    {
-        ptr[i] = CreateOp(1, k_op_nop);
-    }
-}
-
 // Compare a SPIR-V literal string operand (packed into uint32s) against a C string.
 bool CompareWithString(const uint32_t* words, uint32_t max_words, const char* str)
 {
@@ -72,202 +65,373 @@ bool CompareWithString(const uint32_t* words, uint32_t max_words, const char* st
     }
     return false;
 }
-}  // namespace
 
-void Rndr::Impl::PatchSpirv(Opal::DynamicArray<u32>& bytecode)
+// Number of words taken by a literal string operand, including the word with the terminator.
+uint32_t GetStringWordCount(const uint32_t* words, uint32_t max_words)
 {
-    if (bytecode.GetSize() < k_header_words)
-    {
-        throw Opal::Exception("Spir-V module too small, can't fit the header!");
-    }
-    if (bytecode[0] != k_magic)
+    const char* packed = reinterpret_cast<const char*>(words);
+    for (uint32_t i = 0; i < max_words * 4; ++i)
     {
-        throw Opal::Exception("Not a Spir-V module, bad magic value!");
+        if (packed[i] == '\0')
+        {
+            return i / 4 + 1;
+        }
     }
+    return max_words;
+}
 
-    // ── Pass 1: Scan decorations ────────────────────────────────────────────
-    // Find variable IDs decorated with the builtins we care about.
-
-    uint32_t id_instance_index = 0;
-    uint32_t id_base_instance = 0;
-    uint32_t id_vertex_index = 0;
-    uint32_t id_base_vertex = 0;
+// Instructions whose id operands name a target instead of using it.
+bool IsTargetingInstruction(uint32_t op)
+{
+    return op == k_op_name || op == k_op_member_name || op == k_op_decorate || op == k_op_member_decorate ||
+           op == k_op_decorate_string || op == k_op_member_decorate_string || op == k_op_entry_point;
+}
 
-    for (uint32_t i = k_header_words; i < bytecode.GetSize();)
+// Set used[id] for every id that some instruction uses, as opposed to only naming or decorating
+// it. Every operand word below the id bound counts, so a literal that looks like an id keeps that
+// id alive, which is safe.
+void MarkUsedIds(const Rndr::Impl::SpirvModule& spirv_module, Opal::DynamicArray<uint8_t>& used)
+{
+    const uint32_t bound = spirv_module.GetIdBound();
+    used.Resize(bound);
+    memset(used.GetData(), 0, used.GetSize());
+    for (uint64_t i = 0; i < spirv_module.GetInstructionCount(); ++i)
     {
-        const uint32_t wc = GetWordCount(bytecode[i]);
-        const uint32_t op = GetOpCode(bytecode[i]);
-        if (wc == 0)
+        if (spirv_module.IsRemoved(i))
         {
-            throw Opal::Exception("Zero word count instruction detected!");
+            continue;
         }
+        const uint32_t op = spirv_module.GetOpCode(i);
+        const uint32_t* operands = spirv_module.GetOperands(i);
+        const uint32_t operand_count = spirv_module.GetOperandCount(i);
+        // OpString only defines its result.
+        if (IsTargetingInstruction(op) || op == k_op_string)
+        {
+            continue;
+        }
+        uint32_t first = 0;
+        if (op == k_op_decorate_id)
+        {
+            // OpDecorateId %target Decoration <id operands>
+            first = 2;
+        }
+        for (uint32_t j = first; j < operand_count; ++j)
+        {
+            // OpVariable %type %result StorageClass [%initializer], the result is not a use.
+            if (op == k_op_variable && j == 1)
+            {
+                continue;
+            }
+            if (operands[j] < bound)
+            {
+                used[operands[j]] = 1;
+            }
+        }
+    }
+}
 
-        // OpDecorate %id BuiltIn <value>
-        // Layout: [op|wc] [target_id] [decoration] [built_in_value]
-        if (op == k_op_decorate && wc >= 4)
+// Remove names and decorations that target one of the removed ids, and drop them from entry point interfaces.
+void RemoveReferencesToIds(Rndr::Impl::SpirvModule& spirv_module, const Opal::DynamicArray<uint8_t>& removed)
+{
+    const uint32_t bound = spirv_module.GetIdBound();
+    for (uint64_t i = 0; i < spirv_module.GetInstructionCount(); ++i)
+    {
+        if (spirv_module.IsRemoved(i))
+        {
+            continue;
+        }
+        const uint32_t op = spirv_module.GetOpCode(i);
+        uint32_t* operands = spirv_module.GetOperands(i);
+        const uint32_t operand_count = spirv_module.GetOperandCount(i);
+        if (op == k_op_entry_point && operand_count >= 3)
         {
-            const uint32_t target_id = bytecode[i + 1];
-            const uint32_t decoration = bytecode[i + 2];
-            if (decoration == k_decoration_built_in)
+            // OpEntryPoint ExecutionModel %function "name" <interface ids>
+            const uint32_t first_interface = 2 + GetStringWordCount(operands + 2, operand_count - 2);
+            for (uint32_t j = spirv_module.GetOperandCount(i); j > first_interface; --j)
             {
-                const uint32_t built_in = bytecode[i + 3];
-                switch (built_in)
+                const uint32_t id = operands[j - 1];
+                if (id < bound && removed[id] != 0)
                 {
-                    case BuiltInVertexIndex:
-                    {
-                        // Replace with OpenGL mapping instead of Vulkan one
-                        id_vertex_index = target_id;
-                        bytecode[i + 3] = k_built_in_vertex_id;
-                        break;
-                    }
-                    case BuiltInInstanceIndex:
-                    {
-                        // Replace with OpenGL mapping instead of Vulkan one
-                        id_instance_index = target_id;
-                        bytecode[i + 3] = k_built_in_instance_id;
-                        break;
-                    }
-                    case BuiltInBaseVertex:
-                    {
-                        // Not used in OpenGL, just remove it
-                        id_base_vertex = target_id;
-                        ReplaceWithNop(&bytecode[i], wc);
-                        break;
-                    }
-                    case BuiltInBaseInstance:
-                    {
-                        // Not used in OpenGL, just remove it
-                        id_base_instance = target_id;
-                        ReplaceWithNop(&bytecode[i], wc);
-                        break;
-                    }
-                    default:
-                        break;
+                    spirv_module.RemoveOperand(i, j - 1);
                 }
             }
         }
-        i += wc;
+        else if ((op == k_op_name || op == k_op_decorate || op == k_op_decorate_id || op == k_op_decorate_string) &&
+                 operand_count >= 1 && operands[0] < bound && removed[operands[0]] != 0)
+        {
+            spirv_module.Remove(i);
+        }
     }
+}
+
+constexpr uint32_t k_base_vertex = 0;
+constexpr uint32_t k_base_instance = 1;
 
-    // If we found nothing to patch, return early — module is fine as-is.
-    if (id_instance_index == 0 && id_vertex_index == 0 && id_base_instance == 0 && id_base_vertex == 0)
+// BaseVertex or BaseInstance variable, with the instructions that declare and load it.
+struct BaseBuiltin
+{
+    uint32_t id = 0;
+    bool is_used = false;
+    Opal::DynamicArray<uint64_t> instructions;
+};
+
+BaseBuiltin* FindBaseBuiltin(BaseBuiltin (&base_builtins)[2], uint32_t id)
+{
+    for (BaseBuiltin& base_builtin : base_builtins)
     {
-        return;
+        if (id != 0 && base_builtin.id == id)
+        {
+            return &base_builtin;
+        }
     }
+    return nullptr;
+}
 
-    // ── Pass 2: Find OpLoad results for base variables ──────────────────────
-    // We need to know the SSA IDs of loads from BaseInstance / BaseVertex
-    // so we can find the OpISub that uses them.
+}  // namespace
 
-    uint32_t load_result_base_instance = 0;
-    uint32_t load_result_base_vertex = 0;
-    uint32_t load_result_instance_idx = 0;
-    uint32_t load_result_vertex_idx = 0;
+void Rndr::Impl::RemapBuiltinsForOpenGL(SpirvModule& spirv_module)
+{
+    // SPIR-V orders capabilities and extensions first, then annotations, then global variables and
+    // then function bodies, where a load always comes before its uses. A single scan sees every id
+    // before it is needed. Whether a base builtin is read anywhere besides the subtraction is only
+    // known at the end, so its variable and loads are removed afterwards.
+    const u32 bound = spirv_module.GetIdBound();
+    Opal::DynamicArray<u8> removed(bound);
+    memset(removed.GetData(), 0, removed.GetSize());
+    // base_loads[id] is 1 + the BaseBuiltin index of the builtin that the load with result id reads.
+    Opal::DynamicArray<u8> base_loads(bound);
+    memset(base_loads.GetData(), 0, base_loads.GetSize());
+    BaseBuiltin base_builtins[2];
+    bool is_patched = false;
+    u64 draw_parameters_capability = spirv_module.GetInstructionCount();
+    u64 draw_parameters_extension = spirv_module.GetInstructionCount();
 
-    for (uint32_t i = k_header_words; i < bytecode.GetSize();)
+    for (u64 i = 0; i < spirv_module.GetInstructionCount(); ++i)
     {
-        const uint32_t wc = GetWordCount(bytecode[i]);
-        const uint32_t op = GetOpCode(bytecode[i]);
-        if (wc == 0)
+        if (spirv_module.IsRemoved(i))
         {
-            break;
+            continue;
         }
+        const u32 op = spirv_module.GetOpCode(i);
+        u32* operands = spirv_module.GetOperands(i);
+        const u32 operand_count = spirv_module.GetOperandCount(i);
 
-        // OpLoad %result_type %result_id %pointer
-        if (op == OpLoad && wc >= 4)
+        if (op == k_op_capability && operand_count >= 1 && operands[0] == k_capability_draw_parameters)
         {
-            uint32_t result_id = bytecode[i + 2];
-            uint32_t pointer = bytecode[i + 3];
-
-            if (pointer == id_base_instance)
-                load_result_base_instance = result_id;
-            if (pointer == id_base_vertex)
-                load_result_base_vertex = result_id;
-            if (pointer == id_instance_index)
-                load_result_instance_idx = result_id;
-            if (pointer == id_vertex_index)
-                load_result_vertex_idx = result_id;
+            draw_parameters_capability = i;
+        }
+        else if (op == k_op_extension && operand_count >= 1 &&
+                 CompareWithString(operands, operand_count, "SPV_KHR_shader_draw_parameters"))
+        {
+            draw_parameters_extension = i;
+        }
+        // OpDecorate %id BuiltIn <value>
+        else if (op == k_op_decorate && operand_count >= 3 && operands[1] == k_decoration_built_in)
+        {
+            switch (operands[2])
+            {
+                case k_built_in_vertex_index:
+                    // Replace with OpenGL mapping instead of Vulkan one
+                    operands[2] = k_built_in_vertex_id;
+                    is_patched = true;
+                    break;
+                case k_built_in_instance_index:
+                    // Replace with OpenGL mapping instead of Vulkan one
+                    operands[2] = k_built_in_instance_id;
+                    is_patched = true;
+                    break;
+                case k_built_in_base_vertex:
+                    base_builtins[k_base_vertex].id = operands[0];
+                    is_patched = true;
+                    break;
+                case k_built_in_base_instance:
+                    base_builtins[k_base_instance].id = operands[0];
+                    is_patched = true;
+                    break;
+                default:
+                    break;
+            }
+        }
+        // OpVariable %type %result StorageClass
+        else if (op == k_op_variable && operand_count >= 3 && FindBaseBuiltin(base_builtins, operands[1]) != nullptr)
+        {
+            FindBaseBuiltin(base_builtins, operands[1])->instructions.PushBack(i);
+        }
+        // OpLoad %type %result %pointer
+        else if (op == k_op_load && operand_count >= 3 && FindBaseBuiltin(base_builtins, operands[2]) != nullptr)
+        {
+            BaseBuiltin* base_builtin = FindBaseBuiltin(base_builtins, operands[2]);
+            base_builtin->instructions.PushBack(i);
+            if (operands[1] < bound)
+            {
+                base_loads[operands[1]] = static_cast<u8>(1 + (base_builtin - base_builtins));
+            }
+        }
+        // Replace OpISub that uses a base load with OpCopyObject of the index operand, OpenGL
+        // VertexId and InstanceId already exclude the base.
+        // OpISub %type %result %operand1 %operand2, result = operand1 - operand2
+        else if (op == k_op_isub && operand_count == 4 &&
+                 ((operands[3] < bound && base_loads[operands[3]] != 0) || (operands[2] < bound && base_loads[operands[2]] != 0)))
+        {
+            const bool is_base_second = operands[3] < bound && base_loads[operands[3]] != 0;
+            // OpCopyObject %type %result %operand
+            operands[2] = is_base_second ? operands[2] : operands[3];
+            spirv_module.Rewrite(i, k_op_copy_object, 3);
+        }
+        // Any other use of a base load, like instance_id + base_instance, needs the builtin itself.
+        else if (!IsTargetingInstruction(op))
+        {
+            for (u32 j = 0; j < operand_count; ++j)
+            {
+                if (operands[j] < bound && base_loads[operands[j]] != 0)
+                {
+                    base_builtins[base_loads[operands[j]] - 1].is_used = true;
+                }
+            }
         }
-        i += wc;
     }
 
-    // ── Pass 3: Patch instructions ─────────────────────────────────────────
-    // - Remove DrawParameters capability (not needed in OpenGL).
-    // - NOP OpVariable declarations for BaseVertex / BaseInstance.
-    // - NOP OpLoad instructions that load from BaseVertex / BaseInstance.
-    // - Replace OpISub that subtracts a base load with OpCopyObject of the
-    //   index operand, effectively making result = index - 0.
+    // If we found nothing to patch, the module is fine as-is.
+    if (!is_patched)
+    {
+        return;
+    }
 
-    for (uint32_t i = k_header_words; i < bytecode.GetSize();)
+    // Base builtins that were only subtracted are not needed in OpenGL, remove them together with
+    // the DrawParameters capability and the SPV_KHR_shader_draw_parameters extension. OpenGL 4.6
+    // supports DrawParameters, so they all stay if a shader reads a base builtin directly.
+    bool has_removed_ids = false;
+    bool needs_draw_parameters = false;
+    for (BaseBuiltin& base_builtin : base_builtins)
     {
-        const uint32_t wc = GetWordCount(bytecode[i]);
-        const uint32_t op = GetOpCode(bytecode[i]);
-        if (wc == 0)
+        if (base_builtin.id == 0 || base_builtin.id >= bound)
         {
-            break;
+            continue;
         }
-
-        // Remove DrawParameters capability.
-        if (op == k_op_capability && wc >= 2 && bytecode[i + 1] == k_capability_draw_parameters)
+        if (base_builtin.is_used)
         {
-            ReplaceWithNop(&bytecode[i], wc);
+            needs_draw_parameters = true;
+            continue;
         }
-
-        // Remove SPV_KHR_shader_draw_parameters extension.
-        if (op == k_op_extension && wc >= 2 && CompareWithString(&bytecode[i + 1], wc - 1, "SPV_KHR_shader_draw_parameters"))
+        for (u64 j = 0; j < base_builtin.instructions.GetSize(); ++j)
         {
-            ReplaceWithNop(&bytecode[i], wc);
+            spirv_module.Remove(base_builtin.instructions[j]);
         }
+        removed[base_builtin.id] = 1;
+        has_removed_ids = true;
+    }
+    if (!needs_draw_parameters && draw_parameters_capability < spirv_module.GetInstructionCount())
+    {
+        spirv_module.Remove(draw_parameters_capability);
+    }
+    if (!needs_draw_parameters && draw_parameters_extension < spirv_module.GetInstructionCount())
+    {
+        spirv_module.Remove(draw_parameters_extension);
+    }
+    if (has_removed_ids)
+    {
+        RemoveReferencesToIds(spirv_module, removed);
+    }
+}
 
-        // NOP OpVariable for base builtins.
-        if (op == OpVariable && wc >= 4)
+void Rndr::Impl::StripDebugInfo(SpirvModule& spirv_module)
+{
+    bool has_strings = false;
+    for (u64 i = 0; i < spirv_module.GetInstructionCount(); ++i)
+    {
+        if (spirv_module.IsRemoved(i))
         {
-            const uint32_t var_id = bytecode[i + 2];
-            if ((id_base_vertex != 0 && var_id == id_base_vertex) || (id_base_instance != 0 && var_id == id_base_instance))
-            {
-                ReplaceWithNop(&bytecode[i], wc);
-            }
+            continue;
+        }
+        const u32 op = spirv_module.GetOpCode(i);
+        if (op == k_op_source_continued || op == k_op_source || op == k_op_source_extension || op == k_op_name ||
+            op == k_op_member_name || op == k_op_line || op == k_op_no_line || op == k_op_module_processed)
+        {
+            spirv_module.Remove(i);
         }
+        has_strings = has_strings || op == k_op_string;
+    }
+    if (!has_strings)
+    {
+        return;
+    }
 
-        // NOP OpLoad from base builtins.
-        if (op == OpLoad && wc >= 4)
+    // Non-semantic debug info refers to strings through OpExtInst, those strings have to stay.
+    Opal::DynamicArray<u8> used;
+    MarkUsedIds(spirv_module, used);
+    for (u64 i = 0; i < spirv_module.GetInstructionCount(); ++i)
+    {
+        // OpString %result "string"
+        if (!spirv_module.IsRemoved(i) && spirv_module.GetOpCode(i) == k_op_string && spirv_module.GetOperandCount(i) >= 1 &&
+            used[spirv_module.GetOperands(i)[0]] == 0)
         {
-            const uint32_t pointer = bytecode[i + 3];
-            if ((id_base_vertex != 0 && pointer == id_base_vertex) || (id_base_instance != 0 && pointer == id_base_instance))
-            {
-                ReplaceWithNop(&bytecode[i], wc);
-            }
+            spirv_module.Remove(i);
         }
+    }
+}
 
-        // Replace OpISub that uses a base load with OpCopyObject of the index operand.
-        // OpISub layout: [op|wc] [result_type] [result_id] [operand1] [operand2]
-        // Result = operand1 - operand2
-        if (op == OpISub && wc == 5)
+void Rndr::Impl::RemoveNops(SpirvModule& spirv_module)
+{
+    for (u64 i = 0; i < spirv_module.GetInstructionCount(); ++i)
+    {
+        if (!spirv_module.IsRemoved(i) && spirv_module.GetOpCode(i) == k_op_nop)
         {
-            const uint32_t op1 = bytecode[i + 3];
-            const uint32_t op2 = bytecode[i + 4];
+            spirv_module.Remove(i);
+        }
+    }
+}
 
-            uint32_t keep = 0;
-            if ((load_result_base_vertex != 0 && op2 == load_result_base_vertex) ||
-                (load_result_base_instance != 0 && op2 == load_result_base_instance))
-            {
-                keep = op1;
-            }
-            else if ((load_result_base_vertex != 0 && op1 == load_result_base_vertex) ||
-                     (load_result_base_instance != 0 && op1 == load_result_base_instance))
-            {
-                keep = op2;
-            }
+void Rndr::Impl::RemoveUnusedVariables(SpirvModule& spirv_module)
+{
+    Opal::DynamicArray<u8> used;
+    MarkUsedIds(spirv_module, used);
 
-            if (keep != 0)
-            {
-                // OpCopyObject is 4 words: [op|wc] [result_type] [result_id] [operand]
-                bytecode[i] = CreateOp(4, OpCopyObject);
-                bytecode[i + 3] = keep;
-                bytecode[i + 4] = CreateOp(1, k_op_nop);
-            }
+    Opal::DynamicArray<u8> removed(used.GetSize());
+    memset(removed.GetData(), 0, removed.GetSize());
+    bool has_removed = false;
+    for (u64 i = 0; i < spirv_module.GetInstructionCount(); ++i)
+    {
+        if (spirv_module.IsRemoved(i))
+        {
+            continue;
         }
-
-        i += wc;
+        const u32 op = spirv_module.GetOpCode(i);
+        if (op == k_op_function)
+        {
+            // Only module-scope variables are considered, function variables come after this.
+            break;
+        }
+        // OpVariable %type %result StorageClass
+        const u32* operands = spirv_module.GetOperands(i);
+        if (op == k_op_variable && spirv_module.GetOperandCount(i) >= 3 && operands[2] != k_storage_class_input &&
+            operands[2] != k_storage_class_output && operands[1] < used.GetSize() && used[operands[1]] == 0)
+        {
+            removed[operands[1]] = 1;
+            has_removed = true;
+            spirv_module.Remove(i);
+        }
+    }
+    if (has_removed)
+    {
+        RemoveReferencesToIds(spirv_module, removed);
     }
-}
\ No newline at end of file
+}
+
+const Rndr::Impl::SpirvPipeline& Rndr::Impl::GetOpenGLSpirvPipeline()
+{
+    static const SpirvPipeline k_pipeline = []()
+    {
+        SpirvPipeline pipeline;
+        pipeline.AddPass({.name = "RemapBuiltinsForOpenGL", .run = &RemapBuiltinsForOpenGL})
+            .AddPass({.name = "StripDebugInfo", .run = &StripDebugInfo})
+            .AddPass({.name = "RemoveUnusedVariables", .run = &RemoveUnusedVariables})
+            .AddPass({.name = "RemoveNops", .run = &RemoveNops});
+        return pipeline;
+    }();
+    return k_pipeline;
+}
+
+Rndr::Impl::SpirvTransformStats Rndr::Impl::PatchSpirv(Opal::DynamicArray<u32>& bytecode)
+{
+    return GetOpenGLSpirvPipeline().Run(bytecode);
+}
@@ -3,11 +3,38 @@
 #include "opal/container/dynamic-array.h"
 #include "opal/container/array-view.h"
 
+#include "canvas/spirv-module.hpp"
+
 #include "rndr/types.hpp"
 
 namespace Rndr::Impl
 {
 
-void PatchSpirv(Opal::DynamicArray<u32>& bytecode);
+/**
+ * Map the Vulkan VertexIndex and InstanceIndex builtins to the OpenGL VertexId and InstanceId, and
+ * replace the subtractions of BaseVertex and BaseInstance from them with copies. A base builtin that
+ * is only subtracted is removed with its loads. One that the shader also reads directly is kept,
+ * and so are the DrawParameters capability and extension, which OpenGL 4.6 supports.
+ */
+void RemapBuiltinsForOpenGL(SpirvModule& spirv_module);
+
+/** Remove source, name and line debug instructions. Strings are kept if anything else uses them. */
+void StripDebugInfo(SpirvModule& spirv_module);
+
+/** Remove OpNop instructions. */
+void RemoveNops(SpirvModule& spirv_module);
+
+/**
+ * Remove module-scope variables that no instruction uses, along with their names, decorations and
+ * entry point interface entries. Input and output variables are kept since they form the interface
+ * between stages.
+ */
+void RemoveUnusedVariables(SpirvModule& spirv_module);
+
+/** @return Pipeline that prepares Slang output for OpenGL: builtin remap, debug strip, unused variable and nop removal. */
+const SpirvPipeline& GetOpenGLSpirvPipeline();
+
+/** Run the bytecode through GetOpenGLSpirvPipeline(). */
+SpirvTransformStats PatchSpirv(Opal::DynamicArray<u32>& bytecode);
 
-}
\ No newline at end of file
+}
@@ -10,6 +10,8 @@
 #include "opal/file-system.h"
 #include "opal/paths.h"
 
+#include "canvas/gl-state-cache.hpp"
+
 #include "rndr/exception.hpp"
 #include "rndr/trace.hpp"
 
@@ -693,6 +695,10 @@ void Rndr::Canvas::Texture::Destroy()
 {
     if (m_handle != 0)
     {
+        if (Impl::GLStateCache* state_cache = Impl::GetStateCache(); state_cache != nullptr)
+        {
+            state_cache->ForgetTexture(m_handle);
+        }
         glDeleteTextures(1, &m_handle);
         m_handle = 0;
         m_desc = {};
@@ -722,6 +728,37 @@ void Rndr::Canvas::Texture::Update(const Opal::ArrayView<const u8>& data) const
     glTextureSubImage2D(m_handle, 0, 0, 0, m_desc.width, m_desc.height, fmt.format, fmt.type, data.GetData());
 }
 
+Opal::DynamicArray<Rndr::u8> Rndr::Canvas::Texture::ReadData() const
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::Texture::ReadData");
+
+    if (m_handle == 0)
+    {
+        throw GraphicsAPIException(0, "Cannot read an invalid texture!");
+    }
+    if (m_desc.sample_count > 1)
+    {
+        return {};
+    }
+
+    i32 layer_count = 1;
+    if (m_desc.type == TextureType::Texture2DArray)
+    {
+        layer_count = m_desc.array_size;
+    }
+    else if (m_desc.type == TextureType::CubeMap)
+    {
+        layer_count = 6;
+    }
+    const GLFormatInfo fmt = ToGLFormat(m_desc.format);
+    const u64 size = static_cast<u64>(m_desc.width) * m_desc.height * layer_count * fmt.pixel_size;
+
+    Opal::DynamicArray<u8> data(size);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTextureImage(m_handle, 0, fmt.format, fmt.type, static_cast<GLsizei>(size), data.GetData());
+    return data;
+}
+
 bool Rndr::Canvas::Texture::IsValid() const
 {
     return m_handle != 0;
@@ -0,0 +1,162 @@
+#include "canvas/uniform-ring-buffer.hpp"
+
+#include "glad/glad.h"
+
+#include "opal/exceptions.h"
+
+#include "rndr/exception.hpp"
+#include "rndr/trace.hpp"
+
+namespace
+{
+
+Rndr::Canvas::Impl::UniformRingBuffer* g_uniform_ring_buffer = nullptr;
+
+constexpr GLbitfield k_map_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+}  // namespace
+
+Rndr::Canvas::Impl::UniformRingBuffer::UniformRingBuffer(u64 size) : m_size(size)
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::UniformRingBuffer::UniformRingBuffer");
+
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    m_alignment = alignment > 0 ? static_cast<u64>(alignment) : 256;
+
+    glCreateBuffers(1, &m_handle);
+    if (m_handle == 0)
+    {
+        throw GraphicsAPIException(0, "Failed to create uniform ring buffer!");
+    }
+
+    glNamedBufferStorage(m_handle, static_cast<GLsizeiptr>(m_size), nullptr, k_map_flags);
+    m_mapped_data = static_cast<u8*>(glMapNamedBufferRange(m_handle, 0, static_cast<GLsizeiptr>(m_size), k_map_flags));
+    const GLenum err = glGetError();
+    if (err != GL_NO_ERROR || m_mapped_data == nullptr)
+    {
+        glDeleteBuffers(1, &m_handle);
+        m_handle = 0;
+        m_mapped_data = nullptr;
+        throw GraphicsAPIException(err, "Failed to map uniform ring buffer!");
+    }
+
+    constexpr char k_label[] = "Canvas - Uniform Ring Buffer";
+    glObjectLabel(GL_BUFFER, m_handle, static_cast<GLsizei>(sizeof(k_label) - 1), k_label);
+}
+
+Rndr::Canvas::Impl::UniformRingBuffer::~UniformRingBuffer()
+{
+    for (u64 i = 0; i < m_in_flight_frames.GetSize(); ++i)
+    {
+        glDeleteSync(static_cast<GLsync>(m_in_flight_frames[i].fence));
+    }
+    m_in_flight_frames.Clear();
+    if (m_handle != 0)
+    {
+        glUnmapNamedBuffer(m_handle);
+        glDeleteBuffers(1, &m_handle);
+        m_handle = 0;
+    }
+}
+
+Rndr::u8* Rndr::Canvas::Impl::UniformRingBuffer::Allocate(u64 size, u64& out_offset)
+{
+    if (size > m_size)
+    {
+        throw Opal::InvalidArgumentException(__FUNCTION__, "Uniform data is larger than the uniform ring buffer!");
+    }
+
+    u64 offset = 0;
+    u64 required = 0;
+    while (true)
+    {
+        offset = (m_head + m_alignment - 1) / m_alignment * m_alignment;
+        if (offset + size > m_size)
+        {
+            // Skip the tail of the ring and wrap around to the start.
+            offset = 0;
+        }
+        required = (offset >= m_head ? offset - m_head : m_size - m_head) + size;
+        if (m_in_flight_size + m_frame_size + required <= m_size)
+        {
+            break;
+        }
+
+        if (m_in_flight_frames.IsEmpty())
+        {
+            if (m_frame_size == 0)
+            {
+                // Nothing is in use, start over at the front.
+                m_head = 0;
+                continue;
+            }
+            // The current frame alone fills the ring. Fence what it wrote so far and wait for it.
+            EndFrame();
+        }
+        RetireOldestFrame();
+    }
+
+    m_head = offset + size;
+    m_frame_size += required;
+    out_offset = offset;
+    return m_mapped_data + offset;
+}
+
+void Rndr::Canvas::Impl::UniformRingBuffer::EndFrame()
+{
+    ++m_generation;
+    if (m_frame_size == 0)
+    {
+        return;
+    }
+
+    InFlightFrame frame;
+    frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frame.size = m_frame_size;
+    m_in_flight_frames.PushBack(frame);
+    m_in_flight_size += m_frame_size;
+    m_frame_size = 0;
+}
+
+void Rndr::Canvas::Impl::UniformRingBuffer::RetireOldestFrame()
+{
+    RNDR_CPU_EVENT_SCOPED("Canvas::UniformRingBuffer::RetireOldestFrame");
+
+    const InFlightFrame frame = m_in_flight_frames[0];
+    const auto fence = static_cast<GLsync>(frame.fence);
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    while (status == GL_TIMEOUT_EXPIRED)
+    {
+        constexpr GLuint64 k_timeout_ns = 1'000'000;
+        status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, k_timeout_ns);
+    }
+    glDeleteSync(fence);
+    m_in_flight_size -= frame.size;
+    m_in_flight_frames.Erase(m_in_flight_frames.begin());
+}
+
+Rndr::u32 Rndr::Canvas::Impl::UniformRingBuffer::GetNativeHandle() const
+{
+    return m_handle;
+}
+
+Rndr::u64 Rndr::Canvas::Impl::UniformRingBuffer::GetAlignment() const
+{
+    return m_alignment;
+}
+
+Rndr::u64 Rndr::Canvas::Impl::UniformRingBuffer::GetGeneration() const
+{
+    return m_generation;
+}
+
+Rndr::Canvas::Impl::UniformRingBuffer* Rndr::Canvas::Impl::GetUniformRingBuffer()
+{
+    return g_uniform_ring_buffer;
+}
+
+void Rndr::Canvas::Impl::SetUniformRingBuffer(UniformRingBuffer* ring_buffer)
+{
+    g_uniform_ring_buffer = ring_buffer;
+}
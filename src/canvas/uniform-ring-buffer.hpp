@@ -0,0 +1,93 @@
+#pragma once
+
+#include "opal/container/dynamic-array.h"
+
+#include "rndr/types.hpp"
+
+namespace Rndr::Canvas::Impl
+{
+
+/**
+ * One persistently mapped uniform buffer shared by all brushes. Brushes copy their dirty uniform
+ * data into sub-allocations and bind them with glBindBufferRange, so there is a single buffer
+ * object and no driver upload per brush.
+ *
+ * Space is handed out front to back and wraps around. Each EndFrame() fences the bytes allocated
+ * during the frame, and an allocation that would overwrite bytes of a frame the GPU may still read
+ * waits on that frame's fence first. A frame that alone fills the ring is fenced and waited on in
+ * the middle, so it stays correct, only slower.
+ *
+ * Allocations stay readable until the generation changes, and a single allocation never spans two
+ * generations. The generation advances with every
+ * EndFrame(), including the one issued when a frame fills the ring.
+ *
+ * One ring exists per Context.
+ */
+class UniformRingBuffer
+{
+public:
+    /**
+     * Create and map the buffer.
+     * @param size Size of the ring in bytes.
+     * @throw Rndr::GraphicsAPIException if the buffer can't be created or mapped.
+     */
+    explicit UniformRingBuffer(u64 size);
+    ~UniformRingBuffer();
+
+    UniformRingBuffer(const UniformRingBuffer&) = delete;
+    UniformRingBuffer& operator=(const UniformRingBuffer&) = delete;
+    UniformRingBuffer(UniformRingBuffer&&) = delete;
+    UniformRingBuffer& operator=(UniformRingBuffer&&) = delete;
+
+    /**
+     * Allocate space in the ring. The caller writes through the returned pointer.
+     * @param size Size of the allocation in bytes. Must not exceed the ring size.
+     * @param out_offset Offset of the allocation, aligned to GetAlignment().
+     * @return Mapped pointer to the allocation.
+     * @throw Opal::InvalidArgumentException if size is larger than the ring.
+     */
+    u8* Allocate(u64 size, u64& out_offset);
+
+    /** Fence the allocations of the current frame and start a new generation. Called by Context::Present. */
+    void EndFrame();
+
+    /** @return Native handle of the buffer, to bind allocations with. */
+    [[nodiscard]] u32 GetNativeHandle() const;
+
+    /** @return Alignment of uniform buffer binding offsets, GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT. */
+    [[nodiscard]] u64 GetAlignment() const;
+
+    /** @return Current generation. Allocations made in earlier generations may be overwritten. */
+    [[nodiscard]] u64 GetGeneration() const;
+
+private:
+    struct InFlightFrame
+    {
+        /** GLsync of the frame. */
+        void* fence = nullptr;
+
+        /** Bytes the frame took from the ring, including padding. */
+        u64 size = 0;
+    };
+
+    /** Wait for the oldest in-flight frame and release its bytes. */
+    void RetireOldestFrame();
+
+    u32 m_handle = 0;
+    u8* m_mapped_data = nullptr;
+    u64 m_size = 0;
+    u64 m_alignment = 1;
+    u64 m_head = 0;
+    u64 m_frame_size = 0;
+    u64 m_in_flight_size = 0;
+    u64 m_generation = 1;
+    Opal::DynamicArray<InFlightFrame> m_in_flight_frames;
+};
+
+/** @return Uniform ring buffer of the live Context, or nullptr if no Context exists. */
+UniformRingBuffer* GetUniformRingBuffer();
+
+/** Register the uniform ring buffer of the live Context. Pass nullptr when the Context is destroyed. */
+void SetUniformRingBuffer(UniformRingBuffer* ring_buffer);
+
+}  // namespace Rndr::Canvas::Impl
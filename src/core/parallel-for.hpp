@@ -0,0 +1,82 @@
+#pragma once
+
+#include "opal/container/dynamic-array.h"
+
+#include "rndr/types.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+
+namespace Rndr::Impl
+{
+
+/**
+ * Call func(index) for every index in [0, count) on up to max_threads worker threads. Workers pull
+ * indices in order, so early indices start first. Returns once all calls finished. If any call
+ * throws, the exception of the lowest failing index is rethrown on the calling thread.
+ * @param count Number of work items.
+ * @param max_threads Maximum number of threads to use. Zero uses one thread per hardware thread.
+ * @param func Callable taking a u64 index. Must be safe to call concurrently for different indices.
+ */
+template <typename Func>
+void ParallelFor(u64 count, u32 max_threads, const Func& func)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    if (max_threads == 0)
+    {
+        max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    const u64 thread_count = std::min<u64>(max_threads, count);
+    if (thread_count == 1)
+    {
+        for (u64 i = 0; i < count; ++i)
+        {
+            func(i);
+        }
+        return;
+    }
+
+    Opal::DynamicArray<std::exception_ptr> errors(count);
+    std::atomic<u64> next_index = 0;
+    auto worker = [&]()
+    {
+        for (u64 i = next_index.fetch_add(1); i < count; i = next_index.fetch_add(1))
+        {
+            try
+            {
+                func(i);
+            }
+            catch (...)
+            {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+
+    // The calling thread works too, so only thread_count - 1 extra threads are needed.
+    Opal::DynamicArray<std::thread> threads;
+    for (u64 i = 1; i < thread_count; ++i)
+    {
+        threads.PushBack(std::thread(worker));
+    }
+    worker();
+    for (u64 i = 0; i < threads.GetSize(); ++i)
+    {
+        threads[i].join();
+    }
+
+    for (u64 i = 0; i < count; ++i)
+    {
+        if (errors[i] != nullptr)
+        {
+            std::rethrow_exception(errors[i]);
+        }
+    }
+}
+
+}  // namespace Rndr::Impl
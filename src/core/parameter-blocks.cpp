@@ -0,0 +1,253 @@
+#include "core/parameter-blocks.hpp"
+
+#include "opal/exceptions.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <string>
+
+namespace
+{
+
+/** C++ type of a uniform field. Vectors without a math type are arrays of component_count scalars. */
+struct FieldType
+{
+    const char* name = nullptr;
+    Rndr::u32 component_count = 0;
+    Rndr::i32 size = 0;
+};
+
+struct Block
+{
+    Rndr::i32 binding_index = -1;
+    Rndr::i32 binding_space = 0;
+    std::string name;
+    Opal::DynamicArray<const Rndr::ShaderParameter*> fields;
+};
+
+void AppendFormat(std::string& out, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    va_list size_args;
+    va_copy(size_args, args);
+    const int length = vsnprintf(nullptr, 0, format, size_args);
+    va_end(size_args);
+    if (length < 0)
+    {
+        va_end(args);
+        throw Opal::Exception("Failed to format parameter block source!");
+    }
+    // Format in place past the existing contents. vsnprintf also writes the terminator, which is trimmed after.
+    const size_t offset = out.size();
+    out.resize(offset + static_cast<size_t>(length) + 1);
+    vsnprintf(out.data() + offset, static_cast<size_t>(length) + 1, format, args);
+    va_end(args);
+    out.resize(offset + static_cast<size_t>(length));
+}
+
+std::string ToStdString(const Opal::StringUtf8& str)
+{
+    return std::string(reinterpret_cast<const char*>(str.GetData()), str.GetSize());
+}
+
+std::string ToPascalCase(const std::string& name)
+{
+    std::string out;
+    bool upper = true;
+    for (const char c : name)
+    {
+        if (c == '_')
+        {
+            upper = true;
+            continue;
+        }
+        out += upper && c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+        upper = false;
+    }
+    return out;
+}
+
+FieldType GetFieldType(const Rndr::ShaderParameter& param)
+{
+    const Rndr::u32 rows = param.row_count;
+    const Rndr::u32 columns = param.column_count;
+    if (rows == 1 && columns == 1)
+    {
+        switch (param.scalar_type)
+        {
+            case Rndr::ScalarType::Float32:
+                return {.name = "Rndr::f32", .size = 4};
+            case Rndr::ScalarType::Int32:
+                return {.name = "Rndr::i32", .size = 4};
+            case Rndr::ScalarType::UInt32:
+                return {.name = "Rndr::u32", .size = 4};
+            default:
+                return {};
+        }
+    }
+    if (rows == 1 && columns >= 2 && columns <= 4)
+    {
+        const auto size = static_cast<Rndr::i32>(columns * 4);
+        switch (param.scalar_type)
+        {
+            case Rndr::ScalarType::Float32:
+            {
+                const char* k_names[] = {"Rndr::Vector2f", "Rndr::Vector3f", "Rndr::Vector4f"};
+                return {.name = k_names[columns - 2], .size = size};
+            }
+            case Rndr::ScalarType::Int32:
+                return columns == 2 ? FieldType{.name = "Rndr::Vector2i", .size = size}
+                                    : FieldType{.name = "Rndr::i32", .component_count = columns, .size = size};
+            case Rndr::ScalarType::UInt32:
+                return {.name = "Rndr::u32", .component_count = columns, .size = size};
+            default:
+                return {};
+        }
+    }
+    if (rows == 4 && columns == 4 && param.scalar_type == Rndr::ScalarType::Float32)
+    {
+        return {.name = "Rndr::Matrix4x4f", .size = 64};
+    }
+    return {};
+}
+
+Opal::DynamicArray<Block> CollectBlocks(const Opal::DynamicArray<Rndr::ShaderParameter>& parameters)
+{
+    Opal::DynamicArray<Block> blocks;
+    Opal::DynamicArray<const Rndr::ShaderParameter*> declarations;
+    for (Rndr::u64 i = 0; i < parameters.GetSize(); ++i)
+    {
+        const Rndr::ShaderParameter& param = parameters[i];
+        if (param.category != Rndr::ParameterCategory::Uniform)
+        {
+            continue;
+        }
+        if (param.size == 0)
+        {
+            declarations.PushBack(&param);
+            continue;
+        }
+
+        Block* block = nullptr;
+        for (Rndr::u64 j = 0; j < blocks.GetSize(); ++j)
+        {
+            if (blocks[j].binding_index == param.binding_index && blocks[j].binding_space == param.binding_space)
+            {
+                block = &blocks[j];
+                break;
+            }
+        }
+        if (block == nullptr)
+        {
+            blocks.PushBack({.binding_index = param.binding_index, .binding_space = param.binding_space});
+            block = &blocks.Back();
+        }
+        block->fields.PushBack(&param);
+    }
+
+    for (Rndr::u64 i = 0; i < blocks.GetSize(); ++i)
+    {
+        Block& block = blocks[i];
+        block.name = "Globals";
+        for (Rndr::u64 j = 0; j < declarations.GetSize(); ++j)
+        {
+            const Rndr::ShaderParameter* declaration = declarations[j];
+            if (declaration->binding_index == block.binding_index && declaration->binding_space == block.binding_space &&
+                !declaration->name.IsEmpty())
+            {
+                block.name = ToPascalCase(ToStdString(declaration->name));
+                break;
+            }
+        }
+        for (Rndr::u64 j = 0; j < i; ++j)
+        {
+            if (blocks[j].name == block.name)
+            {
+                AppendFormat(block.name, "%d", block.binding_index);
+                break;
+            }
+        }
+
+        std::sort(block.fields.GetData(), block.fields.GetData() + block.fields.GetSize(),
+                  [](const Rndr::ShaderParameter* a, const Rndr::ShaderParameter* b) { return a->offset < b->offset; });
+    }
+    return blocks;
+}
+
+void AppendBlock(std::string& out, const Block& block)
+{
+    AppendFormat(out, "struct %s\n{\n", block.name.c_str());
+    AppendFormat(out, "    static constexpr Rndr::i32 k_binding_index = %d;\n", block.binding_index);
+    AppendFormat(out, "    static constexpr Rndr::i32 k_binding_space = %d;\n\n", block.binding_space);
+
+    Rndr::i32 cursor = 0;
+    Rndr::u32 padding_count = 0;
+    for (Rndr::u64 i = 0; i < block.fields.GetSize(); ++i)
+    {
+        const Rndr::ShaderParameter* field = block.fields[i];
+        const std::string name = ToStdString(field->name);
+        if (field->offset < cursor)
+        {
+            throw Opal::Exception("Uniform fields of a block overlap!");
+        }
+        if (field->offset > cursor)
+        {
+            AppendFormat(out, "    Rndr::u8 padding%u[%d];\n", padding_count++, field->offset - cursor);
+        }
+
+        const Rndr::i32 element_size = field->array_element_count > 0 ? field->array_stride : field->size;
+        const FieldType type = GetFieldType(*field);
+        if (type.name == nullptr || type.size != element_size)
+        {
+            // std140 rounds array elements and matrix columns up to 16 bytes, no math type has that layout.
+            AppendFormat(out, "    Rndr::u8 %s[%d];\n", name.c_str(), field->size);
+        }
+        else
+        {
+            AppendFormat(out, "    %s %s", type.name, name.c_str());
+            if (field->array_element_count > 0)
+            {
+                AppendFormat(out, "[%d]", field->array_element_count);
+            }
+            if (type.component_count > 0)
+            {
+                AppendFormat(out, "[%u]", type.component_count);
+            }
+            out += ";\n";
+        }
+        cursor = field->offset + field->size;
+    }
+    out += "};\n";
+
+    const char* name = block.name.c_str();
+    AppendFormat(out, "static_assert(sizeof(%s) == %d, \"%s does not match the shader layout!\");\n", name, cursor, name);
+    for (Rndr::u64 i = 0; i < block.fields.GetSize(); ++i)
+    {
+        const Rndr::ShaderParameter* field = block.fields[i];
+        const std::string field_name = ToStdString(field->name);
+        AppendFormat(out, "static_assert(offsetof(%s, %s) == %d, \"%s::%s does not match the shader layout!\");\n", name,
+                     field_name.c_str(), field->offset, name, field_name.c_str());
+    }
+}
+
+}  // namespace
+
+Opal::StringUtf8 Rndr::Impl::GenerateParameterBlocks(const Opal::DynamicArray<ShaderParameter>& parameters, const char* source_name,
+                                                     const char* namespace_name)
+{
+    const Opal::DynamicArray<Block> blocks = CollectBlocks(parameters);
+
+    std::string out;
+    AppendFormat(out, "// Generated from %s by parameter-block-generator. Do not edit.\n", source_name);
+    out += "#pragma once\n\n#include <cstddef>\n\n#include \"rndr/math.hpp\"\n#include \"rndr/types.hpp\"\n\n";
+    AppendFormat(out, "namespace %s\n{\n", namespace_name);
+    for (Rndr::u64 i = 0; i < blocks.GetSize(); ++i)
+    {
+        out += "\n";
+        AppendBlock(out, blocks[i]);
+    }
+    AppendFormat(out, "\n}  // namespace %s\n", namespace_name);
+    return Opal::StringUtf8(reinterpret_cast<const char8*>(out.data()), out.size());
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "opal/container/dynamic-array.h"
+#include "opal/container/string.h"
+
+#include "rndr/core/shader-compiler.hpp"
+
+namespace Rndr::Impl
+{
+
+/**
+ * Generate a C++ header with one struct per uniform block of a shader, for use with
+ * Brush::SetParameterBlock(). Each struct matches the reflected layout of its block, with explicit
+ * padding, and static_asserts check its size and field offsets. A ConstantBuffer is named after
+ * its variable in PascalCase, the implicit block of standalone globals is named Globals. Fields
+ * without a matching C++ type are emitted as byte arrays.
+ * @param parameters Reflected parameters of the shader, see Shader::GetParameters().
+ * @param source_name Name of the shader source, written into the header comment.
+ * @param namespace_name Namespace of the generated structs, may be nested like "Game::Shaders".
+ * @return Contents of the header.
+ * @throw Opal::Exception if fields of a block overlap.
+ */
+[[nodiscard]] Opal::StringUtf8 GenerateParameterBlocks(const Opal::DynamicArray<ShaderParameter>& parameters, const char* source_name,
+                                                       const char* namespace_name);
+
+}  // namespace Rndr::Impl
@@ -3,10 +3,15 @@
 #include "slang-com-ptr.h"
 #include "slang.h"
 
+#include "core/parallel-for.hpp"
 #include "rndr/exception.hpp"
 #include "rndr/log.hpp"
+#include "rndr/trace.hpp"
 
+#include <atomic>
+#include <cstdio>
 #include <cstring>
+#include <mutex>
 
 namespace
 {
@@ -86,6 +91,78 @@ Rndr::ParameterCategory FromSlangCategory(slang::VariableLayoutReflection* param
     }
 }
 
+bool IsWritableResource(slang::VariableLayoutReflection* param)
+{
+    if (param->getCategory() == slang::ParameterCategory::UnorderedAccess)
+    {
+        return true;
+    }
+    slang::TypeLayoutReflection* type_layout = param->getTypeLayout();
+    if (type_layout == nullptr || type_layout->getType()->getKind() != slang::TypeReflection::Kind::Resource)
+    {
+        // Unknown access, assume the worst.
+        return true;
+    }
+    return type_layout->getType()->getResourceAccess() != SLANG_RESOURCE_ACCESS_READ;
+}
+
+Rndr::ScalarType FromSlangScalarType(slang::TypeReflection::ScalarType scalar)
+{
+    switch (scalar)
+    {
+        case slang::TypeReflection::Float32:
+            return Rndr::ScalarType::Float32;
+        case slang::TypeReflection::Int32:
+            return Rndr::ScalarType::Int32;
+        case slang::TypeReflection::UInt32:
+            return Rndr::ScalarType::UInt32;
+        default:
+            return Rndr::ScalarType::Unknown;
+    }
+}
+
+/** Fill the scalar type and shape of a uniform field. Arrays are described by their element type. */
+void ExtractUniformType(slang::TypeReflection* type, Rndr::ShaderParameter& sp)
+{
+    if (type->getKind() == slang::TypeReflection::Kind::Array)
+    {
+        type = type->getElementType();
+    }
+
+    slang::TypeReflection* scalar = type;
+    Rndr::u32 row_count = 1;
+    Rndr::u32 column_count = 1;
+    switch (type->getKind())
+    {
+        case slang::TypeReflection::Kind::Scalar:
+            break;
+        case slang::TypeReflection::Kind::Vector:
+            column_count = static_cast<Rndr::u32>(type->getElementCount());
+            scalar = type->getElementType();
+            break;
+        case slang::TypeReflection::Kind::Matrix:
+            row_count = type->getRowCount();
+            column_count = type->getColumnCount();
+            scalar = type->getElementType();
+            // Some Slang versions return the row vector as the element type of a matrix.
+            if (scalar->getKind() == slang::TypeReflection::Kind::Vector)
+            {
+                scalar = scalar->getElementType();
+            }
+            break;
+        default:
+            return;
+    }
+
+    sp.scalar_type = FromSlangScalarType(scalar->getScalarType());
+    if (sp.scalar_type == Rndr::ScalarType::Unknown)
+    {
+        return;
+    }
+    sp.row_count = static_cast<Rndr::u8>(row_count);
+    sp.column_count = static_cast<Rndr::u8>(column_count);
+}
+
 void ExtractUniformFields(slang::TypeLayoutReflection* type_layout, Rndr::i32 binding_index, Rndr::i32 binding_space,
                           Opal::DynamicArray<Rndr::ShaderParameter>& out_params)
 {
@@ -107,6 +184,7 @@ void ExtractUniformFields(slang::TypeLayoutReflection* type_layout, Rndr::i32 bi
         sp.category = Rndr::ParameterCategory::Uniform;
 
         slang::TypeReflection* field_type = field->getTypeLayout()->getType();
+        ExtractUniformType(field_type, sp);
         if (field_type->getKind() == slang::TypeReflection::Kind::Array)
         {
             const auto element_count = static_cast<Rndr::i32>(field_type->getElementCount());
@@ -136,6 +214,10 @@ void ExtractParam(slang::VariableLayoutReflection* param, Opal::DynamicArray<Rnd
     sp.binding_index = binding_index;
     sp.binding_space = binding_space;
     sp.category = category;
+    if (category == Rndr::ParameterCategory::StorageBuffer)
+    {
+        sp.writable = IsWritableResource(param);
+    }
 
     if (category == Rndr::ParameterCategory::Uniform)
     {
@@ -154,6 +236,7 @@ void ExtractParam(slang::VariableLayoutReflection* param, Opal::DynamicArray<Rnd
             sp.size = static_cast<Rndr::i32>(type_layout->getSize(SLANG_PARAMETER_CATEGORY_UNIFORM));
 
             slang::TypeReflection* type = type_layout->getType();
+            ExtractUniformType(type, sp);
             if (type->getKind() == slang::TypeReflection::Kind::Array)
             {
                 const auto element_count = static_cast<Rndr::i32>(type->getElementCount());
@@ -190,19 +273,6 @@ void ExtractParameters(slang::ProgramLayout* layout, Opal::DynamicArray<Rndr::Sh
 // Vertex input attribute extraction from reflection.
 // ---------------------------------------------------------------------------
 
-Rndr::ScalarType FromSlangScalarType(slang::TypeReflection::ScalarType scalar)
-{
-    switch (scalar)
-    {
-        case slang::TypeReflection::Float32:
-            return Rndr::ScalarType::Float32;
-        case slang::TypeReflection::Int32:
-            return Rndr::ScalarType::Int32;
-        default:
-            return Rndr::ScalarType::Unknown;
-    }
-}
-
 void ExtractVertexInputFromType(const char* name, slang::TypeLayoutReflection* type_layout,
                                 Opal::DynamicArray<Rndr::VertexInputAttribute>& out_inputs)
 {
@@ -269,6 +339,85 @@ void ExtractVertexInputs(slang::ProgramLayout* layout, Opal::DynamicArray<Rndr::
     }
 }
 
+// ---------------------------------------------------------------------------
+// Specialization constant extraction from SPIR-V.
+// ---------------------------------------------------------------------------
+
+constexpr Rndr::u32 k_spirv_header_words = 5;
+constexpr Rndr::u32 k_spirv_op_name = 5;
+constexpr Rndr::u32 k_spirv_op_spec_constant_true = 48;
+constexpr Rndr::u32 k_spirv_op_spec_constant_false = 49;
+constexpr Rndr::u32 k_spirv_op_spec_constant = 50;
+constexpr Rndr::u32 k_spirv_op_decorate = 71;
+constexpr Rndr::u32 k_spirv_decoration_spec_id = 1;
+
+void ExtractSpecializationConstants(const Opal::DynamicArray<Rndr::u8>& spirv, Opal::DynamicArray<Rndr::SpecializationConstant>& out_constants)
+{
+    const auto* words = reinterpret_cast<const Rndr::u32*>(spirv.GetData());
+    const Rndr::u64 word_count = spirv.GetSize() / sizeof(Rndr::u32);
+
+    // Debug names and decorations come before the constants, so one pass is enough.
+    Opal::DynamicArray<Rndr::u32> named_ids;
+    Opal::DynamicArray<Opal::StringUtf8> names;
+    Opal::DynamicArray<Rndr::u32> decorated_ids;
+    Opal::DynamicArray<Rndr::u32> spec_ids;
+    for (Rndr::u64 i = k_spirv_header_words; i < word_count;)
+    {
+        const Rndr::u32 instruction_words = words[i] >> 16;
+        const Rndr::u32 op = words[i] & 0xFFFF;
+        if (instruction_words == 0 || i + instruction_words > word_count)
+        {
+            break;
+        }
+
+        if (op == k_spirv_op_name && instruction_words >= 3)
+        {
+            const char* name = reinterpret_cast<const char*>(&words[i + 2]);
+            const Rndr::u64 name_size = strnlen(name, (instruction_words - 2) * sizeof(Rndr::u32));
+            named_ids.PushBack(words[i + 1]);
+            names.PushBack(Opal::StringUtf8(reinterpret_cast<const Rndr::char8*>(name), name_size));
+        }
+        else if (op == k_spirv_op_decorate && instruction_words >= 4 && words[i + 2] == k_spirv_decoration_spec_id)
+        {
+            decorated_ids.PushBack(words[i + 1]);
+            spec_ids.PushBack(words[i + 3]);
+        }
+        else if ((op == k_spirv_op_spec_constant_true || op == k_spirv_op_spec_constant_false || op == k_spirv_op_spec_constant) &&
+                 instruction_words >= 3)
+        {
+            const Rndr::u32 result_id = words[i + 2];
+            for (Rndr::u64 j = 0; j < decorated_ids.GetSize(); ++j)
+            {
+                if (decorated_ids[j] != result_id)
+                {
+                    continue;
+                }
+                Rndr::SpecializationConstant constant;
+                constant.constant_id = spec_ids[j];
+                if (op == k_spirv_op_spec_constant)
+                {
+                    constant.default_value = instruction_words >= 4 ? words[i + 3] : 0;
+                }
+                else
+                {
+                    constant.default_value = op == k_spirv_op_spec_constant_true ? 1 : 0;
+                }
+                for (Rndr::u64 k = 0; k < named_ids.GetSize(); ++k)
+                {
+                    if (named_ids[k] == result_id)
+                    {
+                        constant.name = names[k].Clone();
+                        break;
+                    }
+                }
+                out_constants.PushBack(std::move(constant));
+                break;
+            }
+        }
+        i += instruction_words;
+    }
+}
+
 // ---------------------------------------------------------------------------
 // Merge parameters helpers.
 // ---------------------------------------------------------------------------
@@ -299,9 +448,132 @@ Rndr::ShaderParameter CloneParameter(const Rndr::ShaderParameter& p)
     copy.array_element_count = p.array_element_count;
     copy.array_stride = p.array_stride;
     copy.category = p.category;
+    copy.writable = p.writable;
+    copy.scalar_type = p.scalar_type;
+    copy.row_count = p.row_count;
+    copy.column_count = p.column_count;
     return copy;
 }
 
+// ---------------------------------------------------------------------------
+// Shared Slang state
+// ---------------------------------------------------------------------------
+
+/**
+ * A session holds on to every module loaded into it, so a session is retired once this many
+ * modules were compiled with it. This bounds the memory of long running processes.
+ */
+constexpr Rndr::u32 k_max_modules_per_session = 32;
+
+struct PooledSession
+{
+    Slang::ComPtr<slang::IGlobalSession> global_session;
+    Slang::ComPtr<slang::ISession> session;
+    Rndr::u32 module_count = 0;
+};
+
+/**
+ * Pool of Slang global sessions, each with one compile session created from it. Slang objects
+ * derived from one global session must not be used concurrently, so an entry is checked out by a
+ * single compiler at a time and the pool only grows to the number of compilers alive at once.
+ * Creating a global session is by far the most expensive part of compiler setup, so returned
+ * entries are kept and reused.
+ */
+class SlangSessionPool
+{
+public:
+    PooledSession Acquire()
+    {
+        PooledSession pooled;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_free_sessions.IsEmpty())
+            {
+                pooled = std::move(m_free_sessions.Back());
+                m_free_sessions.PopBack();
+            }
+        }
+
+        // The entry is owned by this caller from here on, so it is set up outside of the lock.
+        if (pooled.global_session == nullptr)
+        {
+            const SlangResult result = slang::createGlobalSession(pooled.global_session.writeRef());
+            if (SLANG_FAILED(result))
+            {
+                throw Rndr::GraphicsAPIException(result, "Failed to create Slang global session!");
+            }
+        }
+        if (pooled.session == nullptr)
+        {
+            CreateSession(pooled);
+        }
+        return pooled;
+    }
+
+    void Release(PooledSession pooled)
+    {
+        if (pooled.global_session == nullptr)
+        {
+            return;
+        }
+        if (pooled.module_count >= k_max_modules_per_session)
+        {
+            // Retire the session but keep the global session, a new session is created on the next checkout.
+            pooled.session = nullptr;
+            pooled.module_count = 0;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free_sessions.PushBack(std::move(pooled));
+    }
+
+    /** @return Unique module name. Sessions cache modules by name, so every load needs a new one. */
+    Opal::StringUtf8 MakeModuleName()
+    {
+        const Rndr::u64 index = m_module_counter.fetch_add(1);
+        char name[48] = {};
+        snprintf(name, sizeof(name), "shader_module_%llu", static_cast<unsigned long long>(index));
+        return Opal::StringUtf8(name);
+    }
+
+private:
+    static void CreateSession(PooledSession& pooled)
+    {
+        slang::TargetDesc target_desc = {};
+        target_desc.format = SLANG_SPIRV;
+        target_desc.profile = pooled.global_session->findProfile("spirv_1_5");
+        target_desc.flags = SLANG_TARGET_FLAG_GENERATE_SPIRV_DIRECTLY;
+
+        // Preserve original Slang entry-point names in the emitted SPIR-V instead of renaming them
+        // all to "main". This lets downstream consumers (e.g. spirv-reflect) look up entry points by
+        // their original name.
+        slang::CompilerOptionEntry session_options[] = {
+            {slang::CompilerOptionName::VulkanUseEntryPointName, {slang::CompilerOptionValueKind::Int, 1, 0, nullptr, nullptr}},
+        };
+
+        slang::SessionDesc session_desc = {};
+        session_desc.targets = &target_desc;
+        session_desc.targetCount = 1;
+        session_desc.compilerOptionEntries = session_options;
+        session_desc.compilerOptionEntryCount = sizeof(session_options) / sizeof(session_options[0]);
+
+        const SlangResult result = pooled.global_session->createSession(session_desc, pooled.session.writeRef());
+        if (SLANG_FAILED(result))
+        {
+            throw Rndr::GraphicsAPIException(result, "Failed to create Slang session!");
+        }
+    }
+
+    std::mutex m_mutex;
+    Opal::DynamicArray<PooledSession> m_free_sessions;
+    std::atomic<Rndr::u64> m_module_counter = 0;
+};
+
+SlangSessionPool& GetSessionPool()
+{
+    static SlangSessionPool s_pool;
+    return s_pool;
+}
+
 }  // namespace
 
 // ---------------------------------------------------------------------------
@@ -310,9 +582,15 @@ Rndr::ShaderParameter CloneParameter(const Rndr::ShaderParameter& p)
 
 struct Rndr::ShaderCompiler::Impl
 {
-    Slang::ComPtr<slang::IGlobalSession> global_session;
-    Slang::ComPtr<slang::ISession> session;
+    PooledSession session;
     slang::IModule* module = nullptr;
+
+    ~Impl()
+    {
+        // The module is owned by the session, which another compiler may use after this point.
+        module = nullptr;
+        GetSessionPool().Release(std::move(session));
+    }
 };
 
 // ---------------------------------------------------------------------------
@@ -344,39 +622,18 @@ Rndr::ShaderCompiler& Rndr::ShaderCompiler::operator=(ShaderCompiler&& other) no
 
 void Rndr::ShaderCompiler::LoadModule(const Opal::StringUtf8& source)
 {
-    SlangResult result = slang::createGlobalSession(m_impl->global_session.writeRef());
-    if (SLANG_FAILED(result))
+    if (m_impl->session.session == nullptr)
     {
-        throw GraphicsAPIException(result, "Failed to create Slang global session!");
+        m_impl->session = GetSessionPool().Acquire();
     }
 
-    slang::TargetDesc target_desc = {};
-    target_desc.format = SLANG_SPIRV;
-    target_desc.profile = m_impl->global_session->findProfile("spirv_1_5");
-    target_desc.flags = SLANG_TARGET_FLAG_GENERATE_SPIRV_DIRECTLY;
-
-    // Preserve original Slang entry-point names in the emitted SPIR-V instead of renaming them
-    // all to "main". This lets downstream consumers (e.g. spirv-reflect) look up entry points by
-    // their original name.
-    slang::CompilerOptionEntry session_options[] = {
-        {slang::CompilerOptionName::VulkanUseEntryPointName, {slang::CompilerOptionValueKind::Int, 1, 0, nullptr, nullptr}},
-    };
-
-    slang::SessionDesc session_desc = {};
-    session_desc.targets = &target_desc;
-    session_desc.targetCount = 1;
-    session_desc.compilerOptionEntries = session_options;
-    session_desc.compilerOptionEntryCount = sizeof(session_options) / sizeof(session_options[0]);
-
-    result = m_impl->global_session->createSession(session_desc, m_impl->session.writeRef());
-    if (SLANG_FAILED(result))
-    {
-        throw GraphicsAPIException(result, "Failed to create Slang session!");
-    }
+    const Opal::StringUtf8 module_name = GetSessionPool().MakeModuleName();
+    const Opal::StringUtf8 module_path = module_name + ".slang";
+    ++m_impl->session.module_count;
 
     Slang::ComPtr<ISlangBlob> diagnostics;
     m_impl->module =
-        m_impl->session->loadModuleFromSourceString("shader_module", "shader_module.slang", *source, diagnostics.writeRef());
+        m_impl->session.session->loadModuleFromSourceString(*module_name, *module_path, *source, diagnostics.writeRef());
     if (m_impl->module == nullptr)
     {
         Opal::StringUtf8 msg = "Failed to load Slang module!";
@@ -405,7 +662,7 @@ Opal::DynamicArray<Rndr::EntryPointInfo> Rndr::ShaderCompiler::DiscoverEntryPoin
 
         slang::IComponentType* components[] = {m_impl->module, ep.get()};
         Slang::ComPtr<slang::IComponentType> linked;
-        const SlangResult result = m_impl->session->createCompositeComponentType(components, 2, linked.writeRef(), nullptr);
+        const SlangResult result = m_impl->session.session->createCompositeComponentType(components, 2, linked.writeRef(), nullptr);
         if (SLANG_FAILED(result))
         {
             continue;
@@ -438,7 +695,7 @@ Rndr::CompileResult Rndr::ShaderCompiler::CompileEntryPoint(const Opal::StringUt
     slang::IComponentType* components[] = {m_impl->module, ep};
     Slang::ComPtr<slang::IComponentType> linked_program;
     Slang::ComPtr<ISlangBlob> diagnostics;
-    result = m_impl->session->createCompositeComponentType(components, 2, linked_program.writeRef(), diagnostics.writeRef());
+    result = m_impl->session.session->createCompositeComponentType(components, 2, linked_program.writeRef(), diagnostics.writeRef());
     if (SLANG_FAILED(result))
     {
         Opal::StringUtf8 msg = "Failed to link Slang program!";
@@ -469,6 +726,8 @@ Rndr::CompileResult Rndr::ShaderCompiler::CompileEntryPoint(const Opal::StringUt
     out.spirv.Resize(spirv_size);
     memcpy(out.spirv.GetData(), spirv_data, spirv_size);
 
+    ExtractSpecializationConstants(out.spirv, out.specialization_constants);
+
     slang::ProgramLayout* layout = linked_program->getLayout();
     if (layout != nullptr)
     {
@@ -498,6 +757,27 @@ Rndr::CompileResult Rndr::ShaderCompiler::CompileEntryPoint(const Opal::StringUt
     return out;
 }
 
+Opal::DynamicArray<Rndr::CompileResult> Rndr::ShaderCompiler::CompileBatch(const Opal::DynamicArray<CompileRequest>& requests,
+                                                                           u32 max_threads)
+{
+    RNDR_CPU_EVENT_SCOPED("ShaderCompiler::CompileBatch");
+
+    Opal::DynamicArray<CompileResult> results(requests.GetSize());
+    Rndr::Impl::ParallelFor(requests.GetSize(), max_threads,
+                            [&requests, &results](u64 index)
+                            {
+                                ShaderCompiler compiler;
+                                compiler.LoadModule(requests[index].source);
+                                results[index] = compiler.CompileEntryPoint(requests[index].entry_point);
+                            });
+    return results;
+}
+
+Opal::StringUtf8 Rndr::ShaderCompiler::GetCompilerVersion()
+{
+    return Opal::StringUtf8(spGetBuildTagString());
+}
+
 Opal::StringUtf8 Rndr::ShaderCompiler::FindSingleEntryPoint(const Opal::DynamicArray<EntryPointInfo>& entries,
                                                               ShaderStage target_stage, const char* stage_name)
 {
@@ -8,12 +8,155 @@
 #include "ktxvulkan.h"
 #endif
 
+#include "opal/container/hash-set.h"
 #include "opal/exceptions.h"
 #include "opal/file-system.h"
 #include "opal/paths.h"
 
 #include "rndr/log.hpp"
 
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+namespace
+{
+
+void AppendBytes(Opal::DynamicArray<Rndr::u8>& out, const Opal::StringUtf8& str, Rndr::u64 start, Rndr::u64 size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+    const Rndr::u64 offset = out.GetSize();
+    out.Resize(offset + size);
+    memcpy(out.GetData() + offset, str.GetData() + start, size);
+}
+
+/**
+ * Parse an include directive that starts at line_start, after any leading whitespace.
+ * @return False if the line is not an include directive. out_is_valid is false if it is one but has no path.
+ */
+bool ParseInclude(const Opal::StringUtf8& contents, Rndr::u64 line_start, Rndr::u64 line_end, Opal::StringUtf8& out_path,
+                  bool& out_is_valid)
+{
+    static constexpr char k_directive[] = "#include";
+    static constexpr Rndr::u64 k_directive_size = sizeof(k_directive) - 1;
+    const char8* data = contents.GetData();
+    while (line_start < line_end && (data[line_start] == ' ' || data[line_start] == '\t'))
+    {
+        ++line_start;
+    }
+    if (line_end - line_start < k_directive_size || memcmp(data + line_start, k_directive, k_directive_size) != 0)
+    {
+        return false;
+    }
+
+    out_is_valid = false;
+    Rndr::u64 path_start = line_start + k_directive_size;
+    while (path_start < line_end && data[path_start] != '"' && data[path_start] != '<')
+    {
+        ++path_start;
+    }
+    if (path_start == line_end)
+    {
+        return true;
+    }
+    const char8 closing = data[path_start] == '"' ? '"' : '>';
+    Rndr::u64 path_end = path_start + 1;
+    while (path_end < line_end && data[path_end] != closing)
+    {
+        ++path_end;
+    }
+    if (path_end == line_end)
+    {
+        return true;
+    }
+    out_path = Opal::StringUtf8(data + path_start + 1, path_end - path_start - 1);
+    out_is_valid = true;
+    return true;
+}
+
+/**
+ * Append the contents of a shader file to out_contents, expanding its includes in place. Files in
+ * expanded_files are skipped, which guards against repeated includes and include cycles. Paths must
+ * be normalized, so that different spellings of the same file are recognized.
+ * @return False if the file or one of its includes can't be read.
+ */
+bool ExpandShaderFile(const Opal::StringUtf8& full_path, Rndr::ShaderFileCache& cache, Opal::HashSet<Opal::StringUtf8>& expanded_files,
+                      Opal::DynamicArray<Opal::StringUtf8>* out_dependencies, Opal::DynamicArray<Rndr::u8>& out_contents)
+{
+    if (expanded_files.Contains(full_path))
+    {
+        return true;
+    }
+    expanded_files.Insert(full_path.Clone());
+    if (out_dependencies != nullptr)
+    {
+        // Record the file even if it is missing, so that creating it later can be detected.
+        bool is_recorded = false;
+        for (Rndr::u64 i = 0; i < out_dependencies->GetSize() && !is_recorded; ++i)
+        {
+            is_recorded = (*out_dependencies)[i] == full_path;
+        }
+        if (!is_recorded)
+        {
+            out_dependencies->PushBack(full_path.Clone());
+        }
+    }
+
+    Opal::StringUtf8 contents;
+    if (!cache.GetContents(full_path, contents))
+    {
+        RNDR_LOG_ERROR("Shader file {} does not exist or can't be read!", full_path.GetData());
+        return false;
+    }
+
+    Opal::StringUtf8 parent_path;
+    Rndr::u64 copy_start = 0;
+    Rndr::u64 line_start = 0;
+    const Rndr::u64 size = contents.GetSize();
+    while (line_start < size)
+    {
+        Rndr::u64 line_end = line_start;
+        while (line_end < size && contents.GetData()[line_end] != '\n')
+        {
+            ++line_end;
+        }
+
+        Opal::StringUtf8 include_path;
+        bool is_valid = false;
+        if (ParseInclude(contents, line_start, line_end, include_path, is_valid))
+        {
+            if (!is_valid)
+            {
+                RNDR_LOG_ERROR("Invalid include statement in shader file {}!", full_path.GetData());
+                return false;
+            }
+            if (parent_path.IsEmpty())
+            {
+                auto parent_path_result = Opal::Paths::GetParentPath(full_path);
+                RNDR_ASSERT(parent_path_result.HasValue(), "Shader parent directory path is empty!");
+                parent_path = std::move(parent_path_result.GetValue());
+            }
+
+            // The directive is replaced by the included contents, the line break after it is kept.
+            AppendBytes(out_contents, contents, copy_start, line_start - copy_start);
+            if (!ExpandShaderFile(Opal::Paths::NormalizePath(Opal::Paths::Combine(parent_path, include_path)), cache, expanded_files,
+                                  out_dependencies, out_contents))
+            {
+                return false;
+            }
+            copy_start = line_end;
+        }
+        line_start = line_end + 1;
+    }
+    AppendBytes(out_contents, contents, copy_start, size - copy_start);
+    return true;
+}
+
+}  // namespace
+
 Rndr::FileHandler::FileHandler(const char* file_path, const char* mode)
 {
     fopen_s(&m_file_handle, file_path, mode);
@@ -91,69 +234,96 @@ Opal::StringUtf8 Rndr::File::ReadEntireTextFile(const Opal::StringUtf8& file_pat
     return {reinterpret_cast<char8*>(contents.GetData()), contents.GetSize()};
 }
 
-Opal::StringUtf8 Rndr::File::ReadShader(const Opal::StringUtf8& ref_path, const Opal::StringUtf8& shader_path)
+Rndr::i64 Rndr::File::GetLastWriteTime(const Opal::StringUtf8& file_path)
 {
-    const Opal::StringUtf8 full_path = Opal::Paths::Combine(ref_path, shader_path);
-    if (!Opal::Exists(full_path))
+    Opal::StringLocale file_path_locale;
+    file_path_locale.Resize(300);
+    if (Opal::Transcode(file_path, file_path_locale) != Opal::ErrorCode::Success)
     {
-        RNDR_LOG_ERROR("Shader file {} does not exist!", full_path.GetData());
-        return {};
+        return 0;
     }
-
-    Opal::StringUtf8 shader_contents = ReadEntireTextFile(full_path);
-    if (shader_contents.IsEmpty())
+    std::error_code error;
+    const std::filesystem::file_time_type time = std::filesystem::last_write_time(file_path_locale.GetData(), error);
+    if (error)
     {
-        RNDR_LOG_ERROR("Failed to read shader file {}!", full_path.GetData());
-        return {};
+        return 0;
     }
+    return static_cast<i64>(time.time_since_epoch().count());
+}
 
-    static constexpr u8 k_bom[] = {0xEF, 0xBB, 0xBF};
-    if (shader_contents.GetSize() > sizeof(k_bom) && memcmp(shader_contents.GetData(), k_bom, sizeof(k_bom)) == 0)
+bool Rndr::ShaderFileCache::GetContents(const Opal::StringUtf8& file_path, Opal::StringUtf8& out_contents)
+{
+    const i64 last_write_time = File::GetLastWriteTime(file_path);
+    if (last_write_time == 0)
     {
-        shader_contents.Erase(0, 3);
+        return false;
     }
-
-    while (true)
     {
-        u64 const result = Opal::Find(shader_contents, "#include");
-        if (result == Opal::StringUtf8::k_npos)
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.Find(file_path);
+        if (it != m_entries.end() && it.GetValue().last_write_time == last_write_time)
         {
-            break;
+            ++m_stats.hits;
+            out_contents = it.GetValue().contents.Clone();
+            return true;
         }
+    }
 
-        const u64 include_start = Opal::Find(shader_contents, "#include");
-        const u64 include_end = Opal::Find(shader_contents, "\n", include_start);
-        const u64 include_length = include_end - include_start;
-        const Opal::StringUtf8 include_line = Opal::GetSubString(shader_contents, include_start, include_length).GetValue();
-        const u64 quote_start = Opal::Find(include_line, '\"');
-        const u64 quote_end = Opal::ReverseFind(include_line, '\"');
-        const u64 quote_length = quote_end - quote_start;
-        const u64 bracket_start = Opal::Find(include_line, '<');
-        const u64 bracket_end = Opal::ReverseFind(include_line, '>');
-        const u64 bracket_length = bracket_end - bracket_start;
-        Opal::StringUtf8 include_path;
-        if (quote_start != Opal::StringUtf8::k_npos)
-        {
-            include_path = Opal::GetSubString(include_line, quote_start + 1, quote_length - 1).GetValue();
-        }
-        else if (bracket_start != Opal::StringUtf8::k_npos)
-        {
-            include_path = Opal::GetSubString(include_line, bracket_start + 1, bracket_length - 1).GetValue();
-        }
-        else
-        {
-            RNDR_LOG_ERROR("Invalid include statement {}", include_line.GetData());
-            return {};
-        }
-        auto parent_path_result = Opal::Paths::GetParentPath(full_path);
-        RNDR_ASSERT(parent_path_result.HasValue(), "Shader parent directory path is empty!");
-        const Opal::StringUtf8 parent_path = std::move(parent_path_result.GetValue());
-        const Opal::StringUtf8 include_contents = ReadShader(parent_path, include_path);
-        shader_contents.Erase(include_start, include_length);
-        shader_contents.Insert(include_start, include_contents);
+    // Read outside of the lock, so threads loading different files don't wait for each other.
+    Opal::StringUtf8 contents = File::ReadEntireTextFile(file_path);
+    static constexpr u8 k_bom[] = {0xEF, 0xBB, 0xBF};
+    if (contents.GetSize() >= sizeof(k_bom) && memcmp(contents.GetData(), k_bom, sizeof(k_bom)) == 0)
+    {
+        contents.Erase(0, 3);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_stats.reads;
+    auto it = m_entries.Find(file_path);
+    if (it != m_entries.end())
+    {
+        it.GetValue().last_write_time = last_write_time;
+        it.GetValue().contents = contents.Clone();
     }
+    else
+    {
+        m_entries.Insert(file_path.Clone(), Entry{.last_write_time = last_write_time, .contents = contents.Clone()});
+    }
+    out_contents = std::move(contents);
+    return true;
+}
 
-    return shader_contents;
+Rndr::i64 Rndr::ShaderFileCache::GetLastWriteTime(const Opal::StringUtf8& file_path) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.Find(file_path);
+    return it != m_entries.end() ? it.GetValue().last_write_time : 0;
+}
+
+void Rndr::ShaderFileCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.Clear();
+}
+
+Rndr::ShaderFileCacheStats Rndr::ShaderFileCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+Opal::StringUtf8 Rndr::File::ReadShader(const Opal::StringUtf8& ref_path, const Opal::StringUtf8& shader_path,
+                                        Opal::DynamicArray<Opal::StringUtf8>* out_dependencies, ShaderFileCache* cache)
+{
+    ShaderFileCache local_cache;
+    Opal::HashSet<Opal::StringUtf8> expanded_files;
+    Opal::DynamicArray<u8> shader_contents;
+    if (!ExpandShaderFile(Opal::Paths::NormalizePath(Opal::Paths::Combine(ref_path, shader_path)), cache != nullptr ? *cache : local_cache,
+                          expanded_files, out_dependencies, shader_contents))
+    {
+        return {};
+    }
+    return {reinterpret_cast<const char8*>(shader_contents.GetData()), shader_contents.GetSize()};
 }
 
 void Rndr::File::PrintShader(const Opal::StringUtf8& shader_contents)
@@ -8,6 +8,8 @@
 
 #if RNDR_CANVAS
 #include "backends/imgui_impl_opengl3.h"
+
+#include "rndr/canvas/draw-list.hpp"
 #endif
 
 #include "opal/container/hash-map.h"
@@ -253,6 +255,49 @@ void Rndr::ImGuiContext::EndFrame()
     m_frame_started = false;
 }
 
+#if RNDR_CANVAS
+void Rndr::ImGuiContext::ShowDrawListStats(const Canvas::DrawListStats& stats, const char* title)
+{
+    if (!m_frame_started)
+    {
+        RNDR_LOG_WARNING("Frame not started!");
+        return;
+    }
+
+    if (ImGui::Begin(title))
+    {
+        ImGui::Text("Draws: %u", stats.draw_count);
+        ImGui::Text("Instanced draws: %u", stats.instanced_draw_count);
+        ImGui::Text("Indirect draws: %u", stats.indirect_draw_count);
+        ImGui::Text("Triangles: %llu", static_cast<unsigned long long>(stats.triangle_count));
+        ImGui::Text("Instances: %llu", static_cast<unsigned long long>(stats.instance_count));
+        ImGui::Text("Dispatches: %u", stats.dispatch_count);
+        ImGui::Text("Render target switches: %u", stats.render_target_switches);
+        ImGui::Text("Brush applies: %u", stats.brush_applies);
+        ImGui::Text("Uniform bytes uploaded: %llu", static_cast<unsigned long long>(stats.uniform_bytes_uploaded));
+        ImGui::Text("Mesh uploads: %u", stats.mesh_uploads);
+        ImGui::Text("CPU time: %.3f ms", stats.total_cpu_time * 1000.0);
+
+        if (ImGui::BeginTable("CommandCpuTime", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Command");
+            ImGui::TableSetupColumn("CPU time (ms)");
+            ImGui::TableHeadersRow();
+            for (u64 i = 0; i < static_cast<u64>(Canvas::DrawListCommandType::EnumCount); ++i)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                ImGui::TextUnformatted(Canvas::GetCommandTypeName(static_cast<Canvas::DrawListCommandType>(i)));
+                ImGui::TableSetColumnIndex(1);
+                ImGui::Text("%.3f", stats.command_cpu_time[i] * 1000.0);
+            }
+            ImGui::EndTable();
+        }
+    }
+    ImGui::End();
+}
+#endif
+
 void Rndr::ImGuiContext::OnWindowSizeChanged(const GenericWindow&, i32, i32) {}
 
 bool Rndr::ImGuiContext::OnButtonDown(const GenericWindow& window, InputPrimitive primitive, bool)
@@ -0,0 +1,587 @@
+#include "rndr/mesh-optimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "rndr/definitions.hpp"
+#include "rndr/trace.hpp"
+
+namespace
+{
+
+using Rndr::f32;
+using Rndr::i32;
+using Rndr::u32;
+using Rndr::u64;
+using Rndr::u8;
+
+constexpr u32 k_invalid_index = 0xFFFFFFFF;
+
+// Forsyth's scoring constants, see "Linear-Speed Vertex Cache Optimisation".
+constexpr u32 k_forsyth_cache_size = 32;
+constexpr f32 k_cache_decay_power = 1.5f;
+constexpr f32 k_last_triangle_score = 0.75f;
+constexpr f32 k_valence_boost_scale = 2.0f;
+constexpr f32 k_valence_boost_power = 0.5f;
+
+constexpr u32 k_overdraw_resolution = 256;
+
+constexpr u32 k_fetch_cache_line_size = 64;
+constexpr u32 k_fetch_cache_line_count = 64;
+
+template <typename T>
+Opal::DynamicArray<T> CreateFilled(u64 count, T value)
+{
+    Opal::DynamicArray<T> array(count);
+    for (u64 i = 0; i < count; ++i)
+    {
+        array[i] = value;
+    }
+    return array;
+}
+
+struct Position
+{
+    f32 x = 0.0f;
+    f32 y = 0.0f;
+    f32 z = 0.0f;
+};
+
+Position ReadPosition(const u8* vertex_data, u32 vertex_stride, u32 index)
+{
+    Position position;
+    memcpy(&position, vertex_data + static_cast<u64>(index) * vertex_stride, sizeof(position));
+    return position;
+}
+
+f32 GetVertexScore(i32 cache_position, u32 live_triangle_count)
+{
+    if (live_triangle_count == 0)
+    {
+        return -1.0f;
+    }
+
+    f32 score = 0.0f;
+    if (cache_position >= 0)
+    {
+        // The vertices of the last triangle get a fixed score, so the next triangle does not just reuse its edge.
+        if (cache_position < 3)
+        {
+            score = k_last_triangle_score;
+        }
+        else
+        {
+            const f32 scale = 1.0f / static_cast<f32>(k_forsyth_cache_size - 3);
+            score = std::pow(1.0f - static_cast<f32>(cache_position - 3) * scale, k_cache_decay_power);
+        }
+    }
+    // Vertices with few triangles left are finished first, so they don't stay behind as lone triangles.
+    score += k_valence_boost_scale * std::pow(static_cast<f32>(live_triangle_count), -k_valence_boost_power);
+    return score;
+}
+
+/**
+ * FIFO cache that is reset in constant time. A vertex is cached if it missed less than cache_size
+ * misses ago.
+ */
+class FifoCache
+{
+public:
+    FifoCache(u32 vertex_count, u32 cache_size) : m_timestamps(CreateFilled<u32>(vertex_count, 0)), m_cache_size(cache_size) {}
+
+    /** @return True if the vertex had to be transformed. */
+    bool Access(u32 vertex)
+    {
+        if (m_time - m_timestamps[vertex] > m_cache_size)
+        {
+            m_timestamps[vertex] = m_time++;
+            return true;
+        }
+        return false;
+    }
+
+    void Reset() { m_time += m_cache_size + 1; }
+
+private:
+    Opal::DynamicArray<u32> m_timestamps;
+    u32 m_cache_size = 0;
+    u32 m_time = k_invalid_index / 2;
+};
+
+struct Cluster
+{
+    u32 first_triangle = 0;
+    u32 triangle_count = 0;
+    f32 sort_key = 0.0f;
+};
+
+Position Cross(const Position& a, const Position& b)
+{
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+Position Subtract(const Position& a, const Position& b)
+{
+    return {a.x - b.x, a.y - b.y, a.z - b.z};
+}
+
+f32 GetComponent(const Position& position, u32 axis)
+{
+    return axis == 0 ? position.x : (axis == 1 ? position.y : position.z);
+}
+
+}  // namespace
+
+void Rndr::OptimizeVertexCache(Opal::ArrayView<u32> indices, u32 vertex_count)
+{
+    RNDR_CPU_EVENT_SCOPED("OptimizeVertexCache");
+
+    RNDR_ASSERT(indices.GetSize() % 3 == 0, "Index count must be a multiple of 3!");
+    const u64 index_count = indices.GetSize();
+    const u64 triangle_count = index_count / 3;
+    if (triangle_count == 0)
+    {
+        return;
+    }
+
+    // Triangles of each vertex. The first live_triangle_counts[v] entries of a vertex are the triangles not emitted yet.
+    Opal::DynamicArray<u32> live_triangle_counts = CreateFilled<u32>(vertex_count, 0);
+    for (u64 i = 0; i < index_count; ++i)
+    {
+        RNDR_ASSERT(indices[i] < vertex_count, "Index out of range!");
+        ++live_triangle_counts[indices[i]];
+    }
+    Opal::DynamicArray<u32> adjacency_offsets(static_cast<u64>(vertex_count) + 1);
+    adjacency_offsets[0] = 0;
+    for (u32 v = 0; v < vertex_count; ++v)
+    {
+        adjacency_offsets[v + 1] = adjacency_offsets[v] + live_triangle_counts[v];
+    }
+    Opal::DynamicArray<u32> adjacency(index_count);
+    Opal::DynamicArray<u32> fill_counts = CreateFilled<u32>(vertex_count, 0);
+    for (u64 i = 0; i < index_count; ++i)
+    {
+        const u32 v = indices[i];
+        adjacency[adjacency_offsets[v] + fill_counts[v]++] = static_cast<u32>(i / 3);
+    }
+
+    Opal::DynamicArray<i32> cache_positions = CreateFilled<i32>(vertex_count, -1);
+    Opal::DynamicArray<f32> vertex_scores(vertex_count);
+    for (u32 v = 0; v < vertex_count; ++v)
+    {
+        vertex_scores[v] = GetVertexScore(-1, live_triangle_counts[v]);
+    }
+
+    Opal::DynamicArray<f32> triangle_scores(triangle_count);
+    Opal::DynamicArray<bool> emitted = CreateFilled<bool>(triangle_count, false);
+    u32 best_triangle = 0;
+    for (u64 t = 0; t < triangle_count; ++t)
+    {
+        triangle_scores[t] = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+        if (triangle_scores[t] > triangle_scores[best_triangle])
+        {
+            best_triangle = static_cast<u32>(t);
+        }
+    }
+
+    // Three extra entries hold the vertices that fall out of the cache when a triangle is added.
+    u32 cache[k_forsyth_cache_size + 3] = {};
+    u32 cache_count = 0;
+    Opal::DynamicArray<u32> output(index_count);
+    u64 next_unemitted = 0;
+    for (u64 out_triangle = 0; out_triangle < triangle_count; ++out_triangle)
+    {
+        if (best_triangle == k_invalid_index)
+        {
+            // Nothing in the cache has triangles left, continue with the next triangle in input order.
+            while (emitted[next_unemitted])
+            {
+                ++next_unemitted;
+            }
+            best_triangle = static_cast<u32>(next_unemitted);
+        }
+
+        const u32* triangle = indices.GetData() + static_cast<u64>(best_triangle) * 3;
+        memcpy(output.GetData() + out_triangle * 3, triangle, 3 * sizeof(u32));
+        emitted[best_triangle] = true;
+
+        u32 new_cache[k_forsyth_cache_size + 3] = {};
+        u32 new_cache_count = 0;
+        for (u32 i = 0; i < 3; ++i)
+        {
+            const u32 v = triangle[i];
+            u32* begin = adjacency.GetData() + adjacency_offsets[v];
+            u32* end = begin + live_triangle_counts[v];
+            u32* it = std::find(begin, end, best_triangle);
+            RNDR_ASSERT(it != end, "Emitted triangle is missing from the adjacency!");
+            *it = *(end - 1);
+            --live_triangle_counts[v];
+
+            if (std::find(new_cache, new_cache + new_cache_count, v) == new_cache + new_cache_count)
+            {
+                new_cache[new_cache_count++] = v;
+            }
+        }
+        for (u32 i = 0; i < cache_count; ++i)
+        {
+            const u32 v = cache[i];
+            if (std::find(new_cache, new_cache + new_cache_count, v) == new_cache + new_cache_count)
+            {
+                new_cache[new_cache_count++] = v;
+            }
+        }
+
+        best_triangle = k_invalid_index;
+        f32 best_score = -1.0f;
+        for (u32 i = 0; i < new_cache_count; ++i)
+        {
+            const u32 v = new_cache[i];
+            cache_positions[v] = i < k_forsyth_cache_size ? static_cast<i32>(i) : -1;
+            vertex_scores[v] = GetVertexScore(cache_positions[v], live_triangle_counts[v]);
+        }
+        for (u32 i = 0; i < new_cache_count; ++i)
+        {
+            const u32 v = new_cache[i];
+            const u32* adjacent = adjacency.GetData() + adjacency_offsets[v];
+            for (u32 j = 0; j < live_triangle_counts[v]; ++j)
+            {
+                const u64 t = adjacent[j];
+                triangle_scores[t] = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+                if (triangle_scores[t] > best_score)
+                {
+                    best_score = triangle_scores[t];
+                    best_triangle = static_cast<u32>(t);
+                }
+            }
+        }
+
+        cache_count = std::min(new_cache_count, k_forsyth_cache_size);
+        memcpy(cache, new_cache, cache_count * sizeof(u32));
+    }
+
+    memcpy(indices.GetData(), output.GetData(), index_count * sizeof(u32));
+}
+
+void Rndr::OptimizeOverdraw(Opal::ArrayView<u32> indices, Opal::ArrayView<const u8> vertex_data, u32 vertex_stride, f32 threshold)
+{
+    RNDR_CPU_EVENT_SCOPED("OptimizeOverdraw");
+
+    RNDR_ASSERT(indices.GetSize() % 3 == 0, "Index count must be a multiple of 3!");
+    RNDR_ASSERT(vertex_stride >= sizeof(Position), "Vertex must start with a float3 position!");
+    const u64 triangle_count = indices.GetSize() / 3;
+    if (triangle_count == 0)
+    {
+        return;
+    }
+    const auto vertex_count = static_cast<u32>(vertex_data.GetSize() / vertex_stride);
+
+    // Cut clusters where the ACMR of the cluster so far, with a cold cache, is within the threshold of
+    // the whole mesh. Reordering such clusters can't raise the ACMR by more than the threshold.
+    const Opal::ArrayView<const u32> const_indices(indices.GetData(), indices.GetSize());
+    const f32 target_acmr = AnalyzeVertexCache(const_indices, vertex_count).acmr * threshold;
+    Opal::DynamicArray<Cluster> clusters;
+    FifoCache cache(vertex_count, k_default_vertex_cache_size);
+    u32 cluster_start = 0;
+    u32 cluster_misses = 0;
+    for (u64 t = 0; t < triangle_count; ++t)
+    {
+        for (u32 i = 0; i < 3; ++i)
+        {
+            cluster_misses += cache.Access(indices[t * 3 + i]) ? 1 : 0;
+        }
+        const auto cluster_triangle_count = static_cast<u32>(t + 1 - cluster_start);
+        if (static_cast<f32>(cluster_misses) <= target_acmr * static_cast<f32>(cluster_triangle_count) || t + 1 == triangle_count)
+        {
+            clusters.PushBack({.first_triangle = cluster_start, .triangle_count = cluster_triangle_count});
+            cluster_start = static_cast<u32>(t + 1);
+            cluster_misses = 0;
+            cache.Reset();
+        }
+    }
+
+    // Area weighted centroid and normal of every cluster and the centroid of the mesh.
+    const u8* positions = vertex_data.GetData();
+    Opal::DynamicArray<Position> cluster_centroids(clusters.GetSize());
+    Opal::DynamicArray<Position> cluster_normals(clusters.GetSize());
+    Position mesh_centroid;
+    f32 mesh_area = 0.0f;
+    for (u64 c = 0; c < clusters.GetSize(); ++c)
+    {
+        Position centroid;
+        Position normal;
+        f32 cluster_area = 0.0f;
+        for (u32 t = clusters[c].first_triangle; t < clusters[c].first_triangle + clusters[c].triangle_count; ++t)
+        {
+            const Position p0 = ReadPosition(positions, vertex_stride, indices[static_cast<u64>(t) * 3]);
+            const Position p1 = ReadPosition(positions, vertex_stride, indices[static_cast<u64>(t) * 3 + 1]);
+            const Position p2 = ReadPosition(positions, vertex_stride, indices[static_cast<u64>(t) * 3 + 2]);
+            const Position triangle_normal = Cross(Subtract(p1, p0), Subtract(p2, p0));
+            const f32 area = std::sqrt(triangle_normal.x * triangle_normal.x + triangle_normal.y * triangle_normal.y +
+                                       triangle_normal.z * triangle_normal.z);
+            centroid.x += (p0.x + p1.x + p2.x) * area;
+            centroid.y += (p0.y + p1.y + p2.y) * area;
+            centroid.z += (p0.z + p1.z + p2.z) * area;
+            normal.x += triangle_normal.x;
+            normal.y += triangle_normal.y;
+            normal.z += triangle_normal.z;
+            cluster_area += area;
+        }
+        mesh_centroid.x += centroid.x;
+        mesh_centroid.y += centroid.y;
+        mesh_centroid.z += centroid.z;
+        mesh_area += cluster_area;
+
+        const f32 inverse_area = cluster_area > 0.0f ? 1.0f / (3.0f * cluster_area) : 0.0f;
+        cluster_centroids[c] = {centroid.x * inverse_area, centroid.y * inverse_area, centroid.z * inverse_area};
+        cluster_normals[c] = normal;
+    }
+    const f32 inverse_mesh_area = mesh_area > 0.0f ? 1.0f / (3.0f * mesh_area) : 0.0f;
+    mesh_centroid = {mesh_centroid.x * inverse_mesh_area, mesh_centroid.y * inverse_mesh_area, mesh_centroid.z * inverse_mesh_area};
+
+    // Clusters far out along their normal are likely in front of the rest of the mesh from most views.
+    for (u64 c = 0; c < clusters.GetSize(); ++c)
+    {
+        const Position& normal = cluster_normals[c];
+        const f32 length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+        const Position offset = Subtract(cluster_centroids[c], mesh_centroid);
+        const f32 distance = offset.x * normal.x + offset.y * normal.y + offset.z * normal.z;
+        clusters[c].sort_key = length > 0.0f ? distance / length : 0.0f;
+    }
+    std::stable_sort(clusters.GetData(), clusters.GetData() + clusters.GetSize(),
+                     [](const Cluster& a, const Cluster& b) { return a.sort_key > b.sort_key; });
+
+    Opal::DynamicArray<u32> output(indices.GetSize());
+    u32* dst = output.GetData();
+    for (u64 c = 0; c < clusters.GetSize(); ++c)
+    {
+        const u64 count = static_cast<u64>(clusters[c].triangle_count) * 3;
+        memcpy(dst, indices.GetData() + static_cast<u64>(clusters[c].first_triangle) * 3, count * sizeof(u32));
+        dst += count;
+    }
+    memcpy(indices.GetData(), output.GetData(), indices.GetSize() * sizeof(u32));
+}
+
+Rndr::u32 Rndr::OptimizeVertexFetch(Opal::ArrayView<u8> vertex_data, u32 vertex_stride, Opal::ArrayView<u32> indices)
+{
+    RNDR_CPU_EVENT_SCOPED("OptimizeVertexFetch");
+
+    const auto vertex_count = static_cast<u32>(vertex_data.GetSize() / vertex_stride);
+    Opal::DynamicArray<u32> remap = CreateFilled<u32>(vertex_count, k_invalid_index);
+    u32 next_vertex = 0;
+    for (u64 i = 0; i < indices.GetSize(); ++i)
+    {
+        RNDR_ASSERT(indices[i] < vertex_count, "Index out of range!");
+        u32& new_index = remap[indices[i]];
+        if (new_index == k_invalid_index)
+        {
+            new_index = next_vertex++;
+        }
+        indices[i] = new_index;
+    }
+    const u32 referenced_count = next_vertex;
+    for (u32 v = 0; v < vertex_count; ++v)
+    {
+        if (remap[v] == k_invalid_index)
+        {
+            remap[v] = next_vertex++;
+        }
+    }
+
+    Opal::DynamicArray<u8> original(vertex_data.GetSize());
+    memcpy(original.GetData(), vertex_data.GetData(), vertex_data.GetSize());
+    for (u32 v = 0; v < vertex_count; ++v)
+    {
+        memcpy(vertex_data.GetData() + static_cast<u64>(remap[v]) * vertex_stride, original.GetData() + static_cast<u64>(v) * vertex_stride,
+               vertex_stride);
+    }
+    return referenced_count;
+}
+
+Rndr::u32 Rndr::OptimizeMesh(Opal::DynamicArray<u8>& vertex_data, u32 vertex_stride, Opal::ArrayView<u32> indices, f32 overdraw_threshold)
+{
+    RNDR_CPU_EVENT_SCOPED("OptimizeMesh");
+
+    const auto vertex_count = static_cast<u32>(vertex_data.GetSize() / vertex_stride);
+    OptimizeVertexCache(indices, vertex_count);
+    OptimizeOverdraw(indices, Opal::ArrayView<const u8>(vertex_data.GetData(), vertex_data.GetSize()), vertex_stride, overdraw_threshold);
+    const u32 referenced_count =
+        OptimizeVertexFetch(Opal::ArrayView<u8>(vertex_data.GetData(), vertex_data.GetSize()), vertex_stride, indices);
+    vertex_data.Resize(static_cast<u64>(referenced_count) * vertex_stride);
+    return referenced_count;
+}
+
+Rndr::VertexCacheStats Rndr::AnalyzeVertexCache(Opal::ArrayView<const u32> indices, u32 vertex_count, u32 cache_size)
+{
+    VertexCacheStats stats;
+    FifoCache cache(vertex_count, cache_size);
+    Opal::DynamicArray<bool> referenced = CreateFilled<bool>(vertex_count, false);
+    u64 referenced_count = 0;
+    for (u64 i = 0; i < indices.GetSize(); ++i)
+    {
+        const u32 v = indices[i];
+        stats.transformed_vertex_count += cache.Access(v) ? 1 : 0;
+        if (!referenced[v])
+        {
+            referenced[v] = true;
+            ++referenced_count;
+        }
+    }
+
+    const u64 triangle_count = indices.GetSize() / 3;
+    if (triangle_count > 0)
+    {
+        stats.acmr = static_cast<f32>(stats.transformed_vertex_count) / static_cast<f32>(triangle_count);
+        stats.atvr = static_cast<f32>(stats.transformed_vertex_count) / static_cast<f32>(referenced_count);
+    }
+    return stats;
+}
+
+Rndr::OverdrawStats Rndr::AnalyzeOverdraw(Opal::ArrayView<const u32> indices, Opal::ArrayView<const u8> vertex_data, u32 vertex_stride)
+{
+    RNDR_CPU_EVENT_SCOPED("AnalyzeOverdraw");
+
+    OverdrawStats stats;
+    const u64 triangle_count = indices.GetSize() / 3;
+    const auto vertex_count = static_cast<u32>(vertex_data.GetSize() / vertex_stride);
+    if (triangle_count == 0 || vertex_count == 0)
+    {
+        return stats;
+    }
+
+    // Fit the bounding box into the raster, keeping the aspect ratio.
+    Position min = ReadPosition(vertex_data.GetData(), vertex_stride, 0);
+    Position max = min;
+    for (u32 v = 1; v < vertex_count; ++v)
+    {
+        const Position p = ReadPosition(vertex_data.GetData(), vertex_stride, v);
+        min = {std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z)};
+        max = {std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z)};
+    }
+    const f32 extent = std::max({max.x - min.x, max.y - min.y, max.z - min.z});
+    const f32 scale = extent > 0.0f ? static_cast<f32>(k_overdraw_resolution) / extent : 0.0f;
+
+    Opal::DynamicArray<f32> depth_buffer(static_cast<u64>(k_overdraw_resolution) * k_overdraw_resolution);
+    for (u32 axis = 0; axis < 3; ++axis)
+    {
+        const u32 u_axis = (axis + 1) % 3;
+        const u32 v_axis = (axis + 2) % 3;
+        for (const f32 direction : {1.0f, -1.0f})
+        {
+            for (u64 i = 0; i < depth_buffer.GetSize(); ++i)
+            {
+                depth_buffer[i] = std::numeric_limits<f32>::max();
+            }
+
+            for (u64 t = 0; t < triangle_count; ++t)
+            {
+                f32 us[3];
+                f32 vs[3];
+                f32 depths[3];
+                for (u32 i = 0; i < 3; ++i)
+                {
+                    const Position p = ReadPosition(vertex_data.GetData(), vertex_stride, indices[t * 3 + i]);
+                    const f32 u = (GetComponent(p, u_axis) - GetComponent(min, u_axis)) * scale;
+                    // Looking from the other side mirrors the image, which keeps front faces counter-clockwise.
+                    us[i] = direction > 0.0f ? u : static_cast<f32>(k_overdraw_resolution) - u;
+                    vs[i] = (GetComponent(p, v_axis) - GetComponent(min, v_axis)) * scale;
+                    depths[i] = -direction * GetComponent(p, axis);
+                }
+
+                const f32 area = (us[1] - us[0]) * (vs[2] - vs[0]) - (us[2] - us[0]) * (vs[1] - vs[0]);
+                if (area <= 0.0f)
+                {
+                    continue;
+                }
+                const f32 inverse_area = 1.0f / area;
+
+                const auto min_x = static_cast<i32>(std::max(std::floor(std::min({us[0], us[1], us[2]})), 0.0f));
+                const auto min_y = static_cast<i32>(std::max(std::floor(std::min({vs[0], vs[1], vs[2]})), 0.0f));
+                const i32 max_pixel = static_cast<i32>(k_overdraw_resolution) - 1;
+                const i32 max_x = std::min(static_cast<i32>(std::ceil(std::max({us[0], us[1], us[2]}))), max_pixel);
+                const i32 max_y = std::min(static_cast<i32>(std::ceil(std::max({vs[0], vs[1], vs[2]}))), max_pixel);
+                for (i32 y = min_y; y <= max_y; ++y)
+                {
+                    for (i32 x = min_x; x <= max_x; ++x)
+                    {
+                        const f32 px = static_cast<f32>(x) + 0.5f;
+                        const f32 py = static_cast<f32>(y) + 0.5f;
+                        const f32 w0 = ((us[1] - px) * (vs[2] - py) - (us[2] - px) * (vs[1] - py)) * inverse_area;
+                        const f32 w1 = ((us[2] - px) * (vs[0] - py) - (us[0] - px) * (vs[2] - py)) * inverse_area;
+                        const f32 w2 = 1.0f - w0 - w1;
+                        if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                        {
+                            continue;
+                        }
+
+                        const f32 depth = w0 * depths[0] + w1 * depths[1] + w2 * depths[2];
+                        f32& stored_depth = depth_buffer[static_cast<u64>(y) * k_overdraw_resolution + static_cast<u64>(x)];
+                        if (stored_depth == std::numeric_limits<f32>::max())
+                        {
+                            ++stats.covered_pixel_count;
+                        }
+                        if (depth < stored_depth)
+                        {
+                            stored_depth = depth;
+                            ++stats.shaded_pixel_count;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if (stats.covered_pixel_count > 0)
+    {
+        stats.overdraw_ratio = static_cast<f32>(stats.shaded_pixel_count) / static_cast<f32>(stats.covered_pixel_count);
+    }
+    return stats;
+}
+
+Rndr::VertexFetchStats Rndr::AnalyzeVertexFetch(Opal::ArrayView<const u32> indices, u32 vertex_count, u32 vertex_stride)
+{
+    VertexFetchStats stats;
+    FifoCache vertex_cache(vertex_count, k_default_vertex_cache_size);
+    Opal::DynamicArray<bool> referenced = CreateFilled<bool>(vertex_count, false);
+    u64 referenced_count = 0;
+
+    // Direct mapped cache of memory lines, tagged with the line address.
+    u64 lines[k_fetch_cache_line_count];
+    for (u64& line : lines)
+    {
+        line = std::numeric_limits<u64>::max();
+    }
+
+    for (u64 i = 0; i < indices.GetSize(); ++i)
+    {
+        const u32 v = indices[i];
+        if (!referenced[v])
+        {
+            referenced[v] = true;
+            ++referenced_count;
+        }
+        if (!vertex_cache.Access(v))
+        {
+            continue;
+        }
+
+        const u64 begin = static_cast<u64>(v) * vertex_stride;
+        const u64 end = begin + vertex_stride;
+        for (u64 line = begin / k_fetch_cache_line_size; line * k_fetch_cache_line_size < end; ++line)
+        {
+            u64& slot = lines[line % k_fetch_cache_line_count];
+            if (slot != line)
+            {
+                slot = line;
+                stats.fetched_byte_count += k_fetch_cache_line_size;
+            }
+        }
+    }
+
+    if (referenced_count > 0)
+    {
+        stats.overfetch_ratio = static_cast<f32>(stats.fetched_byte_count) / static_cast<f32>(referenced_count * vertex_stride);
+    }
+    return stats;
+}
@@ -0,0 +1,523 @@
+#include "rndr/mesh-simplifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "rndr/definitions.hpp"
+#include "rndr/mesh-optimizer.hpp"
+#include "rndr/trace.hpp"
+
+namespace
+{
+
+using Rndr::f32;
+using Rndr::u32;
+using Rndr::u64;
+using Rndr::u8;
+
+/** A collapse may not shrink a triangle below this fraction of its area. */
+constexpr f32 k_min_area_ratio = 1e-3f;
+constexpr f32 k_min_area_ratio_squared = k_min_area_ratio * k_min_area_ratio;
+
+template <typename T>
+Opal::DynamicArray<T> CreateFilled(u64 count, T value)
+{
+    Opal::DynamicArray<T> array(count);
+    for (u64 i = 0; i < count; ++i)
+    {
+        array[i] = value;
+    }
+    return array;
+}
+
+struct Position
+{
+    f32 x = 0.0f;
+    f32 y = 0.0f;
+    f32 z = 0.0f;
+};
+
+Position ReadPosition(const u8* vertex_data, u32 vertex_stride, u32 index)
+{
+    Position position;
+    memcpy(&position, vertex_data + static_cast<u64>(index) * vertex_stride, sizeof(position));
+    return position;
+}
+
+Position Subtract(const Position& a, const Position& b)
+{
+    return {a.x - b.x, a.y - b.y, a.z - b.z};
+}
+
+Position Cross(const Position& a, const Position& b)
+{
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+f32 Dot(const Position& a, const Position& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+struct BoundingSphere
+{
+    Position center;
+    f32 radius = 0.0f;
+};
+
+/** Sphere around the center of the bounding box. Not the smallest one, but cheap and stable. */
+BoundingSphere ComputeBoundingSphere(Opal::ArrayView<const u8> vertex_data, u32 vertex_stride)
+{
+    const auto vertex_count = static_cast<u32>(vertex_data.GetSize() / vertex_stride);
+    if (vertex_count == 0)
+    {
+        return {};
+    }
+    Position min = ReadPosition(vertex_data.GetData(), vertex_stride, 0);
+    Position max = min;
+    for (u32 v = 1; v < vertex_count; ++v)
+    {
+        const Position p = ReadPosition(vertex_data.GetData(), vertex_stride, v);
+        min = {std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z)};
+        max = {std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z)};
+    }
+
+    BoundingSphere sphere;
+    sphere.center = {(min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f};
+    f32 radius_squared = 0.0f;
+    for (u32 v = 0; v < vertex_count; ++v)
+    {
+        const Position offset = Subtract(ReadPosition(vertex_data.GetData(), vertex_stride, v), sphere.center);
+        radius_squared = std::max(radius_squared, Dot(offset, offset));
+    }
+    sphere.radius = std::sqrt(radius_squared);
+    return sphere;
+}
+
+/** Sum of squared distances to a set of planes, each weighted by the area of its triangle. */
+struct Quadric
+{
+    f32 a2 = 0.0f;
+    f32 ab = 0.0f;
+    f32 ac = 0.0f;
+    f32 ad = 0.0f;
+    f32 b2 = 0.0f;
+    f32 bc = 0.0f;
+    f32 bd = 0.0f;
+    f32 c2 = 0.0f;
+    f32 cd = 0.0f;
+    f32 d2 = 0.0f;
+    f32 weight = 0.0f;
+};
+
+void AddPlane(Quadric& quadric, const Position& normal, f32 distance, f32 weight)
+{
+    quadric.a2 += weight * normal.x * normal.x;
+    quadric.ab += weight * normal.x * normal.y;
+    quadric.ac += weight * normal.x * normal.z;
+    quadric.ad += weight * normal.x * distance;
+    quadric.b2 += weight * normal.y * normal.y;
+    quadric.bc += weight * normal.y * normal.z;
+    quadric.bd += weight * normal.y * distance;
+    quadric.c2 += weight * normal.z * normal.z;
+    quadric.cd += weight * normal.z * distance;
+    quadric.d2 += weight * distance * distance;
+    quadric.weight += weight;
+}
+
+void AddQuadric(Quadric& quadric, const Quadric& other)
+{
+    quadric.a2 += other.a2;
+    quadric.ab += other.ab;
+    quadric.ac += other.ac;
+    quadric.ad += other.ad;
+    quadric.b2 += other.b2;
+    quadric.bc += other.bc;
+    quadric.bd += other.bd;
+    quadric.c2 += other.c2;
+    quadric.cd += other.cd;
+    quadric.d2 += other.d2;
+    quadric.weight += other.weight;
+}
+
+/** @return Mean squared distance of the position to the planes of the quadric. */
+f32 EvaluateQuadric(const Quadric& q, const Position& p)
+{
+    if (q.weight <= 0.0f)
+    {
+        return 0.0f;
+    }
+    const f32 error = q.a2 * p.x * p.x + q.b2 * p.y * p.y + q.c2 * p.z * p.z + q.d2 +
+                      2.0f * (q.ab * p.x * p.y + q.ac * p.x * p.z + q.bc * p.y * p.z + q.ad * p.x + q.bd * p.y + q.cd * p.z);
+    return std::max(error, 0.0f) / q.weight;
+}
+
+struct Collapse
+{
+    u32 from = 0;
+    u32 to = 0;
+    f32 error_squared = 0.0f;
+};
+
+/** Vertices whose collapse would tear or shrink the surface: open and non-manifold edges, and vertices sharing a position. */
+Opal::DynamicArray<bool> FindLockedVertices(Opal::ArrayView<const u32> indices, const Opal::DynamicArray<Position>& positions)
+{
+    const auto vertex_count = static_cast<u32>(positions.GetSize());
+    Opal::DynamicArray<bool> locked = CreateFilled<bool>(vertex_count, false);
+
+    Opal::DynamicArray<u32> sorted_vertices(vertex_count);
+    for (u32 v = 0; v < vertex_count; ++v)
+    {
+        sorted_vertices[v] = v;
+    }
+    auto position_less = [&positions](u32 a, u32 b)
+    {
+        const Position& pa = positions[a];
+        const Position& pb = positions[b];
+        return pa.x != pb.x ? pa.x < pb.x : (pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z);
+    };
+    std::sort(sorted_vertices.GetData(), sorted_vertices.GetData() + vertex_count, position_less);
+    for (u32 i = 1; i < vertex_count; ++i)
+    {
+        if (!position_less(sorted_vertices[i - 1], sorted_vertices[i]))
+        {
+            locked[sorted_vertices[i - 1]] = true;
+            locked[sorted_vertices[i]] = true;
+        }
+    }
+
+    // A manifold interior edge is used by exactly two triangles.
+    Opal::DynamicArray<u64> edges(indices.GetSize());
+    for (u64 i = 0; i < indices.GetSize(); ++i)
+    {
+        const u32 a = indices[i];
+        const u32 b = indices[i % 3 == 2 ? i - 2 : i + 1];
+        edges[i] = (static_cast<u64>(std::min(a, b)) << 32) | std::max(a, b);
+    }
+    std::sort(edges.GetData(), edges.GetData() + edges.GetSize());
+    for (u64 i = 0; i < edges.GetSize();)
+    {
+        u64 end = i + 1;
+        while (end < edges.GetSize() && edges[end] == edges[i])
+        {
+            ++end;
+        }
+        if (end - i != 2)
+        {
+            locked[static_cast<u32>(edges[i] >> 32)] = true;
+            locked[static_cast<u32>(edges[i] & 0xFFFFFFFF)] = true;
+        }
+        i = end;
+    }
+    return locked;
+}
+
+/** @return True if moving vertex from onto vertex to turns a triangle of from over or makes it degenerate. */
+bool FlipsTriangle(Opal::ArrayView<const u32> indices, const Opal::DynamicArray<u32>& adjacency_offsets,
+                   const Opal::DynamicArray<u32>& adjacency, const Opal::DynamicArray<Position>& positions, u32 from, u32 to)
+{
+    for (u32 i = adjacency_offsets[from]; i < adjacency_offsets[from + 1]; ++i)
+    {
+        const u32* triangle = indices.GetData() + static_cast<u64>(adjacency[i]) * 3;
+        if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+        {
+            // This triangle collapses.
+            continue;
+        }
+        Position corners[3] = {positions[triangle[0]], positions[triangle[1]], positions[triangle[2]]};
+        const Position old_normal = Cross(Subtract(corners[1], corners[0]), Subtract(corners[2], corners[0]));
+        if (Dot(old_normal, old_normal) == 0.0f)
+        {
+            // Degenerate triangles have no facing to lose.
+            continue;
+        }
+        for (u32 k = 0; k < 3; ++k)
+        {
+            if (triangle[k] == from)
+            {
+                corners[k] = positions[to];
+            }
+        }
+        // Reject triangles that turn by more than 75 degrees or become slivers, not just the ones that flip.
+        const Position new_normal = Cross(Subtract(corners[1], corners[0]), Subtract(corners[2], corners[0]));
+        const f32 old_length_squared = Dot(old_normal, old_normal);
+        const f32 new_length_squared = Dot(new_normal, new_normal);
+        if (Dot(old_normal, new_normal) <= 0.25f * std::sqrt(old_length_squared * new_length_squared) ||
+            new_length_squared <= k_min_area_ratio_squared * old_length_squared)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+Opal::DynamicArray<Rndr::u32> Rndr::SimplifyMesh(Opal::ArrayView<const u32> indices, Opal::ArrayView<const u8> vertex_data,
+                                                 u32 vertex_stride, u32 target_index_count, f32 target_error,
+                                                 Opal::ArrayView<const f32> attribute_weights, f32* out_error)
+{
+    RNDR_CPU_EVENT_SCOPED("SimplifyMesh");
+
+    RNDR_ASSERT(indices.GetSize() % 3 == 0, "Index count must be a multiple of 3!");
+    RNDR_ASSERT(vertex_stride >= sizeof(Position) + attribute_weights.GetSize() * sizeof(f32), "Attributes don't fit in the vertex!");
+    const auto vertex_count = static_cast<u32>(vertex_data.GetSize() / vertex_stride);
+    const auto attribute_count = static_cast<u32>(attribute_weights.GetSize());
+
+    Opal::DynamicArray<u32> result(indices.GetSize());
+    for (u64 i = 0; i < indices.GetSize(); ++i)
+    {
+        RNDR_ASSERT(indices[i] < vertex_count, "Index out of range!");
+        result[i] = indices[i];
+    }
+    if (out_error != nullptr)
+    {
+        *out_error = 0.0f;
+    }
+    if (result.GetSize() <= target_index_count)
+    {
+        return result;
+    }
+
+    // Work on positions scaled to the unit sphere, so errors are relative to the mesh size. Attributes are pre-multiplied
+    // by their weights.
+    const BoundingSphere bounds = ComputeBoundingSphere(vertex_data, vertex_stride);
+    const f32 inverse_radius = bounds.radius > 0.0f ? 1.0f / bounds.radius : 1.0f;
+    Opal::DynamicArray<Position> positions(vertex_count);
+    Opal::DynamicArray<f32> attributes(static_cast<u64>(vertex_count) * attribute_count);
+    for (u32 v = 0; v < vertex_count; ++v)
+    {
+        const Position offset = Subtract(ReadPosition(vertex_data.GetData(), vertex_stride, v), bounds.center);
+        positions[v] = {offset.x * inverse_radius, offset.y * inverse_radius, offset.z * inverse_radius};
+        const u8* vertex = vertex_data.GetData() + static_cast<u64>(v) * vertex_stride + sizeof(Position);
+        for (u32 a = 0; a < attribute_count; ++a)
+        {
+            f32 attribute = 0.0f;
+            memcpy(&attribute, vertex + a * sizeof(f32), sizeof(f32));
+            attributes[static_cast<u64>(v) * attribute_count + a] = attribute * attribute_weights[a];
+        }
+    }
+
+    const Opal::DynamicArray<bool> locked = FindLockedVertices(indices, positions);
+
+    Opal::DynamicArray<Quadric> quadrics(vertex_count);
+    for (u64 i = 0; i < result.GetSize(); i += 3)
+    {
+        const Position& p0 = positions[result[i]];
+        const Position normal = Cross(Subtract(positions[result[i + 1]], p0), Subtract(positions[result[i + 2]], p0));
+        const f32 length = std::sqrt(Dot(normal, normal));
+        if (length == 0.0f)
+        {
+            continue;
+        }
+        const Position unit_normal = {normal.x / length, normal.y / length, normal.z / length};
+        const f32 distance = -Dot(unit_normal, p0);
+        for (u64 k = 0; k < 3; ++k)
+        {
+            AddPlane(quadrics[result[i + k]], unit_normal, distance, length * 0.5f);
+        }
+    }
+
+    const f32 target_error_squared = target_error * target_error;
+    f32 max_error_squared = 0.0f;
+    Opal::DynamicArray<u32> live_triangle_counts(vertex_count);
+    Opal::DynamicArray<u32> adjacency_offsets(static_cast<u64>(vertex_count) + 1);
+    Opal::DynamicArray<u32> collapse_targets(vertex_count);
+    Opal::DynamicArray<bool> touched(vertex_count);
+    Opal::DynamicArray<u64> edges;
+    Opal::DynamicArray<Collapse> collapses;
+
+    // Each pass collapses a set of independent edges, cheapest first, and then rebuilds the triangle list.
+    while (result.GetSize() > target_index_count)
+    {
+        const u64 triangle_count = result.GetSize() / 3;
+        const Opal::ArrayView<const u32> current(result.GetData(), result.GetSize());
+
+        for (u32 v = 0; v < vertex_count; ++v)
+        {
+            live_triangle_counts[v] = 0;
+        }
+        for (u64 i = 0; i < result.GetSize(); ++i)
+        {
+            ++live_triangle_counts[result[i]];
+        }
+        adjacency_offsets[0] = 0;
+        for (u32 v = 0; v < vertex_count; ++v)
+        {
+            adjacency_offsets[v + 1] = adjacency_offsets[v] + live_triangle_counts[v];
+            live_triangle_counts[v] = 0;
+        }
+        Opal::DynamicArray<u32> adjacency(result.GetSize());
+        for (u64 i = 0; i < result.GetSize(); ++i)
+        {
+            const u32 v = result[i];
+            adjacency[adjacency_offsets[v] + live_triangle_counts[v]++] = static_cast<u32>(i / 3);
+        }
+
+        edges.Resize(result.GetSize());
+        for (u64 i = 0; i < result.GetSize(); ++i)
+        {
+            const u32 a = result[i];
+            const u32 b = result[i % 3 == 2 ? i - 2 : i + 1];
+            edges[i] = (static_cast<u64>(std::min(a, b)) << 32) | std::max(a, b);
+        }
+        std::sort(edges.GetData(), edges.GetData() + edges.GetSize());
+
+        collapses.Resize(0);
+        for (u64 i = 0; i < edges.GetSize(); ++i)
+        {
+            if (i > 0 && edges[i] == edges[i - 1])
+            {
+                continue;
+            }
+            const auto a = static_cast<u32>(edges[i] >> 32);
+            const auto b = static_cast<u32>(edges[i] & 0xFFFFFFFF);
+            f32 attribute_error = 0.0f;
+            for (u32 k = 0; k < attribute_count; ++k)
+            {
+                const f32 difference =
+                    attributes[static_cast<u64>(a) * attribute_count + k] - attributes[static_cast<u64>(b) * attribute_count + k];
+                attribute_error += difference * difference;
+            }
+            Collapse collapse{.from = a, .to = b, .error_squared = -1.0f};
+            if (!locked[a])
+            {
+                collapse.error_squared = EvaluateQuadric(quadrics[a], positions[b]) + attribute_error;
+            }
+            if (!locked[b])
+            {
+                const f32 error_squared = EvaluateQuadric(quadrics[b], positions[a]) + attribute_error;
+                if (collapse.error_squared < 0.0f || error_squared < collapse.error_squared)
+                {
+                    collapse = {.from = b, .to = a, .error_squared = error_squared};
+                }
+            }
+            if (collapse.error_squared >= 0.0f && collapse.error_squared <= target_error_squared)
+            {
+                collapses.PushBack(collapse);
+            }
+        }
+        std::sort(collapses.GetData(), collapses.GetData() + collapses.GetSize(),
+                  [](const Collapse& a, const Collapse& b) { return a.error_squared < b.error_squared; });
+
+        for (u32 v = 0; v < vertex_count; ++v)
+        {
+            collapse_targets[v] = v;
+            touched[v] = false;
+        }
+        const u64 triangles_to_remove = triangle_count - target_index_count / 3;
+        u64 removed_triangle_count = 0;
+        u64 collapse_count = 0;
+        for (u64 i = 0; i < collapses.GetSize() && removed_triangle_count < triangles_to_remove; ++i)
+        {
+            const Collapse& collapse = collapses[i];
+            if (touched[collapse.from] || touched[collapse.to] ||
+                FlipsTriangle(current, adjacency_offsets, adjacency, positions, collapse.from, collapse.to))
+            {
+                continue;
+            }
+
+            collapse_targets[collapse.from] = collapse.to;
+            AddQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+            max_error_squared = std::max(max_error_squared, collapse.error_squared);
+            ++collapse_count;
+
+            // Triangles around the collapsed vertex changed, so their vertices wait for the next pass.
+            for (u32 j = adjacency_offsets[collapse.from]; j < adjacency_offsets[collapse.from + 1]; ++j)
+            {
+                const u32* triangle = result.GetData() + static_cast<u64>(adjacency[j]) * 3;
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                {
+                    ++removed_triangle_count;
+                }
+                touched[triangle[0]] = true;
+                touched[triangle[1]] = true;
+                touched[triangle[2]] = true;
+            }
+        }
+        if (collapse_count == 0)
+        {
+            break;
+        }
+
+        u64 write = 0;
+        for (u64 i = 0; i < result.GetSize(); i += 3)
+        {
+            const u32 a = collapse_targets[result[i]];
+            const u32 b = collapse_targets[result[i + 1]];
+            const u32 c = collapse_targets[result[i + 2]];
+            if (a != b && b != c && a != c)
+            {
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+        }
+        result.Resize(write);
+    }
+
+    if (out_error != nullptr)
+    {
+        *out_error = std::sqrt(max_error_squared);
+    }
+    return result;
+}
+
+Rndr::MeshLodChain Rndr::GenerateMeshLods(Opal::ArrayView<const u32> indices, Opal::ArrayView<const u8> vertex_data, u32 vertex_stride,
+                                          Opal::DynamicArray<u32>& out_indices, const MeshLodDesc& desc)
+{
+    RNDR_CPU_EVENT_SCOPED("GenerateMeshLods");
+
+    const auto vertex_count = static_cast<u32>(vertex_data.GetSize() / vertex_stride);
+    const BoundingSphere bounds = ComputeBoundingSphere(vertex_data, vertex_stride);
+
+    MeshLodChain lod_chain;
+    lod_chain.bounds_center = Point3f(bounds.center.x, bounds.center.y, bounds.center.z);
+    lod_chain.bounds_radius = bounds.radius;
+
+    out_indices.Resize(indices.GetSize());
+    for (u64 i = 0; i < indices.GetSize(); ++i)
+    {
+        out_indices[i] = indices[i];
+    }
+    lod_chain.lods.PushBack({.first_index = 0, .index_count = static_cast<u32>(indices.GetSize()), .error = 0.0f});
+
+    while (lod_chain.lods.GetSize() < desc.max_lod_count)
+    {
+        const MeshLod previous = lod_chain.lods.Back();
+        const auto target_index_count = static_cast<u32>(static_cast<f32>(previous.index_count) * desc.reduction) / 3 * 3;
+        f32 error = 0.0f;
+        Opal::DynamicArray<u32> lod_indices =
+            SimplifyMesh(Opal::ArrayView<const u32>(out_indices.GetData() + previous.first_index, previous.index_count), vertex_data,
+                         vertex_stride, target_index_count, desc.max_error, desc.attribute_weights, &error);
+        if (lod_indices.IsEmpty() || static_cast<f32>(lod_indices.GetSize()) > static_cast<f32>(previous.index_count) * desc.max_kept_ratio)
+        {
+            break;
+        }
+        OptimizeVertexCache(Opal::ArrayView<u32>(lod_indices.GetData(), lod_indices.GetSize()), vertex_count);
+
+        const MeshLod lod{.first_index = static_cast<u32>(out_indices.GetSize()),
+                          .index_count = static_cast<u32>(lod_indices.GetSize()),
+                          .error = previous.error + error};
+        out_indices.Resize(out_indices.GetSize() + lod_indices.GetSize());
+        memcpy(out_indices.GetData() + lod.first_index, lod_indices.GetData(), lod_indices.GetSize() * sizeof(u32));
+        lod_chain.lods.PushBack(lod);
+    }
+    return lod_chain;
+}
+
+Rndr::u32 Rndr::SelectMeshLod(Opal::ArrayView<const MeshLod> lods, f32 projected_radius, f32 max_screen_error)
+{
+    // Errors grow along the chain, so the first LOD that is too coarse ends the search.
+    u32 selected = 0;
+    for (u32 i = 1; i < lods.GetSize(); ++i)
+    {
+        if (lods[i].error * projected_radius > max_screen_error)
+        {
+            break;
+        }
+        selected = i;
+    }
+    return selected;
+}
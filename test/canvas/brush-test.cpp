@@ -1,6 +1,12 @@
 #include <catch2/catch2.hpp>
 
+#include <cstring>
+#include <string>
+
 #include "opal/container/scope-ptr.h"
+#include "opal/paths.h"
+
+#include "core/parameter-blocks.hpp"
 
 #include "rndr/application.hpp"
 #include "rndr/canvas/brush.hpp"
@@ -10,6 +16,10 @@
 #include "rndr/canvas/texture.hpp"
 #include "rndr/generic-window.hpp"
 
+#if RNDR_GENERATED_PARAMETER_BLOCKS
+#include "generated/shaders/canvas-pbr.hpp"
+#endif
+
 namespace
 {
 
@@ -185,6 +195,46 @@ FSOutput FragmentMain(VSOutput input)
 }
 )";
 
+/** Parameter block of k_uniform_shader, laid out like the generated struct. */
+struct MaterialBlock
+{
+    static constexpr Rndr::i32 k_binding_index = 0;
+    static constexpr Rndr::i32 k_binding_space = 0;
+
+    float color[4];
+    float roughness;
+};
+
+/** Block with the binding of MaterialBlock but the wrong size. */
+struct TruncatedMaterialBlock
+{
+    static constexpr Rndr::i32 k_binding_index = 0;
+    static constexpr Rndr::i32 k_binding_space = 0;
+
+    float color[4];
+};
+
+Rndr::ShaderParameter CreateUniform(const char* name, Rndr::i32 binding_index, Rndr::i32 offset, Rndr::i32 size,
+                                    Rndr::ScalarType scalar_type = Rndr::ScalarType::Unknown, Rndr::u8 row_count = 0,
+                                    Rndr::u8 column_count = 0)
+{
+    Rndr::ShaderParameter param;
+    param.name = name;
+    param.binding_index = binding_index;
+    param.offset = offset;
+    param.size = size;
+    param.category = Rndr::ParameterCategory::Uniform;
+    param.scalar_type = scalar_type;
+    param.row_count = row_count;
+    param.column_count = column_count;
+    return param;
+}
+
+bool Contains(const Opal::StringUtf8& str, const char* substring)
+{
+    return std::string(reinterpret_cast<const char*>(str.GetData()), str.GetSize()).find(substring) != std::string::npos;
+}
+
 }  // namespace
 
 TEST_CASE("Canvas BrushDesc defaults", "[canvas][brush]")
@@ -279,6 +329,25 @@ TEST_CASE("Canvas Brush", "[canvas][brush]")
         REQUIRE(brush.GetDesc().depth_bias_units == 3.0f);
     }
 
+    SECTION("Brushes with equal state share the pipeline state id")
+    {
+        Rndr::Canvas::Brush const default_brush;
+        REQUIRE(default_brush.GetPipelineStateId() == 0);
+
+        Rndr::Canvas::BrushDesc desc;
+        desc.depth_test = true;
+        desc.cull_mode = Rndr::Canvas::CullMode::Front;
+        Rndr::Canvas::Brush const from_desc(desc);
+        REQUIRE(from_desc.GetPipelineStateId() != 0);
+
+        Rndr::Canvas::Brush from_setters;
+        from_setters.SetDepthTest(true);
+        REQUIRE(from_setters.GetPipelineStateId() != from_desc.GetPipelineStateId());
+        from_setters.SetCullMode(Rndr::Canvas::CullMode::Front);
+        REQUIRE(from_setters.GetPipelineStateId() == from_desc.GetPipelineStateId());
+        REQUIRE(from_desc.Clone().GetPipelineStateId() == from_desc.GetPipelineStateId());
+    }
+
     SECTION("SetUniform stores value by name")
     {
         Rndr::Canvas::Brush brush;
@@ -502,7 +571,7 @@ TEST_CASE("Canvas Brush", "[canvas][brush]")
         brush.SetShader(shader);
 
         REQUIRE(brush.GetUniformBufferSlots().GetSize() == 1);
-        REQUIRE(brush.GetUniformBufferSlots()[0].gpu_buffer.IsValid());
+        REQUIRE_FALSE(brush.GetUniformBufferSlots()[0].cpu_data.IsEmpty());
         REQUIRE(brush.GetUniformBufferSlots()[0].dirty == false);
     }
 
@@ -513,7 +582,7 @@ TEST_CASE("Canvas Brush", "[canvas][brush]")
         brush.SetShader(shader);
 
         REQUIRE(brush.GetUniformBufferSlots().GetSize() >= 1);
-        REQUIRE(brush.GetUniformBufferSlots()[0].gpu_buffer.IsValid());
+        REQUIRE_FALSE(brush.GetUniformBufferSlots()[0].cpu_data.IsEmpty());
     }
 
     SECTION("SetShader with no uniforms creates no UBO slots")
@@ -577,7 +646,7 @@ TEST_CASE("Canvas Brush", "[canvas][brush]")
         const Rndr::Canvas::Brush moved(std::move(brush));
         REQUIRE(moved.IsValid());
         REQUIRE(moved.GetUniformBufferSlots().GetSize() == 1);
-        REQUIRE(moved.GetUniformBufferSlots()[0].gpu_buffer.IsValid());
+        REQUIRE_FALSE(moved.GetUniformBufferSlots()[0].cpu_data.IsEmpty());
     }
 
     SECTION("Clone deep-copies UBO slots")
@@ -591,7 +660,7 @@ TEST_CASE("Canvas Brush", "[canvas][brush]")
 
         Rndr::Canvas::Brush const clone = brush.Clone();
         REQUIRE(clone.GetUniformBufferSlots().GetSize() == 1);
-        REQUIRE(clone.GetUniformBufferSlots()[0].gpu_buffer.IsValid());
+        REQUIRE_FALSE(clone.GetUniformBufferSlots()[0].cpu_data.IsEmpty());
         REQUIRE(clone.GetUniformBufferSlots()[0].dirty == true);
 
         // Original still valid.
@@ -744,4 +813,415 @@ TEST_CASE("Canvas Brush", "[canvas][brush]")
         const float4 value = {1.0f, 0.0f, 0.0f, 1.0f};
         REQUIRE_THROWS(brush.SetUniform("light_colors", static_cast<Rndr::i32>(-1), value));
     }
+
+    SECTION("Uniform handle resolves to the parameter's block")
+    {
+        Rndr::Canvas::Shader const shader = Rndr::Canvas::Shader::FromSourceInMemory(k_array_uniform_shader);
+        const Rndr::Canvas::ShaderParameter* param = shader.FindParameter("light_colors");
+        REQUIRE(param != nullptr);
+
+        const Rndr::Canvas::UniformHandle handle = shader.GetUniformHandle("light_colors");
+        REQUIRE(handle.IsValid());
+        REQUIRE(handle.offset == param->offset);
+        REQUIRE(handle.array_element_count == param->array_element_count);
+        REQUIRE(handle.array_stride == param->array_stride);
+
+        const Rndr::Canvas::UniformBlock& block = shader.GetUniformBlocks()[static_cast<Rndr::u64>(handle.block_index)];
+        REQUIRE(block.binding_index == param->binding_index);
+        REQUIRE(block.binding_space == param->binding_space);
+        REQUIRE_FALSE(shader.GetUniformHandle("nonexistent").IsValid());
+    }
+
+    SECTION("SetUniform with handle writes the same data as by name")
+    {
+        Rndr::Canvas::Shader const shader = Rndr::Canvas::Shader::FromSourceInMemory(k_array_uniform_shader);
+        Rndr::Canvas::Brush by_name;
+        by_name.SetShader(shader);
+        Rndr::Canvas::Brush by_handle;
+        by_handle.SetShader(shader);
+
+        struct float4
+        {
+            float x, y, z, w;
+        };
+        const float4 col0 = {1.0f, 0.0f, 0.0f, 1.0f};
+        const float4 col1 = {0.0f, 1.0f, 0.0f, 1.0f};
+        const Rndr::u32 count = 2;
+        by_name.SetUniform("light_count", count);
+        by_name.SetUniform("light_colors", static_cast<Rndr::i32>(0), col0);
+        by_name.SetUniform("light_colors", static_cast<Rndr::i32>(1), col1);
+
+        const Rndr::Canvas::UniformHandle count_handle = shader.GetUniformHandle("light_count");
+        const Rndr::Canvas::UniformHandle colors_handle = shader.GetUniformHandle("light_colors");
+        by_handle.SetUniform(count_handle, count);
+        by_handle.SetUniform(colors_handle, 0, col0);
+        by_handle.SetUniform(colors_handle, 1, col1);
+
+        REQUIRE(by_handle.GetUniforms().IsEmpty());
+        const auto& name_slots = by_name.GetUniformBufferSlots();
+        const auto& handle_slots = by_handle.GetUniformBufferSlots();
+        REQUIRE(name_slots.GetSize() == handle_slots.GetSize());
+        for (Rndr::u64 i = 0; i < name_slots.GetSize(); ++i)
+        {
+            REQUIRE(handle_slots[i].dirty == name_slots[i].dirty);
+            REQUIRE(memcmp(handle_slots[i].cpu_data.GetData(), name_slots[i].cpu_data.GetData(), name_slots[i].cpu_data.GetSize()) == 0);
+        }
+    }
+
+    SECTION("SetUniform with invalid handle does nothing")
+    {
+        Rndr::Canvas::Shader const shader = Rndr::Canvas::Shader::FromSourceInMemory(k_uniform_shader);
+        Rndr::Canvas::Brush brush;
+        brush.SetShader(shader);
+
+        const float value = 1.0f;
+        brush.SetUniform(Rndr::Canvas::UniformHandle{}, value);
+        REQUIRE(brush.GetUniforms().IsEmpty());
+        for (Rndr::u64 i = 0; i < brush.GetUniformBufferSlots().GetSize(); ++i)
+        {
+            REQUIRE_FALSE(brush.GetUniformBufferSlots()[i].dirty);
+        }
+    }
+
+#if RNDR_HARDENING
+    SECTION("SetUniform with handle validates size and index in hardened builds")
+    {
+        Rndr::Canvas::Shader const shader = Rndr::Canvas::Shader::FromSourceInMemory(k_array_uniform_shader);
+        Rndr::Canvas::Brush brush;
+        brush.SetShader(shader);
+
+        struct float4
+        {
+            float x, y, z, w;
+        };
+        const float4 value = {1.0f, 0.0f, 0.0f, 1.0f};
+        const Rndr::Canvas::UniformHandle count_handle = shader.GetUniformHandle("light_count");
+        const Rndr::Canvas::UniformHandle colors_handle = shader.GetUniformHandle("light_colors");
+        REQUIRE_THROWS(brush.SetUniform(count_handle, value));
+        REQUIRE_THROWS(brush.SetUniform(colors_handle, 4, value));
+        REQUIRE_THROWS(brush.SetUniform(colors_handle, -1, value));
+
+        Rndr::Canvas::Brush no_shader;
+        REQUIRE_THROWS(no_shader.SetUniform(colors_handle, 0, value));
+    }
+#endif
+}
+
+TEST_CASE("Canvas Brush state cache", "[canvas][brush]")
+{
+    BrushTestFixture f;
+    Rndr::Canvas::Shader const shader = Rndr::Canvas::Shader::FromSourceInMemory(k_simple_shader);
+    Rndr::Canvas::Brush brush;
+    brush.SetShader(shader);
+
+    SECTION("First apply issues calls")
+    {
+        f.context.ResetStateCacheStats();
+        brush.Apply();
+        REQUIRE(f.context.GetStateCacheStats().issued_calls > 0);
+    }
+
+    SECTION("Applying the same brush twice skips all calls")
+    {
+        brush.Apply();
+        f.context.ResetStateCacheStats();
+        brush.Apply();
+        const Rndr::Canvas::StateCacheStats stats = f.context.GetStateCacheStats();
+        REQUIRE(stats.issued_calls == 0);
+        REQUIRE(stats.skipped_calls > 0);
+    }
+
+    SECTION("Brush with the same pipeline state skips the whole state")
+    {
+        brush.Apply();
+        Rndr::Canvas::Brush other(brush.GetDesc());
+        other.SetShader(shader);
+        REQUIRE(other.GetPipelineStateId() == brush.GetPipelineStateId());
+        f.context.ResetStateCacheStats();
+        other.Apply();
+        REQUIRE(f.context.GetStateCacheStats().issued_calls == 0);
+    }
+
+    SECTION("Only changed state is issued")
+    {
+        brush.Apply();
+        Rndr::Canvas::BrushDesc desc = brush.GetDesc();
+        desc.fill_mode = Rndr::Canvas::FillMode::Wireframe;
+        Rndr::Canvas::Brush wireframe_brush(desc);
+        wireframe_brush.SetShader(shader);
+        f.context.ResetStateCacheStats();
+        wireframe_brush.Apply();
+        const Rndr::Canvas::StateCacheStats stats = f.context.GetStateCacheStats();
+        REQUIRE(stats.issued_calls >= 1);
+        REQUIRE(stats.skipped_calls > 0);
+    }
+
+    SECTION("Invalidate forces calls to be issued again")
+    {
+        brush.Apply();
+        f.context.InvalidateStateCache();
+        f.context.ResetStateCacheStats();
+        brush.Apply();
+        REQUIRE(f.context.GetStateCacheStats().issued_calls > 0);
+    }
+}
+
+TEST_CASE("Canvas Brush uniform ring buffer", "[canvas][brush]")
+{
+    BrushTestFixture f;
+    Rndr::Canvas::Shader const shader = Rndr::Canvas::Shader::FromSourceInMemory(k_uniform_shader);
+    Rndr::Canvas::Brush brush;
+    brush.SetShader(shader);
+    const float roughness = 0.25f;
+    brush.SetUniform("roughness", roughness);
+
+    SECTION("Upload copies the slots into the ring")
+    {
+        REQUIRE(brush.GetUniformBufferSlots()[0].ring_generation == 0);
+        brush.UploadUniforms();
+        REQUIRE(brush.GetUniformBufferSlots()[0].ring_generation != 0);
+        REQUIRE_FALSE(brush.GetUniformBufferSlots()[0].dirty);
+    }
+
+    SECTION("Clean slots are not copied again in the same frame")
+    {
+        brush.UploadUniforms();
+        const Rndr::u64 offset = brush.GetUniformBufferSlots()[0].ring_offset;
+        brush.UploadUniforms();
+        REQUIRE(brush.GetUniformBufferSlots()[0].ring_offset == offset);
+    }
+
+    SECTION("Dirty slots get a new allocation")
+    {
+        brush.UploadUniforms();
+        const Rndr::u64 offset = brush.GetUniformBufferSlots()[0].ring_offset;
+        brush.SetUniform("roughness", roughness);
+        brush.UploadUniforms();
+        REQUIRE(brush.GetUniformBufferSlots()[0].ring_offset != offset);
+    }
+
+    SECTION("Present makes earlier copies stale")
+    {
+        brush.UploadUniforms();
+        const Rndr::u64 generation = brush.GetUniformBufferSlots()[0].ring_generation;
+        f.context.Present();
+        brush.UploadUniforms();
+        REQUIRE(brush.GetUniformBufferSlots()[0].ring_generation != generation);
+    }
+
+    SECTION("Frames larger than the ring still upload")
+    {
+        for (int i = 0; i < 100000; ++i)
+        {
+            brush.SetUniform("roughness", roughness);
+            REQUIRE_NOTHROW(brush.Apply());
+        }
+    }
+}
+
+TEST_CASE("Canvas Brush instances", "[canvas][brush]")
+{
+    BrushTestFixture f;
+    Rndr::Canvas::Shader const shader = Rndr::Canvas::Shader::FromSourceInMemory(k_uniform_shader);
+    const Rndr::Canvas::UniformHandle roughness_handle = shader.GetUniformHandle("roughness");
+    REQUIRE(roughness_handle.IsValid());
+
+    Rndr::Canvas::Brush parent(Rndr::Canvas::BrushDesc{.depth_test = true});
+    parent.SetShader(shader);
+    const float parent_roughness = 0.25f;
+    parent.SetUniform(roughness_handle, parent_roughness);
+
+    const auto read_roughness = [&roughness_handle](const Rndr::Canvas::Brush& brush)
+    {
+        float value = 0.0f;
+        memcpy(&value, brush.GetUniformData(0).GetData() + roughness_handle.offset, sizeof(value));
+        return value;
+    };
+
+    SECTION("Instance shares the parent's shader, state and uniforms")
+    {
+        Rndr::Canvas::Brush const instance = parent.CreateInstance("Instance");
+        REQUIRE(instance.IsValid());
+        REQUIRE(instance.GetParent() == &parent);
+        REQUIRE(instance.GetShader() == &shader);
+        REQUIRE(instance.GetPipelineStateId() == parent.GetPipelineStateId());
+        REQUIRE(instance.GetUniformBufferSlots()[0].inherited);
+        REQUIRE(instance.GetUniformBufferSlots()[0].cpu_data.IsEmpty());
+        REQUIRE(read_roughness(instance) == parent_roughness);
+    }
+
+    SECTION("Writing to an instance copies the block")
+    {
+        Rndr::Canvas::Brush instance = parent.CreateInstance();
+        const float instance_roughness = 0.75f;
+        instance.SetUniform(roughness_handle, instance_roughness);
+        REQUIRE_FALSE(instance.GetUniformBufferSlots()[0].inherited);
+        REQUIRE(read_roughness(instance) == instance_roughness);
+        REQUIRE(read_roughness(parent) == parent_roughness);
+
+        // The copied block no longer follows the parent.
+        const float new_parent_roughness = 0.5f;
+        parent.SetUniform(roughness_handle, new_parent_roughness);
+        REQUIRE(read_roughness(instance) == instance_roughness);
+    }
+
+    SECTION("Parent changes are seen by inherited blocks and re-uploaded")
+    {
+        Rndr::Canvas::Brush instance = parent.CreateInstance();
+        instance.UploadUniforms();
+        const Rndr::u64 offset = instance.GetUniformBufferSlots()[0].ring_offset;
+
+        const float new_parent_roughness = 0.5f;
+        parent.SetUniform(roughness_handle, new_parent_roughness);
+        REQUIRE(read_roughness(instance) == new_parent_roughness);
+        instance.UploadUniforms();
+        REQUIRE(instance.GetUniformBufferSlots()[0].ring_offset != offset);
+    }
+
+    SECTION("Instance of an instance and clones of an instance share the parent")
+    {
+        Rndr::Canvas::Brush const instance = parent.CreateInstance();
+        REQUIRE(instance.CreateInstance().GetParent() == &parent);
+        REQUIRE(instance.Clone().GetParent() == &parent);
+        REQUIRE(instance.Clone().GetUniformBufferSlots()[0].inherited);
+    }
+
+    SECTION("SetShader detaches an instance")
+    {
+        Rndr::Canvas::Brush instance = parent.CreateInstance();
+        instance.SetShader(shader);
+        REQUIRE(instance.GetParent() == nullptr);
+        REQUIRE_FALSE(instance.GetUniformBufferSlots()[0].inherited);
+    }
+
+    SECTION("Creating an instance requires a shader")
+    {
+        Rndr::Canvas::Brush const empty;
+        REQUIRE_THROWS(empty.CreateInstance());
+    }
+}
+
+TEST_CASE("Canvas Brush parameter blocks", "[canvas][brush]")
+{
+    BrushTestFixture f;
+    Rndr::Canvas::Shader const shader = Rndr::Canvas::Shader::FromSourceInMemory(k_uniform_shader);
+    REQUIRE(shader.GetUniformBlocks()[0].binding_index == MaterialBlock::k_binding_index);
+    REQUIRE(shader.GetUniformBlocks()[0].size == static_cast<Rndr::i32>(sizeof(MaterialBlock)));
+
+    Rndr::Canvas::Brush brush;
+    brush.SetShader(shader);
+    const MaterialBlock block = {.color = {1.0f, 0.5f, 0.25f, 1.0f}, .roughness = 0.75f};
+
+    SECTION("Writes the same data as per field writes")
+    {
+        Rndr::Canvas::Brush by_name;
+        by_name.SetShader(shader);
+        by_name.SetUniform("color", block.color);
+        by_name.SetUniform("roughness", block.roughness);
+
+        brush.SetParameterBlock(block);
+        REQUIRE(brush.GetUniformBufferSlots()[0].dirty);
+        REQUIRE(brush.GetUniforms().IsEmpty());
+        REQUIRE(memcmp(brush.GetUniformData(0).GetData(), by_name.GetUniformData(0).GetData(), sizeof(MaterialBlock)) == 0);
+    }
+
+    SECTION("Instance owns the block after the write")
+    {
+        Rndr::Canvas::Brush instance = brush.CreateInstance();
+        instance.SetParameterBlock(block);
+        REQUIRE_FALSE(instance.GetUniformBufferSlots()[0].inherited);
+        REQUIRE(memcmp(instance.GetUniformData(0).GetData(), &block, sizeof(MaterialBlock)) == 0);
+        REQUIRE(memcmp(brush.GetUniformData(0).GetData(), &block, sizeof(MaterialBlock)) != 0);
+    }
+
+    SECTION("Throws on a size mismatch or without a shader")
+    {
+        REQUIRE_THROWS(brush.SetParameterBlock(TruncatedMaterialBlock{}));
+        Rndr::Canvas::Brush no_shader;
+        REQUIRE_THROWS(no_shader.SetParameterBlock(block));
+    }
+}
+
+TEST_CASE("Canvas parameter block generation", "[canvas][brush]")
+{
+    using Rndr::ScalarType;
+
+    SECTION("Named block with padding")
+    {
+        Opal::DynamicArray<Rndr::ShaderParameter> params;
+        params.PushBack(CreateUniform("frame_constants", 1, 0, 0));
+        params.PushBack(CreateUniform("view_projection", 1, 0, 64, ScalarType::Float32, 4, 4));
+        params.PushBack(CreateUniform("camera_position", 1, 64, 12, ScalarType::Float32, 1, 3));
+        params.PushBack(CreateUniform("light_count", 1, 76, 4, ScalarType::UInt32, 1, 1));
+        params.PushBack(CreateUniform("exposure", 1, 96, 4, ScalarType::Float32, 1, 1));
+
+        const Opal::StringUtf8 header = Rndr::Impl::GenerateParameterBlocks(params, "test.slang", "Test::Shaders");
+        REQUIRE(Contains(header, "namespace Test::Shaders\n"));
+        REQUIRE(Contains(header, "struct FrameConstants\n"));
+        REQUIRE(Contains(header, "static constexpr Rndr::i32 k_binding_index = 1;"));
+        REQUIRE(Contains(header, "    Rndr::Matrix4x4f view_projection;\n    Rndr::Vector3f camera_position;\n    Rndr::u32 light_count;\n"
+                                 "    Rndr::u8 padding0[16];\n    Rndr::f32 exposure;\n"));
+        REQUIRE(Contains(header, "static_assert(sizeof(FrameConstants) == 100,"));
+        REQUIRE(Contains(header, "static_assert(offsetof(FrameConstants, exposure) == 96,"));
+    }
+
+    SECTION("Globals, arrays and fields without a matching type")
+    {
+        Opal::DynamicArray<Rndr::ShaderParameter> params;
+        params.PushBack(CreateUniform("directions", 0, 16, 64, ScalarType::Float32, 1, 3));
+        params.PushBack(CreateUniform("colors", 0, 80, 64, ScalarType::Float32, 1, 4));
+        params.PushBack(CreateUniform("flags", 0, 0, 12, ScalarType::UInt32, 1, 3));
+        params[0].array_element_count = 4;
+        params[0].array_stride = 16;
+        params[1].array_element_count = 4;
+        params[1].array_stride = 16;
+
+        const Opal::StringUtf8 header = Rndr::Impl::GenerateParameterBlocks(params, "test.slang", "Test");
+        REQUIRE(Contains(header, "struct Globals\n"));
+        REQUIRE(Contains(header, "    Rndr::u32 flags[3];\n    Rndr::u8 padding0[4];\n    Rndr::u8 directions[64];\n"
+                                 "    Rndr::Vector4f colors[4];\n"));
+        REQUIRE(Contains(header, "static_assert(sizeof(Globals) == 144,"));
+    }
+}
+
+#if RNDR_GENERATED_PARAMETER_BLOCKS
+TEST_CASE("Canvas generated parameter blocks", "[canvas][brush]")
+{
+    using FrameConstants = Rndr::Shaders::canvas_pbr::FrameConstants;
+
+    BrushTestFixture f;
+    const Opal::StringUtf8 shader_path = Opal::Paths::Combine(RNDR_CORE_ASSETS_DIR, "shaders", "canvas-pbr.slang");
+    Rndr::Canvas::Shader const shader = Rndr::Canvas::Shader::FromSource(shader_path, "PBR");
+
+    FrameConstants constants = {};
+    constants.camera_position = Rndr::Vector3f{1.0f, 2.0f, 3.0f};
+    constants.directional_light_count = 2;
+    constants.directional_light_colors[1] = Rndr::Vector4f{0.5f, 0.25f, 0.125f, 1.0f};
+    constants.point_light_count = 1;
+
+    Rndr::Canvas::Brush brush;
+    brush.SetShader(shader);
+    brush.SetParameterBlock(constants);
+
+    Rndr::Canvas::Brush by_name;
+    by_name.SetShader(shader);
+    by_name.SetUniform("camera_position", constants.camera_position);
+    by_name.SetUniform("directional_light_count", constants.directional_light_count);
+    by_name.SetUniform("directional_light_colors", 1, constants.directional_light_colors[1]);
+    by_name.SetUniform("point_light_count", constants.point_light_count);
+
+    const Opal::DynamicArray<Rndr::Canvas::UniformBufferSlot>& slots = brush.GetUniformBufferSlots();
+    bool found = false;
+    for (Rndr::u64 i = 0; i < slots.GetSize(); ++i)
+    {
+        if (slots[i].binding_index != FrameConstants::k_binding_index || slots[i].binding_space != FrameConstants::k_binding_space)
+        {
+            continue;
+        }
+        found = true;
+        REQUIRE(brush.GetUniformData(i).GetSize() == sizeof(FrameConstants));
+        REQUIRE(memcmp(brush.GetUniformData(i).GetData(), by_name.GetUniformData(i).GetData(), sizeof(FrameConstants)) == 0);
+    }
+    REQUIRE(found);
 }
+#endif
@@ -0,0 +1,157 @@
+#include <catch2/catch2.hpp>
+
+#include <cstring>
+
+#include "opal/container/scope-ptr.h"
+
+#include "rndr/application.hpp"
+#include "rndr/canvas/brush.hpp"
+#include "rndr/canvas/buffer.hpp"
+#include "rndr/canvas/compute-list.hpp"
+#include "rndr/canvas/context.hpp"
+#include "rndr/canvas/shader.hpp"
+#include "rndr/generic-window.hpp"
+
+namespace
+{
+
+Rndr::Canvas::Context CreateTestContext(Opal::ScopePtr<Rndr::Application>& app, Opal::Ref<Rndr::GenericWindow>& window)
+{
+    app = Rndr::Application::Create();
+    Rndr::GenericWindowDesc window_desc;
+    window_desc.start_visible = false;
+    window = app->CreateGenericWindow(window_desc);
+    return Rndr::Canvas::Context::Init(window.Clone());
+}
+
+struct ComputeListTestFixture
+{
+    Opal::ScopePtr<Rndr::Application> app;
+    Opal::Ref<Rndr::GenericWindow> window;
+    Rndr::Canvas::Context context;
+
+    ComputeListTestFixture() : context(CreateTestContext(app, window)) {}
+};
+
+const char* k_fill_shader = R"(
+RWStructuredBuffer<uint> output_buffer;
+
+[shader("compute")]
+[numthreads(64, 1, 1)]
+void ComputeMain(uint3 tid : SV_DispatchThreadID)
+{
+    output_buffer[tid.x] = tid.x;
+}
+)";
+
+const char* k_double_shader = R"(
+StructuredBuffer<uint> input_buffer;
+RWStructuredBuffer<uint> output_buffer;
+
+[shader("compute")]
+[numthreads(64, 1, 1)]
+void ComputeMain(uint3 tid : SV_DispatchThreadID)
+{
+    output_buffer[tid.x] = input_buffer[tid.x] * 2;
+}
+)";
+
+constexpr Rndr::u32 k_element_count = 64;
+
+}  // namespace
+
+TEST_CASE("Canvas ComputeList", "[canvas][computelist]")
+{
+    ComputeListTestFixture f;
+
+    Rndr::Canvas::Shader const fill_shader = Rndr::Canvas::Shader::FromSourceInMemory(k_fill_shader);
+    Rndr::Canvas::Shader const double_shader = Rndr::Canvas::Shader::FromSourceInMemory(k_double_shader);
+    constexpr Rndr::u64 k_buffer_size = k_element_count * sizeof(Rndr::u32);
+    Rndr::Canvas::Buffer buffer_a(Rndr::Canvas::BufferUsage::Storage, k_buffer_size);
+    Rndr::Canvas::Buffer buffer_b(Rndr::Canvas::BufferUsage::Storage, k_buffer_size);
+    Rndr::Canvas::Buffer buffer_c(Rndr::Canvas::BufferUsage::Storage, k_buffer_size);
+
+    Rndr::Canvas::Brush fill_a;
+    fill_a.SetShader(fill_shader);
+    fill_a.SetBuffer("output_buffer", buffer_a);
+    Rndr::Canvas::Brush fill_b;
+    fill_b.SetShader(fill_shader);
+    fill_b.SetBuffer("output_buffer", buffer_b);
+    Rndr::Canvas::Brush double_a_to_b;
+    double_a_to_b.SetShader(double_shader);
+    double_a_to_b.SetBuffer("input_buffer", buffer_a);
+    double_a_to_b.SetBuffer("output_buffer", buffer_b);
+    Rndr::Canvas::Brush double_a_to_c;
+    double_a_to_c.SetShader(double_shader);
+    double_a_to_c.SetBuffer("input_buffer", buffer_a);
+    double_a_to_c.SetBuffer("output_buffer", buffer_c);
+
+    Rndr::Canvas::ComputeList list;
+
+    SECTION("Reflection tells read-only and writable buffers apart")
+    {
+        REQUIRE_FALSE(double_shader.FindParameter("input_buffer")->writable);
+        REQUIRE(double_shader.FindParameter("output_buffer")->writable);
+    }
+
+    SECTION("Empty list issues no barriers")
+    {
+        list.Execute();
+        REQUIRE(list.GetStats().dispatch_count == 0);
+        REQUIRE(list.GetStats().barrier_count == 0);
+    }
+
+    SECTION("Independent dispatches share the final barrier")
+    {
+        list.Dispatch(fill_a, 1);
+        list.Dispatch(fill_b, 1);
+        REQUIRE(list.GetCommandCount() == 2);
+        list.Execute();
+        REQUIRE(list.GetCommandCount() == 0);
+        REQUIRE(list.GetStats().dispatch_count == 2);
+        REQUIRE(list.GetStats().barrier_count == 1);
+    }
+
+    SECTION("Read after write inserts a barrier")
+    {
+        list.Dispatch(fill_a, 1);
+        list.Dispatch(double_a_to_b, 1);
+        list.Execute();
+        REQUIRE(list.GetStats().barrier_count == 2);
+
+        const Opal::DynamicArray<Rndr::u8> data = buffer_b.ReadData();
+        REQUIRE(data.GetSize() == k_buffer_size);
+        Rndr::u32 values[k_element_count];
+        memcpy(values, data.GetData(), k_buffer_size);
+        for (Rndr::u32 i = 0; i < k_element_count; ++i)
+        {
+            REQUIRE(values[i] == i * 2);
+        }
+    }
+
+    SECTION("Write after write inserts a barrier")
+    {
+        list.Dispatch(fill_a, 1);
+        list.Dispatch(fill_a, 1);
+        list.Execute();
+        REQUIRE(list.GetStats().barrier_count == 2);
+    }
+
+    SECTION("Write after read inserts a barrier")
+    {
+        list.Dispatch(double_a_to_b, 1);
+        list.Dispatch(fill_a, 1);
+        list.Execute();
+        REQUIRE(list.GetStats().barrier_count == 2);
+    }
+
+    SECTION("Concurrent reads of the same buffer do not")
+    {
+        list.Dispatch(fill_a, 1);
+        list.Dispatch(double_a_to_b, 1);
+        list.Dispatch(double_a_to_c, 1);
+        list.Execute();
+        REQUIRE(list.GetStats().dispatch_count == 3);
+        REQUIRE(list.GetStats().barrier_count == 2);
+    }
+}
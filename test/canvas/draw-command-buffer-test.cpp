@@ -0,0 +1,394 @@
+#include <catch2/catch2.hpp>
+
+#include <cstring>
+
+#include "opal/container/dynamic-array.h"
+#include "opal/container/scope-ptr.h"
+#include "opal/exceptions.h"
+
+#include "rndr/application.hpp"
+#include "rndr/canvas/brush.hpp"
+#include "rndr/canvas/buffer.hpp"
+#include "rndr/canvas/context.hpp"
+#include "rndr/canvas/draw-command-buffer.hpp"
+#include "rndr/canvas/draw-list.hpp"
+#include "rndr/canvas/mesh.hpp"
+#include "rndr/canvas/render-target.hpp"
+#include "rndr/canvas/shader.hpp"
+#include "rndr/generic-window.hpp"
+
+namespace
+{
+
+Rndr::Canvas::Context CreateTestContext(Opal::ScopePtr<Rndr::Application>& app, Opal::Ref<Rndr::GenericWindow>& window)
+{
+    app = Rndr::Application::Create();
+    Rndr::GenericWindowDesc window_desc;
+    window_desc.start_visible = false;
+    window = app->CreateGenericWindow(window_desc);
+    return Rndr::Canvas::Context::Init(window.Clone());
+}
+
+struct DrawCommandBufferTestFixture
+{
+    Opal::ScopePtr<Rndr::Application> app;
+    Opal::Ref<Rndr::GenericWindow> window;
+    Rndr::Canvas::Context context;
+
+    DrawCommandBufferTestFixture() : context(CreateTestContext(app, window)) {}
+};
+
+const char* k_red_shader = R"(
+struct VSInput
+{
+    float3 position;
+};
+
+struct VSOutput
+{
+    float4 position : SV_POSITION;
+};
+
+[shader("vertex")]
+VSOutput VertexMain(VSInput input)
+{
+    VSOutput output;
+    output.position = float4(input.position, 1.0);
+    return output;
+}
+
+struct FSOutput
+{
+    float4 color : SV_TARGET;
+};
+
+[shader("fragment")]
+FSOutput FragmentMain(VSOutput input)
+{
+    FSOutput output;
+    output.color = float4(1.0, 0.0, 0.0, 1.0);
+    return output;
+}
+)";
+
+/** Writes one draw of each quad of k_quad_indices and counts the draws, like a culling pass would. */
+const char* k_generate_indexed_commands_shader = R"(
+struct DrawIndexedCommand
+{
+    uint index_count;
+    uint instance_count;
+    uint first_index;
+    int vertex_offset;
+    uint first_instance;
+};
+
+RWStructuredBuffer<DrawIndexedCommand> draw_commands;
+RWStructuredBuffer<uint> draw_count;
+
+[shader("compute")]
+[numthreads(2, 1, 1)]
+void ComputeMain(uint3 tid : SV_DispatchThreadID)
+{
+    uint slot;
+    InterlockedAdd(draw_count[0], 1, slot);
+    DrawIndexedCommand command;
+    command.index_count = 6;
+    command.instance_count = 1;
+    command.first_index = tid.x * 6;
+    command.vertex_offset = 0;
+    command.first_instance = 0;
+    draw_commands[slot] = command;
+}
+)";
+
+/** Writes a single draw of the left quad of k_quad_positions, without indices. */
+const char* k_generate_commands_shader = R"(
+struct DrawCommand
+{
+    uint vertex_count;
+    uint instance_count;
+    uint first_vertex;
+    uint first_instance;
+};
+
+RWStructuredBuffer<DrawCommand> draw_commands;
+RWStructuredBuffer<uint> draw_count;
+
+[shader("compute")]
+[numthreads(1, 1, 1)]
+void ComputeMain(uint3 tid : SV_DispatchThreadID)
+{
+    uint slot;
+    InterlockedAdd(draw_count[0], 1, slot);
+    DrawCommand command;
+    command.vertex_count = 6;
+    command.instance_count = 1;
+    command.first_vertex = 0;
+    command.first_instance = 0;
+    draw_commands[slot] = command;
+}
+)";
+
+// Two quads, covering the left and the right half of the render target.
+constexpr float k_quad_positions[] = {-1.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, -1.0f, 1.0f, 0.0f,
+                                      0.0f,  -1.0f, 0.0f, 1.0f, -1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f,  1.0f, 0.0f};
+constexpr Rndr::u32 k_quad_indices[] = {0, 1, 2, 0, 2, 3, 4, 5, 6, 4, 6, 7};
+constexpr Rndr::i32 k_target_size = 4;
+
+Rndr::Canvas::Mesh CreateQuadMesh()
+{
+    Rndr::Canvas::VertexLayout layout;
+    layout.Add(Rndr::Canvas::Attrib::Position, Rndr::Canvas::Format::Float3);
+    return Rndr::Canvas::Mesh(layout, {reinterpret_cast<const Rndr::u8*>(k_quad_positions), sizeof(k_quad_positions)},
+                              {reinterpret_cast<const Rndr::u8*>(k_quad_indices), sizeof(k_quad_indices)});
+}
+
+/**
+ * Quads of k_quad_positions expanded to a triangle list, for draws that read vertices in order. Mesh requires
+ * index data, so the indices just count up and non-indexed draws ignore them.
+ */
+Rndr::Canvas::Mesh CreateTriangleListQuadMesh()
+{
+    Opal::DynamicArray<float> positions;
+    Opal::DynamicArray<Rndr::u32> indices;
+    for (const Rndr::u32 index : k_quad_indices)
+    {
+        for (Rndr::u32 i = 0; i < 3; ++i)
+        {
+            positions.PushBack(k_quad_positions[index * 3 + i]);
+        }
+        indices.PushBack(static_cast<Rndr::u32>(indices.GetSize()));
+    }
+    Rndr::Canvas::VertexLayout layout;
+    layout.Add(Rndr::Canvas::Attrib::Position, Rndr::Canvas::Format::Float3);
+    return Rndr::Canvas::Mesh(layout, Opal::AsBytes(positions), Opal::AsBytes(indices));
+}
+
+/** @return True if the pixels in the columns [first_column, last_column] are red and all others are black. */
+bool HasRedColumns(const Opal::DynamicArray<Rndr::u8>& pixels, Rndr::i32 first_column, Rndr::i32 last_column)
+{
+    for (Rndr::i32 y = 0; y < k_target_size; ++y)
+    {
+        for (Rndr::i32 x = 0; x < k_target_size; ++x)
+        {
+            const Rndr::u8 expected_red = x >= first_column && x <= last_column ? 255 : 0;
+            const Rndr::u8* pixel = pixels.GetData() + (y * k_target_size + x) * 4;
+            if (pixel[0] != expected_red || pixel[1] != 0 || pixel[2] != 0)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+Rndr::u32 ReadDrawCount(const Rndr::Canvas::DrawCommandBuffer<Rndr::Canvas::DrawIndexedCommand>& commands)
+{
+    const Opal::DynamicArray<Rndr::u8> data = commands.GetCountBuffer().ReadData();
+    Rndr::u32 count = 0;
+    memcpy(&count, data.GetData(), sizeof(count));
+    return count;
+}
+
+}  // namespace
+
+TEST_CASE("Canvas DrawCommandBuffer", "[canvas][drawcommandbuffer]")
+{
+    using IndexedBuffer = Rndr::Canvas::DrawCommandBuffer<Rndr::Canvas::DrawIndexedCommand>;
+
+    DrawCommandBufferTestFixture f;
+
+    SECTION("Default constructed buffer is invalid")
+    {
+        IndexedBuffer const buffer;
+        REQUIRE_FALSE(buffer.IsValid());
+        REQUIRE(buffer.GetMaxCount() == 0);
+    }
+
+    SECTION("Create buffer")
+    {
+        IndexedBuffer const buffer(16);
+        REQUIRE(buffer.IsValid());
+        REQUIRE(buffer.GetMaxCount() == 16);
+        REQUIRE(buffer.GetCount() == 0);
+        REQUIRE(buffer.GetBuffer().GetSize() == 16 * sizeof(Rndr::Canvas::DrawIndexedCommand));
+        REQUIRE(buffer.GetCountBuffer().GetSize() == sizeof(Rndr::u32));
+    }
+
+    SECTION("Zero max count throws")
+    {
+        REQUIRE_THROWS_AS(IndexedBuffer(0), Opal::InvalidArgumentException);
+    }
+
+    SECTION("Add and Append stage commands")
+    {
+        IndexedBuffer buffer(4);
+        buffer.Add({.index_count = 36});
+        Opal::ArrayView<Rndr::Canvas::DrawIndexedCommand> commands = buffer.Append(2);
+        REQUIRE(commands.GetSize() == 2);
+        commands[0].index_count = 6;
+        commands[1].first_instance = 3;
+        REQUIRE(buffer.GetCount() == 3);
+        buffer.Upload();
+        REQUIRE(buffer.GetCount() == 3);
+    }
+
+    SECTION("Adding past max count throws")
+    {
+        Rndr::Canvas::DrawCommandBuffer<Rndr::Canvas::DrawCommand> buffer(1);
+        buffer.Add({.vertex_count = 3});
+        REQUIRE_THROWS_AS(buffer.Add({.vertex_count = 3}), Opal::InvalidArgumentException);
+        REQUIRE_THROWS_AS(buffer.Append(1), Opal::InvalidArgumentException);
+    }
+
+    SECTION("Clear removes staged commands")
+    {
+        IndexedBuffer buffer(4);
+        buffer.Add({.index_count = 36});
+        buffer.Clear();
+        REQUIRE(buffer.GetCount() == 0);
+    }
+
+    SECTION("Clone preserves staged commands")
+    {
+        IndexedBuffer buffer(4);
+        buffer.Add({.index_count = 36});
+        IndexedBuffer const clone = buffer.Clone();
+        REQUIRE(clone.IsValid());
+        REQUIRE(clone.GetMaxCount() == 4);
+        REQUIRE(clone.GetCount() == 1);
+        REQUIRE(clone.GetBuffer().GetNativeHandle() != buffer.GetBuffer().GetNativeHandle());
+    }
+
+    SECTION("Move transfers ownership")
+    {
+        IndexedBuffer buffer(4);
+        buffer.Add({.index_count = 36});
+        IndexedBuffer moved(std::move(buffer));
+        REQUIRE(moved.IsValid());
+        REQUIRE(moved.GetCount() == 1);
+        REQUIRE_FALSE(buffer.IsValid());
+    }
+}
+
+TEST_CASE("Canvas DrawList indirect draws", "[canvas][drawcommandbuffer]")
+{
+    using IndexedBuffer = Rndr::Canvas::DrawCommandBuffer<Rndr::Canvas::DrawIndexedCommand>;
+
+    DrawCommandBufferTestFixture f;
+
+    Rndr::Canvas::Mesh mesh = CreateQuadMesh();
+    Rndr::Canvas::Shader const red_shader = Rndr::Canvas::Shader::FromSourceInMemory(k_red_shader);
+    Rndr::Canvas::Brush red_brush;
+    red_brush.SetShader(red_shader);
+
+    Rndr::Canvas::Shader const generate_shader = Rndr::Canvas::Shader::FromSourceInMemory(k_generate_indexed_commands_shader);
+
+    Rndr::Canvas::RenderTargetDesc target_desc;
+    target_desc.AddColor(k_target_size, k_target_size);
+    Rndr::Canvas::RenderTarget target(f.context, target_desc);
+
+    Rndr::Canvas::DrawList list;
+    list.SetRenderTarget(target);
+    list.ClearColor({0.0f, 0.0f, 0.0f, 1.0f});
+
+    SECTION("CPU filled indexed commands draw several meshes")
+    {
+        IndexedBuffer commands(4);
+        commands.Add({.index_count = 6, .first_index = 0});
+        commands.Add({.index_count = 6, .first_index = 6});
+        list.DrawIndexedIndirect(mesh, red_brush, commands);
+        list.Execute();
+
+        REQUIRE(HasRedColumns(target.GetColorAttachment(0).ReadData(), 0, k_target_size - 1));
+        const Rndr::Canvas::DrawListStats& stats = list.GetStats();
+        REQUIRE(stats.indirect_draw_count == 1);
+        REQUIRE(stats.draw_count == 0);
+        REQUIRE(stats.triangle_count == 4);
+        REQUIRE(stats.instance_count == 2);
+    }
+
+    SECTION("CPU filled commands draw non-indexed geometry")
+    {
+        Rndr::Canvas::Mesh non_indexed_mesh = CreateTriangleListQuadMesh();
+        Rndr::Canvas::DrawCommandBuffer<Rndr::Canvas::DrawCommand> commands(4);
+        commands.Add({.vertex_count = 6, .first_vertex = 6});
+        list.DrawIndirect(non_indexed_mesh, red_brush, commands);
+        list.Execute();
+
+        REQUIRE(HasRedColumns(target.GetColorAttachment(0).ReadData(), k_target_size / 2, k_target_size - 1));
+        REQUIRE(list.GetStats().indirect_draw_count == 1);
+        REQUIRE(list.GetStats().triangle_count == 2);
+    }
+
+    SECTION("Empty CPU filled commands draw nothing")
+    {
+        IndexedBuffer commands(4);
+        list.DrawIndexedIndirect(mesh, red_brush, commands);
+        list.Execute();
+
+        REQUIRE(HasRedColumns(target.GetColorAttachment(0).ReadData(), k_target_size, k_target_size));
+        REQUIRE(list.GetStats().indirect_draw_count == 0);
+    }
+
+    SECTION("Indexed commands and count generated by a compute shader")
+    {
+        IndexedBuffer commands(4);
+        Rndr::Canvas::Brush generate_brush;
+        generate_brush.SetShader(generate_shader);
+        generate_brush.SetBuffer("draw_commands", commands.GetBuffer());
+        generate_brush.SetBuffer("draw_count", commands.GetCountBuffer());
+
+        list.ResetDrawCount(commands);
+        list.Dispatch(generate_brush, 1);
+        list.DrawIndexedIndirectCount(mesh, red_brush, commands);
+        list.Execute();
+
+        REQUIRE(ReadDrawCount(commands) == 2);
+        REQUIRE(HasRedColumns(target.GetColorAttachment(0).ReadData(), 0, k_target_size - 1));
+        const Rndr::Canvas::DrawListStats& stats = list.GetStats();
+        REQUIRE(stats.indirect_draw_count == 1);
+        REQUIRE(stats.dispatch_count == 1);
+        // Commands written on the GPU are not counted.
+        REQUIRE(stats.triangle_count == 0);
+    }
+
+    SECTION("Non-indexed commands and count generated by a compute shader")
+    {
+        Rndr::Canvas::Mesh non_indexed_mesh = CreateTriangleListQuadMesh();
+        Rndr::Canvas::DrawCommandBuffer<Rndr::Canvas::DrawCommand> commands(4);
+        Rndr::Canvas::Shader const generate_non_indexed_shader = Rndr::Canvas::Shader::FromSourceInMemory(k_generate_commands_shader);
+        Rndr::Canvas::Brush generate_brush;
+        generate_brush.SetShader(generate_non_indexed_shader);
+        generate_brush.SetBuffer("draw_commands", commands.GetBuffer());
+        generate_brush.SetBuffer("draw_count", commands.GetCountBuffer());
+
+        list.ResetDrawCount(commands);
+        list.Dispatch(generate_brush, 1);
+        list.DrawIndirectCount(non_indexed_mesh, red_brush, commands);
+        list.Execute();
+
+        REQUIRE(HasRedColumns(target.GetColorAttachment(0).ReadData(), 0, k_target_size / 2 - 1));
+        REQUIRE(list.GetStats().indirect_draw_count == 1);
+        REQUIRE(list.GetStats().triangle_count == 0);
+    }
+
+    SECTION("Draw count is reset on every execution of a baked list")
+    {
+        IndexedBuffer commands(4);
+        Rndr::Canvas::Brush generate_brush;
+        generate_brush.SetShader(generate_shader);
+        generate_brush.SetBuffer("draw_commands", commands.GetBuffer());
+        generate_brush.SetBuffer("draw_count", commands.GetCountBuffer());
+
+        list.ResetDrawCount(commands);
+        list.Dispatch(generate_brush, 1);
+        list.DrawIndexedIndirectCount(mesh, red_brush, commands);
+        Rndr::Canvas::BakedDrawList baked = list.Bake();
+
+        baked.Execute();
+        REQUIRE(ReadDrawCount(commands) == 2);
+        baked.Execute();
+        REQUIRE(ReadDrawCount(commands) == 2);
+    }
+}
@@ -0,0 +1,556 @@
+#include <catch2/catch2.hpp>
+
+#include <cstring>
+#include <thread>
+
+#include "opal/container/dynamic-array.h"
+#include "opal/container/scope-ptr.h"
+
+#include "rndr/application.hpp"
+#include "rndr/canvas/brush.hpp"
+#include "rndr/canvas/buffer.hpp"
+#include "rndr/canvas/context.hpp"
+#include "rndr/canvas/draw-list.hpp"
+#include "rndr/canvas/mesh.hpp"
+#include "rndr/canvas/render-target.hpp"
+#include "rndr/canvas/shader.hpp"
+#include "rndr/generic-window.hpp"
+
+namespace
+{
+
+Rndr::Canvas::Context CreateTestContext(Opal::ScopePtr<Rndr::Application>& app, Opal::Ref<Rndr::GenericWindow>& window)
+{
+    app = Rndr::Application::Create();
+    Rndr::GenericWindowDesc window_desc;
+    window_desc.start_visible = false;
+    window = app->CreateGenericWindow(window_desc);
+    return Rndr::Canvas::Context::Init(window.Clone());
+}
+
+struct DrawListTestFixture
+{
+    Opal::ScopePtr<Rndr::Application> app;
+    Opal::Ref<Rndr::GenericWindow> window;
+    Rndr::Canvas::Context context;
+
+    DrawListTestFixture() : context(CreateTestContext(app, window)) {}
+};
+
+const char* k_tinted_shader = R"(
+float4 tint_color;
+
+struct VSInput
+{
+    float3 position;
+};
+
+struct VSOutput
+{
+    float4 position : SV_POSITION;
+};
+
+[shader("vertex")]
+VSOutput VertexMain(VSInput input)
+{
+    VSOutput output;
+    output.position = float4(input.position, 1.0);
+    return output;
+}
+
+struct FSOutput
+{
+    float4 color : SV_TARGET;
+};
+
+[shader("fragment")]
+FSOutput FragmentMain(VSOutput input)
+{
+    FSOutput output;
+    output.color = tint_color;
+    return output;
+}
+)";
+
+const char* k_instance_color_shader = R"(
+StructuredBuffer<float4> instance_colors;
+
+struct VSInput
+{
+    float3 position;
+};
+
+struct VSOutput
+{
+    float4 position : SV_POSITION;
+    nointerpolation float4 color : COLOR;
+};
+
+[shader("vertex")]
+VSOutput VertexMain(VSInput input, uint instance_id : SV_InstanceID, uint first_instance : SV_StartInstanceLocation)
+{
+    VSOutput output;
+    output.position = float4(input.position, 1.0);
+    output.color = instance_colors[first_instance + instance_id];
+    return output;
+}
+
+struct FSOutput
+{
+    float4 color : SV_TARGET;
+};
+
+[shader("fragment")]
+FSOutput FragmentMain(VSOutput input)
+{
+    FSOutput output;
+    output.color = input.color;
+    return output;
+}
+)";
+
+constexpr float k_triangle_positions[] = {-0.5f, -0.5f, 0.0f, 0.5f, -0.5f, 0.0f, 0.0f, 0.5f, 0.0f};
+constexpr Rndr::u32 k_triangle_indices[] = {0, 1, 2};
+
+/** Quad over the full height of the target, from x0 to x1 in clip space, at depth z. */
+Rndr::Canvas::Mesh CreateQuad(float x0, float x1, float z)
+{
+    const float positions[] = {x0, -1.0f, z, x1, -1.0f, z, x1, 1.0f, z, x0, 1.0f, z};
+    constexpr Rndr::u32 k_indices[] = {0, 1, 2, 0, 2, 3};
+    Rndr::Canvas::VertexLayout layout;
+    layout.Add(Rndr::Canvas::Attrib::Position, Rndr::Canvas::Format::Float3);
+    return Rndr::Canvas::Mesh(layout, {reinterpret_cast<const Rndr::u8*>(positions), sizeof(positions)},
+                              {reinterpret_cast<const Rndr::u8*>(k_indices), sizeof(k_indices)});
+}
+
+}  // namespace
+
+TEST_CASE("Canvas DrawList", "[canvas][drawlist]")
+{
+    SECTION("Default constructed list has no commands")
+    {
+        Rndr::Canvas::DrawList const list;
+        REQUIRE(list.GetCommandCount() == 0);
+    }
+
+    SECTION("Append moves commands and empties the secondary list")
+    {
+        Rndr::Canvas::DrawList primary;
+        primary.SetViewport(0, 0, 64, 64);
+        Rndr::Canvas::DrawList secondary;
+        secondary.BeginEvent("Secondary");
+        secondary.EndEvent("Secondary");
+
+        primary.Append(secondary);
+        REQUIRE(primary.GetCommandCount() == 3);
+        REQUIRE(secondary.GetCommandCount() == 0);
+    }
+
+    SECTION("Append into an empty list")
+    {
+        Rndr::Canvas::DrawList primary;
+        Rndr::Canvas::DrawList secondary;
+        secondary.SetViewport(0, 0, 64, 64);
+
+        primary.Append(secondary);
+        REQUIRE(primary.GetCommandCount() == 1);
+        REQUIRE(secondary.GetCommandCount() == 0);
+
+        secondary.SetViewport(0, 0, 32, 32);
+        REQUIRE(secondary.GetCommandCount() == 1);
+    }
+
+    SECTION("Secondary lists recorded in parallel")
+    {
+        constexpr Rndr::u32 k_worker_count = 4;
+        constexpr Rndr::i32 k_commands_per_worker = 100;
+        Rndr::Canvas::DrawList secondaries[k_worker_count];
+        std::thread workers[k_worker_count];
+        for (Rndr::u32 i = 0; i < k_worker_count; ++i)
+        {
+            workers[i] = std::thread(
+                [&secondaries, i]()
+                {
+                    for (Rndr::i32 j = 0; j < k_commands_per_worker; ++j)
+                    {
+                        secondaries[i].SetViewport(static_cast<Rndr::i32>(i), 0, j, j);
+                    }
+                });
+        }
+        // Finish the workers in reverse order, the merged order must not depend on it.
+        for (Rndr::u32 i = k_worker_count; i > 0; --i)
+        {
+            workers[i - 1].join();
+        }
+
+        Rndr::Canvas::DrawList primary;
+        primary.SetViewport(-1, 0, 0, 0);
+        primary.Append(secondaries);
+        REQUIRE(primary.GetCommandCount() == 1 + k_worker_count * k_commands_per_worker);
+        for (const Rndr::Canvas::DrawList& secondary : secondaries)
+        {
+            REQUIRE(secondary.GetCommandCount() == 0);
+        }
+
+        // The primary's own command comes first, then each secondary list in view order, each in
+        // its recording order.
+        using Rndr::Canvas::Impl::SetViewportCommand;
+        Opal::DynamicArray<SetViewportCommand> viewports;
+        primary.ForEachCommand(
+            [&viewports](const Rndr::Canvas::Impl::CommandHeader& header)
+            {
+                REQUIRE(header.type == Rndr::Canvas::DrawListCommandType::SetViewport);
+                viewports.PushBack(Rndr::Canvas::Impl::GetCommandPayload<SetViewportCommand>(header));
+            });
+        REQUIRE(viewports.GetSize() == primary.GetCommandCount());
+        REQUIRE(viewports[0].x == -1);
+        for (Rndr::u32 i = 0; i < k_worker_count; ++i)
+        {
+            for (Rndr::i32 j = 0; j < k_commands_per_worker; ++j)
+            {
+                const SetViewportCommand& viewport = viewports[1 + i * k_commands_per_worker + static_cast<Rndr::u32>(j)];
+                REQUIRE(viewport.x == static_cast<Rndr::i32>(i));
+                REQUIRE(viewport.width == j);
+            }
+        }
+    }
+
+    SECTION("Recording spans multiple arena chunks")
+    {
+        constexpr Rndr::i32 k_command_count = 10000;
+        Rndr::Canvas::DrawList secondary;
+        for (Rndr::i32 i = 0; i < k_command_count; ++i)
+        {
+            secondary.SetViewport(0, 0, i, i);
+        }
+        REQUIRE(secondary.GetCommandCount() == k_command_count);
+
+        Rndr::Canvas::DrawList primary;
+        primary.BeginEvent("Primary");
+        primary.Append(secondary);
+        REQUIRE(primary.GetCommandCount() == k_command_count + 1);
+        REQUIRE(secondary.GetCommandCount() == 0);
+
+        // Chunks are kept after a reset, so the secondary list can be recorded again.
+        secondary.SetViewport(0, 0, 32, 32);
+        REQUIRE(secondary.GetCommandCount() == 1);
+    }
+
+    SECTION("Bake moves commands into a baked list")
+    {
+        Rndr::Canvas::DrawList list;
+        list.BeginEvent("Static");
+        list.SetViewport(0, 0, 64, 64);
+        list.EndEvent("Static");
+
+        Rndr::Canvas::BakedDrawList const baked = list.Bake();
+        REQUIRE(baked.GetCommandCount() == 3);
+        REQUIRE(list.GetCommandCount() == 0);
+    }
+
+    SECTION("Baked list picks up uniforms patched between executions")
+    {
+        DrawListTestFixture f;
+
+        Rndr::Canvas::Mesh quad = CreateQuad(-1.0f, 1.0f, 0.0f);
+        Rndr::Canvas::Shader const shader = Rndr::Canvas::Shader::FromSourceInMemory(k_tinted_shader);
+        Rndr::Canvas::Brush brush;
+        brush.SetShader(shader);
+        brush.SetUniform("tint_color", Rndr::Vector4f{1.0f, 0.0f, 0.0f, 1.0f});
+
+        Rndr::Canvas::RenderTargetDesc target_desc;
+        target_desc.AddColor(4, 4);
+        Rndr::Canvas::RenderTarget target(f.context, target_desc);
+
+        Rndr::Canvas::DrawList list;
+        list.SetRenderTarget(target);
+        list.ClearColor({0.0f, 0.0f, 0.0f, 1.0f});
+        list.Draw(quad, brush);
+        Rndr::Canvas::BakedDrawList baked = list.Bake();
+
+        baked.Execute();
+        const Opal::DynamicArray<Rndr::u8> first_pixels = target.GetColorAttachment(0).ReadData();
+        REQUIRE(first_pixels.GetSize() == 4 * 4 * 4);
+        REQUIRE((first_pixels[0] == 255 && first_pixels[1] == 0 && first_pixels[2] == 0));
+
+        brush.SetUniform("tint_color", Rndr::Vector4f{0.0f, 0.0f, 1.0f, 1.0f});
+        baked.Execute();
+        const Opal::DynamicArray<Rndr::u8> second_pixels = target.GetColorAttachment(0).ReadData();
+        REQUIRE(second_pixels.GetSize() == first_pixels.GetSize());
+        for (Rndr::u64 i = 0; i < second_pixels.GetSize(); i += 4)
+        {
+            REQUIRE((second_pixels[i] == 0 && second_pixels[i + 1] == 0 && second_pixels[i + 2] == 255));
+        }
+    }
+
+    SECTION("Baked and immediate range draws draw the same vertices")
+    {
+        DrawListTestFixture f;
+
+        // A triangle outside of the target, followed by one covering the whole target.
+        constexpr float k_positions[] = {5.0f,  5.0f,  0.0f, 6.0f, 5.0f,  0.0f, 5.0f,  6.0f, 0.0f,
+                                         -1.0f, -1.0f, 0.0f, 3.0f, -1.0f, 0.0f, -1.0f, 3.0f, 0.0f};
+        constexpr Rndr::u32 k_indices[] = {2, 1, 0, 0, 1, 2};
+        Rndr::Canvas::VertexLayout layout;
+        layout.Add(Rndr::Canvas::Attrib::Position, Rndr::Canvas::Format::Float3);
+        Rndr::Canvas::Mesh mesh(layout, {reinterpret_cast<const Rndr::u8*>(k_positions), sizeof(k_positions)},
+                                {reinterpret_cast<const Rndr::u8*>(k_indices), sizeof(k_indices)});
+
+        Rndr::Canvas::Shader const shader = Rndr::Canvas::Shader::FromSourceInMemory(k_tinted_shader);
+        Rndr::Canvas::Brush brush;
+        brush.SetShader(shader);
+        brush.SetUniform("tint_color", Rndr::Vector4f{1.0f, 0.0f, 0.0f, 1.0f});
+
+        Rndr::Canvas::RenderTargetDesc target_desc;
+        target_desc.AddColor(4, 4);
+        Rndr::Canvas::RenderTarget immediate_target(f.context, target_desc);
+        Rndr::Canvas::RenderTarget baked_target(f.context, target_desc);
+
+        // Only the second half of the indices offset by base_vertex reaches the covering triangle.
+        const Rndr::Canvas::MeshRange range{.first_index = 3, .index_count = 3, .base_vertex = 3};
+
+        Rndr::Canvas::DrawList list;
+        list.SetRenderTarget(immediate_target);
+        list.ClearColor({0.0f, 0.0f, 0.0f, 1.0f});
+        list.Draw(mesh, brush, range);
+        list.Execute();
+
+        list.SetRenderTarget(baked_target);
+        list.ClearColor({0.0f, 0.0f, 0.0f, 1.0f});
+        list.Draw(mesh, brush, range);
+        Rndr::Canvas::BakedDrawList baked = list.Bake();
+        baked.Execute();
+
+        const Opal::DynamicArray<Rndr::u8> immediate_pixels = immediate_target.GetColorAttachment(0).ReadData();
+        const Opal::DynamicArray<Rndr::u8> baked_pixels = baked_target.GetColorAttachment(0).ReadData();
+        REQUIRE(immediate_pixels.GetSize() == 4 * 4 * 4);
+        REQUIRE(baked_pixels.GetSize() == immediate_pixels.GetSize());
+        REQUIRE(immediate_pixels[0] == 255);
+        REQUIRE(memcmp(immediate_pixels.GetData(), baked_pixels.GetData(), baked_pixels.GetSize()) == 0);
+    }
+
+    SECTION("Instanced draws of LOD ranges read their own slice of a shared instance buffer")
+    {
+        DrawListTestFixture f;
+
+        // Two LODs of a triangle covering the whole target, packed into one index buffer like PbrRenderer's.
+        constexpr float k_positions[] = {-1.0f, -1.0f, 0.0f, 3.0f, -1.0f, 0.0f, -1.0f, 3.0f, 0.0f};
+        constexpr Rndr::u32 k_lod_indices[] = {0, 1, 2, 0, 1, 2};
+        Rndr::Canvas::VertexLayout layout;
+        layout.Add(Rndr::Canvas::Attrib::Position, Rndr::Canvas::Format::Float3);
+        Rndr::Canvas::Mesh mesh(layout, {reinterpret_cast<const Rndr::u8*>(k_positions), sizeof(k_positions)},
+                                {reinterpret_cast<const Rndr::u8*>(k_lod_indices), sizeof(k_lod_indices)});
+
+        // LOD 0 draws instance 0 and LOD 1 draws instance 1.
+        constexpr float k_instance_colors[] = {1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f};
+        const Rndr::Canvas::Buffer instance_buffer(Rndr::Canvas::BufferUsage::Storage, sizeof(k_instance_colors), 0,
+                                                   {reinterpret_cast<const Rndr::u8*>(k_instance_colors), sizeof(k_instance_colors)});
+        Rndr::Canvas::Shader const shader = Rndr::Canvas::Shader::FromSourceInMemory(k_instance_color_shader);
+        Rndr::Canvas::Brush brush;
+        brush.SetShader(shader);
+        brush.SetBuffer("instance_colors", instance_buffer);
+
+        Rndr::Canvas::RenderTargetDesc target_desc;
+        target_desc.AddColor(4, 4);
+        Rndr::Canvas::RenderTarget lod0_target(f.context, target_desc);
+        Rndr::Canvas::RenderTarget lod1_target(f.context, target_desc);
+
+        Rndr::Canvas::DrawList list;
+        list.SetRenderTarget(lod0_target);
+        list.ClearColor({0.0f, 0.0f, 0.0f, 1.0f});
+        list.DrawInstanced(mesh, brush, {.first_index = 0, .index_count = 3}, 1, 0);
+        list.SetRenderTarget(lod1_target);
+        list.ClearColor({0.0f, 0.0f, 0.0f, 1.0f});
+        list.DrawInstanced(mesh, brush, {.first_index = 3, .index_count = 3}, 1, 1);
+        list.Execute();
+
+        const Opal::DynamicArray<Rndr::u8> lod0_pixels = lod0_target.GetColorAttachment(0).ReadData();
+        const Opal::DynamicArray<Rndr::u8> lod1_pixels = lod1_target.GetColorAttachment(0).ReadData();
+        REQUIRE(lod0_pixels.GetSize() == 4 * 4 * 4);
+        REQUIRE(lod1_pixels.GetSize() == lod0_pixels.GetSize());
+        REQUIRE(lod0_pixels[0] == 255);
+        REQUIRE(lod0_pixels[1] == 0);
+        REQUIRE(lod1_pixels[0] == 0);
+        REQUIRE(lod1_pixels[1] == 255);
+    }
+
+    SECTION("State sorted execution renders the same image as recording order")
+    {
+        DrawListTestFixture f;
+
+        Rndr::Canvas::Shader const shader = Rndr::Canvas::Shader::FromSourceInMemory(k_tinted_shader);
+        const Rndr::Canvas::BrushDesc opaque_desc{.depth_test = true};
+        Rndr::Canvas::Brush red(opaque_desc);
+        red.SetShader(shader);
+        red.SetUniform("tint_color", Rndr::Vector4f{1.0f, 0.0f, 0.0f, 1.0f});
+        Rndr::Canvas::Brush green(opaque_desc);
+        green.SetShader(shader);
+        green.SetUniform("tint_color", Rndr::Vector4f{0.0f, 1.0f, 0.0f, 1.0f});
+        // Blended and without depth write, so its result depends on the draws before it.
+        Rndr::Canvas::Brush additive_blue(
+            Rndr::Canvas::BrushDesc{.blend_mode = Rndr::Canvas::BlendMode::Additive, .depth_test = false, .depth_write = false});
+        additive_blue.SetShader(shader);
+        additive_blue.SetUniform("tint_color", Rndr::Vector4f{0.0f, 0.0f, 1.0f, 1.0f});
+
+        Rndr::Canvas::Mesh far_full = CreateQuad(-1.0f, 1.0f, 0.6f);
+        Rndr::Canvas::Mesh middle_left = CreateQuad(-1.0f, 0.0f, 0.4f);
+        Rndr::Canvas::Mesh near_right = CreateQuad(0.0f, 1.0f, 0.2f);
+        Rndr::Canvas::Mesh nearest_right = CreateQuad(0.0f, 1.0f, 0.1f);
+
+        Rndr::Canvas::RenderTargetDesc target_desc;
+        target_desc.AddColor(4, 4).SetDepthStencil(4, 4);
+        Rndr::Canvas::RenderTarget first_target(f.context, target_desc);
+        Rndr::Canvas::RenderTarget second_target(f.context, target_desc);
+
+        Rndr::Canvas::DrawList list;
+        auto render = [&](Rndr::Canvas::DrawSortMode mode)
+        {
+            list.SetSortMode(mode);
+            list.SetRenderTarget(first_target);
+            list.Clear({0.0f, 0.0f, 0.0f, 1.0f});
+            // Interleaved brushes that sorting groups together. Left ends up green, right red.
+            list.Draw(far_full, red);
+            list.Draw(middle_left, green);
+            list.Draw(near_right, red);
+            // Barrier, adds blue to both halves.
+            list.Draw(far_full, additive_blue);
+            // Must stay after the barrier, or the right half would end up green plus blue.
+            list.Draw(nearest_right, green);
+            list.SetRenderTarget(second_target);
+            list.Clear({0.0f, 0.0f, 0.0f, 1.0f});
+            list.Draw(middle_left, green);
+            list.Draw(far_full, red);
+            list.Execute();
+
+            Opal::DynamicArray<Rndr::u8> pixels = first_target.GetColorAttachment(0).ReadData();
+            const Opal::DynamicArray<Rndr::u8> second_pixels = second_target.GetColorAttachment(0).ReadData();
+            for (Rndr::u64 i = 0; i < second_pixels.GetSize(); ++i)
+            {
+                pixels.PushBack(second_pixels[i]);
+            }
+            return pixels;
+        };
+
+        const Opal::DynamicArray<Rndr::u8> recorded = render(Rndr::Canvas::DrawSortMode::RecordingOrder);
+        const Opal::DynamicArray<Rndr::u8> sorted = render(Rndr::Canvas::DrawSortMode::StateSorted);
+        REQUIRE(recorded.GetSize() == 2 * 4 * 4 * 4);
+        REQUIRE(sorted.GetSize() == recorded.GetSize());
+        REQUIRE(memcmp(recorded.GetData(), sorted.GetData(), recorded.GetSize()) == 0);
+
+        // First target: left is green plus blue, right is the green drawn after the barrier.
+        constexpr Rndr::u64 k_left = 0;
+        constexpr Rndr::u64 k_right = 3 * 4;
+        REQUIRE((sorted[k_left] == 0 && sorted[k_left + 1] == 255 && sorted[k_left + 2] == 255));
+        REQUIRE((sorted[k_right] == 0 && sorted[k_right + 1] == 255 && sorted[k_right + 2] == 0));
+        // Second target: the nearer green stays in front of the red drawn after it.
+        constexpr Rndr::u64 k_second = 4 * 4 * 4;
+        REQUIRE((sorted[k_second + k_left] == 0 && sorted[k_second + k_left + 1] == 255));
+        REQUIRE((sorted[k_second + k_right] == 255 && sorted[k_second + k_right + 1] == 0));
+    }
+}
+
+TEST_CASE("Canvas DrawList stats", "[canvas][drawlist]")
+{
+    SECTION("Command types have names")
+    {
+        REQUIRE(strcmp(Rndr::Canvas::GetCommandTypeName(Rndr::Canvas::DrawListCommandType::DrawMesh), "DrawMesh") == 0);
+        REQUIRE(strcmp(Rndr::Canvas::GetCommandTypeName(Rndr::Canvas::DrawListCommandType::EndEvent), "EndEvent") == 0);
+    }
+
+    SECTION("Stats are zero before the first execution")
+    {
+        Rndr::Canvas::DrawList const list;
+        REQUIRE(list.GetStats().draw_count == 0);
+        REQUIRE(list.GetStats().triangle_count == 0);
+        REQUIRE(list.GetStats().total_cpu_time == 0.0);
+    }
+
+    SECTION("Execute counts submitted work")
+    {
+        DrawListTestFixture f;
+
+        Rndr::Canvas::VertexLayout layout;
+        layout.Add(Rndr::Canvas::Attrib::Position, Rndr::Canvas::Format::Float3);
+        Rndr::Canvas::Mesh mesh(layout, 3, 3);
+        mesh.Append({reinterpret_cast<const Rndr::u8*>(k_triangle_positions), sizeof(k_triangle_positions)},
+                    {reinterpret_cast<const Rndr::u8*>(k_triangle_indices), sizeof(k_triangle_indices)});
+
+        Rndr::Canvas::Shader const shader = Rndr::Canvas::Shader::FromSourceInMemory(k_tinted_shader);
+        Rndr::Canvas::Brush brush;
+        brush.SetShader(shader);
+        brush.SetUniform("tint_color", Rndr::Vector4f{1.0f, 0.0f, 0.0f, 1.0f});
+
+        Rndr::Canvas::DrawList list;
+        list.SetRenderTarget(f.context);
+        list.ClearColor({0.0f, 0.0f, 0.0f, 1.0f});
+        list.Draw(mesh, brush);
+        list.DrawInstanced(mesh, brush, 4);
+        list.Execute();
+
+        const Rndr::Canvas::DrawListStats& stats = list.GetStats();
+        REQUIRE(stats.draw_count == 1);
+        REQUIRE(stats.instanced_draw_count == 1);
+        REQUIRE(stats.triangle_count == 5);
+        REQUIRE(stats.instance_count == 5);
+        REQUIRE(stats.dispatch_count == 0);
+        REQUIRE(stats.render_target_switches == 1);
+        REQUIRE(stats.brush_applies == 2);
+        REQUIRE(stats.uniform_bytes_uploaded > 0);
+        REQUIRE(stats.mesh_uploads == 1);
+        REQUIRE(stats.total_cpu_time >= 0.0);
+        for (const Rndr::f64 command_time : stats.command_cpu_time)
+        {
+            REQUIRE(command_time == 0.0);
+        }
+
+        // Nothing is dirty the second time around.
+        list.Draw(mesh, brush);
+        list.Execute();
+        REQUIRE(list.GetStats().draw_count == 1);
+        REQUIRE(list.GetStats().instanced_draw_count == 0);
+        REQUIRE(list.GetStats().uniform_bytes_uploaded == 0);
+        REQUIRE(list.GetStats().mesh_uploads == 0);
+
+        // Commands are only timed on request.
+        list.SetCommandTimingEnabled(true);
+        list.Draw(mesh, brush);
+        list.Execute();
+        const Rndr::f64 draw_time = list.GetStats().command_cpu_time[static_cast<Rndr::u64>(Rndr::Canvas::DrawListCommandType::DrawMesh)];
+        REQUIRE(draw_time > 0.0);
+        REQUIRE(draw_time <= list.GetStats().total_cpu_time);
+    }
+
+    SECTION("Range draws of a geometry pool")
+    {
+        DrawListTestFixture f;
+
+        Rndr::Canvas::VertexLayout layout;
+        layout.Add(Rndr::Canvas::Attrib::Position, Rndr::Canvas::Format::Float3);
+        Rndr::Canvas::Mesh pool(layout, 6, 6);
+        const Opal::ArrayView<const Rndr::u8> vertices{reinterpret_cast<const Rndr::u8*>(k_triangle_positions),
+                                                       sizeof(k_triangle_positions)};
+        const Opal::ArrayView<const Rndr::u8> indices{reinterpret_cast<const Rndr::u8*>(k_triangle_indices), sizeof(k_triangle_indices)};
+        const Rndr::Canvas::MeshRange first = pool.AddRange(vertices, indices);
+        const Rndr::Canvas::MeshRange second = pool.AddRange(vertices, indices);
+
+        Rndr::Canvas::Shader const shader = Rndr::Canvas::Shader::FromSourceInMemory(k_tinted_shader);
+        Rndr::Canvas::Brush brush;
+        brush.SetShader(shader);
+        brush.SetUniform("tint_color", Rndr::Vector4f{1.0f, 0.0f, 0.0f, 1.0f});
+
+        Rndr::Canvas::DrawList list;
+        list.SetRenderTarget(f.context);
+        list.Draw(pool, brush, first);
+        list.DrawInstanced(pool, brush, second, 3, 1);
+        REQUIRE(list.GetCommandCount() == 3);
+        list.Execute();
+
+        const Rndr::Canvas::DrawListStats& stats = list.GetStats();
+        REQUIRE(stats.draw_count == 1);
+        REQUIRE(stats.instanced_draw_count == 1);
+        REQUIRE(stats.triangle_count == 4);
+        REQUIRE(stats.instance_count == 4);
+        REQUIRE(stats.mesh_uploads == 1);
+        REQUIRE(f.context.GetStateCacheStats().skipped_calls > 0);
+    }
+}
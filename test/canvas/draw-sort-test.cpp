@@ -0,0 +1,128 @@
+#include <catch2/catch2.hpp>
+
+#include "opal/container/dynamic-array.h"
+
+#include "canvas/draw-sort.hpp"
+#include "canvas/pipeline-state.hpp"
+
+TEST_CASE("Canvas DrawSort", "[canvas][drawsort]")
+{
+    using namespace Rndr::Canvas;
+
+    SECTION("Equal brush descriptors intern to the same state")
+    {
+        const BrushDesc a;
+        const BrushDesc b;
+        REQUIRE(Impl::InternPipelineState(a) == 0);
+        REQUIRE(Impl::InternPipelineState(a) == Impl::InternPipelineState(b));
+
+        BrushDesc biased;
+        biased.depth_bias_units = 2.0f;
+        const PipelineStateId biased_id = Impl::InternPipelineState(biased);
+        REQUIRE(Impl::InternPipelineState(biased) == biased_id);
+        REQUIRE(Impl::GetPipelineState(biased_id).depth_bias_units == 2.0f);
+    }
+
+    SECTION("Different brush descriptors intern to different states")
+    {
+        BrushDesc base;
+        BrushDesc culled;
+        culled.cull_mode = CullMode::Front;
+        BrushDesc compared;
+        compared.depth_compare = CompareFunc::Always;
+        BrushDesc wireframe;
+        wireframe.fill_mode = FillMode::Wireframe;
+        REQUIRE(Impl::InternPipelineState(base) != Impl::InternPipelineState(culled));
+        REQUIRE(Impl::InternPipelineState(base) != Impl::InternPipelineState(compared));
+        REQUIRE(Impl::InternPipelineState(base) != Impl::InternPipelineState(wireframe));
+        REQUIRE(Impl::InternPipelineState(culled) != Impl::InternPipelineState(wireframe));
+    }
+
+    SECTION("Shader dominates the sort key")
+    {
+        const Rndr::u64 low_program = Impl::MakeDrawSortKey(1, 0xFFFF, 0xFFFF, 0xFFFF);
+        const Rndr::u64 high_program = Impl::MakeDrawSortKey(2, 0, 0, 0);
+        REQUIRE(low_program < high_program);
+
+        const Rndr::u64 low_state = Impl::MakeDrawSortKey(1, 1, 0xFFFF, 0xFFFF);
+        const Rndr::u64 high_state = Impl::MakeDrawSortKey(1, 2, 0, 0);
+        REQUIRE(low_state < high_state);
+
+        const Rndr::u64 low_texture = Impl::MakeDrawSortKey(1, 0, 1, 0xFFFF);
+        const Rndr::u64 high_texture = Impl::MakeDrawSortKey(1, 0, 2, 0);
+        REQUIRE(low_texture < high_texture);
+    }
+
+    SECTION("Only opaque draws that test and write depth are reorderable")
+    {
+        BrushDesc opaque;
+        opaque.depth_test = true;
+        REQUIRE(Impl::IsDrawReorderable(opaque));
+
+        BrushDesc blended = opaque;
+        blended.blend_mode = BlendMode::Alpha;
+        REQUIRE(!Impl::IsDrawReorderable(blended));
+
+        BrushDesc no_depth = opaque;
+        no_depth.depth_test = false;
+        REQUIRE(!Impl::IsDrawReorderable(no_depth));
+
+        BrushDesc no_depth_write = opaque;
+        no_depth_write.depth_write = false;
+        REQUIRE(!Impl::IsDrawReorderable(no_depth_write));
+
+        for (const CompareFunc func : {CompareFunc::LessEqual, CompareFunc::Greater, CompareFunc::GreaterEqual})
+        {
+            BrushDesc ordered = opaque;
+            ordered.depth_compare = func;
+            REQUIRE(Impl::IsDrawReorderable(ordered));
+        }
+        for (const CompareFunc func : {CompareFunc::Equal, CompareFunc::NotEqual, CompareFunc::Always, CompareFunc::Never})
+        {
+            BrushDesc unordered = opaque;
+            unordered.depth_compare = func;
+            REQUIRE(!Impl::IsDrawReorderable(unordered));
+        }
+    }
+
+    SECTION("Radix sort orders by key and is stable")
+    {
+        constexpr Rndr::u64 k_keys[] = {0x0300000000000002ull, 0x0100000000000001ull, 0x0300000000000002ull,
+                                        0x0000000000000005ull, 0x0100000000000001ull, 0xFF00000000000000ull};
+        constexpr Rndr::u64 k_count = sizeof(k_keys) / sizeof(k_keys[0]);
+        Opal::DynamicArray<Impl::DrawSortEntry> entries;
+        for (Rndr::u64 i = 0; i < k_count; ++i)
+        {
+            entries.PushBack({.key = k_keys[i], .command_index = static_cast<Rndr::u32>(i)});
+        }
+        Opal::DynamicArray<Impl::DrawSortEntry> scratch;
+        scratch.Resize(k_count);
+
+        Impl::RadixSortDrawEntries(entries.GetData(), scratch.GetData(), k_count);
+
+        REQUIRE(entries[0].command_index == 3);
+        REQUIRE(entries[1].command_index == 1);
+        REQUIRE(entries[2].command_index == 4);
+        REQUIRE(entries[3].command_index == 0);
+        REQUIRE(entries[4].command_index == 2);
+        REQUIRE(entries[5].command_index == 5);
+    }
+
+    SECTION("Radix sort with identical keys keeps recording order")
+    {
+        Opal::DynamicArray<Impl::DrawSortEntry> entries;
+        for (Rndr::u32 i = 0; i < 4; ++i)
+        {
+            entries.PushBack({.key = 42, .command_index = i});
+        }
+        Opal::DynamicArray<Impl::DrawSortEntry> scratch;
+        scratch.Resize(4);
+
+        Impl::RadixSortDrawEntries(entries.GetData(), scratch.GetData(), 4);
+
+        for (Rndr::u32 i = 0; i < 4; ++i)
+        {
+            REQUIRE(entries[i].command_index == i);
+        }
+    }
+}
@@ -0,0 +1,227 @@
+#include <catch2/catch2.hpp>
+
+#include <cstring>
+
+#include "opal/container/scope-ptr.h"
+#include "opal/exceptions.h"
+
+#include "rndr/application.hpp"
+#include "rndr/canvas/brush.hpp"
+#include "rndr/canvas/context.hpp"
+#include "rndr/canvas/draw-list.hpp"
+#include "rndr/canvas/frame-capture.hpp"
+#include "rndr/canvas/mesh.hpp"
+#include "rndr/canvas/shader.hpp"
+#include "rndr/canvas/texture.hpp"
+#include "rndr/file.hpp"
+#include "rndr/generic-window.hpp"
+
+namespace
+{
+
+Rndr::Canvas::Context CreateTestContext(Opal::ScopePtr<Rndr::Application>& app, Opal::Ref<Rndr::GenericWindow>& window)
+{
+    app = Rndr::Application::Create();
+    Rndr::GenericWindowDesc window_desc;
+    window_desc.start_visible = false;
+    window = app->CreateGenericWindow(window_desc);
+    return Rndr::Canvas::Context::Init(window.Clone());
+}
+
+struct FrameCaptureTestFixture
+{
+    Opal::ScopePtr<Rndr::Application> app;
+    Opal::Ref<Rndr::GenericWindow> window;
+    Rndr::Canvas::Context context;
+
+    FrameCaptureTestFixture() : context(CreateTestContext(app, window)) {}
+};
+
+const char* k_textured_shader = R"(
+float4 tint_color;
+Sampler2D albedo_texture;
+
+struct VSInput
+{
+    float3 position;
+};
+
+struct VSOutput
+{
+    float4 position : SV_POSITION;
+};
+
+[shader("vertex")]
+VSOutput VertexMain(VSInput input)
+{
+    VSOutput output;
+    output.position = float4(input.position, 1.0);
+    return output;
+}
+
+struct FSOutput
+{
+    float4 color : SV_TARGET;
+};
+
+[shader("fragment")]
+FSOutput FragmentMain(VSOutput input)
+{
+    FSOutput output;
+    output.color = tint_color * albedo_texture.Sample(float2(0.5, 0.5));
+    return output;
+}
+)";
+
+const char* k_variant_shader = R"(
+[vk::constant_id(0)] const bool k_use_tint = false;
+
+float4 tint_color;
+
+struct VSInput
+{
+    float3 position;
+};
+
+struct VSOutput
+{
+    float4 position : SV_POSITION;
+};
+
+[shader("vertex")]
+VSOutput VertexMain(VSInput input)
+{
+    VSOutput output;
+    output.position = float4(input.position, 1.0);
+    return output;
+}
+
+[shader("fragment")]
+float4 FragmentMain(VSOutput input) : SV_TARGET
+{
+    return k_use_tint ? tint_color : float4(1.0, 1.0, 1.0, 1.0);
+}
+)";
+
+constexpr float k_triangle_positions[] = {-0.5f, -0.5f, 0.0f, 0.5f, -0.5f, 0.0f, 0.0f, 0.5f, 0.0f};
+constexpr Rndr::u32 k_triangle_indices[] = {0, 1, 2};
+
+}  // namespace
+
+TEST_CASE("Canvas FrameCapture", "[canvas][framecapture]")
+{
+    FrameCaptureTestFixture f;
+
+    Rndr::Canvas::VertexLayout layout;
+    layout.Add(Rndr::Canvas::Attrib::Position, Rndr::Canvas::Format::Float3);
+    const auto* vraw = reinterpret_cast<const Rndr::u8*>(k_triangle_positions);
+    const auto* iraw = reinterpret_cast<const Rndr::u8*>(k_triangle_indices);
+    Rndr::Canvas::Mesh mesh(layout, {vraw, sizeof(k_triangle_positions)}, {iraw, sizeof(k_triangle_indices)});
+
+    const Rndr::u8 pixels[] = {255, 0, 0, 255, 0, 255, 0, 255, 0, 0, 255, 255, 255, 255, 255, 255};
+    Rndr::Canvas::TextureDesc texture_desc;
+    texture_desc.width = 2;
+    texture_desc.height = 2;
+    Rndr::Canvas::Texture texture(f.context, texture_desc, {pixels, sizeof(pixels)});
+
+    Rndr::Canvas::Shader shader = Rndr::Canvas::Shader::FromSourceInMemory(k_textured_shader);
+    Rndr::Canvas::Brush brush;
+    brush.SetShader(shader);
+    brush.SetUniform("tint_color", Rndr::Vector4f{1.0f, 0.5f, 0.25f, 1.0f});
+    brush.SetTexture("albedo_texture", texture);
+
+    Rndr::Canvas::DrawList list;
+    list.SetRenderTarget(f.context);
+    list.ClearColor({0.0f, 0.0f, 0.0f, 1.0f});
+    list.BeginEvent("Triangles");
+    list.Draw(mesh, brush);
+    list.DrawInstanced(mesh, brush, 4);
+    list.EndEvent("Triangles");
+
+    SECTION("Texture read back matches the initial data")
+    {
+        const Opal::DynamicArray<Rndr::u8> read_back = texture.ReadData();
+        REQUIRE(read_back.GetSize() == sizeof(pixels));
+        REQUIRE(memcmp(read_back.GetData(), pixels, sizeof(pixels)) == 0);
+    }
+
+    SECTION("Capture leaves the list untouched and deduplicates resources")
+    {
+        const Rndr::Canvas::FrameCapture capture = Rndr::Canvas::FrameCapture::Capture(list);
+        REQUIRE(capture.GetCommandCount() == 6);
+        REQUIRE(list.GetCommandCount() == 6);
+
+        // Shader, texture, mesh and brush.
+        REQUIRE(capture.GetResourceCount() == 4);
+        list.Execute();
+    }
+
+    SECTION("Save, load and replay")
+    {
+        const Rndr::Canvas::FrameCapture capture = Rndr::Canvas::FrameCapture::Capture(list);
+        list.Execute();
+        capture.Save("frame-capture-test.rndrcap");
+
+        const Rndr::Canvas::FrameCapture loaded = Rndr::Canvas::FrameCapture::Load("frame-capture-test.rndrcap");
+        REQUIRE(loaded.GetCommandCount() == capture.GetCommandCount());
+        REQUIRE(loaded.GetResourceCount() == capture.GetResourceCount());
+
+        Rndr::Canvas::FrameReplay replay(f.context, loaded);
+        REQUIRE(replay.GetCommandCount() == 6);
+        REQUIRE_NOTHROW(replay.Execute());
+        REQUIRE_NOTHROW(replay.Execute());
+    }
+
+    SECTION("Brushes using a shader variant are captured with its parent and key values")
+    {
+        Rndr::Canvas::Shader variant_shader = Rndr::Canvas::Shader::FromSourceInMemory(k_variant_shader, "Variants");
+        variant_shader.SetPermutationKeys({{.constant_id = 0}});
+        const Rndr::u32 values[] = {1};
+        const Rndr::Canvas::Shader& variant = variant_shader.GetVariant(Opal::ArrayView<const Rndr::u32>(values, 1));
+        Rndr::Canvas::Brush variant_brush;
+        variant_brush.SetShader(variant_shader);
+        variant_brush.SetUniform("tint_color", Rndr::Vector4f{0.0f, 1.0f, 0.0f, 1.0f});
+        variant_brush.SetShaderVariant(variant);
+
+        Rndr::Canvas::DrawList variant_list;
+        variant_list.SetRenderTarget(f.context);
+        variant_list.Draw(mesh, variant_brush);
+        const Rndr::Canvas::FrameCapture capture = Rndr::Canvas::FrameCapture::Capture(variant_list);
+        variant_list.Execute();
+
+        // Parent shader, variant, mesh and brush.
+        REQUIRE(capture.GetResourceCount() == 4);
+        capture.Save("frame-capture-variant-test.rndrcap");
+        const Rndr::Canvas::FrameCapture loaded = Rndr::Canvas::FrameCapture::Load("frame-capture-variant-test.rndrcap");
+        REQUIRE(loaded.GetResourceCount() == 4);
+
+        Rndr::Canvas::FrameReplay replay(f.context, loaded);
+        REQUIRE_NOTHROW(replay.Execute());
+    }
+
+    SECTION("Replaying a capture with an out of range index throws")
+    {
+        const Rndr::Canvas::FrameCapture capture = Rndr::Canvas::FrameCapture::Capture(list);
+        list.Execute();
+        capture.Save("frame-capture-corrupt-test.rndrcap");
+
+        // The file ends with the EndEvent command, whose last four bytes are its event name index.
+        Opal::DynamicArray<Rndr::u8> contents = Rndr::ReadEntireFile("frame-capture-corrupt-test.rndrcap");
+        REQUIRE(contents.GetSize() > sizeof(Rndr::u32));
+        const Rndr::u32 bad_index = 1000;
+        memcpy(contents.GetData() + contents.GetSize() - sizeof(Rndr::u32), &bad_index, sizeof(bad_index));
+        {
+            Rndr::FileHandler file("frame-capture-corrupt-test.rndrcap", "wb");
+            REQUIRE(file.Write(contents.GetData(), 1, contents.GetSize()));
+        }
+
+        const Rndr::Canvas::FrameCapture loaded = Rndr::Canvas::FrameCapture::Load("frame-capture-corrupt-test.rndrcap");
+        Rndr::Canvas::FrameReplay replay(f.context, loaded);
+        REQUIRE_THROWS_AS(replay.Execute(), Opal::Exception);
+    }
+
+    SECTION("Loading a missing file throws")
+    {
+        REQUIRE_THROWS_AS(Rndr::Canvas::FrameCapture::Load("missing-frame-capture.rndrcap"), Opal::Exception);
+    }
+}
@@ -1,5 +1,7 @@
 #include <catch2/catch2.hpp>
 
+#include <cstring>
+
 #include "opal/container/scope-ptr.h"
 #include "opal/exceptions.h"
 
@@ -227,4 +229,44 @@ TEST_CASE("Canvas Mesh", "[canvas][mesh]")
         Rndr::Canvas::Mesh const clone = mesh.Clone();
         REQUIRE_FALSE(clone.IsValid());
     }
+
+    SECTION("Full range covers the whole mesh")
+    {
+        Rndr::Canvas::VertexLayout layout = MakePositionUVLayout();
+        const auto* vraw = reinterpret_cast<const Rndr::u8*>(k_quad_data);
+        const auto* iraw = reinterpret_cast<const Rndr::u8*>(k_quad_indices);
+
+        Rndr::Canvas::Mesh const mesh(layout, {vraw, sizeof(k_quad_data)}, {iraw, sizeof(k_quad_indices)});
+        const Rndr::Canvas::MeshRange range = mesh.GetFullRange();
+        REQUIRE(range.first_index == 0);
+        REQUIRE(range.index_count == 6);
+        REQUIRE(range.base_vertex == 0);
+    }
+
+    SECTION("Add ranges to a geometry pool")
+    {
+        Rndr::Canvas::VertexLayout layout = MakePositionLayout();
+        const auto* vraw = reinterpret_cast<const Rndr::u8*>(k_triangle_positions);
+        const auto* iraw = reinterpret_cast<const Rndr::u8*>(k_triangle_indices);
+
+        Rndr::Canvas::Mesh pool(layout, 6, 6, "Pool");
+        const Rndr::Canvas::MeshRange first = pool.AddRange({vraw, sizeof(k_triangle_positions)}, {iraw, sizeof(k_triangle_indices)});
+        const Rndr::Canvas::MeshRange second = pool.AddRange({vraw, sizeof(k_triangle_positions)}, {iraw, sizeof(k_triangle_indices)});
+        REQUIRE(first.first_index == 0);
+        REQUIRE(first.index_count == 3);
+        REQUIRE(first.base_vertex == 0);
+        REQUIRE(second.first_index == 3);
+        REQUIRE(second.index_count == 3);
+        REQUIRE(second.base_vertex == 3);
+        REQUIRE(pool.GetVertexCount() == 6);
+        REQUIRE(pool.GetIndexCount() == 6);
+
+        // Indices are stored as given, relative to each range's base vertex.
+        Rndr::u32 indices[6];
+        memcpy(indices, pool.GetIndexData().GetData(), sizeof(indices));
+        REQUIRE(indices[3] == 0);
+
+        REQUIRE_THROWS_AS(pool.AddRange({vraw, sizeof(k_triangle_positions)}, {iraw, sizeof(k_triangle_indices)}),
+                          Opal::InvalidArgumentException);
+    }
 }
@@ -0,0 +1,147 @@
+#include <catch2/catch2.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+#include "opal/container/scope-ptr.h"
+#include "opal/math/transform.h"
+
+#include "rndr/application.hpp"
+#include "rndr/canvas/context.hpp"
+#include "rndr/canvas/draw-list.hpp"
+#include "rndr/canvas/renderers/pbr-renderer.hpp"
+#include "rndr/generic-window.hpp"
+
+namespace
+{
+
+constexpr const char* k_model_directory = "pbr-renderer-test";
+
+/** Quads along each side of the grid model. */
+constexpr int k_grid_size = 16;
+constexpr Rndr::u64 k_grid_triangle_count = 2 * k_grid_size * k_grid_size;
+
+Rndr::Canvas::Context CreateTestContext(Opal::ScopePtr<Rndr::Application>& app, Opal::Ref<Rndr::GenericWindow>& window)
+{
+    std::filesystem::remove_all(k_model_directory);
+    std::filesystem::create_directories(k_model_directory);
+    app = Rndr::Application::Create();
+    Rndr::GenericWindowDesc window_desc;
+    window_desc.start_visible = false;
+    window = app->CreateGenericWindow(window_desc);
+    return Rndr::Canvas::Context::Init(window.Clone());
+}
+
+struct PbrRendererTestFixture
+{
+    Opal::ScopePtr<Rndr::Application> app;
+    Opal::Ref<Rndr::GenericWindow> window;
+    Rndr::Canvas::Context context;
+
+    PbrRendererTestFixture() : context(CreateTestContext(app, window)) {}
+};
+
+/**
+ * Write a wavy grid in the Wavefront OBJ format. No part of it is flat, so every LOD after the first
+ * adds error and only LOD 0 is drawn when no error is allowed.
+ * @return Path of the written file.
+ */
+Opal::StringUtf8 WriteGridModel()
+{
+    std::string contents;
+    char line[128];
+    for (int y = 0; y <= k_grid_size; ++y)
+    {
+        for (int x = 0; x <= k_grid_size; ++x)
+        {
+            const float u = static_cast<float>(x) / k_grid_size;
+            const float v = static_cast<float>(y) / k_grid_size;
+            const float height = 0.1f * std::sin(u * 7.0f) * std::cos(v * 5.0f);
+            snprintf(line, sizeof(line), "v %f %f %f\nvt %f %f\n", u * 2.0f - 1.0f, v * 2.0f - 1.0f, height, u, v);
+            contents += line;
+        }
+    }
+    for (int y = 0; y < k_grid_size; ++y)
+    {
+        for (int x = 0; x < k_grid_size; ++x)
+        {
+            // OBJ indices start at 1.
+            const int a = y * (k_grid_size + 1) + x + 1;
+            const int b = a + 1;
+            const int c = a + k_grid_size + 1;
+            const int d = c + 1;
+            snprintf(line, sizeof(line), "f %d/%d %d/%d %d/%d\nf %d/%d %d/%d %d/%d\n", a, a, b, b, d, d, a, a, d, d, c, c);
+            contents += line;
+        }
+    }
+
+    const std::filesystem::path path = std::filesystem::path(k_model_directory) / "grid.obj";
+    FILE* file = nullptr;
+#if defined(RNDR_WINDOWS)
+    fopen_s(&file, path.string().c_str(), "wb");
+#else
+    file = fopen(path.string().c_str(), "wb");
+#endif
+    REQUIRE(file != nullptr);
+    fwrite(contents.data(), 1, contents.size(), file);
+    fclose(file);
+    return Opal::StringUtf8(path.string().c_str());
+}
+
+/**
+ * Render a single model with the given LOD error threshold and return the number of triangles drawn.
+ * @param as_mesh If true, the model's mesh is passed to DrawMesh instead of drawing the model.
+ */
+Rndr::u64 RenderModel(Rndr::Canvas::Context& context, Rndr::Canvas::PbrRenderer& renderer, const Rndr::Canvas::PbrModel& model,
+                      Rndr::f32 max_pixel_error, bool as_mesh = false)
+{
+    const Rndr::Matrix4x4f identity = Opal::Translate(Rndr::Vector3f{0.0f, 0.0f, 0.0f});
+    renderer.BeginFrame();
+    renderer.SetViewProjection(identity);
+    renderer.SetLodErrorThreshold(max_pixel_error);
+    if (as_mesh)
+    {
+        renderer.DrawMesh("grid mesh", model.mesh, identity, Rndr::Canvas::PbrMaterialDesc{});
+    }
+    else
+    {
+        renderer.DrawModel("grid", model, identity);
+    }
+
+    Rndr::Canvas::DrawList list;
+    list.SetRenderTarget(context);
+    renderer.Render(list);
+    list.Execute();
+    return list.GetStats().triangle_count;
+}
+
+}  // namespace
+
+TEST_CASE("Canvas PbrRenderer models", "[canvas][pbr]")
+{
+    PbrRendererTestFixture f;
+    Rndr::Canvas::PbrRenderer renderer(Opal::Ref{f.context});
+    const Rndr::Canvas::PbrModel model = renderer.LoadModel(WriteGridModel());
+
+    SECTION("Drawing the model's mesh whole draws LOD 0")
+    {
+        const Rndr::Canvas::MeshRange full_range = model.mesh.GetFullRange();
+        REQUIRE(full_range.first_index == 0);
+        REQUIRE(full_range.index_count == k_grid_triangle_count * 3);
+
+        // Without error only LOD 0 is drawn, and it has the same triangles as the model's mesh.
+        const Rndr::u64 lod0_triangle_count = RenderModel(f.context, renderer, model, 0.0f);
+        REQUIRE(lod0_triangle_count == full_range.index_count / 3);
+        REQUIRE(RenderModel(f.context, renderer, model, 0.0f, true) == lod0_triangle_count);
+    }
+
+    SECTION("Coarser LODs come from the renderer, not the model's mesh")
+    {
+        const Rndr::u64 coarsest_triangle_count = RenderModel(f.context, renderer, model, 1e9f);
+        REQUIRE(coarsest_triangle_count > 0);
+        REQUIRE(coarsest_triangle_count < k_grid_triangle_count);
+        REQUIRE(model.mesh.GetIndexCount() == k_grid_triangle_count * 3);
+    }
+}
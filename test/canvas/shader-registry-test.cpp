@@ -0,0 +1,343 @@
+#include <catch2/catch2.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+#include "opal/container/scope-ptr.h"
+#include "opal/exceptions.h"
+
+#include "rndr/application.hpp"
+#include "rndr/canvas/brush.hpp"
+#include "rndr/canvas/context.hpp"
+#include "rndr/canvas/shader-registry.hpp"
+#include "rndr/file.hpp"
+#include "rndr/generic-window.hpp"
+
+namespace
+{
+
+constexpr const char* k_shader_directory = "shader-registry-test";
+
+Rndr::Canvas::Context CreateTestContext(Opal::ScopePtr<Rndr::Application>& app, Opal::Ref<Rndr::GenericWindow>& window)
+{
+    std::filesystem::remove_all(k_shader_directory);
+    std::filesystem::create_directories(k_shader_directory);
+    app = Rndr::Application::Create();
+    Rndr::GenericWindowDesc window_desc;
+    window_desc.start_visible = false;
+    window = app->CreateGenericWindow(window_desc);
+    return Rndr::Canvas::Context::Init(window.Clone());
+}
+
+struct ShaderRegistryTestFixture
+{
+    Opal::ScopePtr<Rndr::Application> app;
+    Opal::Ref<Rndr::GenericWindow> window;
+    Rndr::Canvas::Context context;
+
+    ShaderRegistryTestFixture() : context(CreateTestContext(app, window)) {}
+};
+
+/** Write a file into the test directory. Every write moves the modification time forward, so polls always see it. */
+void WriteShaderFile(const char* name, const char* contents)
+{
+    const std::filesystem::path path = std::filesystem::path(k_shader_directory) / name;
+    const bool existed = std::filesystem::exists(path);
+    const std::filesystem::file_time_type previous_time =
+        existed ? std::filesystem::last_write_time(path) : std::filesystem::file_time_type();
+    FILE* file = nullptr;
+#if defined(RNDR_WINDOWS)
+    fopen_s(&file, path.string().c_str(), "wb");
+#else
+    file = fopen(path.string().c_str(), "wb");
+#endif
+    REQUIRE(file != nullptr);
+    fwrite(contents, 1, strlen(contents), file);
+    fclose(file);
+    if (existed)
+    {
+        std::filesystem::last_write_time(path, previous_time + std::chrono::seconds(1));
+    }
+}
+
+/** Call Update until a shader is swapped or the timeout expires. */
+Rndr::u32 WaitForReload(Rndr::Canvas::ShaderRegistry& registry)
+{
+    for (int i = 0; i < 500; ++i)
+    {
+        const Rndr::u32 reloaded_count = registry.Update();
+        if (reloaded_count > 0)
+        {
+            return reloaded_count;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return 0;
+}
+
+const char* k_main_source = R"(
+#include "material.slang"
+
+struct VSInput
+{
+    float3 position;
+};
+
+struct VSOutput
+{
+    float4 position : SV_POSITION;
+};
+
+[shader("vertex")]
+VSOutput VertexMain(VSInput input)
+{
+    VSOutput output;
+    output.position = float4(input.position, 1.0);
+    return output;
+}
+
+struct FSOutput
+{
+    float4 color : SV_TARGET;
+};
+
+[shader("fragment")]
+FSOutput FragmentMain(VSOutput input)
+{
+    FSOutput output;
+    output.color = material.color * material.roughness;
+    return output;
+}
+)";
+
+const char* k_other_source = R"(
+struct VSInput
+{
+    float3 position;
+};
+
+struct VSOutput
+{
+    float4 position : SV_POSITION;
+};
+
+[shader("vertex")]
+VSOutput VertexMain(VSInput input)
+{
+    VSOutput output;
+    output.position = float4(input.position, 1.0);
+    return output;
+}
+
+struct FSOutput
+{
+    float4 color : SV_TARGET;
+};
+
+[shader("fragment")]
+FSOutput FragmentMain(VSOutput input)
+{
+    FSOutput output;
+    output.color = float4(1.0, 0.0, 0.0, 1.0);
+    return output;
+}
+)";
+
+const char* k_material_source = R"(
+struct MaterialData
+{
+    float4 color;
+    float roughness;
+};
+
+ConstantBuffer<MaterialData> material;
+)";
+
+const char* k_material_same_layout_source = R"(
+// Only a comment changed, the uniform layout stays the same.
+struct MaterialData
+{
+    float4 color;
+    float roughness;
+};
+
+ConstantBuffer<MaterialData> material;
+)";
+
+const char* k_material_new_layout_source = R"(
+struct MaterialData
+{
+    float4 color;
+    float metallic;
+    float roughness;
+};
+
+ConstantBuffer<MaterialData> material;
+)";
+
+}  // namespace
+
+TEST_CASE("Canvas ShaderRegistry", "[canvas][shader]")
+{
+    ShaderRegistryTestFixture const f;
+    WriteShaderFile("main.slang", k_main_source);
+    WriteShaderFile("other.slang", k_other_source);
+    WriteShaderFile("material.slang", k_material_source);
+
+    Rndr::Canvas::ShaderRegistryDesc registry_desc;
+    registry_desc.poll_interval_ms = 10;
+    Rndr::Canvas::ShaderRegistry registry(registry_desc);
+
+    SECTION("Load records the include graph")
+    {
+        const Rndr::Canvas::Shader& shader = registry.Load({.ref_path = k_shader_directory, .vertex_path = "main.slang"});
+        REQUIRE(shader.IsValid());
+        REQUIRE(registry.GetShaderCount() == 1);
+        REQUIRE(registry.GetDependencies(shader).GetSize() == 2);
+        REQUIRE(shader.FindParameter("roughness") != nullptr);
+    }
+
+    SECTION("Missing file throws")
+    {
+        REQUIRE_THROWS_AS(registry.Load({.ref_path = k_shader_directory, .vertex_path = "missing.slang"}),
+                          Opal::InvalidArgumentException);
+        REQUIRE(registry.GetShaderCount() == 0);
+    }
+
+    SECTION("Only shaders that depend on the changed file are reloaded")
+    {
+        const Rndr::Canvas::Shader& shader = registry.Load({.ref_path = k_shader_directory, .vertex_path = "main.slang"});
+        const Rndr::Canvas::Shader& other = registry.Load({.ref_path = k_shader_directory, .vertex_path = "other.slang"});
+        const Rndr::u32 other_program = other.GetNativeHandle();
+
+        WriteShaderFile("material.slang", k_material_same_layout_source);
+        REQUIRE(WaitForReload(registry) == 1);
+        REQUIRE(shader.IsValid());
+        REQUIRE(other.GetNativeHandle() == other_program);
+    }
+
+    SECTION("Brush keeps its uniforms if the layout did not change")
+    {
+        const Rndr::Canvas::Shader& shader = registry.Load({.ref_path = k_shader_directory, .vertex_path = "main.slang"});
+        const Rndr::u64 layout_hash = shader.GetUniformLayoutHash();
+        Rndr::Canvas::Brush brush;
+        brush.SetShader(shader);
+        brush.SetUniform("roughness", 0.5f);
+
+        WriteShaderFile("material.slang", k_material_same_layout_source);
+        REQUIRE(WaitForReload(registry) == 1);
+        REQUIRE(shader.GetUniformLayoutHash() == layout_hash);
+
+        brush.UploadUniforms();
+        const Rndr::Canvas::UniformHandle roughness = shader.GetUniformHandle("roughness");
+        float value = 0.0f;
+        memcpy(&value, brush.GetUniformData(0).GetData() + roughness.offset, sizeof(value));
+        REQUIRE(value == 0.5f);
+    }
+
+    SECTION("Brush recreates its slots if the layout changed")
+    {
+        const Rndr::Canvas::Shader& shader = registry.Load({.ref_path = k_shader_directory, .vertex_path = "main.slang"});
+        const Rndr::u64 layout_hash = shader.GetUniformLayoutHash();
+        Rndr::Canvas::Brush brush;
+        brush.SetShader(shader);
+        brush.SetUniform("roughness", 0.5f);
+        Rndr::Canvas::Brush instance = brush.CreateInstance();
+
+        WriteShaderFile("material.slang", k_material_new_layout_source);
+        REQUIRE(WaitForReload(registry) == 1);
+        REQUIRE(shader.GetUniformLayoutHash() != layout_hash);
+        REQUIRE(shader.FindParameter("metallic") != nullptr);
+
+        instance.UploadUniforms();
+        const Rndr::Canvas::UniformHandle roughness = shader.GetUniformHandle("roughness");
+        REQUIRE(brush.GetUniformData(0).GetSize() == static_cast<Rndr::u64>(shader.GetUniformBlocks()[0].size));
+        REQUIRE(instance.GetUniformBufferSlots()[0].inherited);
+        float value = 1.0f;
+        memcpy(&value, instance.GetUniformData(0).GetData() + roughness.offset, sizeof(value));
+        REQUIRE(value == 0.0f);
+    }
+
+    SECTION("Failed recompile keeps the old program")
+    {
+        const Rndr::Canvas::Shader& shader = registry.Load({.ref_path = k_shader_directory, .vertex_path = "main.slang"});
+        const Rndr::u32 program = shader.GetNativeHandle();
+
+        WriteShaderFile("material.slang", "this is not slang");
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        REQUIRE(registry.Update() == 0);
+        REQUIRE(shader.GetNativeHandle() == program);
+
+        WriteShaderFile("material.slang", k_material_source);
+        REQUIRE(WaitForReload(registry) == 1);
+        REQUIRE(shader.IsValid());
+    }
+}
+
+TEST_CASE("File ReadShader", "[canvas][shader]")
+{
+    ShaderRegistryTestFixture const f;
+    WriteShaderFile("common.slang", "// common\n");
+    WriteShaderFile("a.slang", "#include \"common.slang\"\n// a\n");
+    WriteShaderFile("b.slang", "#include \"common.slang\"\n// b\n");
+    WriteShaderFile("main.slang", "#include \"a.slang\"\n#include \"b.slang\"\n// main");
+
+    SECTION("Shared includes are expanded once")
+    {
+        Opal::DynamicArray<Opal::StringUtf8> dependencies;
+        const Opal::StringUtf8 source = Rndr::File::ReadShader(k_shader_directory, "main.slang", &dependencies);
+        REQUIRE(source == "// common\n\n// a\n\n\n// b\n\n// main");
+        REQUIRE(dependencies.GetSize() == 4);
+    }
+
+    SECTION("Different spellings of an include are expanded once")
+    {
+        std::filesystem::create_directories(std::filesystem::path(k_shader_directory) / "nested");
+        WriteShaderFile("a.slang", "#include \"nested/../common.slang\"\n// a\n");
+        WriteShaderFile("b.slang", "#include \"./common.slang\"\n// b\n");
+        Opal::DynamicArray<Opal::StringUtf8> dependencies;
+        const Opal::StringUtf8 source = Rndr::File::ReadShader(k_shader_directory, "main.slang", &dependencies);
+        REQUIRE(source == "// common\n\n// a\n\n\n// b\n\n// main");
+        REQUIRE(dependencies.GetSize() == 4);
+    }
+
+    SECTION("Empty includes expand to nothing")
+    {
+        WriteShaderFile("common.slang", "");
+        const Opal::StringUtf8 source = Rndr::File::ReadShader(k_shader_directory, "main.slang");
+        REQUIRE(source == "\n// a\n\n\n// b\n\n// main");
+    }
+
+    SECTION("Include cycles terminate")
+    {
+        WriteShaderFile("common.slang", "#include \"main.slang\"\n// common\n");
+        const Opal::StringUtf8 source = Rndr::File::ReadShader(k_shader_directory, "main.slang");
+        REQUIRE(source == "\n// common\n\n// a\n\n\n// b\n\n// main");
+    }
+
+    SECTION("Cache only reads changed files")
+    {
+        Rndr::ShaderFileCache cache;
+        REQUIRE_FALSE(Rndr::File::ReadShader(k_shader_directory, "main.slang", nullptr, &cache).IsEmpty());
+        REQUIRE(cache.GetStats().reads == 4);
+
+        REQUIRE_FALSE(Rndr::File::ReadShader(k_shader_directory, "a.slang", nullptr, &cache).IsEmpty());
+        REQUIRE(cache.GetStats().reads == 4);
+        REQUIRE(cache.GetStats().hits == 2);
+
+        WriteShaderFile("common.slang", "// changed\n");
+        const Opal::StringUtf8 source = Rndr::File::ReadShader(k_shader_directory, "main.slang", nullptr, &cache);
+        REQUIRE(source == "// changed\n\n// a\n\n\n// b\n\n// main");
+        REQUIRE(cache.GetStats().reads == 5);
+    }
+
+    SECTION("Missing include fails")
+    {
+        WriteShaderFile("a.slang", "#include \"missing.slang\"\n");
+        Opal::DynamicArray<Opal::StringUtf8> dependencies;
+        REQUIRE(Rndr::File::ReadShader(k_shader_directory, "main.slang", &dependencies).IsEmpty());
+        REQUIRE(dependencies.GetSize() == 3);
+    }
+}
@@ -3,11 +3,20 @@
 #include "opal/container/scope-ptr.h"
 #include "opal/exceptions.h"
 
+#include "canvas/shader-archive.hpp"
+
 #include "rndr/application.hpp"
+#include "rndr/canvas/brush.hpp"
 #include "rndr/canvas/context.hpp"
 #include "rndr/canvas/shader.hpp"
+#include "rndr/core/shader-compiler.hpp"
 #include "rndr/generic-window.hpp"
 
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
 namespace
 {
 
@@ -29,6 +38,30 @@ struct ShaderTestFixture
     ShaderTestFixture() : context(CreateTestContext(app, window)) {}
 };
 
+constexpr const char* k_shader_cache_directory = "shader-cache-test";
+
+/** Create a context with the shader cache enabled. The cache starts out empty. */
+Rndr::Canvas::Context CreateCachedTestContext(Opal::ScopePtr<Rndr::Application>& app, Opal::Ref<Rndr::GenericWindow>& window)
+{
+    std::filesystem::remove_all(k_shader_cache_directory);
+    app = Rndr::Application::Create();
+    Rndr::GenericWindowDesc window_desc;
+    window_desc.start_visible = false;
+    window = app->CreateGenericWindow(window_desc);
+    Rndr::Canvas::ContextDesc context_desc;
+    context_desc.shader_cache_directory = k_shader_cache_directory;
+    return Rndr::Canvas::Context::Init(window.Clone(), context_desc);
+}
+
+struct ShaderCacheTestFixture
+{
+    Opal::ScopePtr<Rndr::Application> app;
+    Opal::Ref<Rndr::GenericWindow> window;
+    Rndr::Canvas::Context context;
+
+    ShaderCacheTestFixture() : context(CreateCachedTestContext(app, window)) {}
+};
+
 const char* k_vertex_source = R"(
 struct VSInput
 {
@@ -421,6 +454,88 @@ void ComputeMain(uint3 tid : SV_DispatchThreadID)
 }
 )";
 
+const char* k_specialization_source = R"(
+[vk::constant_id(0)] const bool k_use_tint = false;
+[vk::constant_id(3)] const uint k_mode = 1;
+
+struct MaterialData
+{
+    float4 tint;
+};
+
+ConstantBuffer<MaterialData> material;
+
+struct VSInput
+{
+    float3 position;
+};
+
+struct VSOutput
+{
+    float4 position : SV_POSITION;
+};
+
+[shader("vertex")]
+VSOutput VertexMain(VSInput input)
+{
+    VSOutput output;
+    output.position = float4(input.position, 1.0);
+    return output;
+}
+
+[shader("fragment")]
+float4 FragmentMain(VSOutput input) : SV_TARGET
+{
+    float4 color = float4(1.0, 1.0, 1.0, 1.0);
+    if (k_use_tint)
+    {
+        color = color * material.tint;
+    }
+    if (k_mode == 2)
+    {
+        color.rgb = float3(0.0, 0.0, 0.0);
+    }
+    return color;
+}
+)";
+
+constexpr const char* k_shader_archive_path = "shader-archive-test.rsa";
+
+/** Write an archive with two shaders and create a context that maps it. */
+Rndr::Canvas::Context CreateArchivedTestContext(Opal::ScopePtr<Rndr::Application>& app, Opal::Ref<Rndr::GenericWindow>& window)
+{
+    Opal::DynamicArray<Rndr::Canvas::Impl::ShaderArchiveEntry> entries;
+    Rndr::Canvas::Impl::ShaderArchiveEntry combined;
+    combined.name = "combined.slang";
+    combined.vertex_source = k_combined_with_params_source;
+    combined.compiled = Rndr::Canvas::Impl::CompileShaderSources(combined.vertex_source, "");
+    entries.PushBack(std::move(combined));
+    Rndr::Canvas::Impl::ShaderArchiveEntry separate;
+    separate.name = "separate";
+    separate.vertex_source = k_vertex_source;
+    separate.fragment_source = k_fragment_source;
+    separate.compiled = Rndr::Canvas::Impl::CompileShaderSources(separate.vertex_source, separate.fragment_source);
+    entries.PushBack(std::move(separate));
+    Rndr::Canvas::Impl::WriteShaderArchive(k_shader_archive_path, entries);
+
+    app = Rndr::Application::Create();
+    Rndr::GenericWindowDesc window_desc;
+    window_desc.start_visible = false;
+    window = app->CreateGenericWindow(window_desc);
+    Rndr::Canvas::ContextDesc context_desc;
+    context_desc.shader_archive_path = k_shader_archive_path;
+    return Rndr::Canvas::Context::Init(window.Clone(), context_desc);
+}
+
+struct ShaderArchiveTestFixture
+{
+    Opal::ScopePtr<Rndr::Application> app;
+    Opal::Ref<Rndr::GenericWindow> window;
+    Rndr::Canvas::Context context;
+
+    ShaderArchiveTestFixture() : context(CreateArchivedTestContext(app, window)) {}
+};
+
 }  // namespace
 
 TEST_CASE("Canvas Shader", "[canvas][shader]")
@@ -728,6 +843,7 @@ TEST_CASE("Canvas Shader", "[canvas][shader]")
         const Rndr::Canvas::ShaderParameter* buffer = shader.FindParameter("output_buffer");
         REQUIRE(buffer != nullptr);
         REQUIRE(buffer->category == Rndr::Canvas::ParameterCategory::StorageBuffer);
+        REQUIRE(buffer->writable);
 
         const Rndr::Canvas::ShaderParameter* cb = shader.FindParameter("params");
         REQUIRE(cb != nullptr);
@@ -893,3 +1009,325 @@ TEST_CASE("Canvas Shader", "[canvas][shader]")
         REQUIRE(count->array_stride == 0);
     }
 }
+
+TEST_CASE("Canvas Shader cache", "[canvas][shader]")
+{
+    ShaderCacheTestFixture const f;
+
+    SECTION("Second load of the same source is a hit with the same reflection")
+    {
+        Rndr::Canvas::Shader const compiled = Rndr::Canvas::Shader::FromSourceInMemory(k_combined_with_params_source);
+        REQUIRE(f.context.GetShaderCacheStats().misses == 1);
+        REQUIRE(f.context.GetShaderCacheStats().hits == 0);
+
+        Rndr::Canvas::Shader const cached = Rndr::Canvas::Shader::FromSourceInMemory(k_combined_with_params_source);
+        REQUIRE(f.context.GetShaderCacheStats().hits == 1);
+        REQUIRE(cached.IsValid());
+        REQUIRE(cached.GetParameters().GetSize() == compiled.GetParameters().GetSize());
+        for (Rndr::u64 i = 0; i < compiled.GetParameters().GetSize(); ++i)
+        {
+            const Rndr::Canvas::ShaderParameter& a = compiled.GetParameters()[i];
+            const Rndr::Canvas::ShaderParameter& b = cached.GetParameters()[i];
+            REQUIRE(a.name == b.name);
+            REQUIRE(a.binding_index == b.binding_index);
+            REQUIRE(a.offset == b.offset);
+            REQUIRE(a.size == b.size);
+            REQUIRE(a.category == b.category);
+        }
+        REQUIRE(cached.GetVertexLayout().GetAttributeCount() == compiled.GetVertexLayout().GetAttributeCount());
+        REQUIRE(cached.GetVertexLayout().GetStride() == compiled.GetVertexLayout().GetStride());
+    }
+
+    SECTION("Separate sources are cached")
+    {
+        Rndr::Canvas::Shader const compiled = Rndr::Canvas::Shader::FromSourcesInMemory(k_vertex_source, k_fragment_source);
+        Rndr::Canvas::Shader const cached = Rndr::Canvas::Shader::FromSourcesInMemory(k_vertex_source, k_fragment_source);
+        REQUIRE(cached.IsValid());
+        REQUIRE(f.context.GetShaderCacheStats().hits == 1);
+    }
+
+    SECTION("Compute shaders keep their thread group size")
+    {
+        Rndr::Canvas::Shader const compiled = Rndr::Canvas::Shader::FromSourceInMemory(k_compute_source);
+        Rndr::Canvas::Shader const cached = Rndr::Canvas::Shader::FromSourceInMemory(k_compute_source);
+        REQUIRE(f.context.GetShaderCacheStats().hits == 1);
+        REQUIRE(cached.GetNumThreads().x == 64);
+        REQUIRE(cached.GetNumThreads().y == 1);
+        REQUIRE(cached.GetNumThreads().z == 1);
+    }
+
+    SECTION("Different sources do not share an entry")
+    {
+        Rndr::Canvas::Shader const first = Rndr::Canvas::Shader::FromSourceInMemory(k_combined_source);
+        Rndr::Canvas::Shader const second = Rndr::Canvas::Shader::FromSourceInMemory(k_combined_with_params_source);
+        REQUIRE(f.context.GetShaderCacheStats().misses == 2);
+        REQUIRE(f.context.GetShaderCacheStats().hits == 0);
+    }
+
+    SECTION("Invalid sources still throw")
+    {
+        REQUIRE_THROWS(Rndr::Canvas::Shader::FromSourceInMemory(k_mixed_compute_graphics_source));
+        REQUIRE_THROWS(Rndr::Canvas::Shader::FromSourceInMemory(k_mixed_compute_graphics_source));
+    }
+}
+
+TEST_CASE("Canvas Shader archive", "[canvas][shader]")
+{
+    ShaderArchiveTestFixture const f;
+
+    SECTION("Load by name")
+    {
+        Rndr::Canvas::Shader const shader = Rndr::Canvas::Shader::FromArchive("combined.slang");
+        REQUIRE(shader.IsValid());
+        REQUIRE(shader.GetDebugName() == "combined.slang");
+        REQUIRE(shader.FindParameter("roughness") != nullptr);
+        REQUIRE(f.context.GetShaderArchiveStats().hits == 1);
+    }
+
+    SECTION("Loads from sources in the archive skip the compiler")
+    {
+        Rndr::Canvas::Shader const combined = Rndr::Canvas::Shader::FromSourceInMemory(k_combined_with_params_source);
+        Rndr::Canvas::Shader const separate = Rndr::Canvas::Shader::FromSourcesInMemory(k_vertex_source, k_fragment_source);
+        REQUIRE(combined.IsValid());
+        REQUIRE(separate.IsValid());
+        REQUIRE(f.context.GetShaderArchiveStats().hits == 2);
+        REQUIRE(f.context.GetShaderArchiveStats().misses == 0);
+    }
+
+    SECTION("Sources not in the archive are compiled")
+    {
+        Rndr::Canvas::Shader const shader = Rndr::Canvas::Shader::FromSourceInMemory(k_combined_source);
+        REQUIRE(shader.IsValid());
+        REQUIRE(f.context.GetShaderArchiveStats().misses == 1);
+    }
+
+    SECTION("Unknown name throws")
+    {
+        REQUIRE_THROWS_AS(Rndr::Canvas::Shader::FromArchive("missing.slang"), Opal::InvalidArgumentException);
+    }
+
+    SECTION("Clone recompiles from the archived sources")
+    {
+        Rndr::Canvas::Shader const shader = Rndr::Canvas::Shader::FromArchive("separate");
+        Rndr::Canvas::Shader const clone = shader.Clone();
+        REQUIRE(clone.IsValid());
+        REQUIRE(f.context.GetShaderArchiveStats().hits == 2);
+    }
+}
+
+TEST_CASE("Canvas Shader batch", "[canvas][shader]")
+{
+    ShaderTestFixture const f;
+
+    SECTION("Shaders are returned in submission order")
+    {
+        Opal::DynamicArray<Rndr::Canvas::ShaderSourceDesc> descs;
+        descs.PushBack({.vertex_source = k_combined_source, .debug_name = "Combined"});
+        descs.PushBack({.vertex_source = k_compute_source, .debug_name = "Compute"});
+        descs.PushBack({.vertex_source = k_vertex_source, .fragment_source = k_fragment_source, .debug_name = "Separate"});
+        descs.PushBack({.vertex_source = k_combined_with_params_source, .debug_name = "Params"});
+
+        const Opal::DynamicArray<Rndr::Canvas::Shader> shaders = Rndr::Canvas::Shader::FromSourcesBatch(descs);
+        REQUIRE(shaders.GetSize() == 4);
+        for (Rndr::u64 i = 0; i < shaders.GetSize(); ++i)
+        {
+            REQUIRE(shaders[i].IsValid());
+            REQUIRE(shaders[i].GetDebugName() == descs[i].debug_name);
+        }
+        REQUIRE(shaders[0].GetNumThreads().x == 0);
+        REQUIRE(shaders[1].GetNumThreads().x == 64);
+        REQUIRE(shaders[2].GetFragmentSource() == k_fragment_source);
+        REQUIRE(shaders[3].FindParameter("roughness") != nullptr);
+    }
+
+    SECTION("Batch matches sequential compilation")
+    {
+        Opal::DynamicArray<Rndr::Canvas::ShaderSourceDesc> descs;
+        descs.PushBack({.vertex_source = k_combined_with_params_source});
+        descs.PushBack({.vertex_source = k_parameter_block_source});
+
+        const Opal::DynamicArray<Rndr::Canvas::Shader> shaders = Rndr::Canvas::Shader::FromSourcesBatch(descs, 2);
+        for (Rndr::u64 i = 0; i < descs.GetSize(); ++i)
+        {
+            Rndr::Canvas::Shader const sequential = Rndr::Canvas::Shader::FromSourceInMemory(descs[i].vertex_source);
+            REQUIRE(shaders[i].GetParameters().GetSize() == sequential.GetParameters().GetSize());
+            REQUIRE(shaders[i].GetUniformBlocks().GetSize() == sequential.GetUniformBlocks().GetSize());
+        }
+    }
+
+    SECTION("Empty batch returns no shaders")
+    {
+        const Opal::DynamicArray<Rndr::Canvas::ShaderSourceDesc> descs;
+        REQUIRE(Rndr::Canvas::Shader::FromSourcesBatch(descs).IsEmpty());
+    }
+
+    SECTION("Empty source throws")
+    {
+        Opal::DynamicArray<Rndr::Canvas::ShaderSourceDesc> descs;
+        descs.PushBack({.vertex_source = k_combined_source});
+        descs.PushBack({});
+        REQUIRE_THROWS_AS(Rndr::Canvas::Shader::FromSourcesBatch(descs), Opal::InvalidArgumentException);
+    }
+
+    SECTION("Compile error of any shader throws")
+    {
+        Opal::DynamicArray<Rndr::Canvas::ShaderSourceDesc> descs;
+        descs.PushBack({.vertex_source = k_combined_source});
+        descs.PushBack({.vertex_source = k_mixed_compute_graphics_source});
+        descs.PushBack({.vertex_source = k_compute_source});
+        REQUIRE_THROWS(Rndr::Canvas::Shader::FromSourcesBatch(descs));
+    }
+}
+
+TEST_CASE("ShaderCompiler concurrent compilation", "[canvas][shader]")
+{
+    // Distinct shaders, so that each result can be told apart and no compiler hits a cached module.
+    constexpr Rndr::u32 k_shader_count = 64;
+    Opal::DynamicArray<Rndr::CompileRequest> requests;
+    for (Rndr::u32 i = 0; i < k_shader_count; ++i)
+    {
+        char source[512] = {};
+        snprintf(source, sizeof(source),
+                 "RWStructuredBuffer<float> output_%u;\n"
+                 "[shader(\"compute\")]\n"
+                 "[numthreads(%u, 1, 1)]\n"
+                 "void ComputeMain(uint3 tid : SV_DispatchThreadID)\n"
+                 "{\n"
+                 "    output_%u[tid.x] = float(tid.x * %u);\n"
+                 "}\n",
+                 i, i + 1, i, i);
+        requests.PushBack({.source = Opal::StringUtf8(source), .entry_point = "ComputeMain"});
+    }
+
+    // Two batches at once, like the shader registry's watch thread compiling next to the Context thread.
+    Opal::DynamicArray<Rndr::CompileResult> results[2];
+    std::thread batches[2];
+    for (Rndr::u32 i = 0; i < 2; ++i)
+    {
+        batches[i] = std::thread([&requests, &results, i]() { results[i] = Rndr::ShaderCompiler::CompileBatch(requests, 8); });
+    }
+    for (std::thread& batch : batches)
+    {
+        batch.join();
+    }
+
+    for (const Opal::DynamicArray<Rndr::CompileResult>& batch_results : results)
+    {
+        REQUIRE(batch_results.GetSize() == k_shader_count);
+        for (Rndr::u32 i = 0; i < k_shader_count; ++i)
+        {
+            const Rndr::CompileResult& result = batch_results[i];
+            REQUIRE(!result.spirv.IsEmpty());
+            REQUIRE(result.num_threads.x == i + 1);
+
+            char buffer_name[32] = {};
+            snprintf(buffer_name, sizeof(buffer_name), "output_%u", i);
+            bool found = false;
+            for (Rndr::u64 j = 0; j < result.parameters.GetSize(); ++j)
+            {
+                found = found || result.parameters[j].name == buffer_name;
+            }
+            REQUIRE(found);
+        }
+    }
+}
+
+TEST_CASE("Canvas Shader variants", "[canvas][shader]")
+{
+    ShaderTestFixture const f;
+    Rndr::Canvas::Shader shader = Rndr::Canvas::Shader::FromSourceInMemory(k_specialization_source, "Variants");
+    REQUIRE(shader.IsValid());
+
+    SECTION("Specialization constants are reflected")
+    {
+        const Opal::DynamicArray<Rndr::SpecializationConstant>& constants = shader.GetSpecializationConstants();
+        REQUIRE(constants.GetSize() == 2);
+        const Rndr::SpecializationConstant* mode = nullptr;
+        for (Rndr::u64 i = 0; i < constants.GetSize(); ++i)
+        {
+            if (constants[i].constant_id == 3)
+            {
+                mode = &constants[i];
+            }
+        }
+        REQUIRE(mode != nullptr);
+        REQUIRE(mode->default_value == 1);
+    }
+
+    SECTION("Shader without specialization constants has no variants")
+    {
+        Rndr::Canvas::Shader plain = Rndr::Canvas::Shader::FromSourceInMemory(k_combined_source);
+        REQUIRE(plain.GetSpecializationConstants().IsEmpty());
+        REQUIRE_THROWS_AS(plain.SetPermutationKeys({{.constant_id = 0}}), Opal::InvalidArgumentException);
+        REQUIRE(&plain.GetVariant({}) == &plain);
+    }
+
+    SECTION("Unknown constant id throws")
+    {
+        REQUIRE_THROWS_AS(shader.SetPermutationKeys({{.constant_id = 1}}), Opal::InvalidArgumentException);
+        REQUIRE_THROWS_AS(shader.SetPermutationKeys({{.constant_id = 0, .value_count = 1}}), Opal::InvalidArgumentException);
+    }
+
+    SECTION("Variants are linked once and cached")
+    {
+        shader.SetPermutationKeys({{.constant_id = 0}, {.constant_id = 3, .value_count = 3}});
+        const Rndr::u32 tinted_values[] = {1, 2};
+        const Rndr::u32 plain_values[] = {0, 0};
+        const Rndr::Canvas::Shader& tinted = shader.GetVariant(Opal::ArrayView<const Rndr::u32>(tinted_values, 2));
+        const Rndr::Canvas::Shader& plain = shader.GetVariant(Opal::ArrayView<const Rndr::u32>(plain_values, 2));
+        REQUIRE(tinted.IsValid());
+        REQUIRE(plain.IsValid());
+        REQUIRE(tinted.GetNativeHandle() != plain.GetNativeHandle());
+        REQUIRE(tinted.GetNativeHandle() != shader.GetNativeHandle());
+        REQUIRE(tinted.GetUniformLayoutHash() == shader.GetUniformLayoutHash());
+        REQUIRE(&shader.GetVariant(Opal::ArrayView<const Rndr::u32>(tinted_values, 2)) == &tinted);
+        REQUIRE(shader.GetVariantCount() == 2);
+    }
+
+    SECTION("Variants know their parent and key values")
+    {
+        shader.SetPermutationKeys({{.constant_id = 0}, {.constant_id = 3, .value_count = 3}});
+        const Rndr::u32 values[] = {1, 2};
+        const Rndr::Canvas::Shader& variant = shader.GetVariant(Opal::ArrayView<const Rndr::u32>(values, 2));
+        REQUIRE(shader.GetVariantParent() == nullptr);
+        REQUIRE(shader.GetVariantValues().IsEmpty());
+        REQUIRE(variant.GetVariantParent() == &shader);
+        REQUIRE(variant.GetVariantValues().GetSize() == 2);
+        REQUIRE(variant.GetVariantValues()[0] == 1);
+        REQUIRE(variant.GetVariantValues()[1] == 2);
+
+        // The variant stays where it is when its parent moves, and follows the parent.
+        Rndr::Canvas::Shader moved = std::move(shader);
+        REQUIRE(variant.GetVariantParent() == &moved);
+    }
+
+    SECTION("Invalid values throw")
+    {
+        shader.SetPermutationKeys({{.constant_id = 0}, {.constant_id = 3, .value_count = 3}});
+        const Rndr::u32 out_of_range_values[] = {0, 3};
+        const Rndr::u32 too_few_values[] = {0};
+        REQUIRE_THROWS_AS(shader.GetVariant(Opal::ArrayView<const Rndr::u32>(out_of_range_values, 2)), Opal::InvalidArgumentException);
+        REQUIRE_THROWS_AS(shader.GetVariant(Opal::ArrayView<const Rndr::u32>(too_few_values, 1)), Opal::InvalidArgumentException);
+        REQUIRE(shader.GetVariantCount() == 0);
+    }
+
+    SECTION("Brush switches variants and keeps its uniforms")
+    {
+        shader.SetPermutationKeys({{.constant_id = 0}});
+        const Rndr::u32 values[] = {1};
+        const Rndr::Canvas::Shader& variant = shader.GetVariant(Opal::ArrayView<const Rndr::u32>(values, 1));
+
+        Rndr::Canvas::Brush brush;
+        brush.SetShader(shader);
+        brush.SetUniform("tint", Rndr::Vector4f{0.5f, 0.5f, 0.5f, 1.0f});
+        brush.SetShaderVariant(variant);
+        REQUIRE(brush.GetShader() == &variant);
+        REQUIRE(brush.GetUniformData(0).GetSize() > 0);
+        float tint_x = 0.0f;
+        memcpy(&tint_x, brush.GetUniformData(0).GetData(), sizeof(tint_x));
+        REQUIRE(tint_x == 0.5f);
+
+        Rndr::Canvas::Shader other = Rndr::Canvas::Shader::FromSourceInMemory(k_combined_with_params_source);
+        REQUIRE_THROWS_AS(brush.SetShaderVariant(other), Opal::InvalidArgumentException);
+    }
+}
@@ -0,0 +1,319 @@
+#include <catch2/catch2.hpp>
+
+#include <cstring>
+
+#include "opal/container/dynamic-array.h"
+#include "opal/exceptions.h"
+
+#include "canvas/spirv-module.hpp"
+#include "canvas/spirv-patch.hpp"
+
+namespace
+{
+
+using Rndr::u32;
+using Rndr::u64;
+
+// Ids of the test module.
+enum : u32
+{
+    k_id_void = 1,
+    k_id_function_type,
+    k_id_int,
+    k_id_input_pointer,
+    k_id_private_pointer,
+    k_id_vertex_index,
+    k_id_base_vertex,
+    k_id_used_private,
+    k_id_unused_private,
+    k_id_main,
+    k_id_label,
+    k_id_load_index,
+    k_id_load_base,
+    k_id_sub,
+    k_id_file_name,
+    k_id_debug_info,
+    k_id_add,
+    k_id_bound
+};
+
+void AddInstruction(Opal::DynamicArray<u32>& words, u32 op_code, std::initializer_list<u32> operands)
+{
+    words.PushBack((static_cast<u32>(operands.size() + 1) << 16) | op_code);
+    for (const u32 operand : operands)
+    {
+        words.PushBack(operand);
+    }
+}
+
+void AddString(Opal::DynamicArray<u32>& words, const char* str)
+{
+    const u64 word_count = strlen(str) / 4 + 1;
+    const u64 offset = words.GetSize();
+    for (u64 i = 0; i < word_count; ++i)
+    {
+        words.PushBack(0);
+    }
+    memcpy(words.GetData() + offset, str, strlen(str));
+}
+
+/** Add an instruction whose operands are ids followed by a literal string. */
+void AddStringInstruction(Opal::DynamicArray<u32>& words, u32 op_code, std::initializer_list<u32> leading_operands, const char* str,
+                          std::initializer_list<u32> trailing_operands = {})
+{
+    const u64 start = words.GetSize();
+    words.PushBack(op_code);
+    for (const u32 operand : leading_operands)
+    {
+        words.PushBack(operand);
+    }
+    AddString(words, str);
+    for (const u32 operand : trailing_operands)
+    {
+        words.PushBack(operand);
+    }
+    words[start] |= static_cast<u32>(words.GetSize() - start) << 16;
+}
+
+/**
+ * Vertex shader as Slang emits it for Vulkan: SV_VertexID is VertexIndex - BaseVertex. It also has
+ * debug info, an unused private variable and nops. padding_count adds debug names to grow the module.
+ * With reads_base_vertex the shader also adds BaseVertex back, like an index into a per-draw slice.
+ */
+Opal::DynamicArray<u32> CreateTestModule(u32 padding_count = 0, bool reads_base_vertex = false)
+{
+    Opal::DynamicArray<u32> words = {0x07230203, 0x00010300, 0, k_id_bound, 0};
+    AddInstruction(words, 17, {1});     // OpCapability Shader
+    AddInstruction(words, 17, {4427});  // OpCapability DrawParameters
+    AddStringInstruction(words, 10, {}, "SPV_KHR_shader_draw_parameters");
+    AddInstruction(words, 14, {0, 1});  // OpMemoryModel Logical GLSL450
+    AddStringInstruction(words, 15, {0, k_id_main}, "main", {k_id_vertex_index, k_id_base_vertex});
+    AddStringInstruction(words, 7, {k_id_file_name}, "shader.slang");
+    AddInstruction(words, 3, {11, 1, k_id_file_name});  // OpSource Slang 1 %file_name
+    AddStringInstruction(words, 5, {k_id_base_vertex}, "base_vertex");
+    AddStringInstruction(words, 5, {k_id_unused_private}, "unused_private");
+    AddStringInstruction(words, 5, {k_id_used_private}, "used_private");
+    for (u32 i = 0; i < padding_count; ++i)
+    {
+        AddStringInstruction(words, 5, {k_id_main}, "padding_name");
+    }
+    AddInstruction(words, 71, {k_id_vertex_index, 11, 42});  // OpDecorate BuiltIn VertexIndex
+    AddInstruction(words, 71, {k_id_base_vertex, 11, 4424});  // OpDecorate BuiltIn BaseVertex
+    AddInstruction(words, 19, {k_id_void});
+    AddInstruction(words, 33, {k_id_function_type, k_id_void});
+    AddInstruction(words, 21, {k_id_int, 32, 1});
+    AddInstruction(words, 32, {k_id_input_pointer, 1, k_id_int});
+    AddInstruction(words, 32, {k_id_private_pointer, 6, k_id_int});
+    AddInstruction(words, 59, {k_id_input_pointer, k_id_vertex_index, 1});
+    AddInstruction(words, 59, {k_id_input_pointer, k_id_base_vertex, 1});
+    AddInstruction(words, 59, {k_id_private_pointer, k_id_used_private, 6});
+    AddInstruction(words, 59, {k_id_private_pointer, k_id_unused_private, 6});
+    AddInstruction(words, 54, {k_id_void, k_id_main, 0, k_id_function_type});
+    AddInstruction(words, 248, {k_id_label});
+    AddInstruction(words, 8, {k_id_file_name, 10, 1});  // OpLine
+    AddInstruction(words, 61, {k_id_int, k_id_load_index, k_id_vertex_index});
+    AddInstruction(words, 61, {k_id_int, k_id_load_base, k_id_base_vertex});
+    AddInstruction(words, 130, {k_id_int, k_id_sub, k_id_load_index, k_id_load_base});
+    if (reads_base_vertex)
+    {
+        AddInstruction(words, 128, {k_id_int, k_id_add, k_id_sub, k_id_load_base});  // OpIAdd
+    }
+    AddInstruction(words, 62, {k_id_used_private, reads_base_vertex ? k_id_add : k_id_sub});  // OpStore
+    AddInstruction(words, 0, {});
+    AddInstruction(words, 253, {});  // OpReturn
+    AddInstruction(words, 56, {});   // OpFunctionEnd
+    return words;
+}
+
+/** @return Index of the first live instruction with the opcode whose first operands match, or the instruction count. */
+u64 FindInstruction(const Rndr::Impl::SpirvModule& spirv_module, u32 op_code, std::initializer_list<u32> operands = {})
+{
+    for (u64 i = 0; i < spirv_module.GetInstructionCount(); ++i)
+    {
+        if (spirv_module.IsRemoved(i) || spirv_module.GetOpCode(i) != op_code || spirv_module.GetOperandCount(i) < operands.size())
+        {
+            continue;
+        }
+        bool matches = true;
+        u32 j = 0;
+        for (const u32 operand : operands)
+        {
+            matches = matches && spirv_module.GetOperands(i)[j++] == operand;
+        }
+        if (matches)
+        {
+            return i;
+        }
+    }
+    return spirv_module.GetInstructionCount();
+}
+
+bool HasInstruction(const Rndr::Impl::SpirvModule& spirv_module, u32 op_code, std::initializer_list<u32> operands = {})
+{
+    return FindInstruction(spirv_module, op_code, operands) < spirv_module.GetInstructionCount();
+}
+
+}  // namespace
+
+TEST_CASE("Canvas SpirvModule", "[canvas][spirv]")
+{
+    using namespace Rndr::Impl;
+
+    SECTION("Invalid modules throw")
+    {
+        REQUIRE_THROWS_AS(SpirvModule(Opal::DynamicArray<u32>{0x07230203, 0}), Opal::Exception);
+        REQUIRE_THROWS_AS(SpirvModule(Opal::DynamicArray<u32>{0, 0, 0, 1, 0}), Opal::Exception);
+        REQUIRE_THROWS_AS(SpirvModule(Opal::DynamicArray<u32>{0x07230203, 0, 0, 1, 0, 0}), Opal::Exception);
+        REQUIRE_THROWS_AS(SpirvModule(Opal::DynamicArray<u32>{0x07230203, 0, 0, 1, 0, (3 << 16) | 17, 1}), Opal::Exception);
+    }
+
+    SECTION("Untouched module is emitted unchanged")
+    {
+        const Opal::DynamicArray<u32> words = CreateTestModule();
+        const SpirvModule spirv_module(words.Clone());
+        REQUIRE(spirv_module.GetWordCount() == words.GetSize());
+        const Opal::DynamicArray<u32> emitted = spirv_module.Emit();
+        REQUIRE(emitted.GetSize() == words.GetSize());
+        REQUIRE(memcmp(emitted.GetData(), words.GetData(), words.GetSize() * sizeof(u32)) == 0);
+    }
+
+    SECTION("Edits are compacted on emit")
+    {
+        SpirvModule spirv_module(CreateTestModule());
+        const u64 entry_point = FindInstruction(spirv_module, 15);
+        const u32 operand_count = spirv_module.GetOperandCount(entry_point);
+        spirv_module.RemoveOperand(entry_point, operand_count - 2);
+        REQUIRE(spirv_module.GetOperandCount(entry_point) == operand_count - 1);
+        REQUIRE(spirv_module.GetOperands(entry_point)[operand_count - 2] == k_id_base_vertex);
+        spirv_module.Remove(FindInstruction(spirv_module, 0));
+
+        const SpirvModule emitted(spirv_module.Emit());
+        REQUIRE(emitted.GetWordCount() == spirv_module.GetWordCount());
+        REQUIRE(emitted.GetInstructionCount() == spirv_module.GetInstructionCount() - 1);
+        REQUIRE_FALSE(HasInstruction(emitted, 0));
+    }
+
+    SECTION("Builtins are remapped for OpenGL")
+    {
+        SpirvModule spirv_module(CreateTestModule());
+        RemapBuiltinsForOpenGL(spirv_module);
+        REQUIRE(HasInstruction(spirv_module, 71, {k_id_vertex_index, 11, 5}));
+        REQUIRE_FALSE(HasInstruction(spirv_module, 71, {k_id_base_vertex}));
+        REQUIRE_FALSE(HasInstruction(spirv_module, 59, {k_id_input_pointer, k_id_base_vertex}));
+        REQUIRE_FALSE(HasInstruction(spirv_module, 61, {k_id_int, k_id_load_base}));
+        REQUIRE_FALSE(HasInstruction(spirv_module, 17, {4427}));
+        REQUIRE_FALSE(HasInstruction(spirv_module, 10));
+        REQUIRE(HasInstruction(spirv_module, 83, {k_id_int, k_id_sub, k_id_load_index}));
+        REQUIRE(spirv_module.GetOperandCount(FindInstruction(spirv_module, 83)) == 3);
+
+        // The entry point interface keeps only VertexIndex.
+        const u64 entry_point = FindInstruction(spirv_module, 15);
+        REQUIRE(spirv_module.GetOperandCount(entry_point) == 5);
+        REQUIRE(spirv_module.GetOperands(entry_point)[4] == k_id_vertex_index);
+    }
+
+    SECTION("Base builtins that the shader reads are kept for OpenGL")
+    {
+        SpirvModule spirv_module(CreateTestModule(0, true));
+        RemapBuiltinsForOpenGL(spirv_module);
+        REQUIRE(HasInstruction(spirv_module, 71, {k_id_vertex_index, 11, 5}));
+        REQUIRE(HasInstruction(spirv_module, 71, {k_id_base_vertex, 11, 4424}));
+        REQUIRE(HasInstruction(spirv_module, 59, {k_id_input_pointer, k_id_base_vertex}));
+        REQUIRE(HasInstruction(spirv_module, 61, {k_id_int, k_id_load_base, k_id_base_vertex}));
+        REQUIRE(HasInstruction(spirv_module, 17, {4427}));
+        REQUIRE(HasInstruction(spirv_module, 10));
+        // VertexId already excludes the base, so the subtraction still goes away.
+        REQUIRE(HasInstruction(spirv_module, 83, {k_id_int, k_id_sub, k_id_load_index}));
+        REQUIRE(HasInstruction(spirv_module, 128, {k_id_int, k_id_add, k_id_sub, k_id_load_base}));
+
+        const u64 entry_point = FindInstruction(spirv_module, 15);
+        REQUIRE(spirv_module.GetOperandCount(entry_point) == 6);
+        REQUIRE(spirv_module.GetOperands(entry_point)[5] == k_id_base_vertex);
+    }
+
+    SECTION("Debug info is stripped")
+    {
+        SpirvModule spirv_module(CreateTestModule());
+        StripDebugInfo(spirv_module);
+        REQUIRE_FALSE(HasInstruction(spirv_module, 5));
+        REQUIRE_FALSE(HasInstruction(spirv_module, 3));
+        REQUIRE_FALSE(HasInstruction(spirv_module, 8));
+        REQUIRE_FALSE(HasInstruction(spirv_module, 7));
+    }
+
+    SECTION("Strings that are still used are kept")
+    {
+        Opal::DynamicArray<u32> words = CreateTestModule();
+        AddInstruction(words, 12, {k_id_void, k_id_debug_info, 1, 1, k_id_file_name});  // OpExtInst that uses the string
+        SpirvModule spirv_module(std::move(words));
+        StripDebugInfo(spirv_module);
+        REQUIRE(HasInstruction(spirv_module, 7, {k_id_file_name}));
+    }
+
+    SECTION("Unused variables are removed")
+    {
+        SpirvModule spirv_module(CreateTestModule());
+        RemoveUnusedVariables(spirv_module);
+        REQUIRE_FALSE(HasInstruction(spirv_module, 59, {k_id_private_pointer, k_id_unused_private}));
+        REQUIRE_FALSE(HasInstruction(spirv_module, 5, {k_id_unused_private}));
+        REQUIRE(HasInstruction(spirv_module, 59, {k_id_private_pointer, k_id_used_private}));
+        REQUIRE(HasInstruction(spirv_module, 5, {k_id_used_private}));
+
+        // Interface variables stay even when unused.
+        REQUIRE(HasInstruction(spirv_module, 59, {k_id_input_pointer, k_id_vertex_index}));
+    }
+
+    SECTION("OpenGL pipeline reports the size change of each pass")
+    {
+        Opal::DynamicArray<u32> words = CreateTestModule();
+        const u64 input_size = words.GetSize();
+        const SpirvTransformStats stats = PatchSpirv(words);
+        REQUIRE(stats.input_word_count == input_size);
+        REQUIRE(stats.output_word_count == words.GetSize());
+        REQUIRE(stats.output_word_count < stats.input_word_count);
+        REQUIRE(stats.removed_word_counts.GetSize() == GetOpenGLSpirvPipeline().GetPassCount());
+        u64 removed_word_count = 0;
+        for (u64 i = 0; i < stats.removed_word_counts.GetSize(); ++i)
+        {
+            REQUIRE(stats.removed_word_counts[i] > 0);
+            removed_word_count += stats.removed_word_counts[i];
+        }
+        REQUIRE(removed_word_count == stats.input_word_count - stats.output_word_count);
+
+        const SpirvModule patched(std::move(words));
+        REQUIRE_FALSE(HasInstruction(patched, 0));
+        REQUIRE_FALSE(HasInstruction(patched, 5));
+        REQUIRE(HasInstruction(patched, 83));
+    }
+}
+
+TEST_CASE("Canvas SpirvModule benchmarks", "[canvas][spirv][!benchmark]")
+{
+    using namespace Rndr::Impl;
+
+    const Opal::DynamicArray<u32> words = CreateTestModule(2000);
+
+    BENCHMARK("Index")
+    {
+        return SpirvModule(words.Clone()).GetInstructionCount();
+    };
+
+    BENCHMARK("Index and emit")
+    {
+        return SpirvModule(words.Clone()).Emit().GetSize();
+    };
+
+    BENCHMARK("OpenGL pipeline")
+    {
+        Opal::DynamicArray<u32> bytecode = words.Clone();
+        return PatchSpirv(bytecode).output_word_count;
+    };
+
+    BENCHMARK("Builtin remap only")
+    {
+        SpirvPipeline pipeline;
+        pipeline.AddPass({.name = "RemapBuiltinsForOpenGL", .run = &RemapBuiltinsForOpenGL});
+        Opal::DynamicArray<u32> bytecode = words.Clone();
+        return pipeline.Run(bytecode).output_word_count;
+    };
+}
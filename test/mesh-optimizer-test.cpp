@@ -0,0 +1,311 @@
+#include <catch2/catch2.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#include "opal/container/dynamic-array.h"
+
+#include "rndr/mesh-optimizer.hpp"
+
+namespace
+{
+
+struct TestVertex
+{
+    float position[3] = {};
+    float normal[3] = {};
+    float uv[2] = {};
+};
+
+struct TestMesh
+{
+    Opal::DynamicArray<TestVertex> vertices;
+    Opal::DynamicArray<Rndr::u32> indices;
+};
+
+constexpr Rndr::u32 k_vertex_stride = sizeof(TestVertex);
+
+void AddQuad(TestMesh& mesh, Rndr::u32 a, Rndr::u32 b, Rndr::u32 c, Rndr::u32 d)
+{
+    const Rndr::u32 quad[] = {a, b, d, a, d, c};
+    for (const Rndr::u32 index : quad)
+    {
+        mesh.indices.PushBack(index);
+    }
+}
+
+/** Flat grid of n x n quads in the XY plane, facing +Z. */
+TestMesh CreateGrid(Rndr::u32 n)
+{
+    TestMesh mesh;
+    for (Rndr::u32 y = 0; y <= n; ++y)
+    {
+        for (Rndr::u32 x = 0; x <= n; ++x)
+        {
+            mesh.vertices.PushBack({.position = {static_cast<float>(x), static_cast<float>(y), 0.0f}, .normal = {0.0f, 0.0f, 1.0f}});
+        }
+    }
+    for (Rndr::u32 y = 0; y < n; ++y)
+    {
+        for (Rndr::u32 x = 0; x < n; ++x)
+        {
+            const Rndr::u32 a = y * (n + 1) + x;
+            AddQuad(mesh, a, a + 1, a + n + 1, a + n + 2);
+        }
+    }
+    return mesh;
+}
+
+/** Append a box centered at the origin with outward facing sides split into n x n quads. */
+void AddBox(TestMesh& mesh, float half_size, Rndr::u32 n)
+{
+    for (Rndr::u32 axis = 0; axis < 3; ++axis)
+    {
+        for (const float sign : {-1.0f, 1.0f})
+        {
+            const auto base = static_cast<Rndr::u32>(mesh.vertices.GetSize());
+            for (Rndr::u32 j = 0; j <= n; ++j)
+            {
+                for (Rndr::u32 i = 0; i <= n; ++i)
+                {
+                    TestVertex vertex = {};
+                    vertex.position[axis] = sign * half_size;
+                    vertex.position[(axis + 1) % 3] = half_size * (2.0f * static_cast<float>(i) / static_cast<float>(n) - 1.0f);
+                    vertex.position[(axis + 2) % 3] = half_size * (2.0f * static_cast<float>(j) / static_cast<float>(n) - 1.0f);
+                    vertex.normal[axis] = sign;
+                    mesh.vertices.PushBack(vertex);
+                }
+            }
+            for (Rndr::u32 j = 0; j < n; ++j)
+            {
+                for (Rndr::u32 i = 0; i < n; ++i)
+                {
+                    const Rndr::u32 a = base + j * (n + 1) + i;
+                    if (sign > 0.0f)
+                    {
+                        AddQuad(mesh, a, a + 1, a + n + 1, a + n + 2);
+                    }
+                    else
+                    {
+                        AddQuad(mesh, a + 1, a, a + n + 2, a + n + 1);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/** Shuffle the triangles with a fixed seed, like an exporter that writes faces in arbitrary order. */
+void ShuffleTriangles(Opal::DynamicArray<Rndr::u32>& indices)
+{
+    Rndr::u32 seed = 1;
+    for (Rndr::u64 i = indices.GetSize() / 3 - 1; i > 0; --i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        const Rndr::u64 j = (seed >> 8) % (i + 1);
+        for (Rndr::u64 k = 0; k < 3; ++k)
+        {
+            std::swap(indices[i * 3 + k], indices[j * 3 + k]);
+        }
+    }
+}
+
+Opal::ArrayView<Rndr::u32> GetIndices(TestMesh& mesh)
+{
+    return Opal::ArrayView<Rndr::u32>(mesh.indices.GetData(), mesh.indices.GetSize());
+}
+
+Opal::ArrayView<const Rndr::u32> GetConstIndices(const TestMesh& mesh)
+{
+    return Opal::ArrayView<const Rndr::u32>(mesh.indices.GetData(), mesh.indices.GetSize());
+}
+
+Opal::ArrayView<const Rndr::u8> GetVertexBytes(const TestMesh& mesh)
+{
+    return Opal::ArrayView<const Rndr::u8>(reinterpret_cast<const Rndr::u8*>(mesh.vertices.GetData()),
+                                           mesh.vertices.GetSize() * sizeof(TestVertex));
+}
+
+Rndr::u32 GetVertexCount(const TestMesh& mesh)
+{
+    return static_cast<Rndr::u32>(mesh.vertices.GetSize());
+}
+
+/** Triangles as sorted position triples, to compare meshes independent of triangle and vertex order. */
+Opal::DynamicArray<float> GetSortedTriangles(const Opal::DynamicArray<Rndr::u32>& indices, const TestVertex* vertices)
+{
+    const Rndr::u64 triangle_count = indices.GetSize() / 3;
+    Opal::DynamicArray<float> triangles(triangle_count * 9);
+    for (Rndr::u64 i = 0; i < indices.GetSize(); ++i)
+    {
+        memcpy(triangles.GetData() + i * 3, vertices[indices[i]].position, 3 * sizeof(float));
+    }
+    struct Triangle
+    {
+        float values[9];
+    };
+    Triangle* begin = reinterpret_cast<Triangle*>(triangles.GetData());
+    std::sort(begin, begin + triangle_count,
+              [](const Triangle& a, const Triangle& b)
+              { return std::lexicographical_compare(a.values, a.values + 9, b.values, b.values + 9); });
+    return triangles;
+}
+
+}  // namespace
+
+TEST_CASE("Mesh optimizer", "[mesh-optimizer]")
+{
+    SECTION("Vertex cache analysis")
+    {
+        TestMesh mesh;
+        mesh.vertices.Resize(4);
+        AddQuad(mesh, 0, 1, 2, 3);
+        const Rndr::VertexCacheStats stats = Rndr::AnalyzeVertexCache(GetConstIndices(mesh), 4);
+        REQUIRE(stats.transformed_vertex_count == 4);
+        REQUIRE(stats.acmr == 2.0f);
+        REQUIRE(stats.atvr == 1.0f);
+
+        // With a single entry no two consecutive indices match, so every index misses.
+        REQUIRE(Rndr::AnalyzeVertexCache(GetConstIndices(mesh), 4, 1).transformed_vertex_count == 6);
+    }
+
+    SECTION("Vertex cache optimization keeps the triangles and lowers the ACMR")
+    {
+        TestMesh mesh = CreateGrid(64);
+        ShuffleTriangles(mesh.indices);
+        const Opal::DynamicArray<float> triangles = GetSortedTriangles(mesh.indices, mesh.vertices.GetData());
+        const Rndr::VertexCacheStats before = Rndr::AnalyzeVertexCache(GetConstIndices(mesh), GetVertexCount(mesh));
+
+        Rndr::OptimizeVertexCache(GetIndices(mesh), GetVertexCount(mesh));
+        const Rndr::VertexCacheStats after = Rndr::AnalyzeVertexCache(GetConstIndices(mesh), GetVertexCount(mesh));
+        REQUIRE(before.acmr > 2.5f);
+        REQUIRE(after.acmr < 0.75f);
+        REQUIRE(after.atvr < 1.5f);
+        const Opal::DynamicArray<float> optimized_triangles = GetSortedTriangles(mesh.indices, mesh.vertices.GetData());
+        REQUIRE(memcmp(triangles.GetData(), optimized_triangles.GetData(), triangles.GetSize() * sizeof(float)) == 0);
+    }
+
+    SECTION("Overdraw analysis")
+    {
+        TestMesh mesh;
+        const float positions[][3] = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {1, 1, 0}, {0, 0, 1}, {1, 0, 1}, {0, 1, 1}, {1, 1, 1}};
+        for (const auto& position : positions)
+        {
+            mesh.vertices.PushBack({.position = {position[0], position[1], position[2]}});
+        }
+
+        // Two quads facing +Z. Drawing the far one first shades the covered pixels twice.
+        AddQuad(mesh, 0, 1, 2, 3);
+        AddQuad(mesh, 4, 5, 6, 7);
+        REQUIRE(Rndr::AnalyzeOverdraw(GetConstIndices(mesh), GetVertexBytes(mesh), k_vertex_stride).overdraw_ratio == 2.0f);
+
+        mesh.indices.Clear();
+        AddQuad(mesh, 4, 5, 6, 7);
+        AddQuad(mesh, 0, 1, 2, 3);
+        REQUIRE(Rndr::AnalyzeOverdraw(GetConstIndices(mesh), GetVertexBytes(mesh), k_vertex_stride).overdraw_ratio == 1.0f);
+    }
+
+    SECTION("Overdraw optimization draws outer clusters first")
+    {
+        TestMesh mesh;
+        AddBox(mesh, 0.5f, 8);
+        AddBox(mesh, 1.0f, 8);
+        const Rndr::OverdrawStats before = Rndr::AnalyzeOverdraw(GetConstIndices(mesh), GetVertexBytes(mesh), k_vertex_stride);
+        REQUIRE(before.overdraw_ratio > 1.2f);
+
+        Rndr::OptimizeOverdraw(GetIndices(mesh), GetVertexBytes(mesh), k_vertex_stride, 3.0f);
+        const Rndr::OverdrawStats after = Rndr::AnalyzeOverdraw(GetConstIndices(mesh), GetVertexBytes(mesh), k_vertex_stride);
+        REQUIRE(after.covered_pixel_count == before.covered_pixel_count);
+        REQUIRE(after.overdraw_ratio == 1.0f);
+    }
+
+    SECTION("Overdraw optimization stays within the ACMR threshold")
+    {
+        TestMesh mesh;
+        AddBox(mesh, 0.5f, 8);
+        AddBox(mesh, 1.0f, 8);
+        ShuffleTriangles(mesh.indices);
+        Rndr::OptimizeVertexCache(GetIndices(mesh), GetVertexCount(mesh));
+        const Rndr::VertexCacheStats before = Rndr::AnalyzeVertexCache(GetConstIndices(mesh), GetVertexCount(mesh));
+
+        Rndr::OptimizeOverdraw(GetIndices(mesh), GetVertexBytes(mesh), k_vertex_stride, 1.05f);
+        const Rndr::VertexCacheStats after = Rndr::AnalyzeVertexCache(GetConstIndices(mesh), GetVertexCount(mesh));
+        REQUIRE(after.acmr <= before.acmr * 1.05f);
+    }
+
+    SECTION("Vertex fetch optimization orders vertices by first use and drops unused ones")
+    {
+        TestMesh mesh = CreateGrid(16);
+        ShuffleTriangles(mesh.indices);
+        mesh.vertices.PushBack({.position = {-1.0f, -1.0f, -1.0f}});
+        const Opal::DynamicArray<float> triangles = GetSortedTriangles(mesh.indices, mesh.vertices.GetData());
+
+        Opal::DynamicArray<Rndr::u8> vertex_data(mesh.vertices.GetSize() * sizeof(TestVertex));
+        memcpy(vertex_data.GetData(), mesh.vertices.GetData(), vertex_data.GetSize());
+        const Rndr::u32 vertex_count = Rndr::OptimizeMesh(vertex_data, k_vertex_stride, GetIndices(mesh));
+        REQUIRE(vertex_count == GetVertexCount(mesh) - 1);
+        REQUIRE(vertex_data.GetSize() == vertex_count * sizeof(TestVertex));
+
+        Rndr::u32 next_new_vertex = 0;
+        for (Rndr::u64 i = 0; i < mesh.indices.GetSize(); ++i)
+        {
+            REQUIRE(mesh.indices[i] <= next_new_vertex);
+            next_new_vertex = std::max(next_new_vertex, mesh.indices[i] + 1);
+        }
+        const auto* optimized_vertices = reinterpret_cast<const TestVertex*>(vertex_data.GetData());
+        const Opal::DynamicArray<float> optimized_triangles = GetSortedTriangles(mesh.indices, optimized_vertices);
+        REQUIRE(memcmp(triangles.GetData(), optimized_triangles.GetData(), triangles.GetSize() * sizeof(float)) == 0);
+        REQUIRE(Rndr::AnalyzeVertexFetch(GetConstIndices(mesh), vertex_count, k_vertex_stride).overfetch_ratio < 2.0f);
+    }
+}
+
+TEST_CASE("Mesh optimizer benchmarks", "[mesh-optimizer][!benchmark]")
+{
+    // CAD-like model: a dense tessellated plate and two nested shells, with faces in arbitrary order.
+    TestMesh model = CreateGrid(128);
+    AddBox(model, 32.0f, 48);
+    AddBox(model, 64.0f, 48);
+    ShuffleTriangles(model.indices);
+
+    Opal::DynamicArray<Rndr::u8> vertex_data(model.vertices.GetSize() * sizeof(TestVertex));
+    memcpy(vertex_data.GetData(), model.vertices.GetData(), vertex_data.GetSize());
+
+    const Rndr::VertexCacheStats cache_before = Rndr::AnalyzeVertexCache(GetConstIndices(model), GetVertexCount(model));
+    const Rndr::OverdrawStats overdraw_before = Rndr::AnalyzeOverdraw(GetConstIndices(model), GetVertexBytes(model), k_vertex_stride);
+    const Rndr::VertexFetchStats fetch_before = Rndr::AnalyzeVertexFetch(GetConstIndices(model), GetVertexCount(model), k_vertex_stride);
+
+    TestMesh optimized;
+    optimized.indices = model.indices.Clone();
+    Opal::DynamicArray<Rndr::u8> optimized_vertex_data = vertex_data.Clone();
+    const Rndr::u32 vertex_count = Rndr::OptimizeMesh(optimized_vertex_data, k_vertex_stride, GetIndices(optimized));
+    const Opal::ArrayView<const Rndr::u8> optimized_bytes(optimized_vertex_data.GetData(), optimized_vertex_data.GetSize());
+    const Rndr::VertexCacheStats cache_after = Rndr::AnalyzeVertexCache(GetConstIndices(optimized), vertex_count);
+    const Rndr::OverdrawStats overdraw_after = Rndr::AnalyzeOverdraw(GetConstIndices(optimized), optimized_bytes, k_vertex_stride);
+    const Rndr::VertexFetchStats fetch_after = Rndr::AnalyzeVertexFetch(GetConstIndices(optimized), vertex_count, k_vertex_stride);
+
+    WARN("ACMR " << cache_before.acmr << " -> " << cache_after.acmr << ", ATVR " << cache_before.atvr << " -> " << cache_after.atvr
+                 << ", overdraw " << overdraw_before.overdraw_ratio << " -> " << overdraw_after.overdraw_ratio << ", overfetch "
+                 << fetch_before.overfetch_ratio << " -> " << fetch_after.overfetch_ratio);
+    REQUIRE(cache_after.acmr < cache_before.acmr);
+    REQUIRE(overdraw_after.overdraw_ratio <= overdraw_before.overdraw_ratio);
+    REQUIRE(fetch_after.overfetch_ratio < fetch_before.overfetch_ratio);
+
+    BENCHMARK("OptimizeVertexCache")
+    {
+        Opal::DynamicArray<Rndr::u32> indices = model.indices.Clone();
+        Rndr::OptimizeVertexCache(Opal::ArrayView<Rndr::u32>(indices.GetData(), indices.GetSize()), GetVertexCount(model));
+        return indices.GetSize();
+    };
+
+    BENCHMARK("OptimizeMesh")
+    {
+        Opal::DynamicArray<Rndr::u32> indices = model.indices.Clone();
+        Opal::DynamicArray<Rndr::u8> data = vertex_data.Clone();
+        return Rndr::OptimizeMesh(data, k_vertex_stride, Opal::ArrayView<Rndr::u32>(indices.GetData(), indices.GetSize()));
+    };
+
+    BENCHMARK("AnalyzeOverdraw")
+    {
+        return Rndr::AnalyzeOverdraw(GetConstIndices(model), GetVertexBytes(model), k_vertex_stride).shaded_pixel_count;
+    };
+}
@@ -0,0 +1,243 @@
+#include <catch2/catch2.hpp>
+
+#include <cmath>
+
+#include "opal/container/dynamic-array.h"
+
+#include "rndr/mesh-simplifier.hpp"
+
+namespace
+{
+
+struct TestVertex
+{
+    float position[3] = {};
+    float normal[3] = {};
+    float uv[2] = {};
+};
+
+struct TestMesh
+{
+    Opal::DynamicArray<TestVertex> vertices;
+    Opal::DynamicArray<Rndr::u32> indices;
+};
+
+constexpr Rndr::u32 k_vertex_stride = sizeof(TestVertex);
+
+/** Flat grid of n x n quads in the XY plane, facing +Z, with the x coordinate as its u coordinate. */
+TestMesh CreateGrid(Rndr::u32 n)
+{
+    TestMesh mesh;
+    for (Rndr::u32 y = 0; y <= n; ++y)
+    {
+        for (Rndr::u32 x = 0; x <= n; ++x)
+        {
+            const auto fx = static_cast<float>(x);
+            const auto fy = static_cast<float>(y);
+            mesh.vertices.PushBack({.position = {fx, fy, 0.0f}, .normal = {0.0f, 0.0f, 1.0f}, .uv = {fx, 0.0f}});
+        }
+    }
+    for (Rndr::u32 y = 0; y < n; ++y)
+    {
+        for (Rndr::u32 x = 0; x < n; ++x)
+        {
+            const Rndr::u32 a = y * (n + 1) + x;
+            const Rndr::u32 quad[] = {a, a + 1, a + n + 2, a, a + n + 2, a + n + 1};
+            for (const Rndr::u32 index : quad)
+            {
+                mesh.indices.PushBack(index);
+            }
+        }
+    }
+    return mesh;
+}
+
+/** Unit sphere laid out like PbrRenderer's, with duplicated vertices along the UV seam and at the poles. */
+TestMesh CreateSphere(Rndr::u32 segments)
+{
+    TestMesh mesh;
+    const float pi = 3.14159265f;
+    for (Rndr::u32 lat = 0; lat <= segments; ++lat)
+    {
+        const float theta = static_cast<float>(lat) * pi / static_cast<float>(segments);
+        for (Rndr::u32 lon = 0; lon <= segments; ++lon)
+        {
+            const float phi = static_cast<float>(lon) * 2.0f * pi / static_cast<float>(segments);
+            float x = std::cos(phi) * std::sin(theta);
+            const float y = std::cos(theta);
+            float z = std::sin(phi) * std::sin(theta);
+            if (lon == segments)
+            {
+                // Match the first column exactly, like a sphere exported with a UV seam.
+                x = std::sin(theta);
+                z = 0.0f;
+            }
+            const float u = static_cast<float>(lon) / static_cast<float>(segments);
+            const float v = static_cast<float>(lat) / static_cast<float>(segments);
+            mesh.vertices.PushBack({.position = {x, y, z}, .normal = {x, y, z}, .uv = {u, v}});
+        }
+    }
+    for (Rndr::u32 lat = 0; lat < segments; ++lat)
+    {
+        for (Rndr::u32 lon = 0; lon < segments; ++lon)
+        {
+            const Rndr::u32 current = lat * (segments + 1) + lon;
+            const Rndr::u32 next = current + segments + 1;
+            const Rndr::u32 quad[] = {current, current + 1, next, current + 1, next + 1, next};
+            for (const Rndr::u32 index : quad)
+            {
+                mesh.indices.PushBack(index);
+            }
+        }
+    }
+    return mesh;
+}
+
+Opal::ArrayView<const Rndr::u32> GetIndices(const TestMesh& mesh)
+{
+    return Opal::ArrayView<const Rndr::u32>(mesh.indices.GetData(), mesh.indices.GetSize());
+}
+
+Opal::ArrayView<const Rndr::u8> GetVertexBytes(const TestMesh& mesh)
+{
+    return Opal::ArrayView<const Rndr::u8>(reinterpret_cast<const Rndr::u8*>(mesh.vertices.GetData()),
+                                           mesh.vertices.GetSize() * sizeof(TestVertex));
+}
+
+/** Sum of the signed triangle areas projected on the XY plane. */
+float GetProjectedArea(const Opal::DynamicArray<Rndr::u32>& indices, const TestMesh& mesh)
+{
+    float area = 0.0f;
+    for (Rndr::u64 i = 0; i < indices.GetSize(); i += 3)
+    {
+        const float* a = mesh.vertices[indices[i]].position;
+        const float* b = mesh.vertices[indices[i + 1]].position;
+        const float* c = mesh.vertices[indices[i + 2]].position;
+        area += 0.5f * ((b[0] - a[0]) * (c[1] - a[1]) - (c[0] - a[0]) * (b[1] - a[1]));
+    }
+    return area;
+}
+
+}  // namespace
+
+TEST_CASE("Mesh simplifier", "[mesh-simplifier]")
+{
+    SECTION("Flat grid simplifies without error and keeps its outline")
+    {
+        const TestMesh grid = CreateGrid(32);
+        float error = -1.0f;
+        const Opal::DynamicArray<Rndr::u32> simplified =
+            Rndr::SimplifyMesh(GetIndices(grid), GetVertexBytes(grid), k_vertex_stride, 1536, 0.01f, {}, &error);
+        REQUIRE(simplified.GetSize() <= 1536);
+        REQUIRE(simplified.GetSize() % 3 == 0);
+        REQUIRE(error < 1e-4f);
+        REQUIRE(GetProjectedArea(simplified, grid) == Catch::Approx(32.0f * 32.0f));
+        for (Rndr::u64 i = 0; i < simplified.GetSize(); i += 3)
+        {
+            const float* a = grid.vertices[simplified[i]].position;
+            const float* b = grid.vertices[simplified[i + 1]].position;
+            const float* c = grid.vertices[simplified[i + 2]].position;
+            REQUIRE((b[0] - a[0]) * (c[1] - a[1]) - (c[0] - a[0]) * (b[1] - a[1]) > 0.0f);
+        }
+    }
+
+    SECTION("Weighted attributes limit the collapses")
+    {
+        TestMesh grid = CreateGrid(16);
+        for (Rndr::u64 i = 0; i < grid.vertices.GetSize(); ++i)
+        {
+            grid.vertices[i].uv[1] = grid.vertices[i].position[1];
+        }
+        const Rndr::u64 index_count = grid.indices.GetSize();
+
+        // The normal is the same everywhere, weighting it changes nothing.
+        const float normal_weights[] = {1.0f, 1.0f, 1.0f};
+        const Opal::DynamicArray<Rndr::u32> with_normals = Rndr::SimplifyMesh(
+            GetIndices(grid), GetVertexBytes(grid), k_vertex_stride, 0, 0.01f, Opal::ArrayView<const float>(normal_weights, 3));
+        REQUIRE(with_normals.GetSize() < index_count / 4);
+
+        // Every collapse changes the UV, so none is within the error limit.
+        const float uv_weights[] = {0.0f, 0.0f, 0.0f, 1.0f, 1.0f};
+        const Opal::DynamicArray<Rndr::u32> with_uvs = Rndr::SimplifyMesh(GetIndices(grid), GetVertexBytes(grid), k_vertex_stride, 0,
+                                                                           0.01f, Opal::ArrayView<const float>(uv_weights, 5));
+        REQUIRE(with_uvs.GetSize() == index_count);
+    }
+
+    SECTION("Error limit stops the simplification")
+    {
+        const TestMesh sphere = CreateSphere(32);
+        float error = 0.0f;
+        const Opal::DynamicArray<Rndr::u32> simplified =
+            Rndr::SimplifyMesh(GetIndices(sphere), GetVertexBytes(sphere), k_vertex_stride, 0, 0.01f, {}, &error);
+        REQUIRE(simplified.GetSize() < sphere.indices.GetSize());
+        REQUIRE(simplified.GetSize() > sphere.indices.GetSize() / 8);
+        REQUIRE(error > 0.0f);
+        REQUIRE(error <= 0.01f);
+    }
+
+    SECTION("LOD chain of a sphere")
+    {
+        const TestMesh sphere = CreateSphere(32);
+        const float weights[] = {0.1f, 0.1f, 0.1f, 0.1f, 0.1f};
+        Opal::DynamicArray<Rndr::u32> lod_indices;
+        const Rndr::MeshLodChain lod_chain =
+            Rndr::GenerateMeshLods(GetIndices(sphere), GetVertexBytes(sphere), k_vertex_stride, lod_indices,
+                                   {.max_lod_count = 4, .attribute_weights = Opal::ArrayView<const float>(weights, 5)});
+        REQUIRE(lod_chain.bounds_radius == Catch::Approx(1.0f));
+        REQUIRE(lod_chain.bounds_center.x == Catch::Approx(0.0f).margin(1e-5f));
+        REQUIRE(lod_chain.lods.GetSize() >= 3);
+        REQUIRE(lod_chain.lods.GetSize() <= 4);
+
+        const Rndr::MeshLod& lod0 = lod_chain.lods[0];
+        REQUIRE(lod0.first_index == 0);
+        REQUIRE(lod0.index_count == sphere.indices.GetSize());
+        REQUIRE(lod0.error == 0.0f);
+        for (Rndr::u64 i = 1; i < lod_chain.lods.GetSize(); ++i)
+        {
+            const Rndr::MeshLod& previous = lod_chain.lods[i - 1];
+            const Rndr::MeshLod& lod = lod_chain.lods[i];
+            REQUIRE(lod.first_index == previous.first_index + previous.index_count);
+            REQUIRE(static_cast<float>(lod.index_count) <= 0.8f * static_cast<float>(previous.index_count));
+            REQUIRE(lod.error >= previous.error);
+            REQUIRE(lod.error <= 0.05f * static_cast<float>(i));
+        }
+        const Rndr::MeshLod& last = lod_chain.lods.Back();
+        REQUIRE(lod_indices.GetSize() == last.first_index + last.index_count);
+    }
+
+    SECTION("LOD selection")
+    {
+        const Rndr::MeshLod lods[] = {{.first_index = 0, .index_count = 96, .error = 0.0f},
+                                      {.first_index = 96, .index_count = 48, .error = 0.01f},
+                                      {.first_index = 144, .index_count = 24, .error = 0.04f},
+                                      {.first_index = 168, .index_count = 12, .error = 0.1f}};
+        const Opal::ArrayView<const Rndr::MeshLod> lod_view(lods, 4);
+        REQUIRE(Rndr::SelectMeshLod(lod_view, 1000.0f, 1.0f) == 0);
+        REQUIRE(Rndr::SelectMeshLod(lod_view, 50.0f, 1.0f) == 1);
+        REQUIRE(Rndr::SelectMeshLod(lod_view, 20.0f, 1.0f) == 2);
+        REQUIRE(Rndr::SelectMeshLod(lod_view, 5.0f, 1.0f) == 3);
+        REQUIRE(Rndr::SelectMeshLod(lod_view, 5.0f, 0.0f) == 0);
+        REQUIRE(Rndr::SelectMeshLod(Opal::ArrayView<const Rndr::MeshLod>(lods, 1), 1.0f, 1.0f) == 0);
+    }
+}
+
+TEST_CASE("Mesh simplifier benchmarks", "[mesh-simplifier][!benchmark]")
+{
+    const TestMesh sphere = CreateSphere(256);
+    const float weights[] = {0.1f, 0.1f, 0.1f, 0.1f, 0.1f};
+    const Rndr::MeshLodDesc desc{.attribute_weights = Opal::ArrayView<const float>(weights, 5)};
+
+    BENCHMARK("SimplifyMesh to half")
+    {
+        return Rndr::SimplifyMesh(GetIndices(sphere), GetVertexBytes(sphere), k_vertex_stride,
+                                  static_cast<Rndr::u32>(sphere.indices.GetSize() / 2), 0.05f,
+                                  Opal::ArrayView<const float>(weights, 5))
+            .GetSize();
+    };
+
+    BENCHMARK("GenerateMeshLods")
+    {
+        Opal::DynamicArray<Rndr::u32> lod_indices;
+        return Rndr::GenerateMeshLods(GetIndices(sphere), GetVertexBytes(sphere), k_vertex_stride, lod_indices, desc).lods.GetSize();
+    };
+}
@@ -0,0 +1,77 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include "glad/glad.h"
+
+#include "opal/exceptions.h"
+
+#include "rndr/application.hpp"
+#include "rndr/canvas/context.hpp"
+#include "rndr/canvas/frame-capture.hpp"
+#include "rndr/generic-window.hpp"
+#include "rndr/time.hpp"
+
+/**
+ * Replays a frame capture written by Canvas::FrameCapture::Save in a loop and reports CPU + GPU
+ * frame times. Each iteration waits for the GPU to finish, so the times cover the whole frame.
+ *
+ * Usage: capture-replay <capture-file> [iteration-count]
+ */
+int main(int argc, char** argv)
+{
+    using namespace Rndr;
+
+    if (argc < 2)
+    {
+        printf("Usage: capture-replay <capture-file> [iteration-count]\n");
+        return 1;
+    }
+    const i32 iteration_count = argc > 2 ? atoi(argv[2]) : 1000;
+    if (iteration_count <= 0)
+    {
+        printf("Iteration count must be positive!\n");
+        return 1;
+    }
+
+    try
+    {
+        auto app = Application::Create();
+        GenericWindowDesc window_desc;
+        window_desc.name = "Capture Replay";
+        window_desc.start_visible = false;
+        auto window = app->CreateGenericWindow(window_desc);
+        auto context = Canvas::Context::Init(window.Clone(), {.vsync_enabled = false});
+
+        const Canvas::FrameCapture capture = Canvas::FrameCapture::Load(argv[1]);
+        Canvas::FrameReplay replay(context, capture);
+        printf("Loaded %s: %u commands, %u resources\n", argv[1], capture.GetCommandCount(), capture.GetResourceCount());
+
+        // The first frame pays for uploads and driver shader compilation, keep it out of the stats.
+        replay.Execute();
+        glFinish();
+
+        f64 total_seconds = 0.0;
+        f64 min_seconds = 0.0;
+        f64 max_seconds = 0.0;
+        for (i32 i = 0; i < iteration_count; ++i)
+        {
+            const Timestamp start = GetTimestamp();
+            replay.Execute();
+            glFinish();
+            const f64 seconds = GetDuration(start, GetTimestamp());
+
+            total_seconds += seconds;
+            min_seconds = i == 0 || seconds < min_seconds ? seconds : min_seconds;
+            max_seconds = seconds > max_seconds ? seconds : max_seconds;
+        }
+
+        printf("%d iterations: avg %.3f ms, min %.3f ms, max %.3f ms\n", iteration_count, 1000.0 * total_seconds / iteration_count,
+               1000.0 * min_seconds, 1000.0 * max_seconds);
+    }
+    catch (const Opal::Exception& e)
+    {
+        printf("Replay failed: %s\n", *e.What());
+        return 1;
+    }
+    return 0;
+}
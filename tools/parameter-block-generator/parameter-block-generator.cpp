@@ -0,0 +1,76 @@
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+#include "opal/exceptions.h"
+
+#include "canvas/shader-cache.hpp"
+#include "core/parameter-blocks.hpp"
+
+#include "rndr/file.hpp"
+
+/**
+ * Generates a C++ header with one struct per uniform block of a Slang shader, to be passed to
+ * Brush::SetParameterBlock. The shader is compiled like Shader::FromSource and the structs follow
+ * its reflected layout, see Impl::GenerateParameterBlocks. The header is only rewritten when its
+ * contents change, so code that includes it is not rebuilt for unrelated shader edits.
+ *
+ * Usage: parameter-block-generator <shader-file> <output-header> <namespace>
+ */
+int main(int argc, char** argv)
+{
+    using namespace Rndr;
+
+    if (argc != 4)
+    {
+        printf("Usage: parameter-block-generator <shader-file> <output-header> <namespace>\n");
+        return 1;
+    }
+
+    try
+    {
+        const std::filesystem::path shader_path = argv[1];
+        const std::string directory = shader_path.parent_path().generic_string();
+        const std::string file_name = shader_path.filename().generic_string();
+        const Opal::StringUtf8 source =
+            File::ReadShader(Opal::StringUtf8(reinterpret_cast<const char8*>(directory.c_str()), directory.size()),
+                             Opal::StringUtf8(reinterpret_cast<const char8*>(file_name.c_str()), file_name.size()));
+        if (source.IsEmpty())
+        {
+            printf("Failed to read the shader %s!\n", argv[1]);
+            return 1;
+        }
+
+        const Canvas::Impl::CompiledShader compiled = Canvas::Impl::CompileShaderSources(source, "");
+        const Opal::StringUtf8 header = Impl::GenerateParameterBlocks(compiled.parameters, file_name.c_str(), argv[3]);
+
+        const Opal::StringUtf8 output_path(reinterpret_cast<const char8*>(argv[2]), strlen(argv[2]));
+        if (std::filesystem::exists(argv[2]) && File::ReadEntireTextFile(output_path) == header)
+        {
+            return 0;
+        }
+
+        std::filesystem::create_directories(std::filesystem::path(argv[2]).parent_path());
+        FILE* file = nullptr;
+        fopen_s(&file, argv[2], "wb");
+        if (file == nullptr)
+        {
+            printf("Failed to open %s for writing!\n", argv[2]);
+            return 1;
+        }
+        const u64 written_bytes = fwrite(header.GetData(), 1, header.GetSize(), file);
+        fclose(file);
+        if (written_bytes != header.GetSize())
+        {
+            printf("Failed to write %s!\n", argv[2]);
+            return 1;
+        }
+    }
+    catch (const Opal::Exception& e)
+    {
+        printf("Generating parameter blocks failed: %s\n", *e.What());
+        return 1;
+    }
+    return 0;
+}
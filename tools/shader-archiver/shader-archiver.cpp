@@ -0,0 +1,111 @@
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+
+#include "opal/exceptions.h"
+
+#include "canvas/embedded-shaders.hpp"
+#include "canvas/shader-archive.hpp"
+#include "core/parallel-for.hpp"
+
+#include "rndr/file.hpp"
+#include "rndr/time.hpp"
+
+/**
+ * Precompiles Slang shaders into a shader archive that Canvas::Context maps at startup, see
+ * ContextDesc::shader_archive_path. Every .slang file under the given directories is compiled as a
+ * single-source shader and named by its path relative to its directory, so FromSource calls on the
+ * same files also hit the archive. The shaders embedded in the Canvas renderers are added under
+ * "embedded/". Files that fail to compile, like include-only files, are reported and skipped.
+ *
+ * Usage: shader-archiver <output-file> <shader-dir>...
+ */
+int main(int argc, char** argv)
+{
+    using namespace Rndr;
+
+    if (argc < 3)
+    {
+        printf("Usage: shader-archiver <output-file> <shader-dir>...\n");
+        return 1;
+    }
+
+    try
+    {
+        const Timestamp start = GetTimestamp();
+
+        Opal::DynamicArray<Canvas::Impl::ShaderArchiveEntry> entries;
+        for (int i = 2; i < argc; ++i)
+        {
+            const std::filesystem::path directory = argv[i];
+            if (!std::filesystem::is_directory(directory))
+            {
+                printf("Shader directory %s does not exist!\n", argv[i]);
+                return 1;
+            }
+            for (const std::filesystem::directory_entry& file : std::filesystem::recursive_directory_iterator(directory))
+            {
+                if (!file.is_regular_file() || file.path().extension() != ".slang")
+                {
+                    continue;
+                }
+                const std::string path = file.path().generic_string();
+                const std::string name = file.path().lexically_relative(directory).generic_string();
+                Canvas::Impl::ShaderArchiveEntry entry;
+                entry.name = Opal::StringUtf8(reinterpret_cast<const char8*>(name.c_str()), name.size());
+                // Read the same way Shader::FromSource does, so the source hashes match at runtime.
+                entry.vertex_source = File::ReadEntireTextFile(Opal::StringUtf8(reinterpret_cast<const char8*>(path.c_str()), path.size()));
+                entries.PushBack(std::move(entry));
+            }
+        }
+
+        const Opal::StringUtf8* embedded_sources[] = {&Canvas::Impl::GetShapeRendererShaderSource(),
+                                                      &Canvas::Impl::GetCubeMapRendererShaderSource(),
+                                                      &Canvas::Impl::GetGridRendererShaderSource()};
+        const char* embedded_names[] = {"embedded/shape-renderer", "embedded/cubemap-renderer", "embedded/grid-renderer"};
+        for (u64 i = 0; i < 3; ++i)
+        {
+            Canvas::Impl::ShaderArchiveEntry entry;
+            entry.name = embedded_names[i];
+            entry.vertex_source = embedded_sources[i]->Clone();
+            entries.PushBack(std::move(entry));
+        }
+
+        Opal::DynamicArray<bool> compiled(entries.GetSize());
+        std::mutex print_mutex;
+        Impl::ParallelFor(entries.GetSize(), 0,
+                          [&entries, &compiled, &print_mutex](u64 index)
+                          {
+                              Canvas::Impl::ShaderArchiveEntry& entry = entries[index];
+                              try
+                              {
+                                  entry.compiled = Canvas::Impl::CompileShaderSources(entry.vertex_source, entry.fragment_source);
+                                  compiled[index] = true;
+                              }
+                              catch (const Opal::Exception& e)
+                              {
+                                  std::lock_guard<std::mutex> lock(print_mutex);
+                                  printf("Skipping %s: %s\n", *entry.name, *e.What());
+                              }
+                          });
+
+        Opal::DynamicArray<Canvas::Impl::ShaderArchiveEntry> archived_entries;
+        for (u64 i = 0; i < entries.GetSize(); ++i)
+        {
+            if (compiled[i])
+            {
+                archived_entries.PushBack(std::move(entries[i]));
+            }
+        }
+        Canvas::Impl::WriteShaderArchive(argv[1], archived_entries);
+
+        printf("Archived %llu of %llu shaders into %s in %.1f s\n", static_cast<unsigned long long>(archived_entries.GetSize()),
+               static_cast<unsigned long long>(entries.GetSize()), argv[1], GetDuration(start, GetTimestamp()));
+    }
+    catch (const Opal::Exception& e)
+    {
+        printf("Archiving failed: %s\n", *e.What());
+        return 1;
+    }
+    return 0;
+}